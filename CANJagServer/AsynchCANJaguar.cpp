@@ -59,6 +59,18 @@ float AsynchCANJaguar :: GetPosition ()
 
 };
 
+/**
+* Position from the server's telemetry cache. Never waits on the server thread.
+*
+* @return False if the server hasn't cached this Jaguar's position. ( See CANJaguarServer :: AddJagTelemetry )
+*/
+bool AsynchCANJaguar :: GetCachedPosition ( float * Position, double * Timestamp )
+{
+
+	return Server -> GetJagCachedPosition ( ID, Position, Timestamp );
+
+};
+
 float AsynchCANJaguar :: GetBusVoltage ()
 {
 
@@ -89,6 +101,20 @@ void AsynchCANJaguar :: Configure ( CANJagConfigInfo Config )
 
 };
 
+CANJaguarServer * AsynchCANJaguar :: GetServer ()
+{
+
+	return Server;
+
+};
+
+CAN_ID AsynchCANJaguar :: GetID ()
+{
+
+	return ID;
+
+};
+
 void AsynchCANJaguar :: PIDWrite ( float Speed )
 {
 
@@ -24,6 +24,7 @@ public:
 	void Set ( float Speed, uint8_t SyncGroup = 0 );
 	float Get ();
 	float GetPosition ();
+	bool GetCachedPosition ( float * Position, double * Timestamp = NULL );
 
 	float GetBusVoltage ();
 	float GetOutputVoltage ();
@@ -31,6 +32,9 @@ public:
 
 	void Configure ( CANJagConfigInfo Config );
 
+	CANJaguarServer * GetServer ();
+	CAN_ID GetID ();
+
 	virtual void PIDWrite ( float Speed );
 
 	static void UpdateSyncGroup ( CANJaguarServer * Server, uint8_t SyncGroup );
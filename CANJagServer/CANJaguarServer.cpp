@@ -1,4 +1,5 @@
 #include "CANJaguarServer.h"
+#include <math.h>
 
 /*
 * Copyright (C) 2014 Liam Taylor
@@ -30,6 +31,13 @@ CANJaguarServer :: CANJaguarServer ( bool DoBrownOutCheck, double BrownOutCheckI
 	ParseWait = ParseTimeout;
 	CommandWait = CommandTimeout;
 
+	TelemetryInterval = 0;
+	TelemetryCount = 0;
+	TelemetryTimestamp = 0;
+
+	TelemetryIDCount = 0;
+	TelemetryCursor = 0;
+
 	Running = false;
 
 	// Server task. _StartServerTask calls this -> RunLoop.
@@ -115,6 +123,20 @@ void CANJaguarServer :: SetCANBusUpdateInterval ( double Interval )
 
 };
 
+/**
+* Set how often the server reads the position of every Jaguar registered with AddJagTelemetry into the telemetry
+* cache. The reads are spread evenly over the interval, one per pass of the server loop.
+*
+* @param Interval Interval time in seconds. ( 0 turns the cache off )
+*/
+void CANJaguarServer :: SetTelemetryInterval ( double Interval )
+{
+
+	// Possible race condition ignored, due to only being used for conditional comparison.
+	TelemetryInterval = Interval;
+
+};
+
 /**
 * Start the server. 
 *
@@ -221,6 +243,8 @@ void CANJaguarServer :: Stop ()
 				case SEND_MESSAGE_NOP:
 				case SEND_MESSAGE_JAG_DISABLE:
 				case SEND_MESSAGE_JAG_REMOVE:
+				case SEND_MESSAGE_JAG_ADD_TELEMETRY:
+				case SEND_MESSAGE_JAG_REMOVE_TELEMETRY:
 
 					delete Message;
 
@@ -520,6 +544,127 @@ float CANJaguarServer :: GetJag ( CAN_ID ID )
 
 };
 
+/**
+* Get the jaguar's position as of the last telemetry sweep, without waiting on the server thread.
+*
+* @param ID The CAN id of the Jaguar.
+* @param Position Set to the cached position.
+* @param Timestamp Set to the time the position was read.
+* @return False if the Jaguar isn't in the cache, or a consistent copy couldn't be made.
+**/
+bool CANJaguarServer :: GetJagCachedPosition ( CAN_ID ID, float * Position, double * Timestamp )
+{
+
+	for ( uint32_t Attempt = 0; Attempt < 16; Attempt ++ )
+	{
+
+		uint32_t Sequence = TelemetryLock.BeginRead ();
+
+		uint32_t Count = TelemetryCount;
+		bool Found = false;
+
+		CANJagTelemetryInfo Entry;
+
+		for ( uint32_t i = 0; i < Count && i < CANJAGSERVER_TELEMETRY_MAX; i ++ )
+		{
+
+			if ( Telemetry [ i ].ID == ID )
+			{
+
+				Entry = Telemetry [ i ];
+				Found = true;
+
+				break;
+
+			}
+
+		}
+
+		if ( TelemetryLock.EndRead ( Sequence ) )
+		{
+
+			// A Jaguar the server doesn't have is in the sweep, but was never read.
+			if ( ! Found || Entry.Timestamp == 0 )
+				return false;
+
+			* Position = Entry.Position;
+
+			if ( Timestamp != NULL )
+				* Timestamp = Entry.Timestamp;
+
+			return true;
+
+		}
+
+	}
+
+	return false;
+
+};
+
+/**
+* Get several jaguars' positions from the same telemetry sweep, without waiting on the server thread.
+*
+* @param IDs The CAN ids of the Jaguars.
+* @param Count Number of Jaguars.
+* @param Positions Set to the cached positions, in the order of IDs.
+* @param Timestamp Set to the time the sweep finished.
+* @return False if any of the Jaguars isn't in the cache, or a consistent copy couldn't be made.
+**/
+bool CANJaguarServer :: GetJagCachedPositions ( const CAN_ID * IDs, uint32_t Count, float * Positions, double * Timestamp )
+{
+
+	for ( uint32_t Attempt = 0; Attempt < 16; Attempt ++ )
+	{
+
+		uint32_t Sequence = TelemetryLock.BeginRead ();
+
+		uint32_t Cached = TelemetryCount;
+		double SweepTimestamp = TelemetryTimestamp;
+
+		bool Found = true;
+
+		for ( uint32_t i = 0; i < Count && Found; i ++ )
+		{
+
+			Found = false;
+
+			for ( uint32_t j = 0; j < Cached && j < CANJAGSERVER_TELEMETRY_MAX; j ++ )
+			{
+
+				if ( Telemetry [ j ].ID == IDs [ i ] )
+				{
+
+					Positions [ i ] = Telemetry [ j ].Position;
+					Found = ( Telemetry [ j ].Timestamp != 0 );
+
+					break;
+
+				}
+
+			}
+
+		}
+
+		if ( TelemetryLock.EndRead ( Sequence ) )
+		{
+
+			if ( ! Found )
+				return false;
+
+			if ( Timestamp != NULL )
+				* Timestamp = SweepTimestamp;
+
+			return true;
+
+		}
+
+	}
+
+	return false;
+
+};
+
 /**
 * Get the jaguar's position
 *
@@ -870,6 +1015,42 @@ void CANJaguarServer :: RemoveJag ( CAN_ID ID )
 
 };
 
+/**
+* Start caching a Jaguar's position. ( See SetTelemetryInterval )
+*
+* Each call needs a matching RemoveJagTelemetry, so several users can share a Jaguar.
+*
+* @param ID Controller ID on the CAN-Bus.
+*/
+void CANJaguarServer :: AddJagTelemetry ( CAN_ID ID )
+{
+
+	CANJagServerMessage * Message = new CANJagServerMessage ();
+	
+	Message -> Command = SEND_MESSAGE_JAG_ADD_TELEMETRY;
+	Message -> Data = static_cast <uint32_t> ( ID );
+
+	SendError = ( msgQSend ( MessageSendQueue, reinterpret_cast <char *> ( & Message ), sizeof ( CANJagServerMessage * ), CommandWait, MSG_PRI_NORMAL ) == ERROR );
+
+};
+
+/**
+* Stop caching a Jaguar's position, once every user that added it has removed it.
+*
+* @param ID Controller ID on the CAN-Bus.
+*/
+void CANJaguarServer :: RemoveJagTelemetry ( CAN_ID ID )
+{
+
+	CANJagServerMessage * Message = new CANJagServerMessage ();
+	
+	Message -> Command = SEND_MESSAGE_JAG_REMOVE_TELEMETRY;
+	Message -> Data = static_cast <uint32_t> ( ID );
+
+	SendError = ( msgQSend ( MessageSendQueue, reinterpret_cast <char *> ( & Message ), sizeof ( CANJagServerMessage * ), CommandWait, MSG_PRI_NORMAL ) == ERROR );
+
+};
+
 void CANJaguarServer :: RunLoop ()
 {
 
@@ -882,18 +1063,44 @@ void CANJaguarServer :: RunLoop ()
 	uint32_t JagLoopCounter = 0;
 	CANJagServerMessage * Message;
 
-	// Possibly used case independant variables.
+	// Possibly used case independant variables. Declared here, since a case label can't jump past an initialization.
 	CAN_ID ID;
 	bool Conflict = false;
 	CANJagServerMessage * SendMessage;
 
+	EnableCANJagMessage * EJMessage;
+	SetCANJagMessage * SJMessage;
+	AddCANJagMessage * AJMessage;
+	ConfigCANJagMessage * CJMessage;
+	uint8_t Group;
+
 	double PreJagCheckTime = Timer :: GetPPCTimestamp () - JagCheckInterval;
 	double PreCANCheckTime = Timer :: GetPPCTimestamp () - CANUpdateInterval;
+	double PreTelemetryTime = Timer :: GetPPCTimestamp ();
 
 	while ( true )
 	{
 
-		if ( msgQReceive ( MessageSendQueue, reinterpret_cast <char *> ( & Message ), sizeof ( CANJagServerMessage * ), ParseWait ) != ERROR )
+		int ReceiveWait = ParseWait;
+
+		// Don't sit waiting for messages past the next telemetry read.
+		if ( TelemetryInterval > 0 && TelemetryIDCount != 0 )
+		{
+
+			double TelemetryRemaining = PreTelemetryTime + TelemetryInterval / TelemetryIDCount - Timer :: GetPPCTimestamp ();
+
+			// Rounded up, so a fraction of a tick left waits a whole tick instead of polling with NO_WAIT until it's up.
+			int TelemetryWait = 0;
+
+			if ( TelemetryRemaining > 0 )
+				TelemetryWait = static_cast <int> ( ceil ( TelemetryRemaining * sysClkRateGet () ) );
+
+			if ( TelemetryWait < ReceiveWait )
+				ReceiveWait = TelemetryWait;
+
+		}
+
+		if ( msgQReceive ( MessageSendQueue, reinterpret_cast <char *> ( & Message ), sizeof ( CANJagServerMessage * ), ReceiveWait ) != ERROR )
 		{
 
 			// CAN-Bus Update speed protection.
@@ -954,11 +1161,29 @@ void CANJaguarServer :: RunLoop ()
 
 						break;
 
+					// Start caching a Jaguar's position
+					case SEND_MESSAGE_JAG_ADD_TELEMETRY:
+
+						AddTelemetryID ( static_cast <CAN_ID> ( Message -> Data ) );
+
+						delete Message;
+
+						break;
+
+					// Stop caching a Jaguar's position
+					case SEND_MESSAGE_JAG_REMOVE_TELEMETRY:
+
+						RemoveTelemetryID ( static_cast <CAN_ID> ( Message -> Data ) );
+
+						delete Message;
+
+						break;
+
 					// Enable Jaguar
 					case SEND_MESSAGE_JAG_ENABLE:
 
 						// Which Jaguar?
-						EnableCANJagMessage * EJMessage = reinterpret_cast <EnableCANJagMessage *> ( Message -> Data );
+						EJMessage = reinterpret_cast <EnableCANJagMessage *> ( Message -> Data );
 
 						if ( EJMessage == NULL )
 						{
@@ -994,7 +1219,7 @@ void CANJaguarServer :: RunLoop ()
 					case SEND_MESSAGE_JAG_SET:
 
 						// Retreive JAG_SET message.
-						SetCANJagMessage * SJMessage = reinterpret_cast <SetCANJagMessage *> ( Message -> Data );
+						SJMessage = reinterpret_cast <SetCANJagMessage *> ( Message -> Data );
 
 						// Garbage data protection.
 						if ( SJMessage == NULL )
@@ -1031,7 +1256,7 @@ void CANJaguarServer :: RunLoop ()
 					case SEND_MESSAGE_JAG_ADD:
 
 						// Retreive ADD_JAG Message.
-						AddCANJagMessage * AJMessage = reinterpret_cast <AddCANJagMessage *> ( Message -> Data );
+						AJMessage = reinterpret_cast <AddCANJagMessage *> ( Message -> Data );
 
 						// Garbage protection.
 						if ( AJMessage == NULL )
@@ -1090,7 +1315,7 @@ void CANJaguarServer :: RunLoop ()
 					case SEND_MESSAGE_JAG_CONFIG:
 
 						// Retreive JAG_CONFIG Message.
-						ConfigCANJagMessage * CJMessage = reinterpret_cast <ConfigCANJagMessage *> ( Message -> Data );
+						CJMessage = reinterpret_cast <ConfigCANJagMessage *> ( Message -> Data );
 
 						// Garbage protection.
 						if ( CJMessage == NULL )
@@ -1194,7 +1419,7 @@ void CANJaguarServer :: RunLoop ()
 					// CANJaguar :: UpdateSyncGroup (). (I'm not sure this actually needs to run in the same thread context as the appropriate jags, but this is easier than testing it.)
 					case SEND_MESSAGE_JAG_UPDATE_SYNC_GROUP:
 
-						uint8_t Group = static_cast <uint8_t> ( Message -> Data );
+						Group = static_cast <uint8_t> ( Message -> Data );
 						CANJaguar :: UpdateSyncGroup ( Group );
 
 						delete Message;
@@ -1373,10 +1598,146 @@ void CANJaguarServer :: RunLoop ()
 
 		}
 
+		// Has the required time passed to read the next telemetry position? If so, read it.
+		if ( TelemetryInterval > 0 && TelemetryIDCount != 0 && ( TelemetryInterval / TelemetryIDCount <= CheckTime - PreTelemetryTime ) )
+		{
+
+			PreTelemetryTime = CheckTime;
+
+			UpdateTelemetry ();
+
+		}
+
 	}
 
 };	
 
+// Read the next registered Jaguar's position. Once the sweep is complete, publish it all at once, so readers always
+// see positions from the same sweep and are never held off while the bus is busy.
+void CANJaguarServer :: UpdateTelemetry ()
+{
+
+	if ( TelemetryCursor >= TelemetryIDCount )
+		TelemetryCursor = 0;
+
+	CANJagTelemetryInfo * Entry = & TelemetrySweep [ TelemetryCursor ];
+
+	Entry -> ID = TelemetryIDs [ TelemetryCursor ];
+	Entry -> Timestamp = 0;
+
+	for ( uint32_t i = 0; i < Jags -> GetLength (); i ++ )
+	{
+
+		ServerCANJagInfo JagInfo = ( * Jags ) [ i ];
+
+		if ( JagInfo.ID == Entry -> ID )
+		{
+
+			Entry -> Position = JagInfo.Jag -> GetPosition ();
+			Entry -> Timestamp = Timer :: GetPPCTimestamp ();
+
+			break;
+
+		}
+
+	}
+
+	TelemetryCursor ++;
+
+	if ( TelemetryCursor < TelemetryIDCount )
+		return;
+
+	TelemetryCursor = 0;
+
+	// Only the server task writes the cache.
+	TelemetryLock.BeginWrite ();
+
+	for ( uint32_t i = 0; i < TelemetryIDCount; i ++ )
+		Telemetry [ i ] = TelemetrySweep [ i ];
+
+	TelemetryCount = TelemetryIDCount;
+	TelemetryTimestamp = Timer :: GetPPCTimestamp ();
+
+	TelemetryLock.EndWrite ();
+
+};
+
+// Register a user of a Jaguar's telemetry. The sweep in progress starts over, since its entries have moved.
+void CANJaguarServer :: AddTelemetryID ( CAN_ID ID )
+{
+
+	for ( uint32_t i = 0; i < TelemetryIDCount; i ++ )
+	{
+
+		if ( TelemetryIDs [ i ] == ID )
+		{
+
+			TelemetryUsers [ i ] ++;
+
+			return;
+
+		}
+
+	}
+
+	if ( TelemetryIDCount >= CANJAGSERVER_TELEMETRY_MAX )
+		return;
+
+	TelemetryIDs [ TelemetryIDCount ] = ID;
+	TelemetryUsers [ TelemetryIDCount ] = 1;
+	TelemetryIDCount ++;
+
+	TelemetryCursor = 0;
+
+};
+
+// Unregister a user of a Jaguar's telemetry, and stop reading it once it has none.
+void CANJaguarServer :: RemoveTelemetryID ( CAN_ID ID )
+{
+
+	for ( uint32_t i = 0; i < TelemetryIDCount; i ++ )
+	{
+
+		if ( TelemetryIDs [ i ] != ID )
+			continue;
+
+		if ( -- TelemetryUsers [ i ] != 0 )
+			return;
+
+		for ( uint32_t j = i + 1; j < TelemetryIDCount; j ++ )
+		{
+
+			TelemetryIDs [ j - 1 ] = TelemetryIDs [ j ];
+			TelemetryUsers [ j - 1 ] = TelemetryUsers [ j ];
+
+		}
+
+		TelemetryIDCount --;
+		TelemetryCursor = 0;
+
+		// Take it out of the published sweep too, so readers don't go on seeing its last position.
+		TelemetryLock.BeginWrite ();
+
+		uint32_t Kept = 0;
+
+		for ( uint32_t j = 0; j < TelemetryCount; j ++ )
+		{
+
+			if ( Telemetry [ j ].ID != ID )
+				Telemetry [ Kept ++ ] = Telemetry [ j ];
+
+		}
+
+		TelemetryCount = Kept;
+
+		TelemetryLock.EndWrite ();
+
+		return;
+
+	}
+
+};
+
 // Server entry point.
 void CANJaguarServer :: _StartServerTask ( CANJaguarServer * Server )
 {
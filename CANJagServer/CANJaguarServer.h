@@ -9,6 +9,7 @@
 #include "WPILib.h"
 #include "src/Util/JaguarUtils.h"
 #include "src/Util/Vector.h"
+#include "src/Util/SequenceLock.h"
 
 #define CANJAGSERVER_PARSE_TIMEOUT_DEFAULT 100
 #define CANJAGSERVER_COMMAND_TIMEOUT_DEFAULT 200
@@ -17,6 +18,8 @@
 
 #define CANJAGSERVER_CANBUS_UPDATEINTERVAL_DEFAULT 0
 
+#define CANJAGSERVER_TELEMETRY_MAX 16
+
 #define CANJAGSERVER_MESSAGEQUEUE_LENGTH 200
 
 #define CANJAGSERVER_PRIORITY 50
@@ -26,6 +29,10 @@ typedef int32_t CAN_ID;
 
 class CANJaguarServer
 {
+
+	// Host check in PIC-Servo/Simulator, which drives telemetry sweeps one read at a time.
+	friend class MecanumOdometryCheck;
+
 public:
 
 	CANJaguarServer ( bool DoBrownOutCHeck = true, double BrownOutCheckInterval = CANJAGSERVER_CHECKINTERVAL_DEFAULT, double CANBusUpdateInterval = CANJAGSERVER_CANBUS_UPDATEINTERVAL_DEFAULT, uint32_t CommandTimeout = CANJAGSERVER_COMMAND_TIMEOUT_DEFAULT, uint32_t ParseTimeout = CANJAGSERVER_PARSE_TIMEOUT_DEFAULT );
@@ -37,6 +44,7 @@ public:
 
 	void SetJagCheckInterval ( double Interval );
 	void SetCANBusUpdateInterval ( double Interval );
+	void SetTelemetryInterval ( double Interval );
 
 	bool Start ();
 	void Stop ();
@@ -54,6 +62,11 @@ public:
 	void SetJag ( CAN_ID ID, float Speed, uint8_t SyncGroup = 0 );
 	float GetJag ( CAN_ID ID );
 	float GetJagPosition ( CAN_ID ID );
+	bool GetJagCachedPosition ( CAN_ID ID, float * Position, double * Timestamp = NULL );
+	bool GetJagCachedPositions ( const CAN_ID * IDs, uint32_t Count, float * Positions, double * Timestamp = NULL );
+
+	void AddJagTelemetry ( CAN_ID ID );
+	void RemoveJagTelemetry ( CAN_ID ID );
 
 	float GetJagBusVoltage ( CAN_ID ID );
 	float GetJagOutputVoltage ( CAN_ID ID );
@@ -81,7 +94,9 @@ public:
 		SEND_MESSAGE_JAG_GET_BUS_VOLTAGE,
 		SEND_MESSAGE_JAG_GET_OUTPUT_VOLTAGE,
 		SEND_MESSAGE_JAG_GET_OUTPUT_CURRENT,
-		SEND_MESSAGE_JAG_GET_POSITION
+		SEND_MESSAGE_JAG_GET_POSITION,
+		SEND_MESSAGE_JAG_ADD_TELEMETRY,
+		SEND_MESSAGE_JAG_REMOVE_TELEMETRY
 
 	};
 
@@ -141,8 +156,21 @@ public:
 	typedef GetCANJagMessage GetCANJagOutputVoltageMessage;
 	typedef GetCANJagMessage GetCANJagOutputCurrentMessage;
 
+	typedef struct CANJagTelemetryInfo
+	{
+
+		CAN_ID ID;
+		float Position;
+		double Timestamp;
+
+	} CANJagTelemetryInfo;
+
 private:
 
+	void UpdateTelemetry ();
+	void AddTelemetryID ( CAN_ID ID );
+	void RemoveTelemetryID ( CAN_ID ID );
+
 	bool Running;
 	bool SendError;
 
@@ -157,6 +185,23 @@ private:
 
 	bool CheckJags;
 
+	// Positions of the registered Jaguars, read by the server task once every TelemetryInterval, so readers never
+	// wait on the CAN bus. One Jaguar is read per pass, and each full sweep is published at once.
+	double TelemetryInterval;
+
+	SequenceLock TelemetryLock;
+	CANJagTelemetryInfo Telemetry [ CANJAGSERVER_TELEMETRY_MAX ];
+	uint32_t TelemetryCount;
+	double TelemetryTimestamp;
+
+	// Only touched by the server task.
+	CAN_ID TelemetryIDs [ CANJAGSERVER_TELEMETRY_MAX ];
+	uint32_t TelemetryUsers [ CANJAGSERVER_TELEMETRY_MAX ];
+	uint32_t TelemetryIDCount;
+
+	CANJagTelemetryInfo TelemetrySweep [ CANJAGSERVER_TELEMETRY_MAX ];
+	uint32_t TelemetryCursor;
+
 	uint32_t ParseWait;
 	uint32_t CommandWait;
 
@@ -0,0 +1,315 @@
+#include "FilterChain.h"
+
+/*
+* Copyright (C) 2014 Liam Taylor
+* FRC Team Sehome Semonsters 2605
+*/
+
+FilterChain :: FilterChain ()
+{
+
+	Length = 0;
+
+};
+
+FilterChain :: ~FilterChain ()
+{
+};
+
+/**
+* Zero inputs within Width of zero, and rescale the rest so full scale is preserved.
+*
+* @param Width Half-width of the deadband. ( 0 to 1 )
+*/
+bool FilterChain :: AddDeadband ( double Width )
+{
+
+	if ( Width < 0 || Width >= 1 )
+		return false;
+
+	return Append ( kDeadband, Width, 0 );
+
+};
+
+/**
+* Limit values to [ Low, High ].
+*/
+bool FilterChain :: AddClamp ( double Low, double High )
+{
+
+	if ( Low > High )
+		return false;
+
+	return Append ( kClamp, Low, High );
+
+};
+
+/**
+* Limit how fast the value may change.
+*
+* @param MaxRate Maximum change per second.
+*/
+bool FilterChain :: AddSlewRate ( double MaxRate )
+{
+
+	if ( MaxRate <= 0 )
+		return false;
+
+	return Append ( kSlewRate, MaxRate, 0 );
+
+};
+
+/**
+* First order low-pass filter.
+*
+* @param TimeConstant Time constant in seconds.
+*/
+bool FilterChain :: AddLowPass ( double TimeConstant )
+{
+
+	if ( TimeConstant < 0 )
+		return false;
+
+	return Append ( kLowPass, TimeConstant, 0 );
+
+};
+
+/**
+* Linear map from one range to another. ( Same mapping as MapFilter. )
+*/
+bool FilterChain :: AddMap ( range_t In, range_t Out )
+{
+
+	if ( In.High == In.Low || Out.High == Out.Low )
+		return false;
+
+	double Mul = ( Out.High - Out.Low ) / ( In.High - In.Low );
+	double Off = In.Low - Out.Low / Mul;
+
+	return Append ( kMap, Off, Mul );
+
+};
+
+/**
+* Linear map of the form ( Value - Offset ) * Multiplier. ( Same mapping as MapFilter. )
+*/
+bool FilterChain :: AddMap ( double Offset, double Multiplier )
+{
+
+	return Append ( kMap, Offset, Multiplier );
+
+};
+
+/**
+* Sign-preserving power curve. ( Same curve as ExponentialFilter. )
+*/
+bool FilterChain :: AddExponential ( double Exponent )
+{
+
+	return Append ( kExponential, Exponent, 0 );
+
+};
+
+void FilterChain :: Clear ()
+{
+
+	Length = 0;
+
+};
+
+uint32_t FilterChain :: GetLength ()
+{
+
+	return Length;
+
+};
+
+/**
+* Copy the chain into a flat stage array and prepare it to be evaluated at a fixed period.
+*
+* @param Out Destination array. Must hold at least FILTERCHAIN_MAX_STAGES stages.
+* @param Period Time in seconds between successive evaluations.
+* @return Number of stages written.
+*/
+uint32_t FilterChain :: Compile ( FilterStage * Out, double Period )
+{
+
+	for ( uint32_t i = 0; i < Length; i ++ )
+		Out [ i ] = Stages [ i ];
+
+	Prepare ( Out, Length, Period );
+	Reset ( Out, Length );
+
+	return Length;
+
+};
+
+/**
+* Recompute the period-dependent coefficients of a compiled chain.
+*/
+void FilterChain :: Prepare ( FilterStage * Stages, uint32_t Length, double Period )
+{
+
+	for ( uint32_t i = 0; i < Length; i ++ )
+	{
+
+		FilterStage * Stage = & Stages [ i ];
+
+		switch ( Stage -> Type )
+		{
+
+		case kDeadband:
+
+			Stage -> CoeffA = Stage -> ParamA;
+			Stage -> CoeffB = 1.0 / ( 1.0 - Stage -> ParamA );
+
+			break;
+
+		case kSlewRate:
+
+			Stage -> CoeffA = Stage -> ParamA * Period;
+			Stage -> CoeffB = 0;
+
+			break;
+
+		case kLowPass:
+
+			Stage -> CoeffA = Period / ( Stage -> ParamA + Period );
+			Stage -> CoeffB = 0;
+
+			break;
+
+		default:
+
+			Stage -> CoeffA = Stage -> ParamA;
+			Stage -> CoeffB = Stage -> ParamB;
+
+			break;
+
+		}
+
+	}
+
+};
+
+/**
+* Clear the memory of slew-rate and low-pass stages.
+*/
+void FilterChain :: Reset ( FilterStage * Stages, uint32_t Length )
+{
+
+	for ( uint32_t i = 0; i < Length; i ++ )
+	{
+
+		Stages [ i ].State = 0;
+		Stages [ i ].Primed = false;
+
+	}
+
+};
+
+double FilterChain :: Evaluate ( FilterStage * Stages, uint32_t Length, double Value )
+{
+
+	for ( uint32_t i = 0; i < Length; i ++ )
+	{
+
+		FilterStage * Stage = & Stages [ i ];
+
+		switch ( Stage -> Type )
+		{
+
+		case kDeadband:
+
+			if ( Value > Stage -> CoeffA )
+				Value = ( Value - Stage -> CoeffA ) * Stage -> CoeffB;
+			else if ( Value < - Stage -> CoeffA )
+				Value = ( Value + Stage -> CoeffA ) * Stage -> CoeffB;
+			else
+				Value = 0;
+
+			break;
+
+		case kClamp:
+
+			if ( Value < Stage -> CoeffA )
+				Value = Stage -> CoeffA;
+			else if ( Value > Stage -> CoeffB )
+				Value = Stage -> CoeffB;
+
+			break;
+
+		case kSlewRate:
+
+			if ( Stage -> Primed )
+			{
+
+				double Delta = Value - Stage -> State;
+
+				if ( Delta > Stage -> CoeffA )
+					Value = Stage -> State + Stage -> CoeffA;
+				else if ( Delta < - Stage -> CoeffA )
+					Value = Stage -> State - Stage -> CoeffA;
+
+			}
+
+			Stage -> State = Value;
+			Stage -> Primed = true;
+
+			break;
+
+		case kLowPass:
+
+			if ( Stage -> Primed )
+				Value = Stage -> State + ( Value - Stage -> State ) * Stage -> CoeffA;
+
+			Stage -> State = Value;
+			Stage -> Primed = true;
+
+			break;
+
+		case kMap:
+
+			Value = ( Value - Stage -> CoeffA ) * Stage -> CoeffB;
+
+			break;
+
+		case kExponential:
+
+			Value = ( Value < 0 ) ? - pow ( - Value, Stage -> CoeffA ) : pow ( Value, Stage -> CoeffA );
+
+			break;
+
+		default:
+
+			break;
+
+		}
+
+	}
+
+	return Value;
+
+};
+
+bool FilterChain :: Append ( uint32_t Type, double ParamA, double ParamB )
+{
+
+	if ( Length >= FILTERCHAIN_MAX_STAGES )
+		return false;
+
+	FilterStage * Stage = & Stages [ Length ];
+
+	Stage -> Type = Type;
+	Stage -> ParamA = ParamA;
+	Stage -> ParamB = ParamB;
+	Stage -> CoeffA = ParamA;
+	Stage -> CoeffB = ParamB;
+	Stage -> State = 0;
+	Stage -> Primed = false;
+
+	Length ++;
+
+	return true;
+
+};
@@ -0,0 +1,87 @@
+#ifndef SHS_2605_FILTER_CHAIN_H
+#define SHS_2605_FILTER_CHAIN_H
+
+/*
+* Copyright (C) 2014 Liam Taylor
+* FRC Team Sehome Semonsters 2605
+*/
+
+#include "src/Math/SHSMath.h"
+
+#include <stdint.h>
+#include <math.h>
+
+#define FILTERCHAIN_MAX_STAGES 8
+
+/*
+* A single compiled stage. Param* hold the values the stage was configured with, Coeff* hold
+* values precomputed for a fixed update period by FilterChain :: Prepare (), and State/Primed
+* hold the per-stage memory of slew-rate and low-pass stages.
+*/
+typedef struct FilterStage
+{
+
+	uint32_t Type;
+
+	double ParamA;
+	double ParamB;
+
+	double CoeffA;
+	double CoeffB;
+
+	double State;
+	bool Primed;
+
+} FilterStage;
+
+/*
+* Builds a chain of shaping stages which is then compiled into a flat FilterStage array.
+* The compiled array is evaluated with a switch per stage, so no virtual calls are made per update.
+*/
+class FilterChain
+{
+public:
+
+	enum StageType
+	{
+
+		kDeadband = 0,
+		kClamp,
+		kSlewRate,
+		kLowPass,
+		kMap,
+		kExponential
+
+	};
+
+	FilterChain ();
+	~FilterChain ();
+
+	bool AddDeadband ( double Width );
+	bool AddClamp ( double Low, double High );
+	bool AddSlewRate ( double MaxRate );
+	bool AddLowPass ( double TimeConstant );
+	bool AddMap ( range_t In, range_t Out );
+	bool AddMap ( double Offset, double Multiplier );
+	bool AddExponential ( double Exponent );
+
+	void Clear ();
+
+	uint32_t GetLength ();
+
+	uint32_t Compile ( FilterStage * Out, double Period );
+
+	static void Prepare ( FilterStage * Stages, uint32_t Length, double Period );
+	static void Reset ( FilterStage * Stages, uint32_t Length );
+	static double Evaluate ( FilterStage * Stages, uint32_t Length, double Value );
+
+private:
+
+	bool Append ( uint32_t Type, double ParamA, double ParamB );
+
+	FilterStage Stages [ FILTERCHAIN_MAX_STAGES ];
+	uint32_t Length;
+
+};
+
+#endif
@@ -1,6 +1,7 @@
 #include "AnalogCANJaguarPipeServer.h"
 
 #include <sysLib.h> 
+#include <memLib.h>
 
 AnalogCANJaguarPipeServer :: AnalogCANJaguarPipeServer ()
 {
@@ -9,7 +10,41 @@ AnalogCANJaguarPipeServer :: AnalogCANJaguarPipeServer ()
 
 	ServerTask = new Task ( "2605_AnalogCANJaguarPipeServer_Task", (FUNCPTR) & _StartServerTask, ANALOGCANJAGSERVERTASK_PRIORITY, ANALOGCANJAGSERVERTASK_STACKSIZE );
 
-	Pipes = new Vector <AnalogCANJaguarPipe> ();
+	Bank = reinterpret_cast <AnalogCANJaguarPipeBank *> ( memalign ( ANALOGCANJAGSERVER_BANK_ALIGNMENT, sizeof ( AnalogCANJaguarPipeBank ) ) );
+	Bank -> Length = 0;
+
+	// Every slot starts out free. Slots are handed out from the top of the free stack, lowest first.
+	for ( uint32_t i = 0; i < ANALOGCANJAGSERVER_MAX_PIPES; i ++ )
+	{
+
+		Bank -> SlotGeneration [ i ] = 1;
+		Bank -> SlotDense [ i ] = 0;
+		Bank -> FreeSlots [ i ] = static_cast <uint16_t> ( ANALOGCANJAGSERVER_MAX_PIPES - 1 - i );
+
+	}
+
+	Bank -> FreeCount = ANALOGCANJAGSERVER_MAX_PIPES;
+
+	for ( uint32_t i = 0; i < ANALOGCANJAGSERVER_SCHEDULE_TICKS; i ++ )
+		Bank -> TickLoad [ i ] = 0;
+
+	SuppressedFrames = 0;
+
+	Statistics.Cycles = 0;
+	Statistics.Overruns = 0;
+	Statistics.LateCycles = 0;
+	Statistics.CommandTime = 0;
+	Statistics.ReadTime = 0;
+	Statistics.WriteTime = 0;
+	Statistics.CycleTime = 0;
+	Statistics.MaxCycleTime = 0;
+
+	for ( uint32_t i = 0; i < ANALOGCANJAGSERVER_MAX_PIPES; i ++ )
+		SlotStatisticsGeneration [ i ] = 0;
+
+	CycleLog = new CycleRecord [ ANALOGCANJAGSERVER_CYCLE_LOG_LENGTH ];
+	CycleLogHead = 0;
+	CycleLogEnabled = false;
 
 };
 
@@ -19,17 +54,29 @@ AnalogCANJaguarPipeServer :: ~AnalogCANJaguarPipeServer ()
 	if ( Running )
 		Stop ();
 
+	for ( uint32_t i = 0; i < Bank -> Length; i ++ )
+	{
+
+		delete Bank -> Pipes [ i ].Jaguar;
+		delete Bank -> Pipes [ i ].InputChannel;
+
+	}
+
+	free ( Bank );
+
+	delete [] CycleLog;
+
 };
 
 bool AnalogCANJaguarPipeServer :: Start ()
 {
 
-	SendMessageQueue = msgQCreate ( ANALOGCANJAGSERVER_MESSAGEQUEUE_LENGTH, sizeof ( ServerMessage * ), MSG_Q_FIFO );
+	SendMessageQueue = msgQCreate ( ANALOGCANJAGSERVER_MESSAGEQUEUE_LENGTH, sizeof ( ServerMessage ), MSG_Q_FIFO );
 
 	if ( SendMessageQueue == NULL )
 		return false;
 
-	ReceiveMessageQueue = msgQCreate ( ANALOGCANJAGSERVER_MESSAGEQUEUE_LENGTH, sizeof ( ServerMessage * ), MSG_Q_FIFO );
+	ReceiveMessageQueue = msgQCreate ( ANALOGCANJAGSERVER_MESSAGEQUEUE_LENGTH, sizeof ( ServerMessage ), MSG_Q_FIFO );
 
 	if ( ReceiveMessageQueue == NULL )
 	{
@@ -111,35 +158,7 @@ void AnalogCANJaguarPipeServer :: Stop ()
 	semGive ( ResponseSemaphore );
 	semGive ( PipesAccessSemaphore );
 
-	bool DeQueueSuccessful = true;
-
-	while ( DeQueueSuccessful )
-	{
-
-		ServerMessage * Message = NULL;
-
-		DeQueueSuccessful = ( msgQReceive ( SendMessageQueue, reinterpret_cast <char *> ( & Message ), sizeof ( ServerMessage * ), 0 ) != ERROR );
-
-		if ( DeQueueSuccessful && Message != NULL )
-		{
-
-			switch ( Message -> Command )
-			{
-
-
-
-				default:
-
-					delete Message;
-
-					break;
-
-			}
-
-		}
-
-	}
-
+	// Queued commands are stored by value in the queues, so deleting the queues is all the cleanup they need.
 	msgQDelete ( SendMessageQueue );
 	msgQDelete ( ReceiveMessageQueue );
 	semDelete ( PipesAccessSemaphore );
@@ -164,113 +183,396 @@ bool AnalogCANJaguarPipeServer :: IsRunning ()
 void AnalogCANJaguarPipeServer :: DisablePipe ( AnalogCANJaguarPipe_t Pipe )
 {
 
-	ServerMessage * SendMessage = new ServerMessage ();
+	ServerMessage Message;
 
-	SendMessage -> Command = COMMAND_DISABLE_PIPE;
-	SendMessage -> Data = static_cast <uint32_t> ( Pipe );
+	Message.Command = COMMAND_DISABLE_PIPE;
+	Message.Pipe = Pipe;
 
-	msgQSend ( SendMessageQueue, reinterpret_cast <char *> ( & SendMessage ), sizeof ( ServerMessage * ), WAIT_FOREVER, MSG_PRI_URGENT );
+	SendCommand ( Message );
 
 };
 
 void AnalogCANJaguarPipeServer :: EnablePipe ( AnalogCANJaguarPipe_t Pipe )
 {
 
-	ServerMessage * SendMessage = new ServerMessage ();
+	ServerMessage Message;
 
-	SendMessage -> Command = COMMAND_ENABLE_PIPE;
-	SendMessage -> Data = static_cast <uint32_t> ( Pipe );
+	Message.Command = COMMAND_ENABLE_PIPE;
+	Message.Pipe = Pipe;
 
-	msgQSend ( SendMessageQueue, reinterpret_cast <char *> ( & SendMessage ), sizeof ( ServerMessage * ), WAIT_FOREVER, MSG_PRI_URGENT );
+	SendCommand ( Message );
 
 };
 
 AnalogCANJaguarPipe_t AnalogCANJaguarPipeServer :: AddPipe ( CAN_ID JaguarID, uint8_t Channel, uint8_t Module )
 {
 
+	ServerMessage Message;
+
+	Message.Command = COMMAND_ADD_PIPE;
+	Message.Pipe = ANALOGCANJAGSERVER_INVALID_PIPE;
+	Message.Data.AddPipe.JaguarID = JaguarID;
+	Message.Data.AddPipe.Channel = Channel;
+	Message.Data.AddPipe.Module = Module;
+
 	semTake ( ResponseSemaphore, WAIT_FOREVER );
 
-	ServerMessage * SendMessage = new ServerMessage ();
+	SendCommand ( Message );
 
-	AddPipeMessage * APMessage = new AddPipeMessage ();
+	ServerMessage Response;
+	Response.Pipe = ANALOGCANJAGSERVER_INVALID_PIPE;
 
-	APMessage -> JaguarID = JaguarID;
-	APMessage -> Channel = Channel;
-	APMessage -> Module = Module;
+	msgQReceive ( ReceiveMessageQueue, reinterpret_cast <char *> ( & Response ), sizeof ( ServerMessage ), WAIT_FOREVER );
 
-	SendMessage -> Command = COMMAND_ADD_PIPE;
-	SendMessage -> Data = reinterpret_cast <uint32_t> ( APMessage );
+	semGive ( ResponseSemaphore );
 
-	msgQSend ( SendMessageQueue, reinterpret_cast <char *> ( & SendMessage ), sizeof ( ServerMessage * ), WAIT_FOREVER, MSG_PRI_URGENT );
+	return Response.Pipe;
 
-	ServerMessage * ResponseMessage = NULL;
-	msgQReceive ( ReceiveMessageQueue, reinterpret_cast <char *> ( & ResponseMessage ), sizeof ( ServerMessage * ), WAIT_FOREVER );
+};
 
-	semGive ( ResponseSemaphore );
+void AnalogCANJaguarPipeServer :: RemovePipe ( AnalogCANJaguarPipe_t Pipe )
+{
 
-	AnalogCANJaguarPipe_t PipeIndex = static_cast <AnalogCANJaguarPipe_t> ( reinterpret_cast <uint32_t> ( ResponseMessage -> Data ) );
+	ServerMessage Message;
 
-	delete ResponseMessage;
+	Message.Command = COMMAND_REMOVE_PIPE;
+	Message.Pipe = Pipe;
 
-	return PipeIndex;
+	SendCommand ( Message );
 
 };
 
-void AnalogCANJaguarPipeServer :: RemovePipe ( AnalogCANJaguarPipe_t Pipe )
+void AnalogCANJaguarPipeServer :: SetPipeInverted ( AnalogCANJaguarPipe_t Pipe, bool Inverted )
 {
 
-	ServerMessage * SendMessage = new ServerMessage ();
+	ServerMessage Message;
 
-	SendMessage -> Command = COMMAND_REMOVE_PIPE;
-	SendMessage -> Data = static_cast <uint32_t> ( Pipe );
+	Message.Command = COMMAND_SET_PIPE_INVERTED;
+	Message.Pipe = Pipe;
+	Message.Data.Inverted = Inverted;
 
-	msgQSend ( SendMessageQueue, reinterpret_cast <char *> ( & SendMessage ), sizeof ( ServerMessage * ), WAIT_FOREVER, MSG_PRI_URGENT );
+	SendCommand ( Message );
 
 };
 
-void AnalogCANJaguarPipeServer :: SetPipeInverted ( AnalogCANJaguarPipe_t Pipe, bool Inverted )
+void AnalogCANJaguarPipeServer :: SetPipeOffset ( AnalogCANJaguarPipe_t Pipe, double Offset )
+{
+
+	ServerMessage Message;
+
+	Message.Command = COMMAND_SET_PIPE_OFFSET;
+	Message.Pipe = Pipe;
+	Message.Data.Offset = Offset;
+
+	SendCommand ( Message );
+
+};
+
+void AnalogCANJaguarPipeServer :: ZeroPipe ( AnalogCANJaguarPipe_t Pipe )
 {
 
-	ServerMessage * SendMessage = new ServerMessage ();
+	ServerMessage Message;
 
-	SetPipeInvertedMessage * SIMessage = new SetPipeInvertedMessage ();
+	Message.Command = COMMAND_ZERO_PIPE;
+	Message.Pipe = Pipe;
 
-	SIMessage -> Pipe = Pipe;
-	SIMessage -> Inverted = Inverted;
+	SendCommand ( Message );
 
-	SendMessage -> Command = COMMAND_SET_PIPE_INVERTED;
-	SendMessage -> Data = reinterpret_cast <uint32_t> ( SIMessage );
+};
 
-	msgQSend ( SendMessageQueue, reinterpret_cast <char *> ( & SendMessage ), sizeof ( ServerMessage * ), WAIT_FOREVER, MSG_PRI_URGENT );
+void AnalogCANJaguarPipeServer :: SetPipeTransfer ( AnalogCANJaguarPipe_t Pipe, FilterChain * Chain )
+{
+
+	ServerMessage Message;
+
+	Message.Command = COMMAND_SET_PIPE_TRANSFER;
+	Message.Pipe = Pipe;
+	Message.Data.Transfer.Length = ( Chain != NULL ) ? Chain -> Compile ( Message.Data.Transfer.Stages, LOOP_ITERATION_TIME ) : 0;
+
+	SendCommand ( Message );
 
 };
 
-void AnalogCANJaguarPipeServer :: SetPipeOffset ( AnalogCANJaguarPipe_t Pipe, double Offset )
+void AnalogCANJaguarPipeServer :: SetPipeGating ( AnalogCANJaguarPipe_t Pipe, double Epsilon, double KeepaliveInterval )
+{
+
+	ServerMessage Message;
+
+	Message.Command = COMMAND_SET_PIPE_GATING;
+	Message.Pipe = Pipe;
+	Message.Data.Gating.Epsilon = Epsilon;
+	Message.Data.Gating.Keepalive = KeepaliveInterval;
+
+	SendCommand ( Message );
+
+};
+
+bool AnalogCANJaguarPipeServer :: GetPipeFrameCounts ( AnalogCANJaguarPipe_t Pipe, uint32_t * Sent, uint32_t * Suppressed )
 {
 
-	ServerMessage * SendMessage = new ServerMessage ();
+	bool Found = false;
 
-	SetPipeOffsetMessage * SOMessage = new SetPipeOffsetMessage ();
+	semTake ( PipesAccessSemaphore, WAIT_FOREVER );
 
-	SOMessage -> Pipe = Pipe;
-	SOMessage -> Offset = Offset;
+	uint32_t PipeIndex = ResolvePipe ( Pipe );
 
-	SendMessage -> Command = COMMAND_SET_PIPE_OFFSET;
-	SendMessage -> Data = reinterpret_cast <uint32_t> ( SOMessage );
+	if ( PipeIndex != ANALOGCANJAGSERVER_INVALID_PIPE )
+	{
+
+		* Sent = Bank -> Pipes [ PipeIndex ].FramesSent;
+		* Suppressed = Bank -> Pipes [ PipeIndex ].FramesSuppressed;
+
+		Found = true;
 
-	msgQSend ( SendMessageQueue, reinterpret_cast <char *> ( & SendMessage ), sizeof ( ServerMessage * ), WAIT_FOREVER, MSG_PRI_URGENT );
+	}
+
+	semGive ( PipesAccessSemaphore );
+
+	return Found;
 
 };
 
-void AnalogCANJaguarPipeServer :: ZeroPipe ( AnalogCANJaguarPipe_t Pipe )
+uint32_t AnalogCANJaguarPipeServer :: GetSuppressedFrameCount ()
+{
+
+	return SuppressedFrames;
+
+};
+
+/**
+* Set how often a pipe runs.
+*
+* @param Pipe Pipe handle.
+* @param Ticks Period in base ticks of LOOP_ITERATION_TIME. Rounded up to a power of two, and limited to ANALOGCANJAGSERVER_SCHEDULE_TICKS.
+*/
+void AnalogCANJaguarPipeServer :: SetPipePeriod ( AnalogCANJaguarPipe_t Pipe, uint32_t Ticks )
+{
+
+	uint32_t Period = 1;
+
+	while ( Period < Ticks && Period < ANALOGCANJAGSERVER_SCHEDULE_TICKS )
+		Period <<= 1;
+
+	ServerMessage Message;
+
+	Message.Command = COMMAND_SET_PIPE_PERIOD;
+	Message.Pipe = Pipe;
+	Message.Data.Period = Period;
+
+	SendCommand ( Message );
+
+};
+
+/**
+* Oversample a pipe's analog input.
+*
+* Hardware averaging costs nothing per cycle and adds about 2^AverageBits module samples of delay. The software ring
+* averages the last RingSamples base ticks, which removes more noise but delays the input by ( RingSamples - 1 ) / 2 ticks.
+*
+* @param Pipe Pipe handle.
+* @param AverageBits Averaging engine bits for the channel. ( 0 reads the channel directly. )
+* @param RingSamples Number of base-tick samples to average. ( 1 disables the ring. )
+*/
+void AnalogCANJaguarPipeServer :: SetPipeOversampling ( AnalogCANJaguarPipe_t Pipe, uint32_t AverageBits, uint32_t RingSamples )
+{
+
+	if ( RingSamples < 1 )
+		RingSamples = 1;
+
+	if ( RingSamples > ANALOGCANJAGSERVER_MAX_RING_SAMPLES )
+		RingSamples = ANALOGCANJAGSERVER_MAX_RING_SAMPLES;
+
+	ServerMessage Message;
+
+	Message.Command = COMMAND_SET_PIPE_OVERSAMPLING;
+	Message.Pipe = Pipe;
+	Message.Data.Oversampling.AverageBits = AverageBits;
+	Message.Data.Oversampling.RingSamples = RingSamples;
+
+	SendCommand ( Message );
+
+};
+
+/**
+* Give a pipe another's settings, for replacing a pipe's Jaguar or input without setting it up again.
+*
+* The inversion, transfer chain and its state, gating, period and oversampling are copied. The offset isn't, since
+* it calibrates the input it was set for, so the new pipe keeps its default until it's set or zeroed. The enable state
+* isn't either.
+*
+* @param From Pipe to copy from. Nothing happens if it has been removed.
+* @param To Pipe to copy to.
+*/
+void AnalogCANJaguarPipeServer :: CopyPipeSettings ( AnalogCANJaguarPipe_t From, AnalogCANJaguarPipe_t To )
 {
 
-	ServerMessage * SendMessage = new ServerMessage ();
+	ServerMessage Message;
 
-	SendMessage -> Command = COMMAND_ZERO_PIPE;
-	SendMessage -> Data = static_cast <uint32_t> ( Pipe );
+	Message.Command = COMMAND_COPY_PIPE_SETTINGS;
+	Message.Pipe = To;
+	Message.Data.Source = From;
 
-	msgQSend ( SendMessageQueue, reinterpret_cast <char *> ( & SendMessage ), sizeof ( ServerMessage * ), WAIT_FOREVER, MSG_PRI_URGENT );
+	SendCommand ( Message );
+
+};
+
+/**
+* Number of pipes ( and so CAN frames, at most ) scheduled on a tick of the schedule.
+*/
+uint32_t AnalogCANJaguarPipeServer :: GetTickLoad ( uint32_t Tick )
+{
+
+	semTake ( PipesAccessSemaphore, WAIT_FOREVER );
+
+	uint32_t Load = Bank -> TickLoad [ Tick % ANALOGCANJAGSERVER_SCHEDULE_TICKS ];
+
+	semGive ( PipesAccessSemaphore );
+
+	return Load;
+
+};
+
+/**
+* Largest number of pipes scheduled on any one tick.
+*/
+uint32_t AnalogCANJaguarPipeServer :: GetPeakTickLoad ()
+{
+
+	uint32_t Peak = 0;
+
+	semTake ( PipesAccessSemaphore, WAIT_FOREVER );
+
+	for ( uint32_t i = 0; i < ANALOGCANJAGSERVER_SCHEDULE_TICKS; i ++ )
+		if ( Bank -> TickLoad [ i ] > Peak )
+			Peak = Bank -> TickLoad [ i ];
+
+	semGive ( PipesAccessSemaphore );
+
+	return Peak;
+
+};
+
+/**
+* Average number of frames per second the current schedule can send.
+*/
+double AnalogCANJaguarPipeServer :: GetScheduledFrameRate ()
+{
+
+	uint32_t Total = 0;
+
+	semTake ( PipesAccessSemaphore, WAIT_FOREVER );
+
+	for ( uint32_t i = 0; i < ANALOGCANJAGSERVER_SCHEDULE_TICKS; i ++ )
+		Total += Bank -> TickLoad [ i ];
+
+	semGive ( PipesAccessSemaphore );
+
+	return static_cast <double> ( Total ) / ( ANALOGCANJAGSERVER_SCHEDULE_TICKS * LOOP_ITERATION_TIME );
+
+};
+
+/**
+* Copy out the server's cycle statistics. Never blocks the server task.
+*
+* @return Whether a consistent copy was read. ( Only fails if the server task is stuck mid-update. )
+*/
+bool AnalogCANJaguarPipeServer :: GetStatistics ( ServerStatistics * Out )
+{
+
+	for ( uint32_t Attempt = 0; Attempt < 16; Attempt ++ )
+	{
+
+		uint32_t Sequence = StatisticsLock.BeginRead ();
+
+		* Out = Statistics;
+
+		if ( StatisticsLock.EndRead ( Sequence ) )
+			return true;
+
+	}
+
+	return false;
+
+};
+
+/**
+* Copy out a pipe's last input, output and write latency as of the last cycle. Never blocks the server task.
+*
+* @return Whether the handle is live and a consistent copy was read.
+*/
+bool AnalogCANJaguarPipeServer :: GetPipeStatistics ( AnalogCANJaguarPipe_t Pipe, PipeStatistics * Out )
+{
+
+	uint32_t Slot = Pipe & 0xFFFF;
+
+	if ( Slot >= ANALOGCANJAGSERVER_MAX_PIPES )
+		return false;
+
+	for ( uint32_t Attempt = 0; Attempt < 16; Attempt ++ )
+	{
+
+		uint32_t Sequence = StatisticsLock.BeginRead ();
+
+		* Out = SlotStatistics [ Slot ];
+		uint16_t Generation = SlotStatisticsGeneration [ Slot ];
+
+		if ( StatisticsLock.EndRead ( Sequence ) )
+			return ( Generation == ( Pipe >> 16 ) );
+
+	}
+
+	return false;
+
+};
+
+/**
+* Record a CycleRecord for every cycle in a ring of the last ANALOGCANJAGSERVER_CYCLE_LOG_LENGTH cycles.
+*/
+void AnalogCANJaguarPipeServer :: SetCycleLogEnabled ( bool Enabled )
+{
+
+	CycleLogEnabled = Enabled;
+
+};
+
+/**
+* Copy out the most recent cycle log records, oldest first. Never blocks the server task.
+*
+* @return Number of records copied.
+*/
+uint32_t AnalogCANJaguarPipeServer :: ReadCycleLog ( CycleRecord * Records, uint32_t MaxRecords )
+{
+
+	uint32_t Head = CycleLogHead;
+	SEQUENCELOCK_BARRIER ();
+
+	uint32_t Count = ( Head < ANALOGCANJAGSERVER_CYCLE_LOG_LENGTH ) ? Head : ANALOGCANJAGSERVER_CYCLE_LOG_LENGTH;
+
+	if ( Count > MaxRecords )
+		Count = MaxRecords;
+
+	for ( uint32_t i = 0; i < Count; i ++ )
+		Records [ i ] = CycleLog [ ( Head - Count + i ) % ANALOGCANJAGSERVER_CYCLE_LOG_LENGTH ];
+
+	SEQUENCELOCK_BARRIER ();
+
+	// Anything the server task wrote while we were copying may have lapped the ring onto the oldest records we took.
+	uint32_t Advanced = CycleLogHead - Head;
+	uint32_t Spare = ANALOGCANJAGSERVER_CYCLE_LOG_LENGTH - Count;
+	uint32_t Overwritten = ( Advanced > Spare ) ? ( Advanced - Spare ) : 0;
+
+	if ( Overwritten >= Count )
+		return 0;
+
+	if ( Overwritten != 0 )
+	{
+
+		for ( uint32_t i = 0; i + Overwritten < Count; i ++ )
+			Records [ i ] = Records [ i + Overwritten ];
+
+	}
+
+	return Count - Overwritten;
 
 };
 
@@ -279,215 +581,645 @@ void AnalogCANJaguarPipeServer :: RunLoop ()
 
 	double sysClkRate = static_cast <double> ( sysClkRateGet () );
 
+	uint32_t Tick = 0;
+
 	while ( true )
 	{
 
 		double LoopInitialTime = Timer :: GetPPCTimestamp ();
 		double LoopTimeElapsed = 0.0;
 
-		uint32_t PipeIndex;
+		ServerStatistics Cycle;
+
+		Cycle.CommandTime = 0;
+
+		uint32_t FramesSent = 0;
+		uint32_t FramesSuppressed = 0;
 
 		while ( LoopTimeElapsed < LOOP_ITERATION_TIME )
 		{
 
-			ServerMessage * Message = NULL;
+			ServerMessage Message;
 
-			if ( msgQReceive ( SendMessageQueue, reinterpret_cast <char *> ( & Message ), sizeof ( ServerMessage * ), static_cast <int> ( ( LOOP_ITERATION_TIME - LoopTimeElapsed ) * sysClkRate ) ) != ERROR )
+			int Timeout = static_cast <int> ( ( LOOP_ITERATION_TIME - LoopTimeElapsed ) * sysClkRate );
+
+			if ( msgQReceive ( SendMessageQueue, reinterpret_cast <char *> ( & Message ), sizeof ( ServerMessage ), Timeout ) != ERROR )
 			{
 
-				switch ( Message -> Command )
-				{
+				double CommandStartTime = Timer :: GetPPCTimestamp ();
 
-				case COMMAND_NOP:
+				HandleCommand ( Message );
 
-					delete Message;
+				Cycle.CommandTime += Timer :: GetPPCTimestamp () - CommandStartTime;
 
-					break;
+			}
+			else if ( Timeout == 0 )
+			{
 
-				case COMMAND_DISABLE_PIPE:
+				// Less than a clock tick left, so the receive didn't block. Sleep out the rest of the cycle instead of spinning.
+				Wait ( LOOP_ITERATION_TIME - LoopTimeElapsed );
 
-					semTake ( PipesAccessSemaphore, WAIT_FOREVER );
+			}
 
-					PipeIndex = reinterpret_cast <uint32_t> ( Message -> Data );
+			LoopTimeElapsed = Timer :: GetPPCTimestamp () - LoopInitialTime;
 
-					if ( PipeIndex + 1 <= Pipes -> GetLength () )
-					{
+		}
 
-						( * Pipes ) [ PipeIndex ].Enabled = false;
-						( * Pipes ) [ PipeIndex ].Jaguar -> DisableControl ();
+		semTake ( PipesAccessSemaphore, WAIT_FOREVER ); 
 
-					}
+		double ReadStartTime = Timer :: GetPPCTimestamp ();
 
-					semGive ( PipesAccessSemaphore );
+		SampleInputs ( Tick );
 
-					break;
+		TransformInputs ( Bank -> Voltage, Bank -> Offset, Bank -> Sign, Bank -> Scale, Bank -> Output, Bank -> Length );
 
-				case COMMAND_ENABLE_PIPE:
+		double SendTime = Timer :: GetPPCTimestamp ();
 
-					semTake ( PipesAccessSemaphore, WAIT_FOREVER );
+		Cycle.ReadTime = SendTime - ReadStartTime;
 
-					PipeIndex = reinterpret_cast <uint32_t> ( Message -> Data );
+		for ( uint32_t i = 0; i < Bank -> Length; i ++ )
+		{
 
-					if ( PipeIndex + 1 <= Pipes -> GetLength () )
-					{
+			if ( ! Bank -> Due [ i ] )
+				continue;
 
-						( * Pipes ) [ PipeIndex ].Jaguar -> EnableControl ();
-						( * Pipes ) [ PipeIndex ].Enabled = true;
-					
-					}
+			AnalogCANJaguarPipe & Pipe = Bank -> Pipes [ i ];
 
-					semGive ( PipesAccessSemaphore );
+			double in_inverted = Bank -> Output [ i ];
 
-					break;
+			// Transfer stages work on the normalized ( -1 to 1 ) value, before it's scaled to the Jaguar.
+			if ( Pipe.TransferLength != 0 )
+				in_inverted = FilterChain :: Evaluate ( Pipe.Transfer, Pipe.TransferLength, in_inverted );
 
-				case COMMAND_ADD_PIPE:
+			double out = in_inverted * JAGSCALE;
 
-					AddPipeMessage * APMessage = reinterpret_cast <AddPipeMessage *> ( Message -> Data );
+			Pipe.LastOutput = out;
 
-					AnalogCANJaguarPipe NewPipe;
+			if ( ! Bank -> Enabled [ i ] )
+				continue;
 
-					NewPipe.JaguarID = APMessage -> JaguarID;
-					NewPipe.Channel = APMessage -> Channel;
-					NewPipe.Module = APMessage -> Module;
+			// Every Set is a CAN frame, so skip it unless the output has actually moved or the keepalive is due.
+			double Change = out - Pipe.LastSent;
 
-					printf ( "ADD PIPE: CAN_ID: %i, Analog Channel: %i\n", NewPipe.JaguarID, NewPipe.Channel );
+			if ( Pipe.ForceSend || Change > Pipe.GateEpsilon || Change < - Pipe.GateEpsilon || SendTime - Pipe.LastSendTime >= Pipe.GateKeepalive )
+			{
 
-					NewPipe.Jaguar = new CANJaguar ( static_cast <uint8_t> ( NewPipe.JaguarID ), JAGCONTROLMODE );
-					NewPipe.Jaguar -> DisableControl ();
+				double WriteStartTime = Timer :: GetPPCTimestamp ();
 
-					NewPipe.InputChannel = new AnalogChannel ( NewPipe.Module, NewPipe.Channel );
+				Pipe.Jaguar -> Set ( out );
 
-					NewPipe.Offset = 2.5;
-					NewPipe.Inverted = false;
-					NewPipe.Enabled = false;
+				Pipe.WriteLatency = Timer :: GetPPCTimestamp () - WriteStartTime;
 
-					semTake ( PipesAccessSemaphore, WAIT_FOREVER );
+				Pipe.LastSent = out;
+				Pipe.LastSendTime = SendTime;
+				Pipe.ForceSend = false;
+				Pipe.FramesSent ++;
 
-					Pipes -> Push ( NewPipe );
+				FramesSent ++;
 
-					ServerMessage * ResponseMessage = new ServerMessage ();
+			}
+			else
+			{
 
-					ResponseMessage -> Command = COMMAND_ADD_PIPE;
-					ResponseMessage -> Data = static_cast <uint32_t> ( Pipes -> GetLength () - 1 );
+				Pipe.FramesSuppressed ++;
+				SuppressedFrames ++;
 
-					semGive ( PipesAccessSemaphore );
+				FramesSuppressed ++;
 
-					msgQSend ( ReceiveMessageQueue, reinterpret_cast <char *> ( & ResponseMessage ), sizeof ( ServerMessage * ), WAIT_FOREVER, MSG_PRI_URGENT );
+			}
 
-					delete APMessage;
-					delete Message;
+		}
 
-					break;
+		double LoopEndTime = Timer :: GetPPCTimestamp ();
 
-				case COMMAND_REMOVE_PIPE:
+		Cycle.WriteTime = LoopEndTime - SendTime;
+		Cycle.CycleTime = LoopEndTime - LoopInitialTime;
 
-					PipeIndex = reinterpret_cast <uint32_t> ( Message -> Data );
+		PublishStatistics ( Cycle, FramesSent, FramesSuppressed );
 
-					if ( PipeIndex + 1 <= Pipes -> GetLength () )
-					{
+		semGive ( PipesAccessSemaphore );
 
-						semTake ( PipesAccessSemaphore, WAIT_FOREVER );
+		Tick ++;
 
-						AnalogCANJaguarPipe PipeToKill = ( * Pipes ) [ PipeIndex ];
+	}
 
-						delete PipeToKill.Jaguar;
-						delete PipeToKill.InputChannel;
+};
 
-						Pipes -> Remove ( PipeIndex, 1 );
+// Queue a command for the server task. The message is copied into the queue, so nothing is allocated. Commands go on
+// the back of the queue so they're carried out in the order they were sent; MSG_PRI_URGENT would put each one at the
+// head, and a copy sent just before a removal would find its source gone.
+void AnalogCANJaguarPipeServer :: SendCommand ( ServerMessage & Message )
+{
 
-						semGive ( PipesAccessSemaphore );
+	msgQSend ( SendMessageQueue, reinterpret_cast <char *> ( & Message ), sizeof ( ServerMessage ), WAIT_FOREVER, MSG_PRI_NORMAL );
 
-					}
+};
 
-					delete Message;
+// Carry out one queued command on the server task.
+void AnalogCANJaguarPipeServer :: HandleCommand ( ServerMessage & Message )
+{
 
-					break;
+	if ( Message.Command == COMMAND_NOP )
+		return;
 
-				case COMMAND_SET_PIPE_INVERTED:
+	if ( Message.Command == COMMAND_ADD_PIPE )
+	{
 
-					SetPipeInvertedMessage * SIMessage = reinterpret_cast <SetPipeInvertedMessage *> ( Message -> Data );
+		AnalogCANJaguarPipe NewPipe;
 
-					semTake ( PipesAccessSemaphore, WAIT_FOREVER );
+		NewPipe.JaguarID = Message.Data.AddPipe.JaguarID;
+		NewPipe.Channel = Message.Data.AddPipe.Channel;
+		NewPipe.Module = Message.Data.AddPipe.Module;
 
-					PipeIndex = SIMessage -> Pipe;
+		NewPipe.Jaguar = new CANJaguar ( static_cast <uint8_t> ( NewPipe.JaguarID ), JAGCONTROLMODE );
+		NewPipe.Jaguar -> DisableControl ();
 
-					if ( PipeIndex + 1 <= Pipes -> GetLength () )
-						( * Pipes ) [ PipeIndex ].Inverted = SIMessage -> Inverted;
+		NewPipe.InputChannel = new AnalogChannel ( NewPipe.Module, NewPipe.Channel );
 
-					semGive ( PipesAccessSemaphore );
+		NewPipe.TransferLength = 0;
 
-					delete SIMessage;
-					delete Message;
+		NewPipe.GateEpsilon = ANALOGCANJAGSERVER_GATE_EPSILON_DEFAULT;
+		NewPipe.GateKeepalive = ANALOGCANJAGSERVER_GATE_KEEPALIVE_DEFAULT;
+		NewPipe.LastSent = 0;
+		NewPipe.LastSendTime = 0;
+		NewPipe.ForceSend = true;
+		NewPipe.FramesSent = 0;
+		NewPipe.FramesSuppressed = 0;
 
-					break;
+		NewPipe.UseAverage = false;
+		NewPipe.RingSum = 0;
+		NewPipe.RingLength = 1;
+		NewPipe.RingIndex = 0;
+		NewPipe.RingFill = 0;
 
-				case COMMAND_SET_PIPE_OFFSET:
+		NewPipe.LastOutput = 0;
+		NewPipe.WriteLatency = 0;
 
-					SetPipeOffsetMessage * SOMessage = reinterpret_cast <SetPipeOffsetMessage *> ( Message -> Data );
+		semTake ( PipesAccessSemaphore, WAIT_FOREVER );
 
-					semTake ( PipesAccessSemaphore, WAIT_FOREVER );
+		ServerMessage Response;
 
-					PipeIndex = SOMessage -> Pipe;
+		Response.Command = COMMAND_ADD_PIPE;
+		Response.Pipe = PushPipe ( NewPipe );
 
-					if ( PipeIndex + 1 <= Pipes -> GetLength () )
-						( * Pipes ) [ PipeIndex ].Offset = SOMessage -> Offset;
+		semGive ( PipesAccessSemaphore );
 
-					semGive ( PipesAccessSemaphore );
+		msgQSend ( ReceiveMessageQueue, reinterpret_cast <char *> ( & Response ), sizeof ( ServerMessage ), WAIT_FOREVER, MSG_PRI_URGENT );
 
-					delete SOMessage;
-					delete Message;
+		return;
 
-					break;
+	}
 
-				case COMMAND_ZERO_PIPE:
+	semTake ( PipesAccessSemaphore, WAIT_FOREVER );
 
-					semTake ( PipesAccessSemaphore, WAIT_FOREVER );
+	uint32_t PipeIndex = ResolvePipe ( Message.Pipe );
 
-					PipeIndex = static_cast <uint32_t> ( Message -> Data );
+	if ( PipeIndex == ANALOGCANJAGSERVER_INVALID_PIPE )
+	{
 
-					if ( PipeIndex + 1 <= Pipes -> GetLength () )
-						( * Pipes ) [ PipeIndex ].Offset = ( * Pipes ) [ PipeIndex ].InputChannel -> GetVoltage ();
+		semGive ( PipesAccessSemaphore );
 
-					semGive ( PipesAccessSemaphore );
+		return;
+
+	}
 
-					break;
+	AnalogCANJaguarPipe & Pipe = Bank -> Pipes [ PipeIndex ];
 
-				default:
+	switch ( Message.Command )
+	{
 
-					delete Message;
+	case COMMAND_DISABLE_PIPE:
 
-					break;
+		Bank -> Enabled [ PipeIndex ] = 0;
+		Pipe.Jaguar -> DisableControl ();
 
-				}
+		break;
 
-			}
+	case COMMAND_ENABLE_PIPE:
 
-			Wait ( 0.001 );
+		Pipe.Jaguar -> EnableControl ();
+		Pipe.ForceSend = true;
+		Bank -> Enabled [ PipeIndex ] = 1;
 
-			LoopTimeElapsed = Timer :: GetPPCTimestamp () - LoopInitialTime;
+		break;
+
+	case COMMAND_REMOVE_PIPE:
+
+		RemovePipeAt ( PipeIndex );
+
+		break;
+
+	case COMMAND_SET_PIPE_INVERTED:
+
+		Bank -> Sign [ PipeIndex ] = Message.Data.Inverted ? - 1.0 : 1.0;
+
+		break;
+
+	case COMMAND_SET_PIPE_OFFSET:
+
+		Bank -> Offset [ PipeIndex ] = Message.Data.Offset;
+
+		break;
+
+	case COMMAND_ZERO_PIPE:
+
+		// Zero against what the pipe actually feeds forward, so a ringed pipe doesn't pick up one sample's noise.
+		if ( Pipe.RingLength > 1 && Pipe.RingFill != 0 )
+			Bank -> Offset [ PipeIndex ] = Pipe.RingSum / Pipe.RingFill;
+		else
+			Bank -> Offset [ PipeIndex ] = ReadInput ( Pipe );
+
+		break;
+
+	case COMMAND_SET_PIPE_TRANSFER:
+
+		for ( uint32_t i = 0; i < Message.Data.Transfer.Length; i ++ )
+			Pipe.Transfer [ i ] = Message.Data.Transfer.Stages [ i ];
+
+		Pipe.TransferLength = Message.Data.Transfer.Length;
+
+		FilterChain :: Prepare ( Pipe.Transfer, Pipe.TransferLength, Pipe.Period * LOOP_ITERATION_TIME );
+
+		break;
+
+	case COMMAND_SET_PIPE_GATING:
+
+		Pipe.GateEpsilon = Message.Data.Gating.Epsilon;
+		Pipe.GateKeepalive = Message.Data.Gating.Keepalive;
+		Pipe.ForceSend = true;
+
+		break;
+
+	case COMMAND_SET_PIPE_PERIOD:
+
+		SchedulePipe ( PipeIndex, Message.Data.Period );
+
+		FilterChain :: Prepare ( Pipe.Transfer, Pipe.TransferLength, Pipe.Period * LOOP_ITERATION_TIME );
+
+		break;
+
+	case COMMAND_SET_PIPE_OVERSAMPLING:
+
+		Pipe.InputChannel -> SetAverageBits ( Message.Data.Oversampling.AverageBits );
+		Pipe.UseAverage = ( Message.Data.Oversampling.AverageBits != 0 );
+
+		Pipe.RingLength = Message.Data.Oversampling.RingSamples;
+		Pipe.RingIndex = 0;
+		Pipe.RingFill = 0;
+		Pipe.RingSum = 0;
+
+		break;
+
+	case COMMAND_COPY_PIPE_SETTINGS:
+	{
+
+		uint32_t SourceIndex = ResolvePipe ( Message.Data.Source );
+
+		if ( SourceIndex == ANALOGCANJAGSERVER_INVALID_PIPE || SourceIndex == PipeIndex )
+			break;
+
+		AnalogCANJaguarPipe & Source = Bank -> Pipes [ SourceIndex ];
+
+		Bank -> Sign [ PipeIndex ] = Bank -> Sign [ SourceIndex ];
+
+		// The chain's state comes along too, so a slew limit or low pass carries on from where the old pipe was.
+		for ( uint32_t i = 0; i < Source.TransferLength; i ++ )
+			Pipe.Transfer [ i ] = Source.Transfer [ i ];
+
+		Pipe.TransferLength = Source.TransferLength;
+
+		Pipe.GateEpsilon = Source.GateEpsilon;
+		Pipe.GateKeepalive = Source.GateKeepalive;
+		Pipe.ForceSend = true;
+
+		SchedulePipe ( PipeIndex, Source.Period );
+
+		Pipe.InputChannel -> SetAverageBits ( Source.InputChannel -> GetAverageBits () );
+		Pipe.UseAverage = Source.UseAverage;
+
+		// The ring holds the old input's samples, so it fills again from the new one.
+		Pipe.RingLength = Source.RingLength;
+		Pipe.RingIndex = 0;
+		Pipe.RingFill = 0;
+		Pipe.RingSum = 0;
+
+		break;
+
+	}
+
+	default:
+
+		break;
+
+	}
+
+	semGive ( PipesAccessSemaphore );
+
+};
+
+// Publish the finished cycle's timing and every pipe's last values for lock-free readers. Call with PipesAccessSemaphore held.
+void AnalogCANJaguarPipeServer :: PublishStatistics ( ServerStatistics & Cycle, uint32_t FramesSent, uint32_t FramesSuppressed )
+{
+
+	StatisticsLock.BeginWrite ();
+
+	Statistics.Cycles ++;
+
+	if ( Cycle.CommandTime + Cycle.ReadTime + Cycle.WriteTime > LOOP_ITERATION_TIME )
+		Statistics.Overruns ++;
+
+	if ( Cycle.CycleTime > LOOP_ITERATION_TIME + ANALOGCANJAGSERVER_LATE_MARGIN )
+		Statistics.LateCycles ++;
+
+	if ( Cycle.CycleTime > Statistics.MaxCycleTime )
+		Statistics.MaxCycleTime = Cycle.CycleTime;
+
+	Statistics.CommandTime = Cycle.CommandTime;
+	Statistics.ReadTime = Cycle.ReadTime;
+	Statistics.WriteTime = Cycle.WriteTime;
+	Statistics.CycleTime = Cycle.CycleTime;
+
+	for ( uint32_t i = 0; i < Bank -> Length; i ++ )
+	{
+
+		AnalogCANJaguarPipe & Pipe = Bank -> Pipes [ i ];
+		uint16_t Slot = Bank -> DenseSlot [ i ];
+
+		SlotStatistics [ Slot ].LastInput = Bank -> Voltage [ i ];
+		SlotStatistics [ Slot ].LastOutput = Pipe.LastOutput;
+		SlotStatistics [ Slot ].WriteLatency = Pipe.WriteLatency;
+		SlotStatistics [ Slot ].FramesSent = Pipe.FramesSent;
+		SlotStatistics [ Slot ].FramesSuppressed = Pipe.FramesSuppressed;
+
+		SlotStatisticsGeneration [ Slot ] = Bank -> SlotGeneration [ Slot ];
+
+	}
+
+	StatisticsLock.EndWrite ();
+
+	if ( CycleLogEnabled )
+	{
+
+		CycleRecord & Record = CycleLog [ CycleLogHead % ANALOGCANJAGSERVER_CYCLE_LOG_LENGTH ];
+
+		Record.Timestamp = static_cast <float> ( Timer :: GetPPCTimestamp () );
+		Record.CommandTime = static_cast <float> ( Cycle.CommandTime );
+		Record.ReadTime = static_cast <float> ( Cycle.ReadTime );
+		Record.WriteTime = static_cast <float> ( Cycle.WriteTime );
+		Record.FramesSent = static_cast <uint16_t> ( FramesSent );
+		Record.FramesSuppressed = static_cast <uint16_t> ( FramesSuppressed );
+
+		SEQUENCELOCK_BARRIER ();
+
+		CycleLogHead ++;
+
+	}
+
+};
+
+// Append a pipe to the bank and give it a slot. Returns the pipe's handle. Call with PipesAccessSemaphore held.
+uint32_t AnalogCANJaguarPipeServer :: PushPipe ( AnalogCANJaguarPipe & NewPipe )
+{
+
+	if ( Bank -> Length >= ANALOGCANJAGSERVER_MAX_PIPES || Bank -> FreeCount == 0 )
+	{
+
+		delete NewPipe.Jaguar;
+		delete NewPipe.InputChannel;
+
+		return ANALOGCANJAGSERVER_INVALID_PIPE;
+
+	}
+
+	uint32_t Index = Bank -> Length;
+	uint16_t Slot = Bank -> FreeSlots [ -- Bank -> FreeCount ];
+
+	Bank -> Pipes [ Index ] = NewPipe;
+
+	Bank -> Voltage [ Index ] = 0;
+	Bank -> Offset [ Index ] = 2.5;
+	Bank -> Sign [ Index ] = 1.0;
+	Bank -> Scale [ Index ] = 1.0 / INPUT_SCALE;
+	Bank -> Output [ Index ] = 0;
+	Bank -> Enabled [ Index ] = 0;
+
+	Bank -> DenseSlot [ Index ] = Slot;
+	Bank -> SlotDense [ Slot ] = static_cast <uint16_t> ( Index );
+
+	Bank -> Length ++;
+
+	Bank -> Pipes [ Index ].Period = 0;
+
+	SchedulePipe ( Index, 1 );
+
+	return MakePipeHandle ( Slot, Bank -> SlotGeneration [ Slot ] );
+
+};
+
+// Destroy a pipe, move the last pipe into its place, and retire its slot. Call with PipesAccessSemaphore held.
+void AnalogCANJaguarPipeServer :: RemovePipeAt ( uint32_t Index )
+{
+
+	UnschedulePipe ( Index );
+
+	delete Bank -> Pipes [ Index ].Jaguar;
+	delete Bank -> Pipes [ Index ].InputChannel;
+
+	uint16_t Slot = Bank -> DenseSlot [ Index ];
+	uint32_t Last = Bank -> Length - 1;
+
+	if ( Index != Last )
+	{
+
+		Bank -> Pipes [ Index ] = Bank -> Pipes [ Last ];
+
+		Bank -> Voltage [ Index ] = Bank -> Voltage [ Last ];
+		Bank -> Offset [ Index ] = Bank -> Offset [ Last ];
+		Bank -> Sign [ Index ] = Bank -> Sign [ Last ];
+		Bank -> Scale [ Index ] = Bank -> Scale [ Last ];
+		Bank -> Output [ Index ] = Bank -> Output [ Last ];
+		Bank -> Enabled [ Index ] = Bank -> Enabled [ Last ];
+
+		Bank -> DenseSlot [ Index ] = Bank -> DenseSlot [ Last ];
+		Bank -> SlotDense [ Bank -> DenseSlot [ Index ] ] = static_cast <uint16_t> ( Index );
+
+	}
+
+	Bank -> Length --;
+
+	// The slot's published statistics belong to the removed pipe. Only the server task gets here, so it's the sole writer.
+	StatisticsLock.BeginWrite ();
+
+	SlotStatisticsGeneration [ Slot ] = 0;
+
+	StatisticsLock.EndWrite ();
+
+	// Bumping the generation invalidates every outstanding handle to this slot.
+	Bank -> SlotGeneration [ Slot ] ++;
+
+	if ( Bank -> SlotGeneration [ Slot ] == 0 )
+		Bank -> SlotGeneration [ Slot ] = 1;
+
+	Bank -> FreeSlots [ Bank -> FreeCount ++ ] = Slot;
+
+};
+
+// Turn a handle into a dense index, or ANALOGCANJAGSERVER_INVALID_PIPE if the handle is stale or garbage.
+uint32_t AnalogCANJaguarPipeServer :: ResolvePipe ( AnalogCANJaguarPipe_t Pipe )
+{
+
+	uint32_t Slot = Pipe & 0xFFFF;
+
+	if ( Slot >= ANALOGCANJAGSERVER_MAX_PIPES )
+		return ANALOGCANJAGSERVER_INVALID_PIPE;
+
+	if ( Bank -> SlotGeneration [ Slot ] != ( Pipe >> 16 ) )
+		return ANALOGCANJAGSERVER_INVALID_PIPE;
+
+	uint32_t Index = Bank -> SlotDense [ Slot ];
+
+	if ( Index >= Bank -> Length || Bank -> DenseSlot [ Index ] != Slot )
+		return ANALOGCANJAGSERVER_INVALID_PIPE;
+
+	return Index;
+
+};
+
+AnalogCANJaguarPipe_t AnalogCANJaguarPipeServer :: MakePipeHandle ( uint16_t Slot, uint16_t Generation )
+{
+
+	return ( static_cast <uint32_t> ( Generation ) << 16 ) | Slot;
+
+};
+
+// Give a pipe a new period, and place it on the phase that keeps the busiest tick as quiet as possible. Call with PipesAccessSemaphore held.
+void AnalogCANJaguarPipeServer :: SchedulePipe ( uint32_t Index, uint32_t Period )
+{
+
+	AnalogCANJaguarPipe & Pipe = Bank -> Pipes [ Index ];
+
+	UnschedulePipe ( Index );
+
+	uint32_t BestPhase = 0;
+	uint32_t BestPeak = 0xFFFFFFFF;
+	uint32_t BestTotal = 0xFFFFFFFF;
+
+	for ( uint32_t Phase = 0; Phase < Period; Phase ++ )
+	{
+
+		uint32_t Peak = 0;
+		uint32_t Total = 0;
+
+		for ( uint32_t t = Phase; t < ANALOGCANJAGSERVER_SCHEDULE_TICKS; t += Period )
+		{
+
+			if ( Bank -> TickLoad [ t ] > Peak )
+				Peak = Bank -> TickLoad [ t ];
+
+			Total += Bank -> TickLoad [ t ];
 
 		}
 
-		semTake ( PipesAccessSemaphore, WAIT_FOREVER ); 
+		if ( Peak < BestPeak || ( Peak == BestPeak && Total < BestTotal ) )
+		{
+
+			BestPhase = Phase;
+			BestPeak = Peak;
+			BestTotal = Total;
+
+		}
+
+	}
+
+	Pipe.Period = Period;
+	Pipe.Phase = BestPhase;
+
+	for ( uint32_t t = BestPhase; t < ANALOGCANJAGSERVER_SCHEDULE_TICKS; t += Period )
+		Bank -> TickLoad [ t ] ++;
+
+};
+
+// Take a pipe's load off the schedule. Call with PipesAccessSemaphore held.
+void AnalogCANJaguarPipeServer :: UnschedulePipe ( uint32_t Index )
+{
+
+	AnalogCANJaguarPipe & Pipe = Bank -> Pipes [ Index ];
+
+	if ( Pipe.Period == 0 )
+		return;
+
+	for ( uint32_t t = Pipe.Phase; t < ANALOGCANJAGSERVER_SCHEDULE_TICKS; t += Pipe.Period )
+		Bank -> TickLoad [ t ] --;
+
+	Pipe.Period = 0;
+
+};
+
+// Work out which pipes run this tick, and fill the voltage buffer for them. Ringed pipes are sampled every tick.
+void AnalogCANJaguarPipeServer :: SampleInputs ( uint32_t Tick )
+{
 
-		for ( uint32_t i = 0; i < Pipes -> GetLength (); i ++ )
+	for ( uint32_t i = 0; i < Bank -> Length; i ++ )
+	{
+
+		AnalogCANJaguarPipe & Pipe = Bank -> Pipes [ i ];
+
+		Bank -> Due [ i ] = ( ( Tick & ( Pipe.Period - 1 ) ) == Pipe.Phase );
+
+		if ( Pipe.RingLength > 1 )
 		{
-			
-			double in = ( * Pipes ) [ i ].InputChannel -> GetVoltage ();
-			double in_offset = in - ( * Pipes ) [ i ].Offset;
-			double in_proportional = in_offset / INPUT_SCALE;
-			double in_inverted = in_proportional * ( ( * Pipes ) [ i ].Inverted ? -1 : 1 );
-			double out = in_inverted * JAGSCALE;
 
-			if ( ( * Pipes ) [ i ].Enabled )
-				( * Pipes ) [ i ].Jaguar -> Set ( out );
+			double Sample = ReadInput ( Pipe );
+
+			if ( Pipe.RingFill < Pipe.RingLength )
+				Pipe.RingFill ++;
+			else
+				Pipe.RingSum -= Pipe.Ring [ Pipe.RingIndex ];
+
+			Pipe.Ring [ Pipe.RingIndex ] = Sample;
+			Pipe.RingSum += Sample;
 
+			Pipe.RingIndex ++;
+
+			// Re-total once per lap so rounding error in the running sum can't build up.
+			if ( Pipe.RingIndex == Pipe.RingLength )
+			{
+
+				Pipe.RingIndex = 0;
+				Pipe.RingSum = 0;
+
+				for ( uint32_t j = 0; j < Pipe.RingFill; j ++ )
+					Pipe.RingSum += Pipe.Ring [ j ];
+
+			}
+
+			if ( Bank -> Due [ i ] )
+				Bank -> Voltage [ i ] = Pipe.RingSum / Pipe.RingFill;
 
 		}
+		else if ( Bank -> Due [ i ] )
+			Bank -> Voltage [ i ] = ReadInput ( Pipe );
+
 	}
 
 };
 
+double AnalogCANJaguarPipeServer :: ReadInput ( AnalogCANJaguarPipe & Pipe )
+{
+
+	return Pipe.UseAverage ? Pipe.InputChannel -> GetAverageVoltage () : Pipe.InputChannel -> GetVoltage ();
+
+};
+
+// Normalize every sampled voltage. No branches or calls, so the compiler is free to unroll or vectorize it.
+void AnalogCANJaguarPipeServer :: TransformInputs ( const double * __restrict__ Voltage, const double * __restrict__ Offset, const double * __restrict__ Sign, const double * __restrict__ Scale, double * __restrict__ Output, uint32_t Length )
+{
+
+	for ( uint32_t i = 0; i < Length; i ++ )
+		Output [ i ] = ( Voltage [ i ] - Offset [ i ] ) * Sign [ i ] * Scale [ i ];
+
+};
+
 int AnalogCANJaguarPipeServer :: _StartServerTask ( AnalogCANJaguarPipeServer * This )
 {
 
@@ -3,7 +3,8 @@
 
 #include "WPILib.h"
 
-#include "src/Util/Vector.h"
+#include "src/Filters/FilterChain.h"
+#include "src/Util/SequenceLock.h"
 
 #define ANALOGCANJAGSERVERTASK_PRIORITY 50
 #define ANALOGCANJAGSERVERTASK_STACKSIZE 0x20000
@@ -18,16 +19,86 @@
 
 #define INPUT_SCALE 2.5
 
+#define ANALOGCANJAGSERVER_MAX_PIPES 64
+#define ANALOGCANJAGSERVER_BANK_ALIGNMENT 16
+
+#define ANALOGCANJAGSERVER_INVALID_PIPE 0xFFFFFFFF
+
+// Pipe periods are powers of two, in base ticks of LOOP_ITERATION_TIME, no longer than the schedule.
+#define ANALOGCANJAGSERVER_SCHEDULE_TICKS 32
+
+// Longest software sample ring a pipe may average over, in base ticks.
+#define ANALOGCANJAGSERVER_MAX_RING_SAMPLES 16
+
+// A cycle that takes longer than LOOP_ITERATION_TIME plus this margin counts as late.
+#define ANALOGCANJAGSERVER_LATE_MARGIN 0.001
+
+#define ANALOGCANJAGSERVER_CYCLE_LOG_LENGTH 512
+
+#define ANALOGCANJAGSERVER_GATE_EPSILON_DEFAULT 0.0
+#define ANALOGCANJAGSERVER_GATE_KEEPALIVE_DEFAULT 0.05
+
 // sysLib.h
 //extern int sysClkRateGet ();
 
+// Pipe handle. The low 16 bits are a slot number, the high 16 bits are that slot's generation when the pipe was added.
 typedef uint32_t AnalogCANJaguarPipe_t;
 typedef int32_t CAN_ID;
 
 class AnalogCANJaguarPipeServer
 {
+
+	// Host benchmark in PIC-Servo/Simulator, which times the numeric kernel on its own.
+	friend class AnalogCANJaguarPipeBench;
+
 public:
 
+	typedef struct ServerStatistics
+	{
+
+		uint32_t Cycles;
+
+		// Cycles whose command, read and write work alone took longer than LOOP_ITERATION_TIME.
+		uint32_t Overruns;
+
+		// Cycles that took longer than LOOP_ITERATION_TIME + ANALOGCANJAGSERVER_LATE_MARGIN from start to finish.
+		uint32_t LateCycles;
+
+		// Breakdown of the last cycle, in seconds.
+		double CommandTime;
+		double ReadTime;
+		double WriteTime;
+		double CycleTime;
+
+		double MaxCycleTime;
+
+	} ServerStatistics;
+
+	typedef struct PipeStatistics
+	{
+
+		double LastInput;
+		double LastOutput;
+		double WriteLatency;
+
+		uint32_t FramesSent;
+		uint32_t FramesSuppressed;
+
+	} PipeStatistics;
+
+	typedef struct CycleRecord
+	{
+
+		float Timestamp;
+		float CommandTime;
+		float ReadTime;
+		float WriteTime;
+
+		uint16_t FramesSent;
+		uint16_t FramesSuppressed;
+
+	} CycleRecord;
+
 	AnalogCANJaguarPipeServer ();
 	~AnalogCANJaguarPipeServer ();
 
@@ -46,10 +117,32 @@ public:
 	void SetPipeOffset ( AnalogCANJaguarPipe_t Pipe, double Offset );
 	void ZeroPipe ( AnalogCANJaguarPipe_t Pipe );
 
+	void SetPipeTransfer ( AnalogCANJaguarPipe_t Pipe, FilterChain * Chain );
+	void SetPipeGating ( AnalogCANJaguarPipe_t Pipe, double Epsilon, double KeepaliveInterval = ANALOGCANJAGSERVER_GATE_KEEPALIVE_DEFAULT );
+
+	bool GetPipeFrameCounts ( AnalogCANJaguarPipe_t Pipe, uint32_t * Sent, uint32_t * Suppressed );
+	uint32_t GetSuppressedFrameCount ();
+
+	void SetPipePeriod ( AnalogCANJaguarPipe_t Pipe, uint32_t Ticks );
+	void SetPipeOversampling ( AnalogCANJaguarPipe_t Pipe, uint32_t AverageBits, uint32_t RingSamples = 1 );
+
+	void CopyPipeSettings ( AnalogCANJaguarPipe_t From, AnalogCANJaguarPipe_t To );
+
+	bool GetStatistics ( ServerStatistics * Statistics );
+	bool GetPipeStatistics ( AnalogCANJaguarPipe_t Pipe, PipeStatistics * Statistics );
+
+	void SetCycleLogEnabled ( bool Enabled );
+	uint32_t ReadCycleLog ( CycleRecord * Records, uint32_t MaxRecords );
+
+	uint32_t GetTickLoad ( uint32_t Tick );
+	uint32_t GetPeakTickLoad ();
+	double GetScheduledFrameRate ();
+
 private:
 
 	void RunLoop ();
 
+	// Per-pipe state that isn't touched by the numeric kernel.
 	typedef struct AnalogCANJaguarPipe
 	{
 
@@ -59,20 +152,84 @@ private:
 
 		CANJaguar * Jaguar;
 		AnalogChannel * InputChannel;
-		
-		double Offset;
-		bool Inverted;
-		bool Enabled;
+
+		FilterStage Transfer [ FILTERCHAIN_MAX_STAGES ];
+		uint32_t TransferLength;
+
+		// Output gating: only send when the output moves by more than GateEpsilon, or GateKeepalive seconds have passed.
+		double GateEpsilon;
+		double GateKeepalive;
+
+		double LastSent;
+		double LastSendTime;
+		bool ForceSend;
+
+		uint32_t FramesSent;
+		uint32_t FramesSuppressed;
+
+		// The pipe runs on ticks where ( Tick & ( Period - 1 ) ) == Phase.
+		uint32_t Period;
+		uint32_t Phase;
+
+		// Oversampling: the analog module's averaging engine, and/or a ring of the last RingLength base-tick samples.
+		bool UseAverage;
+
+		double Ring [ ANALOGCANJAGSERVER_MAX_RING_SAMPLES ];
+		double RingSum;
+		uint32_t RingLength;
+		uint32_t RingIndex;
+		uint32_t RingFill;
+
+		double LastOutput;
+		double WriteLatency;
 
 	} AnalogCANJaguarPipe;
 
-	typedef struct ServerMessage
+	// Pipe state stored as parallel arrays, so sampling and scaling every pipe is one pass over contiguous memory.
+	typedef struct AnalogCANJaguarPipeBank
 	{
 
-		uint32_t Command;
-		uint32_t Data;
+		double Voltage [ ANALOGCANJAGSERVER_MAX_PIPES ];
+		double Offset [ ANALOGCANJAGSERVER_MAX_PIPES ];
+		double Sign [ ANALOGCANJAGSERVER_MAX_PIPES ];
+		double Scale [ ANALOGCANJAGSERVER_MAX_PIPES ];
+		double Output [ ANALOGCANJAGSERVER_MAX_PIPES ];
 
-	} ServerMessage;
+		uint8_t Enabled [ ANALOGCANJAGSERVER_MAX_PIPES ];
+		uint8_t Due [ ANALOGCANJAGSERVER_MAX_PIPES ];
+
+		AnalogCANJaguarPipe Pipes [ ANALOGCANJAGSERVER_MAX_PIPES ];
+
+		uint32_t Length;
+
+		// Slot map. Pipes stay densely packed; handles refer to slots, and slots track which dense index they point at.
+		uint16_t DenseSlot [ ANALOGCANJAGSERVER_MAX_PIPES ];
+		uint16_t SlotDense [ ANALOGCANJAGSERVER_MAX_PIPES ];
+		uint16_t SlotGeneration [ ANALOGCANJAGSERVER_MAX_PIPES ];
+
+		uint16_t FreeSlots [ ANALOGCANJAGSERVER_MAX_PIPES ];
+		uint32_t FreeCount;
+
+		// Number of pipes scheduled on each tick of the schedule.
+		uint32_t TickLoad [ ANALOGCANJAGSERVER_SCHEDULE_TICKS ];
+
+	} AnalogCANJaguarPipeBank;
+
+	uint32_t PushPipe ( AnalogCANJaguarPipe & NewPipe );
+	void RemovePipeAt ( uint32_t Index );
+
+	uint32_t ResolvePipe ( AnalogCANJaguarPipe_t Pipe );
+	static AnalogCANJaguarPipe_t MakePipeHandle ( uint16_t Slot, uint16_t Generation );
+
+	void SchedulePipe ( uint32_t Index, uint32_t Period );
+	void UnschedulePipe ( uint32_t Index );
+
+	void SampleInputs ( uint32_t Tick );
+	static double ReadInput ( AnalogCANJaguarPipe & Pipe );
+
+	void PublishStatistics ( ServerStatistics & Cycle, uint32_t FramesSent, uint32_t FramesSuppressed );
+
+	static void TransformInputs ( const double * Voltage, const double * Offset, const double * Sign, const double * Scale, double * Output, uint32_t Length );
 
 	enum ServerCommands
 	{
@@ -84,34 +241,70 @@ private:
 		COMMAND_REMOVE_PIPE,
 		COMMAND_SET_PIPE_INVERTED,
 		COMMAND_SET_PIPE_OFFSET,
-		COMMAND_ZERO_PIPE
+		COMMAND_ZERO_PIPE,
+		COMMAND_SET_PIPE_TRANSFER,
+		COMMAND_SET_PIPE_GATING,
+		COMMAND_SET_PIPE_PERIOD,
+		COMMAND_SET_PIPE_OVERSAMPLING,
+		COMMAND_COPY_PIPE_SETTINGS
 
 	};
 
-	typedef struct AddPipeMessage
+	// Commands are copied by value through the message queues, so sending one never allocates.
+	typedef struct ServerMessage
 	{
 
-		CAN_ID JaguarID;
-		uint32_t Channel;
-		uint32_t Module;
+		uint32_t Command;
+		AnalogCANJaguarPipe_t Pipe;
 
-	} AddPipeMessage;
+		union
+		{
 
-	typedef struct SetPipeInvertedMessage
-	{
+			struct
+			{
 
-		uint32_t Pipe;
-		bool Inverted;
+				CAN_ID JaguarID;
+				uint32_t Channel;
+				uint32_t Module;
 
-	} SetPipeInvertedMessage;
+			} AddPipe;
 
-	typedef struct SetPipeOffsetMessage
-	{
+			bool Inverted;
+			double Offset;
+			uint32_t Period;
+
+			AnalogCANJaguarPipe_t Source;
+
+			struct
+			{
+
+				double Epsilon;
+				double Keepalive;
+
+			} Gating;
+
+			struct
+			{
+
+				uint32_t AverageBits;
+				uint32_t RingSamples;
+
+			} Oversampling;
+
+			struct
+			{
 
-		uint32_t Pipe;
-		double Offset;
+				uint32_t Length;
+				FilterStage Stages [ FILTERCHAIN_MAX_STAGES ];
 
-	} SetPipeOffsetMessage;
+			} Transfer;
+
+		} Data;
+
+	} ServerMessage;
+
+	void SendCommand ( ServerMessage & Message );
+	void HandleCommand ( ServerMessage & Message );
 
 	bool Running;
 
@@ -123,7 +316,21 @@ private:
 	MSG_Q_ID ReceiveMessageQueue;
 
 
-	Vector <AnalogCANJaguarPipe> * Pipes;
+	AnalogCANJaguarPipeBank * Bank;
+
+	uint32_t SuppressedFrames;
+
+	// Everything below is written only by the server task, and read through StatisticsLock.
+	SequenceLock StatisticsLock;
+
+	ServerStatistics Statistics;
+
+	PipeStatistics SlotStatistics [ ANALOGCANJAGSERVER_MAX_PIPES ];
+	uint16_t SlotStatisticsGeneration [ ANALOGCANJAGSERVER_MAX_PIPES ];
+
+	CycleRecord * CycleLog;
+	volatile uint32_t CycleLogHead;
+	volatile bool CycleLogEnabled;
 
 	static int _StartServerTask ( AnalogCANJaguarPipeServer * This );
 
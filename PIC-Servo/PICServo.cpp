@@ -6,6 +6,7 @@ PICServo :: PICServo ( uint8_t ModuleAddress, PICServoController * Controller, A
 	ModuleNumber = ModuleAddress;
 	this -> Controller = Controller;
 	this -> MotorPipe = MotorPipe;
+	MotorPipeEnabled = false;
 
 	ControlMode = kPWM;
 
@@ -17,6 +18,25 @@ PICServo :: PICServo ( uint8_t ModuleAddress, PICServoController * Controller, A
 	NewVelocity = false;
 	NewAcceleration = false;
 
+	EncoderCount = 1;
+	Enabled = false;
+
+	Mailbox = 0;
+	MailboxFull = false;
+
+	CachedStatus.StandardFlags = 0;
+	CachedStatus.Position = 0;
+	CachedStatus.CurrentSense = 0;
+	CachedStatus.EncoderVelocity = 0;
+	CachedStatus.AuxiliaryStatus = 0;
+	CachedStatus.HomePosition = 0;
+	CachedStatus.DeviceType = 0;
+	CachedStatus.DeviceVersion = 0;
+	CachedStatus.PositionError = 0;
+	CachedStatus.PathPointsPending = 0;
+
+	CachedStatusTime = 0;
+
 };
 
 PICServo :: ~PICServo ()
@@ -74,20 +94,111 @@ void PICServo :: Disable ()
 double PICServo :: Get ()
 {
 
-	return LastSet;
+	semTake ( Controller -> MailboxLock, WAIT_FOREVER );
+
+	double Value = LastSet;
+
+	semGive ( Controller -> MailboxLock );
+
+	return Value;
 
 };
 
+/**
+* Position in revolutions, as of the last status poll.
+*/
 double PICServo :: GetPosition ()
 {
 
-	return static_cast <double> ( Controller -> PICServoReadPosition ( ModuleNumber ) ) / static_cast <double> ( EncoderCount );
+	PICServoCom :: PICServoStatus_t Status;
+
+	GetStatus ( & Status );
+
+	return static_cast <double> ( static_cast <int32_t> ( Status.Position ) ) / static_cast <double> ( EncoderCount );
+
+};
+
+/**
+* Velocity in revolutions per second, as of the last status poll.
+*/
+double PICServo :: GetVelocity ()
+{
+
+	PICServoCom :: PICServoStatus_t Status;
+
+	GetStatus ( & Status );
+
+	return static_cast <double> ( static_cast <int16_t> ( Status.EncoderVelocity ) ) * PICSERVO_SERVO_RATE / static_cast <double> ( EncoderCount );
+
+};
+
+/**
+* Servo position error in revolutions, as of the last status poll.
+*/
+double PICServo :: GetPositionError ()
+{
+
+	PICServoCom :: PICServoStatus_t Status;
+
+	GetStatus ( & Status );
+
+	return static_cast <double> ( static_cast <int16_t> ( Status.PositionError ) ) / static_cast <double> ( EncoderCount );
+
+};
+
+/**
+* Raw motor current sense reading ( 0 - 255 ), as of the last status poll.
+*/
+double PICServo :: GetCurrent ()
+{
+
+	PICServoCom :: PICServoStatus_t Status;
+
+	GetStatus ( & Status );
+
+	return static_cast <double> ( Status.CurrentSense );
+
+};
+
+/**
+* Copy out the latest polled status without touching the serial link.
+*
+* @param Timestamp Set to the time the status was received. ( Zero if it never has been )
+* @return False if a consistent copy couldn't be made. Status still holds the last attempt.
+*/
+bool PICServo :: GetStatus ( PICServoCom :: PICServoStatus_t * Status, double * Timestamp )
+{
+
+	for ( uint32_t Attempt = 0; Attempt < 16; Attempt ++ )
+	{
+
+		uint32_t Sequence = StatusLock.BeginRead ();
+
+		* Status = CachedStatus;
+		double Time = CachedStatusTime;
+
+		if ( StatusLock.EndRead ( Sequence ) )
+		{
+
+			if ( Timestamp != NULL )
+				* Timestamp = Time;
+
+			return true;
+
+		}
+
+	}
+
+	return false;
 
 };
 
 void PICServo :: ConfigVelocity ( double Velocity )
 {
 
+	// The command task copies the settings out with the setpoint, under the same lock.
+	semTake ( Controller -> MailboxLock, WAIT_FOREVER );
+
 	if ( this -> Velocity != Velocity )
 	{
 
@@ -97,11 +208,15 @@ void PICServo :: ConfigVelocity ( double Velocity )
 
 	}
 
+	semGive ( Controller -> MailboxLock );
+
 };
 
 void PICServo :: ConfigAcceleration ( double Acceleration )
 {
 
+	semTake ( Controller -> MailboxLock, WAIT_FOREVER );
+
 	if ( this -> Acceleration != Acceleration )
 	{
 
@@ -111,69 +226,127 @@ void PICServo :: ConfigAcceleration ( double Acceleration )
 
 	}
 
+	semGive ( Controller -> MailboxLock );
+
 };
 
+/**
+* Post a new setpoint and return without waiting on the serial link.
+*
+* The controller's command task sends it as soon as it can. If Set is called again first, only the newer setpoint is
+* sent.
+*/
 void PICServo :: Set ( double Value )
+{
+
+	Controller -> PostSetpoint ( this, Value );
+
+};
+
+// Convert a setpoint from the units Set () takes to the module's.
+double PICServo :: ScaleSetpoint ( double Value )
 {
 
 	switch ( ControlMode )
 	{
-			
-	case kPWM:
 
-		Controller -> PICServoSetPWM ( ModuleNumber, static_cast <int16_t> ( Value * 0xFF ) );
+	case kPosition:
 
-		break;
+		return Value * static_cast <double> ( EncoderCount );
 
-	case kPosition:
+	case kVelocity:
 
-		Value *= static_cast <double> ( EncoderCount );
+		return Value * static_cast <double> ( EncoderCount ) / PICSERVO_SERVO_RATE;
 
-		if ( NewVelocity )
-		{
+	default:
 
-			if ( NewAcceleration )
-				Controller -> PICServoSetPositionVA ( ModuleNumber, Value, Velocity, Acceleration );
-			else
-				Controller -> PICServoSetPositionV ( ModuleNumber, Value, Velocity );
+		return Value;
 
-		}
-		else
-		{
+	}
 
-			if ( NewAcceleration )
-				Controller -> PICServoSetPositionA ( ModuleNumber, Value, Acceleration );
-			else
-				Controller -> PICServoSetPosition ( ModuleNumber, Value );
+};
 
-		}
+// Copy out what loading a setpoint needs, and mark the new trajectory settings as sent. Call with MailboxLock held.
+void PICServo :: TakeSetpoint ( double Value, PICServoSetpoint_t * Setpoint )
+{
+
+	Setpoint -> Value = ScaleSetpoint ( Value );
+
+	Setpoint -> Velocity = Velocity;
+	Setpoint -> Acceleration = Acceleration;
+
+	Setpoint -> LoadVelocity = NewVelocity;
+	Setpoint -> LoadAcceleration = NewAcceleration;
+
+	// Velocity mode never loads the velocity limit, so it leaves both marked, as it always has.
+	if ( ControlMode == kPosition )
+	{
 
 		NewAcceleration = false;
 		NewVelocity = false;
 
-		break;
+	}
 
-	case kVelocity:
+};
 
-		Value *= static_cast <double> ( EncoderCount );
-		Value /= PICSERVO_SERVO_RATE;
+/*
+* Queue the trajectory for a setpoint taken with TakeSetpoint. With Immediate off, the module holds it until a
+* START_MOVE. Only reads the setpoint, so it runs without MailboxLock while it waits on the link.
+*/
+PICServoCom :: PICServoTransaction_t * PICServo :: Load ( const PICServoSetpoint_t * Setpoint, bool Immediate )
+{
 
-		if ( NewAcceleration )
-			Controller -> PICServoSetVelocityA ( ModuleNumber, Value, Acceleration );
-		else
-			Controller -> PICServoSetVelocity ( ModuleNumber, Value );
+	double Value = Setpoint -> Value;
 
-			break;
+	switch ( ControlMode )
+	{
+			
+	case kPWM:
 
-	default:
+		return Controller -> PICServoSetPWM ( ModuleNumber, static_cast <int16_t> ( Value * 0xFF ), Immediate );
+
+	case kPosition:
+
+		if ( Setpoint -> LoadVelocity )
+		{
+
+			if ( Setpoint -> LoadAcceleration )
+				return Controller -> PICServoSetPositionVA ( ModuleNumber, Value, Setpoint -> Velocity, Setpoint -> Acceleration, Immediate );
+
+			return Controller -> PICServoSetPositionV ( ModuleNumber, Value, Setpoint -> Velocity, Immediate );
+
+		}
 
-		Controller -> PICServoSetPWM ( ModuleNumber, 0 );
+		if ( Setpoint -> LoadAcceleration )
+			return Controller -> PICServoSetPositionA ( ModuleNumber, Value, Setpoint -> Acceleration, Immediate );
 
-		break;
+		return Controller -> PICServoSetPosition ( ModuleNumber, Value, Immediate );
+
+	case kVelocity:
+
+		if ( Setpoint -> LoadAcceleration )
+			return Controller -> PICServoSetVelocityA ( ModuleNumber, Value, Setpoint -> Acceleration, Immediate );
+
+		return Controller -> PICServoSetVelocity ( ModuleNumber, Value, Immediate );
+
+	default:
+
+		return Controller -> PICServoSetPWM ( ModuleNumber, 0, Immediate );
 
 	}
 
-	LastSet = Value;
+};
+
+// Only the controller's poll task publishes, so the sequence lock has a single writer.
+void PICServo :: PublishStatus ( const PICServoCom :: PICServoStatus_t * Status, double Timestamp )
+{
+
+	StatusLock.BeginWrite ();
+
+	CachedStatus = * Status;
+	CachedStatusTime = Timestamp;
+
+	StatusLock.EndWrite ();
 
 };
 
@@ -2,14 +2,23 @@
 #define SHS_2605_PICSERVO_H
 
 #include "PICServoController.h"
+#include "PICServoCom.h"
+#include "PICServoSetpoint.h"
 #include "AnalogCANJaguarPipeServer.h"
 
+#include "src/Util/SequenceLock.h"
+
 #define PICSERVO_SERVO_RATE 1953.125
 
+class PICServoController;
+
 class PICServo
 {
 
 	friend class PICServoController;
+	friend class PICServoPathStreamer;
+	friend class PICServoProfiler;
+	friend class PICServoGroupPlanner;
 
 public:
 
@@ -31,7 +40,13 @@ public:
 	void Disable ();
 
 	double Get ();
+
 	double GetPosition ();
+	double GetVelocity ();
+	double GetPositionError ();
+	double GetCurrent ();
+
+	bool GetStatus ( PICServoCom :: PICServoStatus_t * Status, double * Timestamp = NULL );
 
 	void ConfigVelocity ( double Velocity );
 	void ConfigAcceleration ( double Acceleration );
@@ -48,9 +63,21 @@ private:
 	PICServo ( uint8_t ModuleAddress, PICServoController * Controller, AnalogCANJaguarPipe_t MotorPipe );
 	~PICServo ();
 
+	double ScaleSetpoint ( double Value );
+	void TakeSetpoint ( double Value, PICServoSetpoint_t * Setpoint );
+
+	PICServoCom :: PICServoTransaction_t * Load ( const PICServoSetpoint_t * Setpoint, bool Immediate );
+
+	void PublishStatus ( const PICServoCom :: PICServoStatus_t * Status, double Timestamp );
+
 	PICServoController * Controller;
+
+	// The motor pipe, and whether it's been enabled. Only changed with the controller's registry lock held, since
+	// re-adding the module swaps the pipe.
 	AnalogCANJaguarPipe_t MotorPipe;
+	bool MotorPipeEnabled;
 
+	// The last setpoint and the trajectory settings are guarded by the controller's MailboxLock.
 	double LastSet;
 
 	double Acceleration;
@@ -65,6 +92,15 @@ private:
 	PICServoControlMode ControlMode;
 	bool Enabled;
 
+	// Newest setpoint not yet sent by the controller's command task. Guarded by the controller's MailboxLock.
+	double Mailbox;
+	bool MailboxFull;
+
+	// Latest status from the controller's poller. Written only by the poll task.
+	SequenceLock StatusLock;
+	PICServoCom :: PICServoStatus_t CachedStatus;
+	double CachedStatusTime;
+
 };
 
 #endif
@@ -1,252 +1,329 @@
 #include "PICServoCom.h"
 
-PICServoCom :: PICServoCom ()
+#include <math.h>
+
+/*
+* Byte offsets of every status item within a reply, and the reply's total length, for a given status mask.
+* Items appear in bit order after the status byte, and a checksum byte follows the last one.
+*/
+template <uint32_t Mask>
+struct StatusLayout
 {
 
-	Port = new SerialPort ( PICSERVO_BAUD_RATE_INITIAL );
-	Port -> SetWriteBufferMode ( SerialPort :: kFlushOnAccess );
-	Port -> DisableTermination ();
-	Port -> SetReadBufferSize ( 1024 );
+	enum
+	{
 
-	SerialLock = semMCreate ( SEM_Q_PRIORITY | SEM_DELETE_SAFE | SEM_INVERSION_SAFE );
+		Position = 1,
+		CurrentSense = Position + ( ( Mask & PICSERVO_STATUS_TYPE_POSITION ) ? 4 : 0 ),
+		EncoderVelocity = CurrentSense + ( ( Mask & PICSERVO_STATUS_TYPE_CURRENT_SENSE ) ? 1 : 0 ),
+		AuxiliaryStatus = EncoderVelocity + ( ( Mask & PICSERVO_STATUS_TYPE_ENCODER_VELOCITY ) ? 2 : 0 ),
+		HomePosition = AuxiliaryStatus + ( ( Mask & PICSERVO_STATUS_TYPE_AUXILIARY_STATUS ) ? 1 : 0 ),
+		DeviceTypeVersion = HomePosition + ( ( Mask & PICSERVO_STATUS_TYPE_HOME_POSITION ) ? 4 : 0 ),
+		PositionError = DeviceTypeVersion + ( ( Mask & PICSERVO_STATUS_TYPE_DEVICE_TYPE_VERSION ) ? 2 : 0 ),
+		PathPointsPending = PositionError + ( ( Mask & PICSERVO_STATUS_TYPE_SERVO_ERROR ) ? 2 : 0 ),
+		Size = PathPointsPending + ( ( Mask & PICSERVO_STATUS_TYPE_PATH_REMAINING ) ? 1 : 0 ) + 1
 
-	StatusSize = 1;
-	StatusType = 0x00;
-	StatusBytes = new uint8_t [ 20 ];
+	};
 
 };
 
-PICServoCom :: ~PICServoCom ()
+typedef struct StatusLayout_t
 {
 
-	delete Port;
+	uint8_t Size;
 
-};
+	uint8_t Position;
+	uint8_t CurrentSense;
+	uint8_t EncoderVelocity;
+	uint8_t AuxiliaryStatus;
+	uint8_t HomePosition;
+	uint8_t DeviceTypeVersion;
+	uint8_t PositionError;
+	uint8_t PathPointsPending;
+
+} StatusLayout_t;
+
+#define PICSERVOCOM_STATUS_LAYOUT(M) { StatusLayout <M> :: Size, StatusLayout <M> :: Position, StatusLayout <M> :: CurrentSense, StatusLayout <M> :: EncoderVelocity, StatusLayout <M> :: AuxiliaryStatus, StatusLayout <M> :: HomePosition, StatusLayout <M> :: DeviceTypeVersion, StatusLayout <M> :: PositionError, StatusLayout <M> :: PathPointsPending }
 
-void PICServoCom :: ModuleResetPosition ( uint8_t Module, bool Relative )
+#define PICSERVOCOM_STATUS_LAYOUT_4(M) PICSERVOCOM_STATUS_LAYOUT ( M ), PICSERVOCOM_STATUS_LAYOUT ( M + 1 ), PICSERVOCOM_STATUS_LAYOUT ( M + 2 ), PICSERVOCOM_STATUS_LAYOUT ( M + 3 )
+#define PICSERVOCOM_STATUS_LAYOUT_16(M) PICSERVOCOM_STATUS_LAYOUT_4 ( M ), PICSERVOCOM_STATUS_LAYOUT_4 ( M + 4 ), PICSERVOCOM_STATUS_LAYOUT_4 ( M + 8 ), PICSERVOCOM_STATUS_LAYOUT_4 ( M + 12 )
+#define PICSERVOCOM_STATUS_LAYOUT_64(M) PICSERVOCOM_STATUS_LAYOUT_16 ( M ), PICSERVOCOM_STATUS_LAYOUT_16 ( M + 16 ), PICSERVOCOM_STATUS_LAYOUT_16 ( M + 32 ), PICSERVOCOM_STATUS_LAYOUT_16 ( M + 48 )
+
+static const StatusLayout_t StatusLayouts [ 256 ] = 
 {
 
-	if ( ! Relative )
-	{
-		
-		uint8_t Data [ 0 ] = {};
+	PICSERVOCOM_STATUS_LAYOUT_64 ( 0 ),
+	PICSERVOCOM_STATUS_LAYOUT_64 ( 64 ),
+	PICSERVOCOM_STATUS_LAYOUT_64 ( 128 ),
+	PICSERVOCOM_STATUS_LAYOUT_64 ( 192 )
 
-		SendMessage ( Module, PICSERVO_COMMAND_RESET_POS | PICSERVO_RESET_POSITION_DATASIZE_0, Data, 0 );
-	
-	}
-	else
-	{
+};
 
-		uint8_t Data [ 1 ] = { 0x01 };
+// Status items are little endian.
+static inline uint32_t ReadStatus32 ( const uint8_t * Bytes )
+{
 
-		SendMessage ( Module, PICSERVO_COMMAND_RESET_POS | PICSERVO_RESET_POSITION_DATASIZE_1, Data, 1 );
+	return static_cast <uint32_t> ( Bytes [ 0 ] ) | ( static_cast <uint32_t> ( Bytes [ 1 ] ) << 8 ) | ( static_cast <uint32_t> ( Bytes [ 2 ] ) << 16 ) | ( static_cast <uint32_t> ( Bytes [ 3 ] ) << 24 );
 
-	}
+};
+
+static inline uint16_t ReadStatus16 ( const uint8_t * Bytes )
+{
+
+	return static_cast <uint16_t> ( Bytes [ 0 ] | ( Bytes [ 1 ] << 8 ) );
 
 };
 
-void PICServoCom :: ModuleOverwritePosition ( uint8_t Module, int32_t Position )
+// A NULL transaction means the pool ran dry. The frame is dropped, and SubmitFrame passes the NULL on.
+static inline void PutByte ( PICServoCom :: PICServoTransaction_t * Transaction, uint8_t Byte )
 {
 
-	uint32_t * PositionData = reinterpret_cast <uint32_t *> ( & Position );
-	uint8_t Data [ 5 ] = { 0x02, * PositionData & 0xFF, ( * PositionData >> 8 ) & 0xFF, ( * PositionData >> 16 ) & 0xFF, * PositionData >> 24 };
+	if ( Transaction == NULL )
+		return;
 
-	SendMessage ( Module, PICSERVO_COMMAND_RESET_POS | PICSERVO_RESET_POSITION_DATASIZE_5, Data, 5 );
+	Transaction -> Frame [ Transaction -> FrameSize ++ ] = Byte;
+	Transaction -> CheckSum += Byte;
 
 };
 
-void PICServoCom :: ModuleSetAddress ( uint8_t Module, uint8_t NewAddress, uint8_t NewGroupAddress )
+static inline void Put16 ( PICServoCom :: PICServoTransaction_t * Transaction, uint16_t Value )
 {
 
-	uint8_t Data [ 2 ] = { NewAddress, NewGroupAddress };
+	PutByte ( Transaction, Value & 0xFF );
+	PutByte ( Transaction, Value >> 8 );
+
+};
+
+static inline void Put32 ( PICServoCom :: PICServoTransaction_t * Transaction, uint32_t Value )
+{
 
-	SendMessage ( Module, PICSERVO_COMMAND_SET_ADDR | PICSERVO_SET_ADDR_DATASIZE_2, Data, 2 );
+	PutByte ( Transaction, Value & 0xFF );
+	PutByte ( Transaction, ( Value >> 8 ) & 0xFF );
+	PutByte ( Transaction, ( Value >> 16 ) & 0xFF );
+	PutByte ( Transaction, Value >> 24 );
 
 };
 
-void PICServoCom :: ModuleDefineStatus ( uint8_t Module, uint8_t Type )
+PICServoCom :: PICServoCom ()
 {
 
-	uint8_t NewStatusSize = 2;
-	uint8_t Data [ 1 ] = { Type };
+	OpenPort ( PICSERVO_BAUD_RATE_INITIAL );
 
-	if ( StatusType & PICSERVO_STATUS_TYPE_POSITION )
-		NewStatusSize += 4;
+	SubmitLock = semMCreate ( SEM_Q_PRIORITY | SEM_DELETE_SAFE | SEM_INVERSION_SAFE );
+	TransactionLock = semMCreate ( SEM_Q_PRIORITY | SEM_DELETE_SAFE | SEM_INVERSION_SAFE );
+	LinkLock = semMCreate ( SEM_Q_PRIORITY | SEM_DELETE_SAFE | SEM_INVERSION_SAFE );
+	ProgressSemaphore = semBCreate ( SEM_Q_FIFO, SEM_EMPTY );
+	ReopenDone = semBCreate ( SEM_Q_FIFO, SEM_EMPTY );
 
-	if ( StatusType & PICSERVO_STATUS_TYPE_CURRENT_SENSE )
-		NewStatusSize ++;
+	SendQueue = msgQCreate ( PICSERVOCOM_TRANSACTION_COUNT, sizeof ( PICServoTransaction_t * ), MSG_Q_FIFO );
+	// One extra place for ReopenPort's marker, so queueing it never waits.
+	PendingQueue = msgQCreate ( PICSERVOCOM_TRANSACTION_COUNT + 1, sizeof ( PICServoTransaction_t * ), MSG_Q_FIFO );
+	FreeQueue = msgQCreate ( PICSERVOCOM_TRANSACTION_COUNT, sizeof ( PICServoTransaction_t * ), MSG_Q_FIFO );
 
-	if ( StatusType & PICSERVO_STATUS_TYPE_ENCODER_VELOCITY )
-		NewStatusSize += 2;
+	Transactions = new PICServoTransaction_t [ PICSERVOCOM_TRANSACTION_COUNT ];
 
-	if ( StatusType & PICSERVO_STATUS_TYPE_AUXILIARY_STATUS )
-		NewStatusSize ++;
+	for ( uint32_t i = 0; i < PICSERVOCOM_TRANSACTION_COUNT; i ++ )
+	{
 
-	if ( StatusType & PICSERVO_STATUS_TYPE_HOME_POSITION )
-		NewStatusSize += 4;
+		PICServoTransaction_t * Transaction = & Transactions [ i ];
 
-	if ( StatusType & PICSERVO_STATUS_TYPE_DEVICE_TYPE_VERSION )
-		NewStatusSize += 2;
+		Transaction -> Done = semBCreate ( SEM_Q_FIFO, SEM_EMPTY );
+		Transaction -> Result = kComplete;
+		Transaction -> Detached = false;
 
-	if ( StatusType & PICSERVO_STATUS_TYPE_SERVO_ERROR )
-		NewStatusSize += 2;
+		msgQSend ( FreeQueue, reinterpret_cast <char *> ( & Transaction ), sizeof ( PICServoTransaction_t * ), NO_WAIT, MSG_PRI_NORMAL );
 
-	if ( StatusType & PICSERVO_STATUS_TYPE_PATH_REMAINING )
-		NewStatusSize ++;
+	}
 
-	StatusSize = NewStatusSize;
+	ReplyBytesExpected = 0;
+	ReplyBytesReceived = 0;
 
-	SendMessage ( Module, PICSERVO_COMMAND_DEF_STAT | PICSERVO_DEF_STAT_DATASIZE_1, Data, 1 );
+	ReopenBaudRate = PICSERVO_BAUD_RATE_INITIAL;
 
-};
+	for ( uint32_t i = 0; i < 256; i ++ )
+	{
 
-void PICServoCom :: ModuleReadStatus ( uint8_t Module, uint8_t Type, PICServoStatus_t * Status )
-{
+		ModuleStatusType [ i ] = 0;
+		ChecksumErrors [ i ] = 0;
+		Timeouts [ i ] = 0;
 
-	uint8_t TempStatusSize = 2;
-	uint8_t Data [ 1 ] = { Type };
+		for ( uint32_t j = 0; j < PICSERVOCOM_LATENCY_BUCKETS; j ++ )
+			Latency [ i ][ j ] = 0;
 
-	if ( StatusType & PICSERVO_STATUS_TYPE_POSITION )
-		TempStatusSize += 4;
+	}
 
-	if ( StatusType & PICSERVO_STATUS_TYPE_CURRENT_SENSE )
-		TempStatusSize ++;
+	BytesSent = 0;
+	BytesReceived = 0;
+	BytesDiscarded = 0;
 
-	if ( StatusType & PICSERVO_STATUS_TYPE_ENCODER_VELOCITY )
-		TempStatusSize += 2;
+	TxLineTime = 0;
+	RxLineTime = 0;
 
-	if ( StatusType & PICSERVO_STATUS_TYPE_AUXILIARY_STATUS )
-		TempStatusSize ++;
+	for ( uint32_t i = 0; i < 16; i ++ )
+		FramesSent [ i ] = 0;
 
-	if ( StatusType & PICSERVO_STATUS_TYPE_HOME_POSITION )
-		TempStatusSize += 4;
+	Replies = 0;
+	Aborted = 0;
+	Resynchronizations = 0;
+	AcquireTimeouts = 0;
 
-	if ( StatusType & PICSERVO_STATUS_TYPE_DEVICE_TYPE_VERSION )
-		TempStatusSize += 2;
+	LatencyTotal = 0;
+	LatencyMax = 0;
 
-	if ( StatusType & PICSERVO_STATUS_TYPE_SERVO_ERROR )
-		TempStatusSize += 2;
+	SubmitLockMetrics.Acquisitions = 0;
+	SubmitLockMetrics.Contentions = 0;
+	SubmitLockMetrics.WaitTotal = 0;
+	SubmitLockMetrics.WaitMax = 0;
 
-	if ( StatusType & PICSERVO_STATUS_TYPE_PATH_REMAINING )
-		TempStatusSize ++;
+	LinkLockMetrics = SubmitLockMetrics;
 
-	uint8_t TempStatusBytes [ TempStatusSize ];
+	ReceiveTask = new Task ( "2605_PICServoCom_Receive", (FUNCPTR) & _StartReceiveTask, PICSERVOCOM_RECEIVE_PRIORITY, PICSERVOCOM_STACKSIZE );
+	SendTask = new Task ( "2605_PICServoCom_Send", (FUNCPTR) & _StartSendTask, PICSERVOCOM_SEND_PRIORITY, PICSERVOCOM_STACKSIZE );
 
-	SendMessage ( Module, PICSERVO_COMMAND_DEF_STAT | PICSERVO_DEF_STAT_DATASIZE_1, Data, 1 );
-	ReceiveMessage ( TempStatusBytes, TempStatusSize );
+	ReceiveTask -> Start ( reinterpret_cast <uint32_t> ( this ) );
+	SendTask -> Start ( reinterpret_cast <uint32_t> ( this ) );
 
-	uint8_t Counter = 1;
+};
 
-	Status -> StandardFlags = StatusBytes [ 0 ];
+PICServoCom :: ~PICServoCom ()
+{
 
-	if ( Type & PICSERVO_STATUS_TYPE_POSITION )
-	{
+	SendTask -> Stop ();
+	ReceiveTask -> Stop ();
 
-		Status -> Position = TempStatusBytes [ 1 ];
-		Status -> Position |= TempStatusBytes [ 2 ] << 8;
-		Status -> Position |= TempStatusBytes [ 3 ] << 16;
-		Status -> Position |= TempStatusBytes [ 4 ] << 24;
+	delete SendTask;
+	delete ReceiveTask;
 
-		Counter += 4;
+	msgQDelete ( SendQueue );
+	msgQDelete ( PendingQueue );
+	msgQDelete ( FreeQueue );
 
-	}
+	for ( uint32_t i = 0; i < PICSERVOCOM_TRANSACTION_COUNT; i ++ )
+		semDelete ( Transactions [ i ].Done );
 
-	if ( Type & PICSERVO_STATUS_TYPE_CURRENT_SENSE )
-	{
+	delete [] Transactions;
 
-		Status -> CurrentSense = TempStatusBytes [ Counter ];
+	semDelete ( SubmitLock );
+	semDelete ( TransactionLock );
+	semDelete ( LinkLock );
+	semDelete ( ProgressSemaphore );
+	semDelete ( ReopenDone );
 
-		Counter ++;
+	delete Port;
 
-	}
+};
 
-	if ( Type & PICSERVO_STATUS_TYPE_ENCODER_VELOCITY )
-	{
+PICServoCom :: PICServoTransaction_t * PICServoCom :: ModuleResetPosition ( uint8_t Module, bool Relative )
+{
 
-		Status -> EncoderVelocity = TempStatusBytes [ Counter ];
-		Status -> EncoderVelocity |= TempStatusBytes [ Counter + 1 ];
+	PICServoTransaction_t * Transaction = BeginFrame ( Module, PICSERVO_COMMAND_RESET_POS );
 
-		Counter += 2;
+	if ( Relative )
+		PutByte ( Transaction, 0x01 );
 
-	}
+	return SubmitFrame ( Transaction );
 
-	if ( Type & PICSERVO_STATUS_TYPE_AUXILIARY_STATUS )
-	{
+};
+
+PICServoCom :: PICServoTransaction_t * PICServoCom :: ModuleOverwritePosition ( uint8_t Module, int32_t Position )
+{
 
-		Status -> AuxiliaryStatus = TempStatusBytes [ Counter ];
+	PICServoTransaction_t * Transaction = BeginFrame ( Module, PICSERVO_COMMAND_RESET_POS );
 
-		Counter ++;
+	PutByte ( Transaction, 0x02 );
+	Put32 ( Transaction, static_cast <uint32_t> ( Position ) );
 
-	}
+	return SubmitFrame ( Transaction );
 
-	if ( Type & PICSERVO_STATUS_TYPE_HOME_POSITION )
-	{
+};
 
-		Status -> HomePosition = TempStatusBytes [ Counter ];
-		Status -> HomePosition |= TempStatusBytes [ Counter + 1 ] << 8;
-		Status -> HomePosition |= TempStatusBytes [ Counter + 2 ] << 16;
-		Status -> HomePosition |= TempStatusBytes [ Counter + 3 ] << 24;
+PICServoCom :: PICServoTransaction_t * PICServoCom :: ModuleSetAddress ( uint8_t Module, uint8_t NewAddress, uint8_t NewGroupAddress )
+{
 
-		Counter += 4;
+	PICServoTransaction_t * Transaction = BeginFrame ( Module, PICSERVO_COMMAND_SET_ADDR );
 
-	}
+	PutByte ( Transaction, NewAddress );
+	PutByte ( Transaction, NewGroupAddress );
 
-	if ( Type & PICSERVO_STATUS_TYPE_DEVICE_TYPE_VERSION )
-	{
+	return SubmitFrame ( Transaction );
 
-		Status -> DeviceType = TempStatusBytes [ Counter ];
-		Status -> DeviceVersion = TempStatusBytes [ Counter + 1 ];
+};
 
-		Counter += 2;
+PICServoCom :: PICServoTransaction_t * PICServoCom :: ModuleDefineStatus ( uint8_t Module, uint8_t Type )
+{
 
-	}
+	PICServoTransaction_t * Transaction = BeginFrame ( Module, PICSERVO_COMMAND_DEF_STAT );
 
-	if ( Type & PICSERVO_STATUS_TYPE_SERVO_ERROR )
-	{
+	PutByte ( Transaction, Type );
 
-		Status -> PositionError = TempStatusBytes [ Counter ];
-		Status -> PositionError |= TempStatusBytes [ Counter + 1 ] << 8;
+	return SubmitFrame ( Transaction );
 
-		Counter += 2;
+};
 
-	}
+/**
+* Ask a module for a set of status items once, without changing what it returns with other replies.
+*/
+PICServoCom :: PICServoTransaction_t * PICServoCom :: ModuleRequestStatus ( uint8_t Module, uint8_t Type )
+{
 
-	if ( Type & PICSERVO_STATUS_TYPE_PATH_REMAINING )
-	{
+	PICServoTransaction_t * Transaction = BeginFrame ( Module, PICSERVO_COMMAND_READ_STAT );
 
-		Status -> PathPointsPending = TempStatusBytes [ Counter ];
+	PutByte ( Transaction, Type );
 
-		Counter ++;
+	return SubmitFrame ( Transaction );
 
-	}
+};
+
+/**
+* Read a set of status items from a module and wait for the reply.
+*
+* @return Whether the module answered.
+*/
+bool PICServoCom :: ModuleReadStatus ( uint8_t Module, uint8_t Type, PICServoStatus_t * Status )
+{
+
+	return Complete ( ModuleRequestStatus ( Module, Type ), Status );
 
 };
 
-void PICServoCom :: ModuleSetMetrics ( uint8_t Module, uint16_t P, uint16_t I, uint16_t D, uint16_t IntegrationLimit, uint8_t OutputLimit, int8_t CurrentLimit, uint16_t PositionErrorLimit, uint8_t ServoRateDevisor, uint8_t AmplifierDeadbandCompensation, uint8_t StepRateMultiplier )
+PICServoCom :: PICServoTransaction_t * PICServoCom :: ModuleSetMetrics ( uint8_t Module, uint16_t P, uint16_t I, uint16_t D, uint16_t IntegrationLimit, uint8_t OutputLimit, int8_t CurrentLimit, uint16_t PositionErrorLimit, uint8_t ServoRateDevisor, uint8_t AmplifierDeadbandCompensation, uint8_t StepRateMultiplier )
 {
 
 	uint8_t CurrentV = CurrentLimit > 0 ? ( 1 + CurrentLimit * 2 ) : ( CurrentLimit * - 2 );
 
-	uint8_t Data [ 15 ] = { P & 0xFF, P >> 8, I & 0xFF, I >> 8, D & 0xFF, D >> 8, IntegrationLimit & 0xFF, IntegrationLimit >> 8, OutputLimit, CurrentV, PositionErrorLimit & 0xFF, PositionErrorLimit >> 8, ServoRateDevisor, AmplifierDeadbandCompensation, StepRateMultiplier };
+	PICServoTransaction_t * Transaction = BeginFrame ( Module, PICSERVO_COMMAND_SET_GAIN );
+
+	Put16 ( Transaction, P );
+	Put16 ( Transaction, I );
+	Put16 ( Transaction, D );
+	Put16 ( Transaction, IntegrationLimit );
+	PutByte ( Transaction, OutputLimit );
+	PutByte ( Transaction, CurrentV );
+	Put16 ( Transaction, PositionErrorLimit );
+	PutByte ( Transaction, ServoRateDevisor );
+	PutByte ( Transaction, AmplifierDeadbandCompensation );
+	PutByte ( Transaction, StepRateMultiplier );
 
-	SendMessage ( Module, PICSERVO_COMMAND_SET_GAIN | PICSERVO_SET_GAIN_DATASIZE_15, Data, 15 );
+	return SubmitFrame ( Transaction );
 
 };
 
-void PICServoCom :: ModuleStopMotor ( uint8_t Module, bool AmplifierEnabled, bool MotorOff, bool Abruptly )
+PICServoCom :: PICServoTransaction_t * PICServoCom :: ModuleStopMotor ( uint8_t Module, bool AmplifierEnabled, bool MotorOff, bool Abruptly )
 {
 
 	uint8_t Value = AmplifierEnabled ? 0x01 : 0x00;
 	Value |= MotorOff ? 0x02 : 0x00;
 	Value |= Abruptly ? 0x04 : 0x08;
 
-	uint8_t Data [ 1 ] = { Value };
+	PICServoTransaction_t * Transaction = BeginFrame ( Module, PICSERVO_COMMAND_STOP_MOTOR );
+
+	PutByte ( Transaction, Value );
 
-	SendMessage ( Module, PICSERVO_COMMAND_STOP_MOTOR | PICSERVO_STOP_MOTOR_DATASIZE_1, Data, 1 );
+	return SubmitFrame ( Transaction );
 
 };
 
-void PICServoCom :: ModuleIOControl ( uint8_t Module, bool LimitSwitches = false, bool LimitAbruptly = true, bool ThreePhaseCom = false, bool AntiphasePWM = true, bool FastPath = false, bool StepAndDirection = false )
+PICServoCom :: PICServoTransaction_t * PICServoCom :: ModuleIOControl ( uint8_t Module, bool LimitSwitches = false, bool LimitAbruptly = true, bool ThreePhaseCom = false, bool AntiphasePWM = true, bool FastPath = false, bool StepAndDirection = false )
 {
 
 	uint8_t Value = LimitSwitches ? 0x04 : 0x00;
@@ -259,34 +336,36 @@ void PICServoCom :: ModuleIOControl ( uint8_t Module, bool LimitSwitches = false
 	Value |= FastPath ? 0x40 : 0x00;
 	Value |= StepAndDirection ? 0x80 : 0x00;
 
-	uint8_t Data [ 1 ] = { Value };
+	PICServoTransaction_t * Transaction = BeginFrame ( Module, PICSERVO_COMMAND_IO_CTRL );
 
-	SendMessage ( Module, PICSERVO_COMMAND_IO_CTRL | PICSERVO_IO_CONTROL_DATASIZE_1, Data, 1 );
+	PutByte ( Transaction, Value );
+
+	return SubmitFrame ( Transaction );
 
 };
 
-void PICServoCom :: ModuleClearStatus ( uint8_t Module )
+PICServoCom :: PICServoTransaction_t * PICServoCom :: ModuleClearStatus ( uint8_t Module )
 {
 
-	SendMessage ( Module, PICSERVO_COMMAND_CLEAR_BITS, NULL, 0 );
+	return SubmitFrame ( BeginFrame ( Module, PICSERVO_COMMAND_CLEAR_BITS ) );
 
 };
 
-void PICServoCom :: ModuleGetStatus ( uint8_t Module )
+PICServoCom :: PICServoTransaction_t * PICServoCom :: ModuleGetStatus ( uint8_t Module )
 {
 
-	SendMessage ( Module, PICSERVO_COMMAND_NOP, NULL, 0 );
+	return SubmitFrame ( BeginFrame ( Module, PICSERVO_COMMAND_NOP ) );
 
 };
 
-void PICServoCom :: ModuleHardReset ( uint8_t Module )
+PICServoCom :: PICServoTransaction_t * PICServoCom :: ModuleHardReset ( uint8_t Module )
 {
 
-	SendMessage ( Module, PICSERVO_COMMAND_HARD_RESET, NULL, 0 );
+	return SubmitFrame ( BeginFrame ( Module, PICSERVO_COMMAND_HARD_RESET ) );
 
 };
 
-void PICServoCom :: ModuleHardReset ( uint8_t Module, bool SaveConfigInEERROM, bool RestoreAddresses, bool AmplifierEnabled, bool ServoEnabled, bool StepAndDirectionEnabled, bool LimitAndStopEnabled, bool ThreePhaseComEnabled, bool AntiphasePWMEnabled )
+PICServoCom :: PICServoTransaction_t * PICServoCom :: ModuleHardReset ( uint8_t Module, bool SaveConfigInEERROM, bool RestoreAddresses, bool AmplifierEnabled, bool ServoEnabled, bool StepAndDirectionEnabled, bool LimitAndStopEnabled, bool ThreePhaseComEnabled, bool AntiphasePWMEnabled )
 {
 
 	uint8_t Value = SaveConfigInEERROM ? 0x01 : 0x00;
@@ -298,30 +377,75 @@ void PICServoCom :: ModuleHardReset ( uint8_t Module, bool SaveConfigInEERROM, b
 	Value |= ThreePhaseComEnabled ? 0x40 : 0x00;
 	Value |= AntiphasePWMEnabled ? 0x80 : 0x00;
 
-	uint8_t Data [ 1 ] = { Value };
+	PICServoTransaction_t * Transaction = BeginFrame ( Module, PICSERVO_COMMAND_HARD_RESET );
+
+	PutByte ( Transaction, Value );
 
-	SendMessage ( Module, PICSERVO_COMMAND_HARD_RESET | PICSERVO_HARD_RESET_DATASIZE_1, Data, 1 );
+	return SubmitFrame ( Transaction );
 
 };
 
-void PICServoCom :: ModuleLoadTrajectory ( uint8_t Module, int32_t Position, double Velocity, double Acceleration, int16_t PWM, bool LoadPosition, bool LoadVelocity, bool LoadAcceleration, bool LoadPWM, bool EnableServo, bool VelocityProfileMode, bool RelativePosition, bool ImmediateMotion )
+/**
+* Change a module's baud rate. The module answers at the old rate, if at all, and listens at the new one afterward.
+*
+* @param Divisor Baud rate divisor for the module's 20 MHz clock.
+*/
+PICServoCom :: PICServoTransaction_t * PICServoCom :: ModuleSetBaud ( uint8_t Module, uint8_t Divisor )
 {
 
-	uint8_t DataSize = 1;
+	PICServoTransaction_t * Transaction = BeginFrame ( Module, PICSERVO_COMMAND_SET_BAUD );
 
-	if ( LoadPosition )
-		DataSize += 4;
+	PutByte ( Transaction, Divisor );
 
-	if ( LoadVelocity )
-		DataSize += 4;
+	return SubmitFrame ( Transaction );
 
-	if ( LoadAcceleration )
-		DataSize += 4;
+};
 
-	if ( LoadPWM )
-		DataSize += 1;
+/**
+* Start a trajectory loaded with ImmediateMotion off. Sent to a group address, every member starts on the same frame.
+*/
+PICServoCom :: PICServoTransaction_t * PICServoCom :: ModuleStartMove ( uint8_t Module )
+{
+
+	return SubmitFrame ( BeginFrame ( Module, PICSERVO_COMMAND_START_MOVE ) );
+
+};
+
+/**
+* Append points to a module's path buffer. Each point carries the low 16 bits of an absolute position, so successive
+* points must be less than 32768 counts apart. Sending no points starts the path.
+*
+* @param Count Number of points. ( At most PICSERVO_PATH_POINTS_MAX )
+*/
+PICServoCom :: PICServoTransaction_t * PICServoCom :: ModuleAddPathPoints ( uint8_t Module, const int32_t * Points, uint8_t Count )
+{
 
-	uint8_t Data [ DataSize ];
+	if ( Count > PICSERVO_PATH_POINTS_MAX )
+		Count = PICSERVO_PATH_POINTS_MAX;
+
+	PICServoTransaction_t * Transaction = BeginFrame ( Module, PICSERVO_COMMAND_ADD_PATHPOINT );
+
+	for ( uint8_t i = 0; i < Count; i ++ )
+		Put16 ( Transaction, static_cast <uint16_t> ( Points [ i ] ) );
+
+	return SubmitFrame ( Transaction );
+
+};
+
+/**
+* Load a trajectory. In velocity and PWM modes the sign of the velocity or PWM picks the direction.
+*/
+PICServoCom :: PICServoTransaction_t * PICServoCom :: ModuleLoadTrajectory ( uint8_t Module, int32_t Position, double Velocity, double Acceleration, int16_t PWM, bool LoadPosition, bool LoadVelocity, bool LoadAcceleration, bool LoadPWM, bool EnableServo, bool VelocityProfileMode, bool RelativePosition, bool ImmediateMotion )
+{
+
+	bool Reverse;
+
+	if ( VelocityProfileMode )
+		Reverse = LoadVelocity ? ( Velocity < 0 ) : ( PWM < 0 );
+	else if ( LoadPWM && ! LoadPosition )
+		Reverse = ( PWM < 0 );
+	else
+		Reverse = RelativePosition;
 
 	uint8_t ControlByte = LoadPosition ? 0x01 : 0x00;
 	ControlByte |= LoadVelocity ? 0x02 : 0x00;
@@ -329,211 +453,892 @@ void PICServoCom :: ModuleLoadTrajectory ( uint8_t Module, int32_t Position, dou
 	ControlByte |= LoadPWM ? 0x08 : 0x00;
 	ControlByte |= EnableServo ? 0x10 : 0x00;
 	ControlByte |= VelocityProfileMode ? 0x20 : 0x00;
-	ControlByte |= VelocityProfileMode ? ( PWM >= 0 ? 0x00 : 0x40 ) : ( RelativePosition ? 0x40 : 0x00 );
+	ControlByte |= Reverse ? 0x40 : 0x00;
 	ControlByte |= ImmediateMotion ? 0x80 : 0x00;
 
-	Data [ 0 ] = ControlByte;
+	PICServoTransaction_t * Transaction = BeginFrame ( Module, PICSERVO_COMMAND_LOAD_TRAJ );
 
-	uint8_t Counter = 1;
-
-	uint32_t * PositionData = reinterpret_cast <uint32_t *> ( & Position );
+	PutByte ( Transaction, ControlByte );
 
 	if ( LoadPosition )
+		Put32 ( Transaction, static_cast <uint32_t> ( Position ) );
+
+	// Velocity and acceleration are unsigned 16.16 fixed point.
+	if ( LoadVelocity )
+		Put32 ( Transaction, static_cast <uint32_t> ( fabs ( Velocity ) * 65536.0 ) );
+
+	if ( LoadAcceleration )
+		Put32 ( Transaction, static_cast <uint32_t> ( fabs ( Acceleration ) * 65536.0 ) );
+
+	if ( LoadPWM )
 	{
 
-		Data [ 1 ] = ( * PositionData ) & 0xFF;
-		Data [ 2 ] = ( * PositionData ) >> 8;
-		Data [ 3 ] = ( * PositionData ) >> 16;
-		Data [ 4 ] = ( * PositionData ) >> 24;
+		int16_t Magnitude = ( PWM < 0 ) ? - PWM : PWM;
 
-		Counter += 4;
+		PutByte ( Transaction, ( Magnitude > 0xFF ) ? 0xFF : Magnitude );
 
 	}
 
-	if ( LoadVelocity )
-	{
+	return SubmitFrame ( Transaction );
+
+};
+
+/**
+* Wait for a transaction to finish, without giving it back.
+*
+* @param Status Decoded reply, if the caller wants it.
+* @return Whether the module answered.
+*/
+bool PICServoCom :: Wait ( PICServoTransaction_t * Transaction, PICServoStatus_t * Status )
+{
+
+	if ( Transaction == NULL )
+		return false;
+
+	semTake ( Transaction -> Done, WAIT_FOREVER );
+
+	// Done only signals once, so give it back for anyone else waiting on the same transaction.
+	semGive ( Transaction -> Done );
+
+	if ( Transaction -> Result != kComplete )
+		return false;
+
+	if ( Status != NULL && Transaction -> ReplySize != 0 )
+		DecodeStatus ( Transaction -> Reply, Transaction -> StatusType, Status );
+
+	return true;
+
+};
+
+/**
+* Wait for a transaction to finish, then return it to the pool.
+*
+* @param Status Decoded reply, if the caller wants it.
+* @return Whether the module answered.
+*/
+bool PICServoCom :: Complete ( PICServoTransaction_t * Transaction, PICServoStatus_t * Status )
+{
+
+	if ( Transaction == NULL )
+		return false;
+
+	bool Answered = Wait ( Transaction, Status );
+
+	Release ( Transaction );
+
+	return Answered;
+
+};
+
+/**
+* Let a transaction return itself to the pool when it finishes. The caller must not touch it afterward.
+*/
+void PICServoCom :: Detach ( PICServoTransaction_t * Transaction )
+{
+
+	if ( Transaction == NULL )
+		return;
+
+	semTake ( TransactionLock, WAIT_FOREVER );
+
+	bool Finished = ( Transaction -> Result != kPending );
+
+	if ( ! Finished )
+		Transaction -> Detached = true;
+
+	semGive ( TransactionLock );
+
+	if ( Finished )
+		Release ( Transaction );
+
+};
+
+/**
+* Return a finished transaction to the pool.
+*/
+void PICServoCom :: Release ( PICServoTransaction_t * Transaction )
+{
+
+	if ( Transaction == NULL )
+		return;
+
+	msgQSend ( FreeQueue, reinterpret_cast <char *> ( & Transaction ), sizeof ( PICServoTransaction_t * ), NO_WAIT, MSG_PRI_NORMAL );
+
+};
+
+/**
+* Status items a module currently returns with every reply.
+*/
+uint8_t PICServoCom :: GetStatusType ( uint8_t Module )
+{
+
+	return ModuleStatusType [ Module ];
+
+};
+
+/**
+* Number of bytes in a status reply carrying the items in Type, including the status byte and checksum.
+*/
+uint8_t PICServoCom :: StatusPacketSize ( uint8_t Type )
+{
+
+	return StatusLayouts [ Type ].Size;
+
+};
 
-		if ( Velocity < 0 )
-			Velocity = - Velocity;
+/**
+* Fill in the fields of Status carried by a reply with the items in Type. Fields not in Type are left alone.
+*/
+void PICServoCom :: DecodeStatus ( const uint8_t * Bytes, uint8_t Type, PICServoStatus_t * Status )
+{
+
+	const StatusLayout_t * Layout = & StatusLayouts [ Type ];
 
-		uint16_t VelHigh = static_cast <uint16_t> ( Velocity );
-		uint16_t VelLow = static_cast <uint16_t> ( Velocity * ( 1 << 16 ) );
+	Status -> StandardFlags = Bytes [ 0 ];
+
+	if ( Type & PICSERVO_STATUS_TYPE_POSITION )
+		Status -> Position = ReadStatus32 ( & Bytes [ Layout -> Position ] );
 
-		Data [ Counter ] = VelLow;
-		Data [ Counter + 1 ] = VelLow >> 8;
-		Data [ Counter + 2 ] = VelHigh;
-		Data [ Counter + 3 ] = VelHigh >> 8;
+	if ( Type & PICSERVO_STATUS_TYPE_CURRENT_SENSE )
+		Status -> CurrentSense = Bytes [ Layout -> CurrentSense ];
+
+	if ( Type & PICSERVO_STATUS_TYPE_ENCODER_VELOCITY )
+		Status -> EncoderVelocity = ReadStatus16 ( & Bytes [ Layout -> EncoderVelocity ] );
+
+	if ( Type & PICSERVO_STATUS_TYPE_AUXILIARY_STATUS )
+		Status -> AuxiliaryStatus = Bytes [ Layout -> AuxiliaryStatus ];
+
+	if ( Type & PICSERVO_STATUS_TYPE_HOME_POSITION )
+		Status -> HomePosition = ReadStatus32 ( & Bytes [ Layout -> HomePosition ] );
+
+	if ( Type & PICSERVO_STATUS_TYPE_DEVICE_TYPE_VERSION )
+	{
 
-		Counter += 4;
+		Status -> DeviceType = Bytes [ Layout -> DeviceTypeVersion ];
+		Status -> DeviceVersion = Bytes [ Layout -> DeviceTypeVersion + 1 ];
 
 	}
 
-	if ( LoadAcceleration )
+	if ( Type & PICSERVO_STATUS_TYPE_SERVO_ERROR )
+		Status -> PositionError = ReadStatus16 ( & Bytes [ Layout -> PositionError ] );
+
+	if ( Type & PICSERVO_STATUS_TYPE_PATH_REMAINING )
+		Status -> PathPointsPending = Bytes [ Layout -> PathPointsPending ];
+
+};
+
+/*
+* Frames are encoded straight into a pooled transaction in one pass. BeginFrame writes the header, the Put* helpers
+* append payload bytes, and SubmitFrame fills the length nibble in and appends the checksum, which is summed as the
+* bytes go in.
+*/
+PICServoCom :: PICServoTransaction_t * PICServoCom :: BeginFrame ( uint8_t Address, uint8_t Command )
+{
+
+	PICServoTransaction_t * Transaction = AcquireTransaction ();
+
+	if ( Transaction == NULL )
+		return NULL;
+
+	Transaction -> Frame [ 0 ] = 0xAA;
+	Transaction -> Frame [ 1 ] = Address;
+	Transaction -> Frame [ 2 ] = Command;
+
+	Transaction -> Module = Address;
+	Transaction -> FrameSize = 3;
+	Transaction -> CheckSum = Address + Command;
+
+	return Transaction;
+
+};
+
+PICServoCom :: PICServoTransaction_t * PICServoCom :: SubmitFrame ( PICServoTransaction_t * Transaction )
+{
+
+	if ( Transaction == NULL )
+		return NULL;
+
+	uint8_t DataSize = Transaction -> FrameSize - 3;
+	uint8_t Address = Transaction -> Module;
+	uint8_t Command = Transaction -> Frame [ 2 ] & 0x0F;
+	const uint8_t * Data = & Transaction -> Frame [ 3 ];
+
+	Transaction -> Frame [ 2 ] |= DataSize << 4;
+	Transaction -> CheckSum += DataSize << 4;
+
+	Transaction -> Frame [ Transaction -> FrameSize ++ ] = Transaction -> CheckSum;
+
+	// The status definition bookkeeping has to happen in the same order the frames go out.
+	TakeLock ( SubmitLock, & SubmitLockMetrics );
+
+	Transaction -> StatusType = ModuleStatusType [ Address ];
+
+	switch ( Command )
 	{
 
-		if ( Acceleration < 0 )
-			Acceleration = - Acceleration;
+	case PICSERVO_COMMAND_DEF_STAT:
+
+		ModuleStatusType [ Address ] = Data [ 0 ];
+		Transaction -> StatusType = Data [ 0 ];
 
-		uint16_t AccHigh = static_cast <uint16_t> ( Acceleration );
-		uint16_t AccLow = static_cast <uint16_t> ( Acceleration * ( 1 << 16 ) );
+		break;
 
-		Data [ Counter ] = AccLow;
-		Data [ Counter + 1 ] = AccLow >> 8;
-		Data [ Counter + 2 ] = AccHigh;
-		Data [ Counter + 3 ] = AccHigh >> 8;
+	case PICSERVO_COMMAND_READ_STAT:
 
-		Counter += 4;
+		Transaction -> StatusType = Data [ 0 ];
+
+		break;
+
+	case PICSERVO_COMMAND_SET_ADDR:
+
+		ModuleStatusType [ Data [ 0 ] ] = ModuleStatusType [ Address ];
+
+		break;
+
+	case PICSERVO_COMMAND_HARD_RESET:
+
+		ModuleStatusType [ Address ] = 0;
+
+		break;
+
+	default:
+
+		break;
 
 	}
 
-	if ( LoadPWM )
+	// Group addressed commands and resets aren't answered.
+	if ( Address >= PICSERVO_GROUP_ADDRESS_BASE || Command == PICSERVO_COMMAND_HARD_RESET )
+		Transaction -> ReplySize = 0;
+	else
+		Transaction -> ReplySize = StatusPacketSize ( Transaction -> StatusType );
+
+	msgQSend ( SendQueue, reinterpret_cast <char *> ( & Transaction ), sizeof ( PICServoTransaction_t * ), WAIT_FOREVER, MSG_PRI_NORMAL );
+
+	semGive ( SubmitLock );
+
+	return Transaction;
+
+};
+
+PICServoCom :: PICServoTransaction_t * PICServoCom :: AcquireTransaction ()
+{
+
+	PICServoTransaction_t * Transaction;
+
+	int AcquireWait = static_cast <int> ( PICSERVOCOM_ACQUIRE_TIMEOUT * sysClkRateGet () ) + 1;
+
+	// Callers hold transactions while they acquire more, so waiting forever here could deadlock them all.
+	if ( msgQReceive ( FreeQueue, reinterpret_cast <char *> ( & Transaction ), sizeof ( PICServoTransaction_t * ), AcquireWait ) == ERROR )
 	{
 
-		if ( PWM > 0xFF )
-			PWM = 0xFF;
+		semTake ( TransactionLock, WAIT_FOREVER );
+
+		AcquireTimeouts ++;
+
+		semGive ( TransactionLock );
 
-		Data [ Counter ] = PWM;
+		return NULL;
 
 	}
 
+	// Clear a completion nobody waited for.
+	semTake ( Transaction -> Done, NO_WAIT );
+
+	Transaction -> Result = kPending;
+	Transaction -> Detached = false;
+	Transaction -> Received = 0;
+
+	return Transaction;
+
 };
 
-void PICServoCom :: ReceiveStatusPacket ()
+void PICServoCom :: FinishTransaction ( PICServoTransaction_t * Transaction, uint32_t Result )
 {
 
-	ReceiveMessage ( StatusBytes, StatusSize );
+	semTake ( TransactionLock, WAIT_FOREVER );
+
+	Transaction -> Result = Result;
+	bool Detached = Transaction -> Detached;
+
+	semGive ( TransactionLock );
+
+	if ( Detached )
+		Release ( Transaction );
+	else
+		semGive ( Transaction -> Done );
 
 };
 
-void PICServoCom :: GetStatus ( PICServoStatus_t * Status )
+void PICServoCom :: SendLoop ()
 {
 
-	uint8_t Counter = 1;
+	int ProgressWait = static_cast <int> ( PICSERVOCOM_REPLY_TIMEOUT * sysClkRateGet () ) + 1;
 
-	Status -> StandardFlags = StatusBytes [ 0 ];
+	PICServoTransaction_t * Transaction;
 
-	if ( StatusType & PICSERVO_STATUS_TYPE_POSITION )
+	while ( true )
 	{
 
-		Status -> Position = StatusBytes [ 1 ];
-		Status -> Position |= StatusBytes [ 2 ] << 8;
-		Status -> Position |= StatusBytes [ 3 ] << 16;
-		Status -> Position |= StatusBytes [ 4 ] << 24;
+		if ( msgQReceive ( SendQueue, reinterpret_cast <char *> ( & Transaction ), sizeof ( PICServoTransaction_t * ), WAIT_FOREVER ) == ERROR )
+			continue;
+
+		// A module starts answering once the last byte of its frame is in, so the frame may go out while earlier
+		// replies are still coming back, as long as they'd finish before this frame does.
+		while ( ( ReplyBytesExpected - ReplyBytesReceived ) + PICSERVOCOM_PIPELINE_MARGIN > Transaction -> FrameSize )
+			semTake ( ProgressSemaphore, ProgressWait );
+
+		TakeLock ( LinkLock, & LinkLockMetrics );
+
+		ReplyBytesExpected += Transaction -> ReplySize;
 
-		Counter += 4;
+		Port -> Write ( reinterpret_cast <const char *> ( Transaction -> Frame ), Transaction -> FrameSize );
+
+		Transaction -> SendTime = Timer :: GetPPCTimestamp ();
+
+		// Ten bits a byte on the line: start, eight data and stop.
+		BytesSent += Transaction -> FrameSize;
+		TxLineTime += ( Transaction -> FrameSize * 10.0 ) / CurrentBaudRate;
+		FramesSent [ Transaction -> Frame [ 2 ] & 0x0F ] ++;
+
+		if ( Transaction -> ReplySize != 0 )
+			msgQSend ( PendingQueue, reinterpret_cast <char *> ( & Transaction ), sizeof ( PICServoTransaction_t * ), WAIT_FOREVER, MSG_PRI_NORMAL );
+
+		semGive ( LinkLock );
+
+		if ( Transaction -> ReplySize == 0 )
+			FinishTransaction ( Transaction, kComplete );
 
 	}
 
-	if ( StatusType & PICSERVO_STATUS_TYPE_CURRENT_SENSE )
+};
+
+void PICServoCom :: ReceiveLoop ()
+{
+
+	PICServoTransaction_t * Transaction;
+
+	while ( true )
 	{
 
-		Status -> CurrentSense = StatusBytes [ Counter ];
+		if ( msgQReceive ( PendingQueue, reinterpret_cast <char *> ( & Transaction ), sizeof ( PICServoTransaction_t * ), WAIT_FOREVER ) == ERROR )
+			continue;
+
+		// ReopenPort's marker. Every reply queued ahead of it is in, and this task is the one reading the port.
+		if ( Transaction == NULL )
+		{
+
+			TakeLock ( LinkLock, & LinkLockMetrics );
+
+			SwapPort ();
+
+			semGive ( LinkLock );
+
+			continue;
+
+		}
+
+		// Earlier replies are already in, so this one is due within a reply timeout of now.
+		double Deadline = Timer :: GetPPCTimestamp () + PICSERVOCOM_REPLY_TIMEOUT;
+
+		while ( Transaction -> Received < Transaction -> ReplySize )
+		{
+
+			int32_t Wanted = Transaction -> ReplySize - Transaction -> Received;
+			int32_t Available = Port -> GetBytesReceived ();
+
+			// Take whatever has arrived, or block for a single byte, so the send task sees progress byte by byte.
+			if ( Available < Wanted )
+				Wanted = ( Available > 0 ) ? Available : 1;
+
+			uint32_t Count = Port -> Read ( reinterpret_cast <char *> ( & Transaction -> Reply [ Transaction -> Received ] ), Wanted );
+
+			if ( Count != 0 )
+			{
+
+				Transaction -> Received += Count;
+				ReplyBytesReceived += Count;
+
+				BytesReceived += Count;
+				RxLineTime += ( Count * 10.0 ) / CurrentBaudRate;
+
+				semGive ( ProgressSemaphore );
+
+			}
+			else if ( Timer :: GetPPCTimestamp () > Deadline )
+				break;
+
+		}
+
+		if ( Transaction -> Received < Transaction -> ReplySize )
+		{
+
+			// Write off the missing bytes so the send task doesn't wait on them forever.
+			ReplyBytesReceived += Transaction -> ReplySize - Transaction -> Received;
+
+			Timeouts [ Transaction -> Module ] ++;
+
+			FinishTransaction ( Transaction, kTimeout );
+
+			Resynchronize ();
 
-		Counter ++;
+		}
+		else if ( ! ChecksumValid ( Transaction -> Reply, Transaction -> ReplySize ) )
+		{
+
+			ChecksumErrors [ Transaction -> Module ] ++;
+
+			FinishTransaction ( Transaction, kChecksumError );
+
+			Resynchronize ();
+
+		}
+		else
+		{
+
+			RecordLatency ( Transaction -> Module, Timer :: GetPPCTimestamp () - Transaction -> SendTime );
+
+			FinishTransaction ( Transaction, kComplete );
+
+		}
 
 	}
 
-	if ( StatusType & PICSERVO_STATUS_TYPE_ENCODER_VELOCITY )
+};
+
+/*
+* Status replies have no start byte, so once a byte is lost or garbled there's no telling where the next reply begins.
+* Replies already in flight are abandoned and the line is drained until it goes quiet, so the next frame sent starts
+* from a clean slate.
+*/
+void PICServoCom :: Resynchronize ()
+{
+
+	PICServoTransaction_t * Abandoned;
+	bool ReopenRequested = false;
+
+	// Hold off the send task, so nothing new goes out while the line is drained.
+	TakeLock ( LinkLock, & LinkLockMetrics );
+
+	Resynchronizations ++;
+
+	while ( msgQReceive ( PendingQueue, reinterpret_cast <char *> ( & Abandoned ), sizeof ( PICServoTransaction_t * ), NO_WAIT ) != ERROR )
 	{
 
-		Status -> EncoderVelocity = StatusBytes [ Counter ];
-		Status -> EncoderVelocity |= StatusBytes [ Counter + 1 ];
+		if ( Abandoned == NULL )
+		{
+
+			ReopenRequested = true;
+
+			continue;
+
+		}
 
-		Counter += 2;
+		ReplyBytesReceived += Abandoned -> ReplySize - Abandoned -> Received;
+		Aborted ++;
+
+		FinishTransaction ( Abandoned, kAborted );
 
 	}
 
-	if ( StatusType & PICSERVO_STATUS_TYPE_AUXILIARY_STATUS )
+	char Discard [ 64 ];
+	int32_t Available;
+
+	do
 	{
 
-		Status -> AuxiliaryStatus = StatusBytes [ Counter ];
+		:: Wait ( PICSERVOCOM_RESYNC_QUIET_TIME );
+
+		Available = Port -> GetBytesReceived ();
 
-		Counter ++;
+		while ( Available > 0 )
+		{
+
+			uint32_t Count = Port -> Read ( Discard, ( Available > 64 ) ? 64 : Available );
+
+			if ( Count == 0 )
+				break;
+
+			Available -= Count;
+			BytesDiscarded += Count;
+			RxLineTime += ( Count * 10.0 ) / CurrentBaudRate;
+
+		}
 
 	}
+	while ( Port -> GetBytesReceived () > 0 );
+
+	if ( ReopenRequested )
+		SwapPort ();
+
+	semGive ( LinkLock );
 
-	if ( StatusType & PICSERVO_STATUS_TYPE_HOME_POSITION )
+	semGive ( ProgressSemaphore );
+
+};
+
+// Take a lock, timing the wait when there is one, so the uncontended case stays a single semTake.
+void PICServoCom :: TakeLock ( SEM_ID Lock, PICServoLockMetrics_t * Metrics )
+{
+
+	if ( semTake ( Lock, NO_WAIT ) == OK )
 	{
 
-		Status -> HomePosition = StatusBytes [ Counter ];
-		Status -> HomePosition |= StatusBytes [ Counter + 1 ] << 8;
-		Status -> HomePosition |= StatusBytes [ Counter + 2 ] << 16;
-		Status -> HomePosition |= StatusBytes [ Counter + 3 ] << 24;
+		Metrics -> Acquisitions ++;
+
+		return;
+
+	}
+
+	double Start = Timer :: GetPPCTimestamp ();
+
+	semTake ( Lock, WAIT_FOREVER );
+
+	double Waited = Timer :: GetPPCTimestamp () - Start;
+
+	Metrics -> Acquisitions ++;
+	Metrics -> Contentions ++;
+	Metrics -> WaitTotal += Waited;
+
+	if ( Waited > Metrics -> WaitMax )
+		Metrics -> WaitMax = Waited;
 
-		Counter += 4;
+};
+
+// Called by the receive task only.
+void PICServoCom :: RecordLatency ( uint8_t Module, double Time )
+{
+
+	uint32_t Ticks = static_cast <uint32_t> ( Time / PICSERVOCOM_LATENCY_BUCKET_BASE );
+	uint32_t Bucket = 0;
+
+	while ( Ticks != 0 && Bucket < PICSERVOCOM_LATENCY_BUCKETS - 1 )
+	{
+
+		Ticks >>= 1;
+		Bucket ++;
 
 	}
 
-	if ( StatusType & PICSERVO_STATUS_TYPE_DEVICE_TYPE_VERSION )
+	Latency [ Module ][ Bucket ] ++;
+
+	Replies ++;
+	LatencyTotal += Time;
+
+	if ( Time > LatencyMax )
+		LatencyMax = Time;
+
+};
+
+// The last byte of a reply is the 8 bit sum of the bytes before it.
+bool PICServoCom :: ChecksumValid ( const uint8_t * Bytes, uint8_t Size )
+{
+
+	uint8_t Sum = 0;
+
+	for ( uint8_t i = 0; i < Size - 1; i ++ )
+		Sum += Bytes [ i ];
+
+	return Sum == Bytes [ Size - 1 ];
+
+};
+
+/**
+* Move every module and the port to a faster baud rate.
+*
+* The modules are first checked at the current rate. If none of them answer, they're looked for at the new rate, in
+* case an earlier negotiation outlived a robot reboot. A group SET_BAUD then switches the modules together, the port
+* is reopened at the new rate, and every module must answer again. If any don't, the group and the port are put back
+* to the old rate.
+*
+* @param BaudRate One of 9600, 19200, 38400, 57600, 115200 or 230400.
+* @param GroupAddress Group address every module in Modules belongs to.
+* @param Modules Addresses of the modules on the network.
+* @param Count Number of modules.
+* @return Whether the network is now running at BaudRate.
+*/
+bool PICServoCom :: NegotiateBaud ( uint32_t BaudRate, uint8_t GroupAddress, const uint8_t * Modules, uint32_t Count )
+{
+
+	uint8_t Divisor;
+	uint8_t OldDivisor;
+
+	if ( ! BaudDivisor ( BaudRate, & Divisor ) || ! BaudDivisor ( CurrentBaudRate, & OldDivisor ) )
+		return false;
+
+	if ( BaudRate == CurrentBaudRate )
+		return true;
+
+	// Nobody else may queue commands while the rate changes. Mutexes nest, so our own commands still go through.
+	TakeLock ( SubmitLock, & SubmitLockMetrics );
+
+	uint32_t OldBaudRate = CurrentBaudRate;
+
+	// Answering also means every earlier reply is in, so the line is idle.
+	if ( ! VerifyModules ( Modules, Count ) )
 	{
 
-		Status -> DeviceType = StatusBytes [ Counter ];
-		Status -> DeviceVersion = StatusBytes [ Counter + 1 ];
+		ReopenPort ( BaudRate );
 
-		Counter += 2;
+		bool AlreadySwitched = VerifyModules ( Modules, Count );
+
+		if ( ! AlreadySwitched )
+			ReopenPort ( OldBaudRate );
+
+		semGive ( SubmitLock );
+
+		return AlreadySwitched;
 
 	}
 
-	if ( StatusType & PICSERVO_STATUS_TYPE_SERVO_ERROR )
+	Complete ( ModuleSetBaud ( GroupAddress, Divisor ) );
+	:: Wait ( PICSERVOCOM_BAUD_SETTLE_TIME );
+
+	ReopenPort ( BaudRate );
+
+	if ( VerifyModules ( Modules, Count ) )
 	{
 
-		Status -> PositionError = StatusBytes [ Counter ];
-		Status -> PositionError |= StatusBytes [ Counter + 1 ] << 8;
+		semGive ( SubmitLock );
 
-		Counter += 2;
+		return true;
 
 	}
 
-	if ( StatusType & PICSERVO_STATUS_TYPE_PATH_REMAINING )
+	// Some of the modules may have switched, so send them back before returning to the old rate.
+	Complete ( ModuleSetBaud ( GroupAddress, OldDivisor ) );
+	:: Wait ( PICSERVOCOM_BAUD_SETTLE_TIME );
+
+	ReopenPort ( OldBaudRate );
+
+	semGive ( SubmitLock );
+
+	return false;
+
+};
+
+/**
+* Baud rate the port is currently running at.
+*/
+uint32_t PICServoCom :: GetBaudRate ()
+{
+
+	return CurrentBaudRate;
+
+};
+
+/**
+* Number of replies from a module that failed their checksum.
+*/
+uint32_t PICServoCom :: GetChecksumErrorCount ( uint8_t Module )
+{
+
+	return ChecksumErrors [ Module ];
+
+};
+
+/**
+* Number of commands to a module that went unanswered.
+*/
+uint32_t PICServoCom :: GetTimeoutCount ( uint8_t Module )
+{
+
+	return Timeouts [ Module ];
+
+};
+
+/**
+* Take a snapshot of the link counters.
+*
+* The counters are cumulative from construction. Compare two snapshots to get rates and utilization over the time
+* between them.
+*/
+void PICServoCom :: GetLinkMetrics ( PICServoLinkMetrics_t * Metrics )
+{
+
+	Metrics -> Timestamp = Timer :: GetPPCTimestamp ();
+	Metrics -> BaudRate = CurrentBaudRate;
+
+	Metrics -> BytesSent = BytesSent;
+	Metrics -> BytesReceived = BytesReceived;
+	Metrics -> BytesDiscarded = BytesDiscarded;
+
+	Metrics -> TxLineTime = TxLineTime;
+	Metrics -> RxLineTime = RxLineTime;
+
+	for ( uint32_t i = 0; i < 16; i ++ )
+		Metrics -> Frames [ i ] = FramesSent [ i ];
+
+	Metrics -> Replies = Replies;
+	Metrics -> Timeouts = 0;
+	Metrics -> ChecksumErrors = 0;
+	Metrics -> Aborted = Aborted;
+	Metrics -> Resynchronizations = Resynchronizations;
+	Metrics -> AcquireTimeouts = AcquireTimeouts;
+
+	Metrics -> LatencyTotal = LatencyTotal;
+	Metrics -> LatencyMax = LatencyMax;
+
+	for ( uint32_t j = 0; j < PICSERVOCOM_LATENCY_BUCKETS; j ++ )
+		Metrics -> Latency [ j ] = 0;
+
+	for ( uint32_t i = 0; i < 256; i ++ )
 	{
 
-		Status -> PathPointsPending = StatusBytes [ Counter ];
+		Metrics -> Timeouts += Timeouts [ i ];
+		Metrics -> ChecksumErrors += ChecksumErrors [ i ];
 
-		Counter ++;
+		for ( uint32_t j = 0; j < PICSERVOCOM_LATENCY_BUCKETS; j ++ )
+			Metrics -> Latency [ j ] += Latency [ i ][ j ];
 
 	}
 
+	Metrics -> SubmitLock = SubmitLockMetrics;
+	Metrics -> LinkLock = LinkLockMetrics;
+
+};
+
+/**
+* Copy one module's reply latency histogram. ( Bucket bounds as in PICServoLinkMetrics_t. )
+*
+* @param Buckets Destination. Must hold PICSERVOCOM_LATENCY_BUCKETS counts.
+*/
+void PICServoCom :: GetLatencyHistogram ( uint8_t Module, uint32_t * Buckets )
+{
+
+	for ( uint32_t i = 0; i < PICSERVOCOM_LATENCY_BUCKETS; i ++ )
+		Buckets [ i ] = Latency [ Module ][ i ];
+
 };
 
-void PICServoCom :: SerialTaskLock ()
+void PICServoCom :: OpenPort ( uint32_t BaudRate )
 {
 
-	semTake ( SerialLock, WAIT_FOREVER );
+	Port = new SerialPort ( BaudRate );
+	Port -> SetWriteBufferMode ( SerialPort :: kFlushOnAccess );
+	Port -> DisableTermination ();
+	Port -> SetReadBufferSize ( 1024 );
+	Port -> SetTimeout ( PICSERVOCOM_REPLY_TIMEOUT );
+
+	CurrentBaudRate = BaudRate;
+
+};
+
+/*
+* Has the receive task swap the port, since it reads the port and resynchronizes on it without the link lock. A NULL
+* queued behind the pending replies tells it to, once they're in. Call with SubmitLock held, so no new frames go out
+* until the port is back.
+*/
+void PICServoCom :: ReopenPort ( uint32_t BaudRate )
+{
+
+	PICServoTransaction_t * Marker = NULL;
+
+	ReopenBaudRate = BaudRate;
+
+	// The send task queues under the link lock, so the marker can't land between a write and its pending replies.
+	TakeLock ( LinkLock, & LinkLockMetrics );
+
+	msgQSend ( PendingQueue, reinterpret_cast <char *> ( & Marker ), sizeof ( PICServoTransaction_t * ), WAIT_FOREVER, MSG_PRI_NORMAL );
+
+	semGive ( LinkLock );
+
+	semTake ( ReopenDone, WAIT_FOREVER );
 
 };
 
-void PICServoCom :: SerialTaskUnlock ()
+// Replace the port at the rate ReopenPort asked for. Receive task only, with LinkLock held.
+void PICServoCom :: SwapPort ()
 {
 
-	semGive ( SerialLock );
+	delete Port;
+	OpenPort ( ReopenBaudRate );
+
+	semGive ( ReopenDone );
 
 };
 
-void PICServoCom :: SendMessage ( uint8_t Address, uint8_t Command, uint8_t * Data, uint8_t DataSize )
+// Check that every module answers a NOP.
+bool PICServoCom :: VerifyModules ( const uint8_t * Modules, uint32_t Count )
 {
 
-	uint8_t CheckSum = Address + Command;
-	uint8_t DataBuffer [ 3 + DataSize ];
+	for ( uint32_t i = 0; i < Count; i ++ )
+	{
+
+		if ( ! Complete ( ModuleGetStatus ( Modules [ i ] ) ) )
+			return false;
 
-	DataBuffer [ 0 ] = 0xAA;
-	DataBuffer [ 1 ] = Address;
-	DataBuffer [ 2 ] = Command;
+	}
+
+	return true;
+
+};
+
+// Baud rate divisors for the PIC-SERVO's 20 MHz clock.
+bool PICServoCom :: BaudDivisor ( uint32_t BaudRate, uint8_t * Divisor )
+{
 
-	for ( uint8_t i = 0; i < DataSize; i ++ )
+	switch ( BaudRate )
 	{
 
-		DataBuffer [ 3 + i ] = Data [ i ];
-		CheckSum += Data [ i ];
-	
+	case 9600:
+
+		* Divisor = 0x81;
+
+		return true;
+
+	case 19200:
+
+		* Divisor = 0x3F;
+
+		return true;
+
+	case 38400:
+
+		* Divisor = 0x20;
+
+		return true;
+
+	case 57600:
+
+		* Divisor = 0x14;
+
+		return true;
+
+	case 115200:
+
+		* Divisor = 0x0A;
+
+		return true;
+
+	case 230400:
+
+		* Divisor = 0x05;
+
+		return true;
+
+	default:
+
+		return false;
+
 	}
 
-	Port -> Write ( reinterpret_cast <const char *> ( DataBuffer ), 3 + DataSize );
+};
+
+int PICServoCom :: _StartSendTask ( PICServoCom * This )
+{
+
+	This -> SendLoop ();
+
+	return 0;
 
 };
 
-void PICServoCom :: ReceiveMessage ( uint8_t * Buffer, uint8_t Count )
+int PICServoCom :: _StartReceiveTask ( PICServoCom * This )
 {
 
-	Port -> Read ( reinterpret_cast <char *> ( Buffer ), Count );
+	This -> ReceiveLoop ();
+
+	return 0;
 
 };
@@ -3,50 +3,42 @@
 
 #include "WPILib.h"
 
-#define PICSERVO_BAUD_RATE_INITIAL 19200
-
-#define	PICSERVO_COMMAND_RESET_POS	  0x00	//Reset encoder counter to 0 (0 bytes)
-#define	PICSERVO_COMMAND_SET_ADDR	  0x01	//Set address and group address (2 bytes)
-#define	PICSERVO_COMMAND_DEF_STAT	  0x02	//Define status items to return (1 byte)
-#define	PICSERVO_COMMAND_READ_STAT	  0x03	//Read value of current status items
-#define	PICSERVO_COMMAND_LOAD_TRAJ  	  0x04	//Load trahectory date (1 - 14 bytes)
-#define PICSERVO_COMMAND_START_MOVE	  0x05	//Start pre-loaded trajectory (0 bytes)
-#define PICSERVO_COMMAND_SET_GAIN	  0x06  //Set servo gain and control parameters (13 or 14)
-#define	PICSERVO_COMMAND_STOP_MOTOR 	  0x07	//Stop motor (1 byte)
-#define	PICSERVO_COMMAND_IO_CTRL		  0x08	//Define bit directions and set output (1 byte)
-#define PICSERVO_COMMAND_SET_HOMING	  0x09  //Define homing mode (1 byte)
-#define	PICSERVO_COMMAND_SET_BAUD	  0x0A 	//Set the baud rate (1 byte)
-#define PICSERVO_COMMAND_CLEAR_BITS	  0x0B  //Save current pos. in home pos. register (0 bytes)
-#define PICSERVO_COMMAND_SAVE_AS_HOME  0x0C	//Store the input bytes and timer val (0 bytes)
-#define PICSERVO_COMMAND_ADD_PATHPOINT 0x0D  //Adds path points for path mode
-#define	PICSERVO_COMMAND_NOP			  0x0E	//No operation - returns prev. defined status (0 bytes)
-#define PICSERVO_COMMAND_HARD_RESET	  0x0F	//RESET - no status is returned
-
-#define PICSERVO_RESET_POSITION_DATASIZE_0 0x00
-#define PICSERVO_RESET_POSITION_DATASIZE_1 0x10
-#define PICSERVO_RESET_POSITION_DATASIZE_5 0x50
-
-#define PICSERVO_SET_ADDR_DATASIZE_2 0x20
-
-#define PICSERVO_DEF_STAT_DATASIZE_1 0x10
-
-#define PICSERVO_SET_GAIN_DATASIZE_15 0xF0
-
-#define PICSERVO_STOP_MOTOR_DATASIZE_1 0x10
-
-#define PICSERVO_IO_CONTROL_DATASIZE_1 0x10
-
-#define PICSERVO_HARD_RESET_DATASIZE_1 0x10
-
-#define PICSERVO_STATUS_TYPE_POSITION 0x01
-#define PICSERVO_STATUS_TYPE_CURRENT_SENSE 0x02
-#define PICSERVO_STATUS_TYPE_ENCODER_VELOCITY 0x04
-#define PICSERVO_STATUS_TYPE_AUXILIARY_STATUS 0x08
-#define PICSERVO_STATUS_TYPE_HOME_POSITION 0x10
-#define PICSERVO_STATUS_TYPE_DEVICE_TYPE_VERSION 0x20
-#define PICSERVO_STATUS_TYPE_SERVO_ERROR 0x40
-#define PICSERVO_STATUS_TYPE_PATH_REMAINING 0x80
+#include "PICServoProtocol.h"
 
+#define PICSERVOCOM_MAX_FRAME_SIZE 20
+#define PICSERVOCOM_MAX_STATUS_SIZE 20
+
+// Sized for every holder at once: a poll batch, a command batch or group move, and the single transactions of the
+// profiler, path streamer and user calls. Acquiring past this waits at most PICSERVOCOM_ACQUIRE_TIMEOUT, then fails.
+#define PICSERVOCOM_TRANSACTION_COUNT 64
+#define PICSERVOCOM_ACQUIRE_TIMEOUT 0.5
+
+#define PICSERVOCOM_REPLY_TIMEOUT 0.05
+#define PICSERVOCOM_PIPELINE_MARGIN 1
+#define PICSERVOCOM_RESYNC_QUIET_TIME 0.005
+#define PICSERVOCOM_BAUD_SETTLE_TIME 0.02
+
+#define PICSERVOCOM_LATENCY_BUCKETS 12
+#define PICSERVOCOM_LATENCY_BUCKET_BASE 0.0001
+
+#define PICSERVOCOM_SEND_PRIORITY 45
+#define PICSERVOCOM_RECEIVE_PRIORITY 44
+#define PICSERVOCOM_STACKSIZE 0x10000
+
+/*
+* Serial transaction engine for a network of PIC-SERVO modules.
+*
+* Module* calls encode a frame straight into a pooled transaction, queue it and return immediately. A send task
+* writes queued frames one at a time as soon as the protocol allows, overlapping them with the replies still coming
+* back, and a receive task matches replies to requests in the order they were sent. Replies can't collide, since a
+* frame is only written once the replies still outstanding are shorter than the frame itself. Frames carry a checksum,
+* replies are checked against theirs, and after a bad or missing reply the line is drained so the next frame
+* starts cleanly.
+*
+* Every transaction returned by a Module* call must be handed back with Complete () or Release (), or
+* detached with Detach (). A Module* call returns NULL if the pool stays empty for PICSERVOCOM_ACQUIRE_TIMEOUT, and
+* Wait (), Complete (), Detach () and Release () all take NULL as a failed transaction.
+*/
 class PICServoCom
 {
 public:
@@ -67,42 +59,217 @@ public:
 
 	} PICServoStatus_t;
 
+	/*
+	* Contention on one of the link's locks. Every acquisition is counted, and those that had to wait add the time
+	* they waited.
+	*/
+	typedef struct PICServoLockMetrics_t
+	{
+
+		uint32_t Acquisitions;
+		uint32_t Contentions;
+		double WaitTotal;
+		double WaitMax;
+
+	} PICServoLockMetrics_t;
+
+	/*
+	* Link counters. Every count only ever goes up, so utilization and rates come from the difference between two
+	* snapshots: ( TxLineTime1 - TxLineTime0 ) / ( Timestamp1 - Timestamp0 ) is the fraction of time the line to the
+	* modules was busy.
+	*
+	* Latency [ 0 ] counts replies that took under PICSERVOCOM_LATENCY_BUCKET_BASE seconds from the end of the write,
+	* and Latency [ n ] counts those that took between BASE * 2^(n-1) and BASE * 2^n. The last bucket is open ended.
+	*/
+	typedef struct PICServoLinkMetrics_t
+	{
+
+		double Timestamp;
+		uint32_t BaudRate;
+
+		uint32_t BytesSent;
+		uint32_t BytesReceived;
+		uint32_t BytesDiscarded;
+
+		double TxLineTime;
+		double RxLineTime;
+
+		uint32_t Frames [ 16 ];
+
+		uint32_t Replies;
+		uint32_t Timeouts;
+		uint32_t ChecksumErrors;
+		uint32_t Aborted;
+		uint32_t Resynchronizations;
+		uint32_t AcquireTimeouts;
+
+		double LatencyTotal;
+		double LatencyMax;
+		uint32_t Latency [ PICSERVOCOM_LATENCY_BUCKETS ];
+
+		// SubmitLock orders frames onto the send queue, and LinkLock guards the port against resynchronization.
+		PICServoLockMetrics_t SubmitLock;
+		PICServoLockMetrics_t LinkLock;
+
+	} PICServoLinkMetrics_t;
+
+	enum TransactionResult
+	{
+
+		kPending = 0,
+		kComplete,
+		kTimeout,
+		kChecksumError,
+		kAborted
+
+	};
+
+	typedef struct PICServoTransaction_t
+	{
+
+		uint8_t Module;
+		uint8_t StatusType;
+
+		uint8_t FrameSize;
+		uint8_t CheckSum;
+		uint8_t ReplySize;
+		uint8_t Received;
+
+		uint8_t Frame [ PICSERVOCOM_MAX_FRAME_SIZE ];
+		uint8_t Reply [ PICSERVOCOM_MAX_STATUS_SIZE ];
+
+		volatile uint32_t Result;
+		bool Detached;
+
+		double SendTime;
+
+		SEM_ID Done;
+
+	} PICServoTransaction_t;
+
 	PICServoCom ();
 	~PICServoCom ();
 
-	void ModuleResetPosition ( uint8_t Module, bool Relative = false );
-	void ModuleOverwritePosition ( uint8_t Module, int32_t Position = 0 );
-	void ModuleSetAddress ( uint8_t Module, uint8_t NewAddress, uint8_t NewGroupAddress );
-	void ModuleDefineStatus ( uint8_t Module, uint8_t Type = 0 );
-	void ModuleReadStatus ( uint8_t Module, uint8_t Type, PICServoStatus_t * Status );
-	void ModuleStopMotor ( uint8_t Module, bool AmplifierEnabled, bool MotorOff = true, bool Abruptly = true );
-	void ModuleSetMetrics ( uint8_t Module, uint16_t P, uint16_t I, uint16_t D, uint16_t IntegrationLimit = 32767, uint8_t OutputLimit = 127, int8_t CurrentLimit = 127, uint16_t PositionErrorLimit = 32767, uint8_t ServoRateDevisor = 1, uint8_t AmplifierDeadbandCompensation = 0, uint8_t StepRateMultiplier = 1 );
-	void ModuleIOControl ( uint8_t Module, bool LimitSwitches, bool LimitAbruptly, bool ThreePhaseCom, bool AntiphasePWM, bool FastPath, bool StepAndDirection );
-	void ModuleClearStatus ( uint8_t Module );
-	void ModuleGetStatus ( uint8_t Module );
-	void ModuleHardReset ( uint8_t Module );
-	void ModuleHardReset ( uint8_t Module, bool SaveConfigInEERROM, bool RestoreAddresses, bool AmplifierEnabled, bool ServoEnabled, bool StepAndDirectionEnabled, bool LimitAndStopEnabled, bool ThreePhaseComEnabled, bool AntiphasePWMEnabled );
-	void ModuleLoadTrajectory ( uint8_t Module, int32_t Position, double Velocity, double Acceleration, int16_t PWM, bool LoadPosition, bool LoadVelocity, bool LoadAcceleration, bool LoadPWM, bool EnableServo, bool VelocityProfileMode = true, bool RelativePosition = 0, bool ImmediateMotion = true );
+	PICServoTransaction_t * ModuleResetPosition ( uint8_t Module, bool Relative = false );
+	PICServoTransaction_t * ModuleOverwritePosition ( uint8_t Module, int32_t Position = 0 );
+	PICServoTransaction_t * ModuleSetAddress ( uint8_t Module, uint8_t NewAddress, uint8_t NewGroupAddress );
+	PICServoTransaction_t * ModuleDefineStatus ( uint8_t Module, uint8_t Type = 0 );
+	PICServoTransaction_t * ModuleRequestStatus ( uint8_t Module, uint8_t Type );
+	PICServoTransaction_t * ModuleStopMotor ( uint8_t Module, bool AmplifierEnabled, bool MotorOff = true, bool Abruptly = true );
+	PICServoTransaction_t * ModuleSetMetrics ( uint8_t Module, uint16_t P, uint16_t I, uint16_t D, uint16_t IntegrationLimit = 32767, uint8_t OutputLimit = 127, int8_t CurrentLimit = 127, uint16_t PositionErrorLimit = 32767, uint8_t ServoRateDevisor = 1, uint8_t AmplifierDeadbandCompensation = 0, uint8_t StepRateMultiplier = 1 );
+	PICServoTransaction_t * ModuleIOControl ( uint8_t Module, bool LimitSwitches, bool LimitAbruptly, bool ThreePhaseCom, bool AntiphasePWM, bool FastPath, bool StepAndDirection );
+	PICServoTransaction_t * ModuleClearStatus ( uint8_t Module );
+	PICServoTransaction_t * ModuleGetStatus ( uint8_t Module );
+	PICServoTransaction_t * ModuleHardReset ( uint8_t Module );
+	PICServoTransaction_t * ModuleHardReset ( uint8_t Module, bool SaveConfigInEERROM, bool RestoreAddresses, bool AmplifierEnabled, bool ServoEnabled, bool StepAndDirectionEnabled, bool LimitAndStopEnabled, bool ThreePhaseComEnabled, bool AntiphasePWMEnabled );
+	PICServoTransaction_t * ModuleSetBaud ( uint8_t Module, uint8_t Divisor );
+	PICServoTransaction_t * ModuleStartMove ( uint8_t Module );
+	PICServoTransaction_t * ModuleAddPathPoints ( uint8_t Module, const int32_t * Points, uint8_t Count );
+	PICServoTransaction_t * ModuleLoadTrajectory ( uint8_t Module, int32_t Position, double Velocity, double Acceleration, int16_t PWM, bool LoadPosition, bool LoadVelocity, bool LoadAcceleration, bool LoadPWM, bool EnableServo, bool VelocityProfileMode = true, bool RelativePosition = 0, bool ImmediateMotion = true );
+
+	bool ModuleReadStatus ( uint8_t Module, uint8_t Type, PICServoStatus_t * Status );
+
+	bool Wait ( PICServoTransaction_t * Transaction, PICServoStatus_t * Status = NULL );
+	bool Complete ( PICServoTransaction_t * Transaction, PICServoStatus_t * Status = NULL );
+	void Detach ( PICServoTransaction_t * Transaction );
+	void Release ( PICServoTransaction_t * Transaction );
+
+	uint8_t GetStatusType ( uint8_t Module );
 
-	void ReceiveStatusPacket ();
+	static void DecodeStatus ( const uint8_t * Bytes, uint8_t Type, PICServoStatus_t * Status );
+	static uint8_t StatusPacketSize ( uint8_t Type );
 
-	void GetStatus ( PICServoStatus_t * Status );
+	bool NegotiateBaud ( uint32_t BaudRate, uint8_t GroupAddress, const uint8_t * Modules, uint32_t Count );
+	uint32_t GetBaudRate ();
 
-	void SerialTaskLock ();
-	void SerialTaskUnlock ();
+	uint32_t GetChecksumErrorCount ( uint8_t Module );
+	uint32_t GetTimeoutCount ( uint8_t Module );
+
+	void GetLinkMetrics ( PICServoLinkMetrics_t * Metrics );
+	void GetLatencyHistogram ( uint8_t Module, uint32_t * Buckets );
 
 private:
 
-	void SendMessage ( uint8_t Address, uint8_t Command, uint8_t * Data, uint8_t DataSize );
-	void ReceiveMessage ( uint8_t * Buffer, uint8_t Count );
+	PICServoTransaction_t * BeginFrame ( uint8_t Address, uint8_t Command );
+	PICServoTransaction_t * SubmitFrame ( PICServoTransaction_t * Transaction );
+
+	PICServoTransaction_t * AcquireTransaction ();
+	void FinishTransaction ( PICServoTransaction_t * Transaction, uint32_t Result );
+
+	void SendLoop ();
+	void ReceiveLoop ();
+	void Resynchronize ();
+
+	void TakeLock ( SEM_ID Lock, PICServoLockMetrics_t * Metrics );
+
+	static bool ChecksumValid ( const uint8_t * Bytes, uint8_t Size );
+
+	void RecordLatency ( uint8_t Module, double Time );
+
+	void OpenPort ( uint32_t BaudRate );
+	void ReopenPort ( uint32_t BaudRate );
+	void SwapPort ();
+	bool VerifyModules ( const uint8_t * Modules, uint32_t Count );
 
+	static bool BaudDivisor ( uint32_t BaudRate, uint8_t * Divisor );
+
+	static int _StartSendTask ( PICServoCom * This );
+	static int _StartReceiveTask ( PICServoCom * This );
+
+	// Only the receive task replaces the port once the tasks are running, so its reads never race a reopen.
 	SerialPort * Port;
+	uint32_t CurrentBaudRate;
+	uint32_t ReopenBaudRate;
+
+	SEM_ID SubmitLock;
+	SEM_ID TransactionLock;
+	SEM_ID LinkLock;
+	SEM_ID ProgressSemaphore;
+	SEM_ID ReopenDone;
+
+	Task * SendTask;
+	Task * ReceiveTask;
+
+	MSG_Q_ID SendQueue;
+	MSG_Q_ID PendingQueue;
+	MSG_Q_ID FreeQueue;
+
+	PICServoTransaction_t * Transactions;
+
+	// Reply bytes owed by the modules are ReplyBytesExpected - ReplyBytesReceived. Each side is written by only one task.
+	volatile uint32_t ReplyBytesExpected;
+	volatile uint32_t ReplyBytesReceived;
+
+	uint8_t ModuleStatusType [ 256 ];
+
+	uint32_t ChecksumErrors [ 256 ];
+	uint32_t Timeouts [ 256 ];
+
+	// Link metrics. Each counter has a single writer: the send task, the receive task, or the holder of a lock.
+	// Readers just copy them, so a snapshot is made of whole counters but isn't taken at a single instant.
+	uint32_t BytesSent;
+	uint32_t BytesReceived;
+	uint32_t BytesDiscarded;
+
+	double TxLineTime;
+	double RxLineTime;
+
+	uint32_t FramesSent [ 16 ];
+
+	uint32_t Replies;
+	uint32_t Aborted;
+	uint32_t Resynchronizations;
+
+	// Written under TransactionLock, since any task can run out of transactions.
+	uint32_t AcquireTimeouts;
 
-	SEM_ID SerialLock;
+	double LatencyTotal;
+	double LatencyMax;
+	uint32_t Latency [ 256 ][ PICSERVOCOM_LATENCY_BUCKETS ];
 
-	uint8_t StatusType;
-	uint8_t StatusSize;
-	uint8_t * StatusBytes;
+	// Only written by whoever holds the lock being measured.
+	PICServoLockMetrics_t SubmitLockMetrics;
+	PICServoLockMetrics_t LinkLockMetrics;
 
 };
 
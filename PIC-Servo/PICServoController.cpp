@@ -5,22 +5,72 @@ PICServoController :: PICServoController ( uint8_t GroupAddress )
 
 	this -> GroupAddress = GroupAddress;
 
-	Modules = new PICServo * [ 256 ];
+	for ( uint32_t i = 0; i < 256; i ++ )
+	{
 
-	for ( uint8_t i = 0; i != 255; i ++ )
 		Modules [ i ] = NULL;
+		ModuleIndex [ i ] = - 1;
+
+	}
+
+	ModuleCount = 0;
+	RegistryLock = semMCreate ( SEM_Q_PRIORITY | SEM_DELETE_SAFE | SEM_INVERSION_SAFE );
 
 	Com = new PICServoCom ();
 	PipeServer = new AnalogCANJaguarPipeServer ();
 
 	PipeServer -> Start ();
 
+	PollTask = new Task ( "2605_PICServoController_Poll", (FUNCPTR) & _StartPollTask, PICSERVOCONTROLLER_POLL_PRIORITY, PICSERVOCONTROLLER_POLL_STACKSIZE );
+	PollLock = semMCreate ( SEM_Q_PRIORITY | SEM_DELETE_SAFE | SEM_INVERSION_SAFE );
+	Polling = false;
+
+	StartPolling ();
+
+	CommandTask = new Task ( "2605_PICServoController_Command", (FUNCPTR) & _StartCommandTask, PICSERVOCONTROLLER_COMMAND_PRIORITY, PICSERVOCONTROLLER_COMMAND_STACKSIZE );
+	CommandLock = semMCreate ( SEM_Q_PRIORITY | SEM_DELETE_SAFE | SEM_INVERSION_SAFE );
+	MailboxLock = semMCreate ( SEM_Q_PRIORITY | SEM_DELETE_SAFE | SEM_INVERSION_SAFE );
+	CommandSignal = semBCreate ( SEM_Q_FIFO, SEM_EMPTY );
+	CommandCursor = 0;
+
+	CommandTask -> Start ( reinterpret_cast <uint32_t> ( this ) );
+
 };
 
 PICServoController :: ~PICServoController ()
 {
 
+	StopPolling ();
+
+	delete PollTask;
+	semDelete ( PollLock );
+
+	// Like the poller, the command task holds its lock while it has transactions out.
+	semTake ( CommandLock, WAIT_FOREVER );
+
+	CommandTask -> Stop ();
 
+	semGive ( CommandLock );
+
+	delete CommandTask;
+
+	semDelete ( CommandLock );
+	semDelete ( MailboxLock );
+	semDelete ( CommandSignal );
+
+	// Leave every motor off before the link goes away.
+	for ( uint32_t i = 0; i < ModuleCount; i ++ )
+		Com -> Complete ( Com -> ModuleStopMotor ( Modules [ i ] -> ModuleNumber, false, true, true ) );
+
+	delete Com;
+
+	// The pipe server owns the Jaguars and analog channels behind the pipes.
+	delete PipeServer;
+
+	for ( uint32_t i = 0; i < ModuleCount; i ++ )
+		delete Modules [ i ];
+
+	semDelete ( RegistryLock );
 
 };
 
@@ -36,200 +86,477 @@ void PICServoController :: AddPICServo ( uint8_t ModuleNumber, bool Initialize,
 
 	PICServo * Module;
 
-	Com -> SerialTaskLock ();
+	semTake ( RegistryLock, WAIT_FOREVER );
 
-	if ( Modules [ ModuleNumber ] != NULL )
+	if ( ModuleIndex [ ModuleNumber ] >= 0 )
 	{
 
-		Module = Modules [ ModuleNumber ];
+		Module = Modules [ ModuleIndex [ ModuleNumber ] ];
 
-		PipeServer -> DisablePipe ( Module -> MotorPipe );
-		PipeServer -> RemovePipe ( Module -> MotorPipe );
+		// Pipe handles are stable, so the replacement can be brought up before the old pipe is torn down.
+		AnalogCANJaguarPipe_t OldPipe = Module -> MotorPipe;
 
 		Module -> MotorPipe = PipeServer -> AddPipe ( JaguarID, AnalogChannel, AnalogModule );
 
-		Com -> ModuleStopMotor ( ModuleNumber, false, true, true );
-		Com -> ReceiveStatusPacket ();
+		// The replacement keeps the old pipe's transfer chain, gating, period and oversampling. Its offset belongs to
+		// the new input, so a servo that zeroed or offset its pipe has to do that again.
+		PipeServer -> CopyPipeSettings ( OldPipe, Module -> MotorPipe );
+
+		PipeServer -> DisablePipe ( OldPipe );
+		PipeServer -> RemovePipe ( OldPipe );
+
+		// New pipes start out disabled, so an enabled servo has to have its replacement turned on.
+		if ( Module -> MotorPipeEnabled )
+			PipeServer -> EnablePipe ( Module -> MotorPipe );
+
+		// A replacement module comes up on address 0, like a new one.
+		if ( Initialize )
+			Com -> Complete ( Com -> ModuleSetAddress ( 0, ModuleNumber, GroupAddress ) );
+
+		Com -> Complete ( Com -> ModuleStopMotor ( ModuleNumber, false, true, true ) );
 
 	}
 	else
 	{
 
 		Module = new PICServo ( ModuleNumber, this, PipeServer -> AddPipe ( JaguarID, AnalogChannel, AnalogModule ) );
-		Modules [ ModuleNumber ] = Module;
+
+		Modules [ ModuleCount ] = Module;
+		ModuleIndex [ ModuleNumber ] = ModuleCount;
+
+		ModuleCount ++;
 
 		if ( Initialize )
 		{
 
-			Com -> ModuleSetAddress ( 0, ModuleNumber, GroupAddress );
-			Com -> ReceiveStatusPacket ();
+			Com -> Complete ( Com -> ModuleSetAddress ( 0, ModuleNumber, GroupAddress ) );
 
 		}
 
 	}
 
-	Com -> SerialTaskUnlock ();
+	semGive ( RegistryLock );
 
 };
 
 PICServo * PICServoController :: GetModule ( uint8_t Module )
 {
 
-	return Modules [ Module ];
+	if ( ModuleIndex [ Module ] < 0 )
+		return NULL;
+
+	return Modules [ ModuleIndex [ Module ] ];
 
 };
 
-void PICServoController :: PICServoEnable ( uint8_t ModuleNumber )
+/**
+* Number of modules added so far.
+*/
+uint32_t PICServoController :: GetModuleCount ()
 {
 
-	PICServo * Module = Modules [ ModuleNumber ];
+	return ModuleCount;
 
-	PipeServer -> EnablePipe ( Module -> MotorPipe );
+};
+
+/**
+* Module by the order it was added in, for walking every module without scanning all the addresses.
+*
+* @return The module, or NULL if Index is past the last one.
+*/
+PICServo * PICServoController :: GetModuleByIndex ( uint32_t Index )
+{
+
+	if ( Index >= ModuleCount )
+		return NULL;
+
+	return Modules [ Index ];
 
 };
 
-void PICServoController :: PICServoDisable ( uint8_t ModuleNumber )
+/**
+* Move several servos together. Each servo's trajectory is loaded without starting it, then a single
+* START_MOVE is broadcast to the group address, so every axis starts on the same frame.
+*
+* @param Count Number of servos. ( At most PICSERVOCONTROLLER_GROUP_MOVE_MAX )
+* @param Servos Servos to move. All of them must belong to this controller.
+* @param Values Setpoint for each servo, as it would be passed to PICServo :: Set ().
+* @return Whether every module took its trajectory and the move was started.
+*/
+bool PICServoController :: CoordinatedMove ( uint32_t Count, PICServo ** Servos, const double * Values )
 {
 
-	PICServo * Module = Modules [ ModuleNumber ];
+	if ( Count > PICSERVOCONTROLLER_GROUP_MOVE_MAX )
+		return false;
 
-	PipeServer -> DisablePipe ( Module -> MotorPipe );
+	PICServoSetpoint_t Setpoints [ PICSERVOCONTROLLER_GROUP_MOVE_MAX ];
+
+	// Holding the command lock keeps the command task's immediate loads out until the move has started.
+	semTake ( CommandLock, WAIT_FOREVER );
+	semTake ( MailboxLock, WAIT_FOREVER );
+
+	// A setpoint still waiting in a mailbox would override the move, so it's dropped.
+	for ( uint32_t i = 0; i < Count; i ++ )
+	{
+
+		Servos [ i ] -> MailboxFull = false;
+		Servos [ i ] -> TakeSetpoint ( Values [ i ], & Setpoints [ i ] );
+		Servos [ i ] -> LastSet = Setpoints [ i ].Value;
+
+	}
+
+	semGive ( MailboxLock );
+
+	bool Moved = LoadGroupMove ( Count, Servos, Setpoints );
+
+	semGive ( CommandLock );
+
+	return Moved;
 
 };
 
-void PICServoController :: PICServoSetPWM ( uint8_t ModuleNumber, int16_t PWM )
+/**
+* Start every trajectory preloaded on this controller's group.
+*/
+bool PICServoController :: StartGroupMove ()
 {
 
-	Com -> SerialTaskLock ();
+	return Com -> Complete ( Com -> ModuleStartMove ( GroupAddress ) );
+
+};
 
-	Com -> ModuleLoadTrajectory ( ModuleNumber, 0, 0, 0, PWM, false, false, false, true, false, false, false, true );
-	Com -> ReceiveStatusPacket ();
+/**
+* Step every module added so far, and the serial port, up to a faster baud rate. Call once the modules are added.
+*
+* @return Whether the network is running at BaudRate. On failure it stays at the old rate.
+*/
+bool PICServoController :: SetBaudRate ( uint32_t BaudRate )
+{
 
-	Com -> SerialTaskUnlock ();
+	uint8_t Addresses [ 256 ];
+	uint32_t Count = ModuleCount;
+
+	for ( uint32_t i = 0; i < Count; i ++ )
+		Addresses [ i ] = Modules [ i ] -> ModuleNumber;
+
+	return Com -> NegotiateBaud ( BaudRate, GroupAddress, Addresses, Count );
 
 };
 
-void PICServoController :: PICServoSetPosition ( uint8_t ModuleNumber, double Position )
+/**
+* Start reading PICSERVOCONTROLLER_POLL_STATUS from every module in round robin, and caching it in each PICServo.
+*/
+bool PICServoController :: StartPolling ()
 {
 
-	Com -> SerialTaskLock ();
+	if ( Polling )
+		return true;
 
-	Com -> ModuleLoadTrajectory ( ModuleNumber, static_cast <uint32_t> ( Position ), 0.0, 0.0, 0, true, false, false, false, true, false, false, true );
-	Com -> ReceiveStatusPacket ();
+	Polling = PollTask -> Start ( reinterpret_cast <uint32_t> ( this ) );
 
-	Com -> SerialTaskUnlock ();
+	return Polling;
 
 };
 
-void PICServoController :: PICServoSetPositionV ( uint8_t ModuleNumber, double Position, double Velocity )
+void PICServoController :: StopPolling ()
 {
 
-	Com -> SerialTaskLock ();
+	if ( ! Polling )
+		return;
+
+	// The poll task holds the lock while it has transactions out.
+	semTake ( PollLock, WAIT_FOREVER );
+
+	PollTask -> Stop ();
 
-	Com -> ModuleLoadTrajectory ( ModuleNumber, static_cast <uint32_t> ( Position ), static_cast <uint32_t> ( Velocity ), 0.0, 0, true, true, false, false, true, false, false, true );
-	Com -> ReceiveStatusPacket ();
+	semGive ( PollLock );
 
-	Com -> SerialTaskUnlock ();
+	Polling = false;
 
 };
 
-void PICServoController :: PICServoSetPositionA ( uint8_t ModuleNumber, double Position, double Acceleration )
+void PICServoController :: PICServoEnable ( uint8_t ModuleNumber )
 {
 
-	Com -> SerialTaskLock ();
+	PICServo * Module = GetModule ( ModuleNumber );
+
+	// Held so AddPICServo can't swap the pipe out from under this.
+	semTake ( RegistryLock, WAIT_FOREVER );
 
-	Com -> ModuleLoadTrajectory ( ModuleNumber, static_cast <uint32_t> ( Position ), 0.0, static_cast <uint32_t> ( Acceleration ), 0, true, false, true, false, true, false, false, true );
-	Com -> ReceiveStatusPacket ();
+	PipeServer -> EnablePipe ( Module -> MotorPipe );
+	Module -> MotorPipeEnabled = true;
 
-	Com -> SerialTaskUnlock ();
+	semGive ( RegistryLock );
 
 };
 
-void PICServoController :: PICServoSetPositionVA ( uint8_t ModuleNumber, double Position, double Velocity, double Acceleration )
+void PICServoController :: PICServoDisable ( uint8_t ModuleNumber )
 {
 
-	Com -> SerialTaskLock ();
+	PICServo * Module = GetModule ( ModuleNumber );
 
-	Com -> ModuleLoadTrajectory ( ModuleNumber, static_cast <uint32_t> ( Position ), Velocity, Acceleration, 0, true, true, true, false, true, false, false, true );
-	Com -> ReceiveStatusPacket ();
+	semTake ( RegistryLock, WAIT_FOREVER );
 
-	Com -> SerialTaskUnlock ();
+	PipeServer -> DisablePipe ( Module -> MotorPipe );
+	Module -> MotorPipeEnabled = false;
+
+	semGive ( RegistryLock );
 
 };
 
-void PICServoController :: PICServoResetPosition ( uint8_t ModuleNumber )
+PICServoCom :: PICServoTransaction_t * PICServoController :: PICServoSetPWM ( uint8_t ModuleNumber, int16_t PWM, bool Immediate )
+{
+
+	return Com -> ModuleLoadTrajectory ( ModuleNumber, 0, 0, 0, PWM, false, false, false, true, false, false, false, Immediate );
+
+};
+
+PICServoCom :: PICServoTransaction_t * PICServoController :: PICServoSetPosition ( uint8_t ModuleNumber, double Position, bool Immediate )
+{
+
+	return Com -> ModuleLoadTrajectory ( ModuleNumber, static_cast <int32_t> ( Position ), 0.0, 0.0, 0, true, false, false, false, true, false, false, Immediate );
+
+};
+
+PICServoCom :: PICServoTransaction_t * PICServoController :: PICServoSetPositionV ( uint8_t ModuleNumber, double Position, double Velocity, bool Immediate )
+{
+
+	return Com -> ModuleLoadTrajectory ( ModuleNumber, static_cast <int32_t> ( Position ), static_cast <uint32_t> ( Velocity ), 0.0, 0, true, true, false, false, true, false, false, Immediate );
+
+};
+
+PICServoCom :: PICServoTransaction_t * PICServoController :: PICServoSetPositionA ( uint8_t ModuleNumber, double Position, double Acceleration, bool Immediate )
 {
 
-	Com -> SerialTaskLock ();
+	return Com -> ModuleLoadTrajectory ( ModuleNumber, static_cast <int32_t> ( Position ), 0.0, static_cast <uint32_t> ( Acceleration ), 0, true, false, true, false, true, false, false, Immediate );
 
-	Com -> ModuleResetPosition ( ModuleNumber, false );
-	Com -> ReceiveStatusPacket ();
+};
+
+PICServoCom :: PICServoTransaction_t * PICServoController :: PICServoSetPositionVA ( uint8_t ModuleNumber, double Position, double Velocity, double Acceleration, bool Immediate )
+{
 
-	Com -> SerialTaskUnlock ();
+	return Com -> ModuleLoadTrajectory ( ModuleNumber, static_cast <int32_t> ( Position ), Velocity, Acceleration, 0, true, true, true, false, true, false, false, Immediate );
+
+};
+
+void PICServoController :: PICServoResetPosition ( uint8_t ModuleNumber )
+{
+
+	Com -> Complete ( Com -> ModuleResetPosition ( ModuleNumber, false ) );
 
 };
 
 void PICServoController :: PICServoSetCurrentPosition ( uint8_t ModuleNumber, double Position )
 {
 
-	Com -> SerialTaskLock ();
+	Com -> Complete ( Com -> ModuleOverwritePosition ( ModuleNumber, static_cast <int32_t> ( Position ) ) );
 
-	Com -> ModuleOverwritePosition ( ModuleNumber, static_cast <int32_t> ( Position ) );
-	Com -> ReceiveStatusPacket ();
+};
 
-	Com -> SerialTaskUnlock ();
+void PICServoController :: PICServoSetPID ( uint8_t ModuleNumber, double P, double I, double D )
+{
+
+	Com -> Complete ( Com -> ModuleSetMetrics ( ModuleNumber, static_cast <uint16_t> ( P * 1024 ), static_cast <uint16_t> ( I * 1024 ), static_cast <uint16_t> ( D * 1024 ) ) );
 
 };
 
-double PICServoController :: PICServoReadPosition ( uint8_t ModuleNumber )
+PICServoCom :: PICServoTransaction_t * PICServoController :: PICServoSetVelocityA ( uint8_t ModuleNumber, double Velocity, double Acceleration, bool Immediate )
 {
 
+	return Com -> ModuleLoadTrajectory ( ModuleNumber, 0, Velocity, Acceleration, 0, false, true, true, false, true, true, false, Immediate );
+
+};
+
+PICServoCom :: PICServoTransaction_t * PICServoController :: PICServoSetVelocity ( uint8_t ModuleNumber, double Velocity, bool Immediate )
+{
+
+	return Com -> ModuleLoadTrajectory ( ModuleNumber, 0, Velocity, 0, 0, false, true, false, false, true, true, false, Immediate );
+
+};
+
+void PICServoController :: PollLoop ()
+{
+
+	PICServoCom :: PICServoTransaction_t * Requests [ PICSERVOCONTROLLER_POLL_BATCH ];
 	PICServoCom :: PICServoStatus_t Status;
 
-	Com -> SerialTaskLock ();
+	while ( true )
+	{
 
-	Com -> ModuleReadStatus ( ModuleNumber, PICSERVO_STATUS_TYPE_POSITION, & Status );
+		double Start = Timer :: GetPPCTimestamp ();
 
-	Com -> SerialTaskUnlock ();
+		// Modules are only ever appended, under the registry lock, so everything below the count read here
+		// stays put without copying the list.
+		semTake ( RegistryLock, WAIT_FOREVER );
 
-	return Status.Position;
+		uint32_t Count = ModuleCount;
+
+		semGive ( RegistryLock );
+
+		semTake ( PollLock, WAIT_FOREVER );
+
+		// Requests go out a batch at a time, so the link pipelines them.
+		for ( uint32_t Base = 0; Base < Count; Base += PICSERVOCONTROLLER_POLL_BATCH )
+		{
+
+			uint32_t Batch = Count - Base;
+
+			if ( Batch > PICSERVOCONTROLLER_POLL_BATCH )
+				Batch = PICSERVOCONTROLLER_POLL_BATCH;
+
+			for ( uint32_t i = 0; i < Batch; i ++ )
+				Requests [ i ] = Com -> ModuleRequestStatus ( Modules [ Base + i ] -> ModuleNumber, PICSERVOCONTROLLER_POLL_STATUS );
+
+			for ( uint32_t i = 0; i < Batch; i ++ )
+			{
+
+				Status = Modules [ Base + i ] -> CachedStatus;
+
+				if ( Com -> Complete ( Requests [ i ], & Status ) )
+					Modules [ Base + i ] -> PublishStatus ( & Status, Timer :: GetPPCTimestamp () );
+
+			}
+
+		}
+
+		semGive ( PollLock );
+
+		double Elapsed = Timer :: GetPPCTimestamp () - Start;
+
+		if ( Elapsed < PICSERVOCONTROLLER_POLL_PERIOD )
+			Wait ( PICSERVOCONTROLLER_POLL_PERIOD - Elapsed );
+
+	}
 
 };
 
-void PICServoController :: PICServoSetPID ( uint8_t ModuleNumber, double P, double I, double D )
+// Leave a setpoint in a servo's mailbox, replacing any the command task hasn't sent yet.
+void PICServoController :: PostSetpoint ( PICServo * Servo, double Value )
+{
+
+	semTake ( MailboxLock, WAIT_FOREVER );
+
+	Servo -> Mailbox = Value;
+	Servo -> MailboxFull = true;
+
+	Servo -> LastSet = Servo -> ScaleSetpoint ( Value );
+
+	semGive ( MailboxLock );
+
+	semGive ( CommandSignal );
+
+};
+
+/*
+* Queue a trajectory for each servo with ImmediateMotion off, then start them all with one group START_MOVE. Every
+* load is queued before any is waited on, so they share the link instead of taking turns. Call with CommandLock held,
+* and MailboxLock free.
+*/
+bool PICServoController :: LoadGroupMove ( uint32_t Count, PICServo ** Servos, const PICServoSetpoint_t * Setpoints )
 {
 
-	Com -> SerialTaskLock ();
+	PICServoCom :: PICServoTransaction_t * Loads [ PICSERVOCONTROLLER_GROUP_MOVE_MAX ];
+
+	for ( uint32_t i = 0; i < Count; i ++ )
+		Loads [ i ] = Servos [ i ] -> Load ( & Setpoints [ i ], false );
+
+	bool Loaded = true;
 
-	Com -> ModuleSetMetrics ( ModuleNumber, static_cast <uint16_t> ( P * 1024 ), static_cast <uint16_t> ( I * 1024 ), static_cast <uint16_t> ( D * 1024 ) );
-	Com -> ReceiveStatusPacket ();
+	for ( uint32_t i = 0; i < Count; i ++ )
+		Loaded &= Com -> Complete ( Loads [ i ] );
 
-	Com -> SerialTaskUnlock ();
+	// Modules that did take their trajectory keep it until the next START_MOVE.
+	if ( ! Loaded )
+		return false;
+
+	return StartGroupMove ();
 
 };
 
-void PICServoController :: PICServoSetVelocityA ( uint8_t ModuleNumber, double Velocity, double Acceleration )
+/*
+* Sends the setpoints left in the mailboxes. Each pass takes up to a batch of full mailboxes in round robin, starting
+* after the last module served, so a servo updated every tick can't starve the others. Only the newest setpoint for
+* each module is ever sent.
+*/
+void PICServoController :: CommandLoop ()
 {
 
-	Com -> SerialTaskLock ();
+	PICServo * Servos [ PICSERVOCONTROLLER_COMMAND_BATCH ];
+	PICServoSetpoint_t Setpoints [ PICSERVOCONTROLLER_COMMAND_BATCH ];
+	PICServoCom :: PICServoTransaction_t * Loads [ PICSERVOCONTROLLER_COMMAND_BATCH ];
+
+	while ( true )
+	{
+
+		semTake ( CommandSignal, WAIT_FOREVER );
+
+		while ( true )
+		{
+
+			semTake ( RegistryLock, WAIT_FOREVER );
+
+			uint32_t Count = ModuleCount;
+
+			semGive ( RegistryLock );
 
-	Com -> ModuleLoadTrajectory ( ModuleNumber, 0, Velocity, Acceleration, 0, false, true, true, false, true, true, false, true );
-	Com -> ReceiveStatusPacket ();
+			semTake ( CommandLock, WAIT_FOREVER );
+			semTake ( MailboxLock, WAIT_FOREVER );
 
-	Com -> SerialTaskUnlock ();
+			uint32_t Taken = 0;
 
+			for ( uint32_t i = 0; i < Count && Taken < PICSERVOCONTROLLER_COMMAND_BATCH; i ++ )
+			{
+
+				uint32_t Index = ( CommandCursor + i ) % Count;
+				PICServo * Servo = Modules [ Index ];
+
+				if ( ! Servo -> MailboxFull )
+					continue;
+
+				Servo -> MailboxFull = false;
+				Servo -> TakeSetpoint ( Servo -> Mailbox, & Setpoints [ Taken ] );
+
+				Servos [ Taken ++ ] = Servo;
+
+				CommandCursor = Index + 1;
+
+			}
+
+			semGive ( MailboxLock );
+
+			// Loading can wait on the link, so it happens with the mailboxes free and Set () never waits on it.
+			for ( uint32_t i = 0; i < Taken; i ++ )
+				Loads [ i ] = Servos [ i ] -> Load ( & Setpoints [ i ], true );
+
+			for ( uint32_t i = 0; i < Taken; i ++ )
+				Com -> Complete ( Loads [ i ] );
+
+			semGive ( CommandLock );
+
+			if ( Taken == 0 )
+				break;
+
+		}
+
+	}
 
 };
 
-void PICServoController :: PICServoSetVelocity ( uint8_t ModuleNumber, double Velocity )
+int PICServoController :: _StartCommandTask ( PICServoController * This )
 {
 
-	Com -> SerialTaskLock ();
+	This -> CommandLoop ();
+
+	return 0;
+
+};
+
+int PICServoController :: _StartPollTask ( PICServoController * This )
+{
 
-	Com -> ModuleLoadTrajectory ( ModuleNumber, 0, Velocity, 0, 0, false, true, false, false, true, true, false, true );
-	Com -> ReceiveStatusPacket ();
+	This -> PollLoop ();
 
-	Com -> SerialTaskUnlock ();
+	return 0;
 
 };
 
@@ -3,12 +3,32 @@
 
 #include "PICServo.h"
 #include "PICServoCom.h"
+#include "PICServoSetpoint.h"
 #include "AnalogCANJaguarPipeServer.h"
 
+#define PICSERVOCONTROLLER_GROUP_MOVE_MAX 16
+
+#define PICSERVOCONTROLLER_POLL_STATUS ( PICSERVO_STATUS_TYPE_POSITION | PICSERVO_STATUS_TYPE_CURRENT_SENSE | PICSERVO_STATUS_TYPE_ENCODER_VELOCITY | PICSERVO_STATUS_TYPE_SERVO_ERROR )
+#define PICSERVOCONTROLLER_POLL_PERIOD 0.01
+#define PICSERVOCONTROLLER_POLL_BATCH 8
+
+#define PICSERVOCONTROLLER_POLL_PRIORITY 60
+#define PICSERVOCONTROLLER_POLL_STACKSIZE 0x8000
+
+#define PICSERVOCONTROLLER_COMMAND_BATCH 8
+
+#define PICSERVOCONTROLLER_COMMAND_PRIORITY 58
+#define PICSERVOCONTROLLER_COMMAND_STACKSIZE 0x8000
+
+class PICServo;
+
 class PICServoController
 {
 
 	friend class PICServo;
+	friend class PICServoPathStreamer;
+	friend class PICServoProfiler;
+	friend class PICServoGroupPlanner;
 
 public:
 
@@ -20,6 +40,17 @@ public:
 
 	PICServo * GetModule ( uint8_t ModuleNumber );
 
+	uint32_t GetModuleCount ();
+	PICServo * GetModuleByIndex ( uint32_t Index );
+
+	bool CoordinatedMove ( uint32_t Count, PICServo ** Servos, const double * Values );
+	bool StartGroupMove ();
+
+	bool SetBaudRate ( uint32_t BaudRate = PICSERVO_BAUD_RATE_FAST );
+
+	bool StartPolling ();
+	void StopPolling ();
+
 	//AnalogCANJaguarPipe_t GetPipeID ( uint8_t ModuleNumber );
 
 private:
@@ -27,30 +58,57 @@ private:
 	void PICServoEnable ( uint8_t ModuleNumber );
 	void PICServoDisable ( uint8_t ModuleNumber );
 
-	void PICServoSetPWM ( uint8_t ModuleNumber, int16_t PWM );
+	PICServoCom :: PICServoTransaction_t * PICServoSetPWM ( uint8_t ModuleNumber, int16_t PWM, bool Immediate = true );
 
-	void PICServoSetPosition ( uint8_t ModuleNumber, double Position );
-	void PICServoSetPositionV ( uint8_t ModuleNumber, double Position, double Velocity );
-	void PICServoSetPositionA ( uint8_t ModuleNumber, double Position, double Acceleration );
-	void PICServoSetPositionVA ( uint8_t ModuleNumber, double Position, double Velocity, double Acceleration );
+	PICServoCom :: PICServoTransaction_t * PICServoSetPosition ( uint8_t ModuleNumber, double Position, bool Immediate = true );
+	PICServoCom :: PICServoTransaction_t * PICServoSetPositionV ( uint8_t ModuleNumber, double Position, double Velocity, bool Immediate = true );
+	PICServoCom :: PICServoTransaction_t * PICServoSetPositionA ( uint8_t ModuleNumber, double Position, double Acceleration, bool Immediate = true );
+	PICServoCom :: PICServoTransaction_t * PICServoSetPositionVA ( uint8_t ModuleNumber, double Position, double Velocity, double Acceleration, bool Immediate = true );
 
 	void PICServoResetPosition ( uint8_t ModuleNumber );
 	void PICServoSetCurrentPosition ( uint8_t ModuleNumber, double Position );
 
-	double PICServoReadPosition ( uint8_t ModuleNumber );
-
-	void PICServoSetVelocityA ( uint8_t ModuleNumber, double Velocity, double Acceleration );
-	void PICServoSetVelocity ( uint8_t ModuleNumber, double Velocity );
+	PICServoCom :: PICServoTransaction_t * PICServoSetVelocityA ( uint8_t ModuleNumber, double Velocity, double Acceleration, bool Immediate = true );
+	PICServoCom :: PICServoTransaction_t * PICServoSetVelocity ( uint8_t ModuleNumber, double Velocity, bool Immediate = true );
 
 	void PICServoSetPID ( uint8_t ModuleNumber, double P, double I, double D );
 
-	PICServo ** Modules;
+	void PostSetpoint ( PICServo * Servo, double Value );
+	bool LoadGroupMove ( uint32_t Count, PICServo ** Servos, const PICServoSetpoint_t * Setpoints );
+
+	void PollLoop ();
+	void CommandLoop ();
+
+	static int _StartPollTask ( PICServoController * This );
+	static int _StartCommandTask ( PICServoController * This );
+
+	// Modules in the order they were added, and each address's place in that list. ( -1 if there's no module )
+	// Modules are never removed, so an entry below ModuleCount never changes once it's there.
+	PICServo * Modules [ 256 ];
+	int16_t ModuleIndex [ 256 ];
+	volatile uint32_t ModuleCount;
+
+	// Held while a module is added or a servo's pipe is swapped, enabled or disabled.
+	SEM_ID RegistryLock;
 
 	PICServoCom * Com;
 	AnalogCANJaguarPipeServer * PipeServer;
 
 	uint8_t GroupAddress;
 
+	Task * PollTask;
+	SEM_ID PollLock;
+	bool Polling;
+
+	// Setpoints posted by PICServo :: Set wait in each servo's mailbox for the command task. MailboxLock covers the
+	// mailboxes, each servo's last setpoint and its trajectory settings, and is only held to copy them. CommandLock
+	// is held while the command task or a group move has transactions out, and is always taken before MailboxLock.
+	Task * CommandTask;
+	SEM_ID CommandLock;
+	SEM_ID MailboxLock;
+	SEM_ID CommandSignal;
+	uint32_t CommandCursor;
+
 };
 
 #endif
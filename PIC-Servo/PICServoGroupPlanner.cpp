@@ -0,0 +1,269 @@
+#include "PICServoGroupPlanner.h"
+
+PICServoGroupPlanner :: PICServoGroupPlanner ( PICServoController * Controller )
+{
+
+	this -> Controller = Controller;
+
+	AxisCount = 0;
+
+	Duration = 0;
+	Planned = false;
+
+};
+
+PICServoGroupPlanner :: ~PICServoGroupPlanner ()
+{
+};
+
+/**
+* Add an axis to plan for. Axes are numbered in the order they're added.
+*
+* @param MaxVelocity Revolutions per second.
+* @param MaxAcceleration Revolutions per second squared.
+* @param MaxJerk Revolutions per second cubed. ( Zero for no jerk limit )
+* @return False if the group is full, the limits are out of range, or the servo is on another controller.
+*/
+bool PICServoGroupPlanner :: AddAxis ( PICServo * Servo, double MaxVelocity, double MaxAcceleration, double MaxJerk )
+{
+
+	if ( AxisCount >= PICSERVOCONTROLLER_GROUP_MOVE_MAX || Servo -> Controller != Controller )
+		return false;
+
+	if ( MaxVelocity <= 0 || MaxAcceleration <= 0 || MaxJerk < 0 )
+		return false;
+
+	Axis_t * Axis = & Axes [ AxisCount ++ ];
+
+	Axis -> Servo = Servo;
+	Axis -> MaxVelocity = MaxVelocity;
+	Axis -> MaxAcceleration = MaxAcceleration;
+	Axis -> MaxJerk = MaxJerk;
+
+	Planned = false;
+
+	return true;
+
+};
+
+void PICServoGroupPlanner :: ClearAxes ()
+{
+
+	AxisCount = 0;
+	Planned = false;
+
+};
+
+uint32_t PICServoGroupPlanner :: GetAxisCount ()
+{
+
+	return AxisCount;
+
+};
+
+/**
+* Plan a move of every axis from its last polled position.
+*
+* @param Targets Target of each axis in revolutions, in the order the axes were added.
+*/
+bool PICServoGroupPlanner :: Plan ( const double * Targets )
+{
+
+	double Starts [ PICSERVOCONTROLLER_GROUP_MOVE_MAX ];
+
+	for ( uint32_t i = 0; i < AxisCount; i ++ )
+		Starts [ i ] = Axes [ i ].Servo -> GetPosition ();
+
+	return Plan ( Starts, Targets );
+
+};
+
+/**
+* Plan a move of every axis between given positions.
+*
+* @param Starts Start of each axis in revolutions.
+* @param Targets Target of each axis in revolutions.
+*/
+bool PICServoGroupPlanner :: Plan ( const double * Starts, const double * Targets )
+{
+
+	Planned = false;
+	Duration = 0;
+
+	for ( uint32_t i = 0; i < AxisCount; i ++ )
+	{
+
+		Axis_t * Axis = & Axes [ i ];
+
+		if ( ! Axis -> Profile.Plan ( Starts [ i ], Targets [ i ], Axis -> MaxVelocity, Axis -> MaxAcceleration, Axis -> MaxJerk ) )
+			return false;
+
+		if ( Axis -> Profile.GetDuration () > Duration )
+			Duration = Axis -> Profile.GetDuration ();
+
+	}
+
+	// Axes that don't move have nothing to stretch, and are already done.
+	for ( uint32_t i = 0; i < AxisCount; i ++ )
+	{
+
+		if ( Axes [ i ].Profile.GetDuration () > 0 )
+			Axes [ i ].Profile.Stretch ( Duration );
+
+	}
+
+	Planned = true;
+
+	return true;
+
+};
+
+/**
+* Length of the planned move in seconds.
+*/
+double PICServoGroupPlanner :: GetDuration ()
+{
+
+	return Duration;
+
+};
+
+/**
+* The stretched profile planned for an axis, or NULL if there's no such axis.
+*/
+PICServoProfile * PICServoGroupPlanner :: GetProfile ( uint32_t Axis )
+{
+
+	if ( Axis >= AxisCount )
+		return NULL;
+
+	return & Axes [ Axis ].Profile;
+
+};
+
+/**
+* Load every axis's move into its module and start them together with a group START_MOVE.
+*
+* Every axis has to be in kPosition mode and enabled, and the modules must all be in the controller's group. Like
+* CoordinatedMove, this drops setpoints still waiting in the axes' mailboxes, and it becomes each axis's last setpoint.
+* The next Set () on an axis loads its configured velocity and acceleration again, in place of the planned ones.
+*/
+bool PICServoGroupPlanner :: Dispatch ()
+{
+
+	if ( ! Planned )
+		return false;
+
+	PICServoProfile Trapezoids [ PICSERVOCONTROLLER_GROUP_MOVE_MAX ];
+	PICServoProfile * Profiles [ PICSERVOCONTROLLER_GROUP_MOVE_MAX ];
+
+	// The modules only generate trapezoids, so S-curve plans are redone without the jerk limit. That only makes
+	// them shorter, so they can still be stretched to the planned duration.
+	for ( uint32_t i = 0; i < AxisCount; i ++ )
+	{
+
+		Axis_t * Axis = & Axes [ i ];
+
+		if ( Axis -> MaxJerk > 0 )
+		{
+
+			Trapezoids [ i ].Plan ( Axis -> Profile.GetStart (), Axis -> Profile.GetEnd (), Axis -> MaxVelocity, Axis -> MaxAcceleration );
+
+			if ( Trapezoids [ i ].GetDuration () > 0 )
+				Trapezoids [ i ].Stretch ( Duration );
+
+			Profiles [ i ] = & Trapezoids [ i ];
+
+		}
+		else
+			Profiles [ i ] = & Axis -> Profile;
+
+	}
+
+	PICServo * Servos [ PICSERVOCONTROLLER_GROUP_MOVE_MAX ];
+	PICServoSetpoint_t Setpoints [ PICSERVOCONTROLLER_GROUP_MOVE_MAX ];
+	uint32_t Moving = 0;
+
+	// Same lock order as CoordinatedMove, so the command task can't load a setpoint between the loads and the start.
+	semTake ( Controller -> CommandLock, WAIT_FOREVER );
+	semTake ( Controller -> MailboxLock, WAIT_FOREVER );
+
+	for ( uint32_t i = 0; i < AxisCount; i ++ )
+	{
+
+		if ( Axes [ i ].Servo -> ControlMode != PICServo :: kPosition )
+		{
+
+			semGive ( Controller -> MailboxLock );
+			semGive ( Controller -> CommandLock );
+
+			return false;
+
+		}
+
+	}
+
+	for ( uint32_t i = 0; i < AxisCount; i ++ )
+	{
+
+		PICServo * Servo = Axes [ i ].Servo;
+		double Counts = static_cast <double> ( Servo -> EncoderCount );
+		double Position = Profiles [ i ] -> GetEnd () * Counts;
+
+		Servo -> MailboxFull = false;
+		Servo -> LastSet = Position;
+
+		// The planned limits replace the configured ones in the module.
+		Servo -> NewVelocity = ( Servo -> Velocity != 0 );
+		Servo -> NewAcceleration = ( Servo -> Acceleration != 0 );
+
+		if ( Profiles [ i ] -> GetDuration () <= 0 )
+			continue;
+
+		Setpoints [ Moving ].Value = Position;
+		Setpoints [ Moving ].Velocity = Profiles [ i ] -> GetPeakVelocity () * Counts / PICSERVO_SERVO_RATE;
+		Setpoints [ Moving ].Acceleration = Profiles [ i ] -> GetPeakAcceleration () * Counts / ( PICSERVO_SERVO_RATE * PICSERVO_SERVO_RATE );
+		Setpoints [ Moving ].LoadVelocity = true;
+		Setpoints [ Moving ].LoadAcceleration = true;
+
+		Servos [ Moving ++ ] = Servo;
+
+	}
+
+	semGive ( Controller -> MailboxLock );
+
+	bool Moved = Controller -> LoadGroupMove ( Moving, Servos, Setpoints );
+
+	semGive ( Controller -> CommandLock );
+
+	return Moved;
+
+};
+
+/**
+* Run every axis's stretched profile from the host.
+*
+* The profilers start one after another, within a few milliseconds of each other, so this doesn't synchronize as
+* tightly as Dispatch ().
+*
+* @param Profilers One profiler per axis, in the order the axes were added, each driving that axis's servo.
+*/
+bool PICServoGroupPlanner :: Dispatch ( PICServoProfiler ** Profilers )
+{
+
+	if ( ! Planned )
+		return false;
+
+	bool Started = true;
+
+	for ( uint32_t i = 0; i < AxisCount; i ++ )
+	{
+
+		if ( Axes [ i ].Profile.GetDuration () > 0 )
+			Started &= Profilers [ i ] -> Run ( Axes [ i ].Profile );
+
+	}
+
+	return Started;
+
+};
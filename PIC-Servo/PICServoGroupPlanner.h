@@ -0,0 +1,68 @@
+#ifndef SHS_2605_PICSERVO_GROUP_PLANNER_H
+#define SHS_2605_PICSERVO_GROUP_PLANNER_H
+
+#include "WPILib.h"
+
+#include "PICServo.h"
+#include "PICServoController.h"
+#include "PICServoProfile.h"
+#include "PICServoProfiler.h"
+
+/*
+* Plans a move of several PIC-Servo axes to a joint target so that they all finish together.
+*
+* Each axis is planned on its own limits first. The slowest sets the duration T, and every other axis is stretched
+* to it by S = T / Ti, which divides its velocity by S, acceleration by S^2 and jerk by S^3. No axis goes past its own
+* limits, and each keeps the shape of its move.
+*
+* Dispatch () hands the stretched moves to the modules' own trapezoid generators and starts them with one group
+* START_MOVE, so they begin on the same byte. Jerk limits are ignored there, since the modules can't follow them.
+* Dispatch ( Profilers ) runs the stretched S-curves from the host instead.
+*/
+class PICServoGroupPlanner
+{
+public:
+
+	PICServoGroupPlanner ( PICServoController * Controller );
+	~PICServoGroupPlanner ();
+
+	bool AddAxis ( PICServo * Servo, double MaxVelocity, double MaxAcceleration, double MaxJerk = 0 );
+	void ClearAxes ();
+
+	uint32_t GetAxisCount ();
+
+	bool Plan ( const double * Targets );
+	bool Plan ( const double * Starts, const double * Targets );
+
+	double GetDuration ();
+	PICServoProfile * GetProfile ( uint32_t Axis );
+
+	bool Dispatch ();
+	bool Dispatch ( PICServoProfiler ** Profilers );
+
+private:
+
+	typedef struct Axis_t
+	{
+
+		PICServo * Servo;
+
+		double MaxVelocity;
+		double MaxAcceleration;
+		double MaxJerk;
+
+		PICServoProfile Profile;
+
+	} Axis_t;
+
+	PICServoController * Controller;
+
+	Axis_t Axes [ PICSERVOCONTROLLER_GROUP_MOVE_MAX ];
+	uint32_t AxisCount;
+
+	double Duration;
+	bool Planned;
+
+};
+
+#endif
@@ -0,0 +1,293 @@
+#include "PICServoPathStreamer.h"
+
+PICServoPathStreamer :: PICServoPathStreamer ( PICServo * Servo, bool FastPath )
+{
+
+	this -> Servo = Servo;
+	this -> FastPath = FastPath;
+
+	Com = Servo -> Controller -> Com;
+	Module = Servo -> ModuleNumber;
+
+	StreamTask = new Task ( "2605_PICServoPathStreamer_Task", (FUNCPTR) & _StartStreamTask, PICSERVOPATH_TASK_PRIORITY, PICSERVOPATH_TASK_STACKSIZE );
+
+	StreamLock = semMCreate ( SEM_Q_PRIORITY | SEM_DELETE_SAFE | SEM_INVERSION_SAFE );
+	QueueLock = semMCreate ( SEM_Q_PRIORITY | SEM_DELETE_SAFE | SEM_INVERSION_SAFE );
+
+	Running = false;
+
+	QueueHead = 0;
+	QueueLength = 0;
+
+	LastPushed = 0;
+	HasPushed = false;
+
+	ModulePending = 0;
+	Underruns = 0;
+
+	PathRunning = false;
+	Finishing = false;
+
+};
+
+PICServoPathStreamer :: ~PICServoPathStreamer ()
+{
+
+	if ( Running )
+		Stop ();
+
+	delete StreamTask;
+
+	semDelete ( StreamLock );
+	semDelete ( QueueLock );
+
+};
+
+/**
+* Put the module in path mode at this streamer's point rate, and start feeding it.
+*/
+bool PICServoPathStreamer :: Start ()
+{
+
+	if ( Running )
+		return true;
+
+	if ( ! Com -> Complete ( Com -> ModuleIOControl ( Module, false, true, false, true, FastPath, false ) ) )
+		return false;
+
+	// Every reply has to carry the path buffer count.
+	if ( ! Com -> Complete ( Com -> ModuleDefineStatus ( Module, Com -> GetStatusType ( Module ) | PICSERVO_STATUS_TYPE_PATH_REMAINING ) ) )
+		return false;
+
+	ModulePending = 0;
+	PathRunning = false;
+	Finishing = false;
+
+	if ( ! StreamTask -> Start ( reinterpret_cast <uint32_t> ( this ) ) )
+		return false;
+
+	Running = true;
+
+	return true;
+
+};
+
+/**
+* Stop feeding the module. Points already in the module's buffer still run.
+*/
+void PICServoPathStreamer :: Stop ()
+{
+
+	if ( ! Running )
+		return;
+
+	// The service task only touches the link while holding the stream lock, so no transaction is left behind.
+	semTake ( StreamLock, WAIT_FOREVER );
+
+	StreamTask -> Stop ();
+
+	semGive ( StreamLock );
+
+	semTake ( QueueLock, WAIT_FOREVER );
+
+	QueueHead = 0;
+	QueueLength = 0;
+	HasPushed = false;
+
+	semGive ( QueueLock );
+
+	Running = false;
+
+};
+
+bool PICServoPathStreamer :: IsRunning ()
+{
+
+	return Running;
+
+};
+
+/**
+* Queue the next path point.
+*
+* @param Position Absolute position in revolutions.
+* @return False if the queue is full, or the point is too far from the last one to encode.
+*/
+bool PICServoPathStreamer :: Push ( double Position )
+{
+
+	int32_t Counts = static_cast <int32_t> ( Position * static_cast <double> ( Servo -> EncoderCount ) );
+
+	semTake ( QueueLock, WAIT_FOREVER );
+
+	if ( QueueLength >= PICSERVOPATH_QUEUE_LENGTH || ( HasPushed && ( Counts - LastPushed > 32767 || Counts - LastPushed < - 32767 ) ) )
+	{
+
+		semGive ( QueueLock );
+
+		return false;
+
+	}
+
+	Queue [ ( QueueHead + QueueLength ) % PICSERVOPATH_QUEUE_LENGTH ] = Counts;
+	QueueLength ++;
+
+	LastPushed = Counts;
+	HasPushed = true;
+
+	Finishing = false;
+
+	semGive ( QueueLock );
+
+	return true;
+
+};
+
+/**
+* Mark the end of the path, so the module running out of points isn't counted as an underrun.
+*/
+void PICServoPathStreamer :: Finish ()
+{
+
+	Finishing = true;
+
+};
+
+/**
+* Rate in points per second that the module consumes path points at.
+*/
+double PICServoPathStreamer :: GetPointRate ()
+{
+
+	return FastPath ? PICSERVOPATH_RATE_FAST : PICSERVOPATH_RATE_SLOW;
+
+};
+
+uint32_t PICServoPathStreamer :: GetQueuedPoints ()
+{
+
+	return QueueLength;
+
+};
+
+/**
+* Points left in the module's buffer, as of its last reply.
+*/
+uint32_t PICServoPathStreamer :: GetPendingPoints ()
+{
+
+	return ModulePending;
+
+};
+
+uint32_t PICServoPathStreamer :: GetUnderrunCount ()
+{
+
+	return Underruns;
+
+};
+
+void PICServoPathStreamer :: Service ()
+{
+
+	PICServoCom :: PICServoStatus_t Status;
+	int32_t Chunk [ PICSERVO_PATH_POINTS_MAX ];
+
+	bool Refreshed = false;
+
+	while ( true )
+	{
+
+		uint32_t Free = ( ModulePending < PICSERVOPATH_BUFFER_SIZE ) ? PICSERVOPATH_BUFFER_SIZE - ModulePending : 0;
+
+		semTake ( QueueLock, WAIT_FOREVER );
+
+		uint32_t Count = QueueLength;
+
+		if ( Count > Free )
+			Count = Free;
+
+		if ( Count > PICSERVO_PATH_POINTS_MAX )
+			Count = PICSERVO_PATH_POINTS_MAX;
+
+		for ( uint32_t i = 0; i < Count; i ++ )
+			Chunk [ i ] = Queue [ ( QueueHead + i ) % PICSERVOPATH_QUEUE_LENGTH ];
+
+		semGive ( QueueLock );
+
+		if ( Count == 0 )
+			break;
+
+		if ( ! Com -> Complete ( Com -> ModuleAddPathPoints ( Module, Chunk, Count ), & Status ) )
+			return;
+
+		// Only drop the points from the queue once the module has them.
+		semTake ( QueueLock, WAIT_FOREVER );
+
+		QueueHead = ( QueueHead + Count ) % PICSERVOPATH_QUEUE_LENGTH;
+		QueueLength -= Count;
+
+		semGive ( QueueLock );
+
+		ModulePending = Status.PathPointsPending;
+		Refreshed = true;
+
+	}
+
+	if ( ! Refreshed )
+	{
+
+		if ( ! Com -> Complete ( Com -> ModuleGetStatus ( Module ), & Status ) )
+			return;
+
+		ModulePending = Status.PathPointsPending;
+
+	}
+
+	if ( PathRunning && ModulePending == 0 )
+	{
+
+		if ( ! Finishing )
+			Underruns ++;
+
+		PathRunning = false;
+
+	}
+
+	// Start once the buffer is primed, or with whatever is left at the end of a short path.
+	if ( ! PathRunning && ModulePending != 0 && ( ModulePending >= PICSERVOPATH_START_POINTS || ( Finishing && QueueLength == 0 ) ) )
+	{
+
+		if ( Com -> Complete ( Com -> ModuleAddPathPoints ( Module, NULL, 0 ) ) )
+			PathRunning = true;
+
+	}
+
+};
+
+void PICServoPathStreamer :: RunLoop ()
+{
+
+	while ( true )
+	{
+
+		semTake ( StreamLock, WAIT_FOREVER );
+
+		Service ();
+
+		semGive ( StreamLock );
+
+		Wait ( PICSERVOPATH_SERVICE_PERIOD );
+
+	}
+
+};
+
+int PICServoPathStreamer :: _StartStreamTask ( PICServoPathStreamer * This )
+{
+
+	This -> RunLoop ();
+
+	return 0;
+
+};
@@ -0,0 +1,84 @@
+#ifndef SHS_2605_PICSERVO_PATH_STREAMER_H
+#define SHS_2605_PICSERVO_PATH_STREAMER_H
+
+#include "WPILib.h"
+
+#include "PICServo.h"
+#include "PICServoCom.h"
+
+#define PICSERVOPATH_BUFFER_SIZE 32
+#define PICSERVOPATH_QUEUE_LENGTH 512
+#define PICSERVOPATH_START_POINTS 8
+
+#define PICSERVOPATH_RATE_SLOW 30.0
+#define PICSERVOPATH_RATE_FAST 60.0
+
+#define PICSERVOPATH_SERVICE_PERIOD 0.05
+
+#define PICSERVOPATH_TASK_PRIORITY 55
+#define PICSERVOPATH_TASK_STACKSIZE 0x8000
+
+/*
+* Streams time-sampled positions to a PIC-Servo module in path mode.
+*
+* A producer pushes positions at the path point rate, and a service task keeps the module's on-board path buffer
+* topped up, using the PathPointsPending count returned with every reply. The path is started once enough points
+* are buffered. If the module runs dry before Finish () is called, that's counted as an underrun, and the path
+* restarts once the buffer is primed again.
+*/
+class PICServoPathStreamer
+{
+public:
+
+	PICServoPathStreamer ( PICServo * Servo, bool FastPath = false );
+	~PICServoPathStreamer ();
+
+	bool Start ();
+	void Stop ();
+
+	bool IsRunning ();
+
+	bool Push ( double Position );
+	void Finish ();
+
+	double GetPointRate ();
+
+	uint32_t GetQueuedPoints ();
+	uint32_t GetPendingPoints ();
+	uint32_t GetUnderrunCount ();
+
+private:
+
+	void Service ();
+	void RunLoop ();
+
+	static int _StartStreamTask ( PICServoPathStreamer * This );
+
+	PICServo * Servo;
+	PICServoCom * Com;
+
+	uint8_t Module;
+	bool FastPath;
+
+	Task * StreamTask;
+	SEM_ID StreamLock;
+	SEM_ID QueueLock;
+
+	bool Running;
+
+	int32_t Queue [ PICSERVOPATH_QUEUE_LENGTH ];
+	uint32_t QueueHead;
+	uint32_t QueueLength;
+
+	int32_t LastPushed;
+	bool HasPushed;
+
+	volatile uint32_t ModulePending;
+	volatile uint32_t Underruns;
+
+	bool PathRunning;
+	volatile bool Finishing;
+
+};
+
+#endif
@@ -0,0 +1,281 @@
+#include "PICServoProfile.h"
+
+PICServoProfile :: PICServoProfile ()
+{
+
+	Plan ( 0, 0, 1, 1 );
+
+};
+
+PICServoProfile :: ~PICServoProfile ()
+{
+};
+
+/**
+* Plan a move.
+*
+* @param Start Start position.
+* @param End End position.
+* @param MaxVelocity Velocity limit. ( Position units per second )
+* @param MaxAcceleration Acceleration limit. ( Position units per second squared )
+* @param MaxJerk Jerk limit. ( Position units per second cubed, zero for a trapezoidal move )
+* @return False if a limit is out of range. The profile is left unchanged.
+*/
+bool PICServoProfile :: Plan ( double Start, double End, double MaxVelocity, double MaxAcceleration, double MaxJerk )
+{
+
+	if ( MaxVelocity <= 0 || MaxAcceleration <= 0 || MaxJerk < 0 )
+		return false;
+
+	this -> Start = Start;
+	this -> End = End;
+
+	double Distance = fabs ( End - Start );
+	double Direction = ( End < Start ) ? - 1.0 : 1.0;
+
+	double Peak = MaxVelocity;
+	double AccelTime = AccelerationTime ( Peak, MaxAcceleration, MaxJerk );
+
+	// Speeding up and slowing down take Peak * AccelTime between them. If that's too far, the move never reaches
+	// the velocity limit, and the peak it does reach solves Peak * AccelerationTime ( Peak ) = Distance.
+	if ( Peak * AccelTime > Distance )
+	{
+
+		if ( MaxJerk > 0 )
+		{
+
+			double JerkTime = MaxAcceleration / MaxJerk;
+
+			Peak = MaxAcceleration * ( sqrt ( JerkTime * JerkTime + 4 * Distance / MaxAcceleration ) - JerkTime ) / 2;
+
+			// Too short to reach the acceleration limit either.
+			if ( Peak * MaxJerk < MaxAcceleration * MaxAcceleration )
+				Peak = pow ( Distance * Distance * MaxJerk / 4, 1.0 / 3.0 );
+
+		}
+		else
+			Peak = sqrt ( Distance * MaxAcceleration );
+
+		AccelTime = AccelerationTime ( Peak, MaxAcceleration, MaxJerk );
+
+	}
+
+	double JerkTime = 0;
+	double Acceleration = MaxAcceleration;
+
+	if ( MaxJerk > 0 )
+	{
+
+		JerkTime = ( Peak * MaxJerk >= MaxAcceleration * MaxAcceleration ) ? MaxAcceleration / MaxJerk : sqrt ( Peak / MaxJerk );
+		Acceleration = MaxJerk * JerkTime;
+
+	}
+
+	double CruiseTime = 0;
+
+	if ( Peak > 0 )
+	{
+
+		CruiseTime = ( Distance - Peak * AccelTime ) / Peak;
+
+		if ( CruiseTime < 0 )
+			CruiseTime = 0;
+
+	}
+	else
+	{
+
+		AccelTime = 0;
+		JerkTime = 0;
+		Acceleration = 0;
+
+	}
+
+	PeakVelocity = Peak;
+	PeakAcceleration = Acceleration;
+
+	Build ( JerkTime, AccelTime, CruiseTime, Acceleration, MaxJerk, Direction );
+
+	return true;
+
+};
+
+/**
+* Slow the move down so it takes Duration seconds, keeping its shape.
+*
+* Stretching time by S = Duration / GetDuration () divides velocity by S, acceleration by S^2 and jerk by S^3, so a
+* move that kept to its limits still does.
+*
+* @return False if Duration is shorter than the move, or the move has no length to stretch.
+*/
+bool PICServoProfile :: Stretch ( double Duration )
+{
+
+	if ( this -> Duration <= 0 || Duration < this -> Duration )
+		return false;
+
+	double S = Duration / this -> Duration;
+
+	for ( uint32_t i = 0; i < PICSERVOPROFILE_SEGMENTS; i ++ )
+	{
+
+		Segments [ i ].StartTime *= S;
+		Segments [ i ].Velocity /= S;
+		Segments [ i ].Acceleration /= S * S;
+		Segments [ i ].Jerk /= S * S * S;
+
+	}
+
+	PeakVelocity /= S;
+	PeakAcceleration /= S * S;
+
+	this -> Duration = Duration;
+	Cursor = 0;
+
+	return true;
+
+};
+
+/**
+* Length of the move in seconds.
+*/
+double PICServoProfile :: GetDuration ()
+{
+
+	return Duration;
+
+};
+
+double PICServoProfile :: GetStart ()
+{
+
+	return Start;
+
+};
+
+double PICServoProfile :: GetEnd ()
+{
+
+	return End;
+
+};
+
+/**
+* Highest speed the move reaches. ( Never more than the velocity limit )
+*/
+double PICServoProfile :: GetPeakVelocity ()
+{
+
+	return PeakVelocity;
+
+};
+
+double PICServoProfile :: GetPeakAcceleration ()
+{
+
+	return PeakAcceleration;
+
+};
+
+/**
+* State of the move at a time since its start. Times past the end give the end position at rest.
+*/
+void PICServoProfile :: Evaluate ( double Time, double * Position, double * Velocity, double * Acceleration )
+{
+
+	if ( Time < 0 )
+		Time = 0;
+
+	if ( Time < Segments [ Cursor ].StartTime )
+		Cursor = 0;
+
+	while ( Cursor < PICSERVOPROFILE_SEGMENTS - 1 && Time >= Segments [ Cursor + 1 ].StartTime )
+		Cursor ++;
+
+	const Segment_t * Segment = & Segments [ Cursor ];
+
+	double T = Time - Segment -> StartTime;
+
+	if ( Cursor == PICSERVOPROFILE_SEGMENTS - 1 )
+		T = 0;
+
+	* Position = Segment -> Position + T * ( Segment -> Velocity + T * ( Segment -> Acceleration / 2 + T * Segment -> Jerk / 6 ) );
+
+	if ( Velocity != NULL )
+		* Velocity = Segment -> Velocity + T * ( Segment -> Acceleration + T * Segment -> Jerk / 2 );
+
+	if ( Acceleration != NULL )
+		* Acceleration = Segment -> Acceleration + T * Segment -> Jerk;
+
+};
+
+/*
+* Lay the seven phases out: jerk up, constant acceleration, jerk down, cruise, then the same again mirrored. The
+* acceleration each phase starts at is set outright rather than integrated, so a trapezoid, whose jerk phases have no
+* length, steps straight to full acceleration.
+*/
+void PICServoProfile :: Build ( double JerkTime, double AccelerationTime, double CruiseTime, double PeakAcceleration, double Jerk, double Direction )
+{
+
+	double HoldTime = AccelerationTime - 2 * JerkTime;
+
+	if ( HoldTime < 0 )
+		HoldTime = 0;
+
+	if ( JerkTime == 0 )
+		Jerk = 0;
+
+	const double Durations [ PICSERVOPROFILE_SEGMENTS - 1 ] = { JerkTime, HoldTime, JerkTime, CruiseTime, JerkTime, HoldTime, JerkTime };
+	const double Accelerations [ PICSERVOPROFILE_SEGMENTS - 1 ] = { 0, PeakAcceleration, PeakAcceleration, 0, 0, - PeakAcceleration, - PeakAcceleration };
+	const double Jerks [ PICSERVOPROFILE_SEGMENTS - 1 ] = { Jerk, 0, - Jerk, 0, - Jerk, 0, Jerk };
+
+	double Time = 0;
+	double Position = Start;
+	double Velocity = 0;
+
+	for ( uint32_t i = 0; i < PICSERVOPROFILE_SEGMENTS - 1; i ++ )
+	{
+
+		Segment_t * Segment = & Segments [ i ];
+
+		Segment -> StartTime = Time;
+		Segment -> Position = Position;
+		Segment -> Velocity = Velocity;
+		Segment -> Acceleration = Direction * Accelerations [ i ];
+		Segment -> Jerk = Direction * Jerks [ i ];
+
+		double T = Durations [ i ];
+
+		Position += T * ( Velocity + T * ( Segment -> Acceleration / 2 + T * Segment -> Jerk / 6 ) );
+		Velocity += T * ( Segment -> Acceleration + T * Segment -> Jerk / 2 );
+		Time += T;
+
+	}
+
+	// Park exactly on the end point, whatever rounding crept in along the way.
+	Segment_t * Hold = & Segments [ PICSERVOPROFILE_SEGMENTS - 1 ];
+
+	Hold -> StartTime = Time;
+	Hold -> Position = End;
+	Hold -> Velocity = 0;
+	Hold -> Acceleration = 0;
+	Hold -> Jerk = 0;
+
+	Duration = Time;
+	Cursor = 0;
+
+};
+
+// Time to get from rest to Velocity, including both jerk phases.
+double PICServoProfile :: AccelerationTime ( double Velocity, double MaxAcceleration, double MaxJerk )
+{
+
+	if ( MaxJerk <= 0 )
+		return Velocity / MaxAcceleration;
+
+	if ( Velocity * MaxJerk >= MaxAcceleration * MaxAcceleration )
+		return Velocity / MaxAcceleration + MaxAcceleration / MaxJerk;
+
+	return 2 * sqrt ( Velocity / MaxJerk );
+
+};
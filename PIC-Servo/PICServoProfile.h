@@ -0,0 +1,69 @@
+#ifndef SHS_2605_PICSERVO_PROFILE_H
+#define SHS_2605_PICSERVO_PROFILE_H
+
+#include <stdint.h>
+#include <math.h>
+
+#define PICSERVOPROFILE_SEGMENTS 8
+
+/*
+* Jerk limited ( S-curve ) point to point move, from rest to rest.
+*
+* Plan () works out the seven phases of the move once, and stores the state at the start of each, so Evaluate () only
+* has to find the phase and evaluate one cubic. The last segment holds the end position. With no jerk limit the
+* jerk phases have no length, and the move is an ordinary trapezoid.
+*
+* Units are up to the caller. PICServoProfiler uses revolutions and seconds.
+*/
+class PICServoProfile
+{
+public:
+
+	PICServoProfile ();
+	~PICServoProfile ();
+
+	bool Plan ( double Start, double End, double MaxVelocity, double MaxAcceleration, double MaxJerk = 0 );
+	bool Stretch ( double Duration );
+
+	double GetDuration ();
+	double GetStart ();
+	double GetEnd ();
+
+	double GetPeakVelocity ();
+	double GetPeakAcceleration ();
+
+	void Evaluate ( double Time, double * Position, double * Velocity = NULL, double * Acceleration = NULL );
+
+private:
+
+	typedef struct Segment_t
+	{
+
+		double StartTime;
+
+		double Position;
+		double Velocity;
+		double Acceleration;
+		double Jerk;
+
+	} Segment_t;
+
+	void Build ( double JerkTime, double AccelerationTime, double CruiseTime, double PeakAcceleration, double Jerk, double Direction );
+
+	static double AccelerationTime ( double Velocity, double MaxAcceleration, double MaxJerk );
+
+	Segment_t Segments [ PICSERVOPROFILE_SEGMENTS ];
+
+	// Segment the last evaluation landed in. Ticks move forward, so the search almost always stops here.
+	uint32_t Cursor;
+
+	double Start;
+	double End;
+	double Duration;
+
+	double PeakVelocity;
+	double PeakAcceleration;
+
+};
+
+#endif
@@ -0,0 +1,244 @@
+#include "PICServoProfiler.h"
+
+PICServoProfiler :: PICServoProfiler ( PICServo * Servo, PICServoPathStreamer * Streamer )
+{
+
+	this -> Servo = Servo;
+	this -> Streamer = Streamer;
+
+	ProfileTask = new Task ( "2605_PICServoProfiler_Task", (FUNCPTR) & _StartProfileTask, PICSERVOPROFILER_TASK_PRIORITY, PICSERVOPROFILER_TASK_STACKSIZE );
+	ProfileLock = semMCreate ( SEM_Q_PRIORITY | SEM_DELETE_SAFE | SEM_INVERSION_SAFE );
+
+	Running = false;
+	StartTime = 0;
+
+};
+
+PICServoProfiler :: ~PICServoProfiler ()
+{
+
+	Stop ();
+
+	delete ProfileTask;
+
+	semDelete ( ProfileLock );
+
+};
+
+/**
+* Start running a planned profile, replacing any move already running.
+*
+* @return False if the path streamer couldn't be started, or the profile task couldn't be spawned.
+*/
+bool PICServoProfiler :: Run ( const PICServoProfile & Profile )
+{
+
+	Stop ();
+
+	if ( Streamer != NULL && ! Streamer -> IsRunning () && ! Streamer -> Start () )
+		return false;
+
+	this -> Profile = Profile;
+
+	StartTime = Timer :: GetPPCTimestamp ();
+	Running = true;
+
+	if ( ! ProfileTask -> Start ( reinterpret_cast <uint32_t> ( this ) ) )
+	{
+
+		Running = false;
+
+		return false;
+
+	}
+
+	return true;
+
+};
+
+/**
+* Plan and run a move from the last polled position.
+*
+* @param Position Target in revolutions.
+* @param MaxVelocity Revolutions per second.
+* @param MaxAcceleration Revolutions per second squared.
+* @param MaxJerk Revolutions per second cubed. ( Zero for a trapezoidal move )
+*/
+bool PICServoProfiler :: MoveTo ( double Position, double MaxVelocity, double MaxAcceleration, double MaxJerk )
+{
+
+	PICServoProfile Move;
+
+	if ( ! Move.Plan ( Servo -> GetPosition (), Position, MaxVelocity, MaxAcceleration, MaxJerk ) )
+		return false;
+
+	return Run ( Move );
+
+};
+
+/**
+* Abandon the running move. In velocity mode the module is sent back to rest. In path mode the streamer is stopped,
+* and the points already in the module's buffer still run.
+*/
+void PICServoProfiler :: Stop ()
+{
+
+	if ( ! Running )
+		return;
+
+	// The profile task only touches the link while holding the profile lock, so no transaction is left behind.
+	semTake ( ProfileLock, WAIT_FOREVER );
+
+	ProfileTask -> Stop ();
+
+	semGive ( ProfileLock );
+
+	if ( Streamer != NULL )
+		Streamer -> Stop ();
+	else
+	{
+
+		double Acceleration = Profile.GetPeakAcceleration () * static_cast <double> ( Servo -> EncoderCount ) / ( PICSERVO_SERVO_RATE * PICSERVO_SERVO_RATE );
+
+		SendVelocity ( 0, Acceleration );
+
+	}
+
+	Running = false;
+
+};
+
+bool PICServoProfiler :: IsRunning ()
+{
+
+	return Running;
+
+};
+
+/**
+* Seconds since the running move started.
+*/
+double PICServoProfiler :: GetElapsedTime ()
+{
+
+	return Timer :: GetPPCTimestamp () - StartTime;
+
+};
+
+// Sample the whole move at the streamer's point rate, then wait for the module to use the points up.
+void PICServoProfiler :: StreamPath ()
+{
+
+	double Period = 1.0 / Streamer -> GetPointRate ();
+	double Duration = Profile.GetDuration ();
+
+	uint32_t Points = static_cast <uint32_t> ( ceil ( Duration / Period ) );
+	double Position;
+
+	for ( uint32_t i = 1; i <= Points; i ++ )
+	{
+
+		Profile.Evaluate ( i * Period, & Position );
+
+		// The streamer's queue holds many seconds of points, so a full queue only means a long move.
+		while ( ! Streamer -> Push ( Position ) )
+			Wait ( PICSERVOPROFILER_PUSH_RETRY );
+
+	}
+
+	Streamer -> Finish ();
+
+	while ( Streamer -> GetQueuedPoints () != 0 || Streamer -> GetPendingPoints () != 0 )
+		Wait ( PICSERVOPATH_SERVICE_PERIOD );
+
+};
+
+// Send the velocity the profile will have one update from now, with the acceleration that gets there on time.
+void PICServoProfiler :: StreamVelocity ()
+{
+
+	double VelocityScale = static_cast <double> ( Servo -> EncoderCount ) / PICSERVO_SERVO_RATE;
+	double AccelerationScale = VelocityScale / PICSERVO_SERVO_RATE;
+
+	// The smallest acceleration the module can represent, so a velocity change is never stalled at zero.
+	double MinimumAcceleration = 1.0 / 65536.0;
+
+	double Duration = Profile.GetDuration ();
+	double Commanded = 0;
+
+	double Position;
+	double Velocity;
+
+	while ( true )
+	{
+
+		double Elapsed = Timer :: GetPPCTimestamp () - StartTime;
+
+		Profile.Evaluate ( Elapsed + PICSERVOPROFILER_VELOCITY_PERIOD, & Position, & Velocity );
+
+		double Acceleration = fabs ( Velocity - Commanded ) / PICSERVOPROFILER_VELOCITY_PERIOD * AccelerationScale;
+
+		if ( Acceleration < MinimumAcceleration )
+			Acceleration = MinimumAcceleration;
+
+		semTake ( ProfileLock, WAIT_FOREVER );
+
+		SendVelocity ( Velocity * VelocityScale, Acceleration );
+
+		semGive ( ProfileLock );
+
+		Commanded = Velocity;
+
+		if ( Elapsed >= Duration )
+			break;
+
+		Wait ( PICSERVOPROFILER_VELOCITY_PERIOD );
+
+	}
+
+};
+
+/*
+* Send a velocity and acceleration in module units. Like a coordinated move, it holds the controller's CommandLock so
+* the command task's loads can't interleave, and drops a setpoint still waiting in the servo's mailbox, which would
+* override it. The module's acceleration no longer matches the servo's, so the servo's next setpoint loads it again.
+*/
+void PICServoProfiler :: SendVelocity ( double Velocity, double Acceleration )
+{
+
+	PICServoController * Controller = Servo -> Controller;
+
+	semTake ( Controller -> CommandLock, WAIT_FOREVER );
+	semTake ( Controller -> MailboxLock, WAIT_FOREVER );
+
+	Servo -> MailboxFull = false;
+	Servo -> NewAcceleration = true;
+
+	semGive ( Controller -> MailboxLock );
+
+	Controller -> Com -> Complete ( Controller -> PICServoSetVelocityA ( Servo -> ModuleNumber, Velocity, Acceleration ) );
+
+	semGive ( Controller -> CommandLock );
+
+};
+
+void PICServoProfiler :: RunLoop ()
+{
+
+	if ( Streamer != NULL )
+		StreamPath ();
+	else
+		StreamVelocity ();
+
+	Running = false;
+
+};
+
+int PICServoProfiler :: _StartProfileTask ( PICServoProfiler * This )
+{
+
+	This -> RunLoop ();
+
+	return 0;
+
+};
@@ -0,0 +1,65 @@
+#ifndef SHS_2605_PICSERVO_PROFILER_H
+#define SHS_2605_PICSERVO_PROFILER_H
+
+#include "WPILib.h"
+
+#include "PICServo.h"
+#include "PICServoCom.h"
+#include "PICServoProfile.h"
+#include "PICServoPathStreamer.h"
+
+#define PICSERVOPROFILER_VELOCITY_PERIOD 0.02
+#define PICSERVOPROFILER_PUSH_RETRY 0.02
+
+#define PICSERVOPROFILER_TASK_PRIORITY 54
+#define PICSERVOPROFILER_TASK_STACKSIZE 0x8000
+
+/*
+* Runs a PICServoProfile on a PIC-Servo module from the host.
+*
+* With a path streamer, the profile is sampled at the streamer's point rate and pushed as path points, and the module
+* interpolates between them. Without one, the module is sent a new velocity every PICSERVOPROFILER_VELOCITY_PERIOD,
+* along with the acceleration that reaches it by the next update. That tracks the profile's velocity but not its
+* position, so it suits mechanisms that are stopped by something else, and path mode should be preferred otherwise.
+*
+* The servo must already be enabled. Positions are in revolutions.
+*/
+class PICServoProfiler
+{
+public:
+
+	PICServoProfiler ( PICServo * Servo, PICServoPathStreamer * Streamer = NULL );
+	~PICServoProfiler ();
+
+	bool Run ( const PICServoProfile & Profile );
+	bool MoveTo ( double Position, double MaxVelocity, double MaxAcceleration, double MaxJerk );
+
+	void Stop ();
+
+	bool IsRunning ();
+	double GetElapsedTime ();
+
+private:
+
+	void StreamPath ();
+	void StreamVelocity ();
+	void SendVelocity ( double Velocity, double Acceleration );
+
+	void RunLoop ();
+
+	static int _StartProfileTask ( PICServoProfiler * This );
+
+	PICServo * Servo;
+	PICServoPathStreamer * Streamer;
+
+	Task * ProfileTask;
+	SEM_ID ProfileLock;
+
+	PICServoProfile Profile;
+
+	volatile bool Running;
+	volatile double StartTime;
+
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef SHS_2605_PICSERVO_PROTOCOL_H
+#define SHS_2605_PICSERVO_PROTOCOL_H
+
+/*
+* PIC-SERVO serial protocol constants. Kept free of WPILib so host-side tools can share them.
+*/
+
+#define PICSERVO_BAUD_RATE_INITIAL 19200
+#define PICSERVO_BAUD_RATE_FAST 115200
+
+#define	PICSERVO_COMMAND_RESET_POS	  0x00	//Reset encoder counter to 0 (0 bytes)
+#define	PICSERVO_COMMAND_SET_ADDR	  0x01	//Set address and group address (2 bytes)
+#define	PICSERVO_COMMAND_DEF_STAT	  0x02	//Define status items to return (1 byte)
+#define	PICSERVO_COMMAND_READ_STAT	  0x03	//Read value of current status items
+#define	PICSERVO_COMMAND_LOAD_TRAJ  	  0x04	//Load trahectory date (1 - 14 bytes)
+#define PICSERVO_COMMAND_START_MOVE	  0x05	//Start pre-loaded trajectory (0 bytes)
+#define PICSERVO_COMMAND_SET_GAIN	  0x06  //Set servo gain and control parameters (13 or 14)
+#define	PICSERVO_COMMAND_STOP_MOTOR 	  0x07	//Stop motor (1 byte)
+#define	PICSERVO_COMMAND_IO_CTRL		  0x08	//Define bit directions and set output (1 byte)
+#define PICSERVO_COMMAND_SET_HOMING	  0x09  //Define homing mode (1 byte)
+#define	PICSERVO_COMMAND_SET_BAUD	  0x0A 	//Set the baud rate (1 byte)
+#define PICSERVO_COMMAND_CLEAR_BITS	  0x0B  //Save current pos. in home pos. register (0 bytes)
+#define PICSERVO_COMMAND_SAVE_AS_HOME  0x0C	//Store the input bytes and timer val (0 bytes)
+#define PICSERVO_COMMAND_ADD_PATHPOINT 0x0D  //Adds path points for path mode
+#define	PICSERVO_COMMAND_NOP			  0x0E	//No operation - returns prev. defined status (0 bytes)
+#define PICSERVO_COMMAND_HARD_RESET	  0x0F	//RESET - no status is returned
+
+#define PICSERVO_RESET_POSITION_DATASIZE_0 0x00
+#define PICSERVO_RESET_POSITION_DATASIZE_1 0x10
+#define PICSERVO_RESET_POSITION_DATASIZE_5 0x50
+
+#define PICSERVO_SET_ADDR_DATASIZE_2 0x20
+
+#define PICSERVO_DEF_STAT_DATASIZE_1 0x10
+
+#define PICSERVO_READ_STAT_DATASIZE_1 0x10
+
+#define PICSERVO_SET_GAIN_DATASIZE_15 0xF0
+
+#define PICSERVO_STOP_MOTOR_DATASIZE_1 0x10
+
+#define PICSERVO_SET_BAUD_DATASIZE_1 0x10
+
+#define PICSERVO_PATH_POINTS_MAX 7
+
+#define PICSERVO_IO_CONTROL_DATASIZE_1 0x10
+
+#define PICSERVO_HARD_RESET_DATASIZE_1 0x10
+
+#define PICSERVO_STATUS_TYPE_POSITION 0x01
+#define PICSERVO_STATUS_TYPE_CURRENT_SENSE 0x02
+#define PICSERVO_STATUS_TYPE_ENCODER_VELOCITY 0x04
+#define PICSERVO_STATUS_TYPE_AUXILIARY_STATUS 0x08
+#define PICSERVO_STATUS_TYPE_HOME_POSITION 0x10
+#define PICSERVO_STATUS_TYPE_DEVICE_TYPE_VERSION 0x20
+#define PICSERVO_STATUS_TYPE_SERVO_ERROR 0x40
+#define PICSERVO_STATUS_TYPE_PATH_REMAINING 0x80
+
+#define PICSERVO_GROUP_ADDRESS_BASE 0x80
+
+#endif
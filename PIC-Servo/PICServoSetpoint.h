@@ -0,0 +1,22 @@
+#ifndef SHS_2605_PICSERVO_SETPOINT_H
+#define SHS_2605_PICSERVO_SETPOINT_H
+
+/*
+* A setpoint in module units, with the trajectory settings to load alongside it. Copied out of a PICServo under the
+* controller's MailboxLock, so it can be loaded with no lock held. Shared by PICServo and PICServoController, which
+* include each other.
+*/
+typedef struct PICServoSetpoint_t
+{
+
+	double Value;
+
+	double Velocity;
+	double Acceleration;
+
+	bool LoadVelocity;
+	bool LoadAcceleration;
+
+} PICServoSetpoint_t;
+
+#endif
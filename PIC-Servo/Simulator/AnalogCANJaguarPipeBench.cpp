@@ -0,0 +1,671 @@
+/*
+* Host benchmark for AnalogCANJaguarPipeServer.
+*
+* kernel: times the parallel-array transform against the per-pipe struct loop it replaced, for 8 to 64 pipes, and
+* checks they agree. Then runs the server itself with that many pipes and reads its cycle log for the time spent
+* sampling and transforming, and writing to the Jaguars.
+*
+* oversampling: one pipe reads a noisy input through each mix of averaging bits and ring length. The noise left on the
+* pipe's input is measured against what the averaging should leave, and a noiseless step shows how many cycles the
+* input takes to get halfway. The host shim averages without delay, so only the ring's delay shows here; on the cRIO
+* the averaging engine adds about 2^AverageBits module samples on top.
+*
+* soak: issues every kind of pipe command, millions of times, to a running server with 8 pipes. Neither operator new
+* nor the malloc heap may grow while it runs, and afterwards every pipe must still drive its Jaguar correctly.
+*
+* copy: CopyPipeSettings, as a servo's pipe is replaced, must carry every setting but the offset to the new pipe, and
+* do nothing once the old pipe has been removed.
+*
+* Build and run from the repository root:
+*
+*   g++ -std=gnu++98 -fpermissive -O2 -pthread -I PIC-Servo/Simulator/Host PIC-Servo/Simulator/AnalogCANJaguarPipeBench.cpp
+*       PIC-Servo/AnalogCANJaguarPipeServer.cpp PIC-Servo/Simulator/Host/HostWPILib.cpp Filters/FilterChain.cpp
+*       -o AnalogCANJaguarPipeBench
+*   ./AnalogCANJaguarPipeBench [ kernel | oversampling | soak [ commands ] | copy ]
+*/
+
+#if defined ( __linux__ )
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <malloc.h>
+
+#include "WPILib.h"
+
+#include <memLib.h>
+
+#include "../AnalogCANJaguarPipeServer.h"
+#include "../../Util/Vector.h"
+
+#define ANALOGCANJAGUARPIPEBENCH_EVALUATIONS 50000000
+
+#define ANALOGCANJAGUARPIPEBENCH_LEVEL 2.5
+#define ANALOGCANJAGUARPIPEBENCH_NOISE 0.05
+#define ANALOGCANJAGUARPIPEBENCH_NOISE_SAMPLES 600
+
+#define ANALOGCANJAGUARPIPEBENCH_SOAK_PIPES 8
+#define ANALOGCANJAGUARPIPEBENCH_SOAK_REPORTS 8
+
+// The pipe struct as it was before the numeric state moved into parallel arrays, walked through Vector as it was.
+typedef struct OldPipe_t
+{
+
+	CAN_ID JaguarID;
+	uint8_t Channel;
+	uint8_t Module;
+
+	CANJaguar * Jaguar;
+	AnalogChannel * InputChannel;
+
+	double Offset;
+	bool Inverted;
+	bool Enabled;
+
+	FilterStage Transfer [ FILTERCHAIN_MAX_STAGES ];
+	uint32_t TransferLength;
+
+	// The old loop sampled into a local. It's kept here so both sides transform the same stored samples.
+	double Voltage;
+	double Output;
+
+} OldPipe_t;
+
+static uint32_t RandomState = 0x2605;
+
+static double Random ( double Low, double High )
+{
+
+	RandomState ^= RandomState << 13;
+	RandomState ^= RandomState >> 17;
+	RandomState ^= RandomState << 5;
+
+	return Low + ( High - Low ) * ( RandomState / 4294967296.0 );
+
+};
+
+class AnalogCANJaguarPipeBench
+{
+public:
+
+	static bool Kernel ();
+	static bool Oversampling ();
+	static bool Soak ( uint32_t Commands );
+	static bool Copy ();
+
+private:
+
+	typedef AnalogCANJaguarPipeServer :: AnalogCANJaguarPipeBank Bank_t;
+
+	static void OldTransform ( Vector <OldPipe_t> & Pipes );
+	static void ServerCycle ( AnalogCANJaguarPipeServer * Server, uint32_t Count );
+
+	static double NextInput ( AnalogCANJaguarPipeServer * Server, AnalogCANJaguarPipe_t Pipe, uint32_t * Cycle );
+	static bool Oversample ( AnalogCANJaguarPipeServer * Server, AnalogCANJaguarPipe_t Pipe, uint32_t AverageBits, uint32_t RingSamples );
+
+	static void IssueCommand ( AnalogCANJaguarPipeServer * Server, AnalogCANJaguarPipe_t Pipe, uint32_t i );
+
+};
+
+static double Sink = 0;
+
+void AnalogCANJaguarPipeBench :: OldTransform ( Vector <OldPipe_t> & Pipes )
+{
+
+	for ( uint32_t i = 0; i < Pipes.GetLength (); i ++ )
+	{
+
+		OldPipe_t & Pipe = Pipes [ i ];
+
+		if ( ! Pipe.Enabled )
+			continue;
+
+		double in_offset = Pipe.Voltage - Pipe.Offset;
+		double in_proportional = in_offset / INPUT_SCALE;
+
+		Pipe.Output = in_proportional * ( Pipe.Inverted ? -1 : 1 );
+
+	}
+
+};
+
+// Average sampling and writing time per cycle with Count pipes, from the server's own cycle log. Pipes are added to
+// the server until it has Count of them.
+void AnalogCANJaguarPipeBench :: ServerCycle ( AnalogCANJaguarPipeServer * Server, uint32_t Count )
+{
+
+	static uint32_t Pipes = 0;
+
+	for ( ; Pipes < Count; Pipes ++ )
+	{
+
+		AnalogChannel :: SetHostInput ( Pipes / 8 + 1, Pipes % 8 + 1, Random ( 0, 5 ), 0.01 );
+
+		AnalogCANJaguarPipe_t Pipe = Server -> AddPipe ( Pipes + 1, Pipes % 8 + 1, Pipes / 8 + 1 );
+
+		Server -> SetPipeInverted ( Pipe, Pipes & 1 );
+		Server -> EnablePipe ( Pipe );
+
+	}
+
+	Wait ( 0.1 );
+
+	Server -> SetCycleLogEnabled ( true );
+
+	Wait ( 1.0 );
+
+	Server -> SetCycleLogEnabled ( false );
+
+	static AnalogCANJaguarPipeServer :: CycleRecord Records [ ANALOGCANJAGSERVER_CYCLE_LOG_LENGTH ];
+
+	uint32_t Read = Server -> ReadCycleLog ( Records, ANALOGCANJAGSERVER_CYCLE_LOG_LENGTH );
+
+	double ReadTime = 0;
+	double WriteTime = 0;
+	uint32_t Frames = 0;
+
+	for ( uint32_t i = 0; i < Read; i ++ )
+	{
+
+		ReadTime += Records [ i ].ReadTime;
+		WriteTime += Records [ i ].WriteTime;
+		Frames += Records [ i ].FramesSent;
+
+	}
+
+	if ( Read != 0 )
+		printf ( "  server, %2u pipes: sample and transform %6.2f us, write %6.2f us, %5.1f frames per cycle over %u cycles\n", Count, 1e6 * ReadTime / Read, 1e6 * WriteTime / Read, static_cast <double> ( Frames ) / Read, Read );
+
+};
+
+bool AnalogCANJaguarPipeBench :: Kernel ()
+{
+
+	bool Passed = true;
+
+	Bank_t * Bank = static_cast <Bank_t *> ( memalign ( ANALOGCANJAGSERVER_BANK_ALIGNMENT, sizeof ( Bank_t ) ) );
+
+	printf ( "kernel: %u pipe evaluations per row\n", ANALOGCANJAGUARPIPEBENCH_EVALUATIONS );
+	printf ( "  pipes   struct loop            parallel arrays\n" );
+
+	for ( uint32_t Count = 8; Count <= ANALOGCANJAGSERVER_MAX_PIPES; Count *= 2 )
+	{
+
+		Vector <OldPipe_t> Pipes;
+
+		for ( uint32_t i = 0; i < Count; i ++ )
+		{
+
+			OldPipe_t Pipe;
+
+			memset ( & Pipe, 0, sizeof ( Pipe ) );
+
+			Pipe.Voltage = Random ( 0, 5 );
+			Pipe.Offset = Random ( 2, 3 );
+			Pipe.Inverted = ( i & 1 ) != 0;
+			Pipe.Enabled = true;
+
+			Pipes.Push ( Pipe );
+
+			Bank -> Voltage [ i ] = Pipe.Voltage;
+			Bank -> Offset [ i ] = Pipe.Offset;
+			Bank -> Sign [ i ] = Pipe.Inverted ? - 1.0 : 1.0;
+			Bank -> Scale [ i ] = 1.0 / INPUT_SCALE;
+
+		}
+
+		OldTransform ( Pipes );
+		AnalogCANJaguarPipeServer :: TransformInputs ( Bank -> Voltage, Bank -> Offset, Bank -> Sign, Bank -> Scale, Bank -> Output, Count );
+
+		for ( uint32_t i = 0; i < Count; i ++ )
+			Passed &= ( fabs ( Pipes [ i ].Output - Bank -> Output [ i ] ) < 1e-12 );
+
+		uint32_t Calls = ANALOGCANJAGUARPIPEBENCH_EVALUATIONS / Count;
+
+		double Start = Timer :: GetPPCTimestamp ();
+
+		for ( uint32_t i = 0; i < Calls; i ++ )
+		{
+
+			// Nudge an input each call, so the loop can't be hoisted.
+			Pipes [ i & ( Count - 1 ) ].Voltage += 1e-9;
+
+			OldTransform ( Pipes );
+
+			Sink += Pipes [ 0 ].Output;
+
+		}
+
+		double Old = 1e9 * ( Timer :: GetPPCTimestamp () - Start ) / Calls;
+
+		Start = Timer :: GetPPCTimestamp ();
+
+		for ( uint32_t i = 0; i < Calls; i ++ )
+		{
+
+			Bank -> Voltage [ i & ( Count - 1 ) ] += 1e-9;
+
+			AnalogCANJaguarPipeServer :: TransformInputs ( Bank -> Voltage, Bank -> Offset, Bank -> Sign, Bank -> Scale, Bank -> Output, Count );
+
+			Sink += Bank -> Output [ 0 ];
+
+		}
+
+		double New = 1e9 * ( Timer :: GetPPCTimestamp () - Start ) / Calls;
+
+		printf ( "  %5u   %7.1f ns %5.2f/pipe   %7.1f ns %5.2f/pipe ( %.1fx )\n", Count, Old, Old / Count, New, New / Count, Old / New );
+
+	}
+
+	free ( Bank );
+
+	printf ( "  outputs agree: %s\n", Passed ? "ok" : "FAILED" );
+
+	AnalogCANJaguarPipeServer * Server = new AnalogCANJaguarPipeServer ();
+
+	Server -> Start ();
+
+	for ( uint32_t Count = 8; Count <= ANALOGCANJAGSERVER_MAX_PIPES; Count *= 2 )
+		ServerCycle ( Server, Count );
+
+	Server -> Stop ();
+
+	return Passed;
+
+};
+
+// Waits for a cycle after Cycle to be published and returns the pipe's input from it.
+double AnalogCANJaguarPipeBench :: NextInput ( AnalogCANJaguarPipeServer * Server, AnalogCANJaguarPipe_t Pipe, uint32_t * Cycle )
+{
+
+	AnalogCANJaguarPipeServer :: ServerStatistics Statistics;
+	AnalogCANJaguarPipeServer :: PipeStatistics PipeStatistics;
+
+	while ( true )
+	{
+
+		Server -> GetStatistics ( & Statistics );
+
+		if ( Statistics.Cycles != * Cycle )
+			break;
+
+		Wait ( 0.0002 );
+
+	}
+
+	* Cycle = Statistics.Cycles;
+
+	Server -> GetPipeStatistics ( Pipe, & PipeStatistics );
+
+	return PipeStatistics.LastInput;
+
+};
+
+// Noise left on the input, and cycles for a 1 V step to get halfway, with one oversampling setting.
+bool AnalogCANJaguarPipeBench :: Oversample ( AnalogCANJaguarPipeServer * Server, AnalogCANJaguarPipe_t Pipe, uint32_t AverageBits, uint32_t RingSamples )
+{
+
+	AnalogCANJaguarPipeServer :: ServerStatistics Statistics;
+
+	AnalogChannel :: SetHostInput ( 1, 1, ANALOGCANJAGUARPIPEBENCH_LEVEL, ANALOGCANJAGUARPIPEBENCH_NOISE );
+	Server -> SetPipeOversampling ( Pipe, AverageBits, RingSamples );
+
+	Server -> GetStatistics ( & Statistics );
+
+	uint32_t Cycle = Statistics.Cycles;
+
+	// Let the ring fill.
+	for ( uint32_t i = 0; i < RingSamples + 2; i ++ )
+		NextInput ( Server, Pipe, & Cycle );
+
+	double Sum = 0;
+	double SumSquares = 0;
+
+	double Start = Timer :: GetPPCTimestamp ();
+	uint32_t FirstCycle = Cycle;
+
+	for ( uint32_t i = 0; i < ANALOGCANJAGUARPIPEBENCH_NOISE_SAMPLES; i ++ )
+	{
+
+		double Input = NextInput ( Server, Pipe, & Cycle ) - ANALOGCANJAGUARPIPEBENCH_LEVEL;
+
+		Sum += Input;
+		SumSquares += Input * Input;
+
+	}
+
+	double CycleTime = ( Timer :: GetPPCTimestamp () - Start ) / ( Cycle - FirstCycle );
+
+	double Mean = Sum / ANALOGCANJAGUARPIPEBENCH_NOISE_SAMPLES;
+	double Noise = sqrt ( SumSquares / ANALOGCANJAGUARPIPEBENCH_NOISE_SAMPLES - Mean * Mean );
+	double Expected = ANALOGCANJAGUARPIPEBENCH_NOISE / sqrt ( static_cast <double> ( ( 1u << AverageBits ) * RingSamples ) );
+
+	// Step without noise, counting cycles from the one that first sees the new level.
+	AnalogChannel :: SetHostInput ( 1, 1, ANALOGCANJAGUARPIPEBENCH_LEVEL, 0 );
+
+	for ( uint32_t i = 0; i < RingSamples + 2; i ++ )
+		NextInput ( Server, Pipe, & Cycle );
+
+	AnalogChannel :: SetHostInput ( 1, 1, ANALOGCANJAGUARPIPEBENCH_LEVEL + 1.0, 0 );
+
+	uint32_t Latency = 0;
+
+	while ( NextInput ( Server, Pipe, & Cycle ) < ANALOGCANJAGUARPIPEBENCH_LEVEL + 0.5 - 1e-6 && Latency < 100 )
+		Latency ++;
+
+	Latency ++;
+
+	printf ( "  %u bits, ring %2u: noise %7.2f mV ( expected %6.2f, %4.2fx less ), halfway after %2u cycles ( %5.1f ms )\n", AverageBits, RingSamples, 1000 * Noise, 1000 * Expected, ANALOGCANJAGUARPIPEBENCH_NOISE / Noise, Latency, 1000 * Latency * CycleTime );
+
+	// The ring's samples overlap from one cycle to the next, so the noise estimate is rougher for long rings.
+	return fabs ( Noise / Expected - 1 ) < 0.3 && Latency <= RingSamples / 2 + 2;
+
+};
+
+bool AnalogCANJaguarPipeBench :: Oversampling ()
+{
+
+	bool Passed = true;
+
+	AnalogCANJaguarPipeServer * Server = new AnalogCANJaguarPipeServer ();
+
+	Server -> Start ();
+
+	AnalogChannel :: SetHostInput ( 1, 1, ANALOGCANJAGUARPIPEBENCH_LEVEL, ANALOGCANJAGUARPIPEBENCH_NOISE );
+
+	AnalogCANJaguarPipe_t Pipe = Server -> AddPipe ( 1, 1, 1 );
+
+	Server -> EnablePipe ( Pipe );
+
+	printf ( "oversampling: %.0f mV of noise on one pipe, %u cycles per setting\n", 1000 * ANALOGCANJAGUARPIPEBENCH_NOISE, ANALOGCANJAGUARPIPEBENCH_NOISE_SAMPLES );
+
+	for ( uint32_t Ring = 1; Ring <= ANALOGCANJAGSERVER_MAX_RING_SAMPLES; Ring *= 2 )
+		Passed &= Oversample ( Server, Pipe, 0, Ring );
+
+	for ( uint32_t Bits = 1; Bits <= 4; Bits ++ )
+		Passed &= Oversample ( Server, Pipe, Bits, 1 );
+
+	Passed &= Oversample ( Server, Pipe, 4, ANALOGCANJAGSERVER_MAX_RING_SAMPLES );
+
+	Server -> Stop ();
+
+	return Passed;
+
+};
+
+// One of each command the server takes after AddPipe, chosen by i.
+void AnalogCANJaguarPipeBench :: IssueCommand ( AnalogCANJaguarPipeServer * Server, AnalogCANJaguarPipe_t Pipe, uint32_t i )
+{
+
+	switch ( i % 10 )
+	{
+
+	case 0:
+
+		Server -> SetPipeInverted ( Pipe, ( i & 16 ) != 0 );
+		break;
+
+	case 1:
+
+		Server -> SetPipeOffset ( Pipe, Random ( 0, 1 ) );
+		break;
+
+	case 2:
+
+		Server -> DisablePipe ( Pipe );
+		break;
+
+	case 3:
+
+		Server -> EnablePipe ( Pipe );
+		break;
+
+	case 4:
+
+		Server -> ZeroPipe ( Pipe );
+		break;
+
+	case 5:
+
+		Server -> SetPipeGating ( Pipe, Random ( 0, 0.01 ), Random ( 0.05, 0.2 ) );
+		break;
+
+	case 6:
+
+		Server -> SetPipePeriod ( Pipe, 1 + ( i & 7 ) );
+		break;
+
+	case 7:
+
+		Server -> SetPipeOversampling ( Pipe, i & 3, 1 + ( i & 15 ) );
+		break;
+
+	case 8:
+
+		Server -> SetPipeTransfer ( Pipe, NULL );
+		break;
+
+	default:
+
+		Server -> SetPipePeriod ( Pipe, 1 );
+		break;
+
+	}
+
+};
+
+bool AnalogCANJaguarPipeBench :: Soak ( uint32_t Commands )
+{
+
+	AnalogCANJaguarPipeServer * Server = new AnalogCANJaguarPipeServer ();
+
+	Server -> Start ();
+
+	AnalogCANJaguarPipe_t Pipes [ ANALOGCANJAGUARPIPEBENCH_SOAK_PIPES ];
+
+	// Levels a float holds exactly, so the Jaguar outputs can be checked exactly.
+	for ( uint32_t i = 0; i < ANALOGCANJAGUARPIPEBENCH_SOAK_PIPES; i ++ )
+	{
+
+		AnalogChannel :: SetHostInput ( 1, i + 1, 0.5 + 0.5 * i, 0.01 );
+
+		Pipes [ i ] = Server -> AddPipe ( i + 1, i + 1, 1 );
+
+	}
+
+	// Once through every command first, so anything allocated on first use is out of the way.
+	for ( uint32_t i = 0; i < 10 * ANALOGCANJAGUARPIPEBENCH_SOAK_PIPES; i ++ )
+		IssueCommand ( Server, Pipes [ i % ANALOGCANJAGUARPIPEBENCH_SOAK_PIPES ], i );
+
+	Wait ( 0.1 );
+
+	// Printed before the heap is measured, since the first printf allocates stdout's buffer.
+	printf ( "soak: %u commands over %u pipes\n", Commands, ANALOGCANJAGUARPIPEBENCH_SOAK_PIPES );
+
+	AnalogCANJaguarPipeServer :: ServerStatistics Before;
+	AnalogCANJaguarPipeServer :: ServerStatistics After;
+
+	Server -> GetStatistics ( & Before );
+
+	uint32_t Allocations = HostAllocationCount ();
+	size_t Heap = mallinfo2 ().uordblks;
+
+	bool Passed = true;
+
+	double Start = Timer :: GetPPCTimestamp ();
+	uint32_t Report = Commands / ANALOGCANJAGUARPIPEBENCH_SOAK_REPORTS;
+
+	for ( uint32_t i = 0; i < Commands; i ++ )
+	{
+
+		IssueCommand ( Server, Pipes [ ( i / 10 ) % ANALOGCANJAGUARPIPEBENCH_SOAK_PIPES ], i );
+
+		if ( Report != 0 && ( i + 1 ) % Report == 0 )
+		{
+
+			long Grown = static_cast <long> ( mallinfo2 ().uordblks ) - static_cast <long> ( Heap );
+
+			printf ( "  %9u commands, %7.0f per second: %u allocations, heap %+ld bytes\n", i + 1, ( i + 1 ) / ( Timer :: GetPPCTimestamp () - Start ), HostAllocationCount () - Allocations, Grown );
+
+			Passed &= ( HostAllocationCount () == Allocations && Grown == 0 );
+
+		}
+
+	}
+
+	// Let the queue drain before looking at the server.
+	Wait ( 0.1 );
+
+	Server -> GetStatistics ( & After );
+
+	printf ( "  %u cycles, %u late, longest %.2f ms\n", After.Cycles - Before.Cycles, After.LateCycles - Before.LateCycles, 1000 * After.MaxCycleTime );
+
+	// Put every pipe in a known state, and check what its Jaguar was last sent.
+	for ( uint32_t i = 0; i < ANALOGCANJAGUARPIPEBENCH_SOAK_PIPES; i ++ )
+	{
+
+		AnalogChannel :: SetHostInput ( 1, i + 1, 0.5 + 0.5 * i, 0 );
+
+		Server -> SetPipeOffset ( Pipes [ i ], 0 );
+		Server -> SetPipeInverted ( Pipes [ i ], i & 1 );
+		Server -> SetPipePeriod ( Pipes [ i ], 1 );
+		Server -> SetPipeOversampling ( Pipes [ i ], 0, 1 );
+		Server -> SetPipeGating ( Pipes [ i ], 0 );
+		Server -> EnablePipe ( Pipes [ i ] );
+
+	}
+
+	Wait ( 0.1 );
+
+	uint32_t Wrong = 0;
+
+	for ( uint32_t i = 0; i < ANALOGCANJAGUARPIPEBENCH_SOAK_PIPES; i ++ )
+	{
+
+		float Value = 0;
+		double Time;
+		uint32_t Count;
+
+		double Expected = ( ( i & 1 ) ? - 1 : 1 ) * ( 0.5 + 0.5 * i ) / INPUT_SCALE * JAGSCALE;
+
+		if ( ! CANJaguar :: GetHostOutput ( i + 1, & Value, & Time, & Count ) || fabs ( Value - Expected ) > 1e-5 )
+			Wrong ++;
+
+	}
+
+	printf ( "  pipes driving the wrong output afterwards: %u\n", Wrong );
+
+	Server -> Stop ();
+
+	return Passed && Wrong == 0;
+
+};
+
+// A pipe set up every way but its offset, copied to a fresh one, and a copy from a removed pipe.
+bool AnalogCANJaguarPipeBench :: Copy ()
+{
+
+	AnalogCANJaguarPipeServer * Server = new AnalogCANJaguarPipeServer ();
+
+	Server -> Start ();
+
+	FilterChain Chain;
+
+	Chain.AddDeadband ( 0.1 );
+	Chain.AddLowPass ( 0.05 );
+
+	AnalogCANJaguarPipe_t From = Server -> AddPipe ( 1, 1, 1 );
+
+	Server -> SetPipeInverted ( From, true );
+	Server -> SetPipeOffset ( From, 1.0 );
+	Server -> SetPipeTransfer ( From, & Chain );
+	Server -> SetPipeGating ( From, 0.02, 0.1 );
+	Server -> SetPipePeriod ( From, 4 );
+	Server -> SetPipeOversampling ( From, 2, 4 );
+
+	AnalogCANJaguarPipe_t To = Server -> AddPipe ( 2, 2, 1 );
+	AnalogCANJaguarPipe_t Orphan = Server -> AddPipe ( 3, 3, 1 );
+
+	Server -> CopyPipeSettings ( From, To );
+
+	Wait ( 0.05 );
+
+	semTake ( Server -> PipesAccessSemaphore, WAIT_FOREVER );
+
+	Bank_t * Bank = Server -> Bank;
+
+	uint32_t FromIndex = Server -> ResolvePipe ( From );
+	uint32_t ToIndex = Server -> ResolvePipe ( To );
+
+	AnalogCANJaguarPipeServer :: AnalogCANJaguarPipe & Source = Bank -> Pipes [ FromIndex ];
+	AnalogCANJaguarPipeServer :: AnalogCANJaguarPipe & Copied = Bank -> Pipes [ ToIndex ];
+
+	bool Transfer = ( Copied.TransferLength == Source.TransferLength );
+
+	for ( uint32_t i = 0; i < Source.TransferLength && Transfer; i ++ )
+		Transfer = ( Copied.Transfer [ i ].Type == Source.Transfer [ i ].Type && Copied.Transfer [ i ].ParamA == Source.Transfer [ i ].ParamA && Copied.Transfer [ i ].CoeffA == Source.Transfer [ i ].CoeffA );
+
+	bool Inverted = ( Bank -> Sign [ ToIndex ] == - 1.0 );
+	bool Offset = ( Bank -> Offset [ ToIndex ] == 2.5 );
+	bool Gating = ( Copied.GateEpsilon == 0.02 && Copied.GateKeepalive == 0.1 );
+	bool Period = ( Copied.Period == 4 );
+	bool Oversampling = ( Copied.InputChannel -> GetAverageBits () == 2 && Copied.UseAverage && Copied.RingLength == 4 );
+
+	semGive ( Server -> PipesAccessSemaphore );
+
+	printf ( "copy: inverted %s, transfer chain %s, gating %s, period %s, oversampling %s, offset left at default %s\n", Inverted ? "ok" : "FAILED", Transfer ? "ok" : "FAILED", Gating ? "ok" : "FAILED", Period ? "ok" : "FAILED", Oversampling ? "ok" : "FAILED", Offset ? "ok" : "FAILED" );
+
+	Server -> RemovePipe ( From );
+	Server -> CopyPipeSettings ( From, Orphan );
+
+	Wait ( 0.05 );
+
+	semTake ( Server -> PipesAccessSemaphore, WAIT_FOREVER );
+
+	AnalogCANJaguarPipeServer :: AnalogCANJaguarPipe & Untouched = Bank -> Pipes [ Server -> ResolvePipe ( Orphan ) ];
+
+	bool Ignored = ( Untouched.TransferLength == 0 && Untouched.Period == 1 && Untouched.RingLength == 1 && Bank -> Sign [ Server -> ResolvePipe ( Orphan ) ] == 1.0 );
+
+	semGive ( Server -> PipesAccessSemaphore );
+
+	printf ( "copy from a removed pipe: %s\n", Ignored ? "ignored" : "FAILED, applied" );
+
+	Server -> Stop ();
+
+	return Inverted && Transfer && Gating && Period && Oversampling && Offset && Ignored;
+
+};
+
+int main ( int argc, char ** argv )
+{
+
+	const char * Section = ( argc > 1 ) ? argv [ 1 ] : "all";
+	bool All = ( strcmp ( Section, "all" ) == 0 );
+
+	bool Passed = true;
+
+	if ( All || strcmp ( Section, "kernel" ) == 0 )
+		Passed &= AnalogCANJaguarPipeBench :: Kernel ();
+
+	if ( All || strcmp ( Section, "oversampling" ) == 0 )
+		Passed &= AnalogCANJaguarPipeBench :: Oversampling ();
+
+	if ( All || strcmp ( Section, "soak" ) == 0 )
+		Passed &= AnalogCANJaguarPipeBench :: Soak ( ( argc > 2 ) ? atoi ( argv [ 2 ] ) : 2000000 );
+
+	if ( All || strcmp ( Section, "copy" ) == 0 )
+		Passed &= AnalogCANJaguarPipeBench :: Copy ();
+
+	// Keeps the timed loops from being optimized out.
+	if ( Sink == 0.123 )
+		printf ( "\n" );
+
+	printf ( "%s\n", Passed ? "PASSED" : "FAILED" );
+
+	fflush ( stdout );
+	_exit ( Passed ? 0 : 1 );
+
+};
+
+#endif
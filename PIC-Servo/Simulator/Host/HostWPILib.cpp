@@ -0,0 +1,1194 @@
+#if defined ( __linux__ ) && ! defined ( _GNU_SOURCE )
+	#define _GNU_SOURCE
+#endif
+
+#include "WPILib.h"
+
+#if defined ( __linux__ )
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <new>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+
+#define HOSTWPILIB_TICK_RATE 1000
+#define HOSTWPILIB_ARENA_SIZE ( 512u << 20 )
+#define HOSTWPILIB_ANALOG_SLOTS 64
+#define HOSTWPILIB_JAGUARS 64
+
+/*
+* operator new, from an arena below 4 GB.
+*/
+
+static char * ArenaBase = NULL;
+static size_t ArenaUsed = 0;
+static uint32_t Allocations = 0;
+static pthread_mutex_t ArenaLock = PTHREAD_MUTEX_INITIALIZER;
+
+static void * ArenaAllocate ( size_t Size )
+{
+
+	pthread_mutex_lock ( & ArenaLock );
+
+	if ( ArenaBase == NULL )
+	{
+
+		void * Base = mmap ( NULL, HOSTWPILIB_ARENA_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT | MAP_NORESERVE, - 1, 0 );
+
+		if ( Base == MAP_FAILED )
+		{
+
+			pthread_mutex_unlock ( & ArenaLock );
+
+			fprintf ( stderr, "HostWPILib: no memory below 4 GB\n" );
+			abort ();
+
+		}
+
+		ArenaBase = static_cast <char *> ( Base );
+
+	}
+
+	size_t Offset = ( ArenaUsed + 15 ) & ~ static_cast <size_t> ( 15 );
+
+	if ( Offset + Size > HOSTWPILIB_ARENA_SIZE )
+	{
+
+		pthread_mutex_unlock ( & ArenaLock );
+
+		fprintf ( stderr, "HostWPILib: arena exhausted\n" );
+		abort ();
+
+	}
+
+	ArenaUsed = Offset + ( Size != 0 ? Size : 1 );
+	Allocations ++;
+
+	pthread_mutex_unlock ( & ArenaLock );
+
+	return ArenaBase + Offset;
+
+};
+
+void * operator new ( size_t Size )
+{
+
+	return ArenaAllocate ( Size );
+
+};
+
+void * operator new [] ( size_t Size )
+{
+
+	return ArenaAllocate ( Size );
+
+};
+
+void operator delete ( void * ) throw ()
+{
+};
+
+void operator delete [] ( void * ) throw ()
+{
+};
+
+void operator delete ( void *, size_t ) throw ()
+{
+};
+
+void operator delete [] ( void *, size_t ) throw ()
+{
+};
+
+uint32_t HostAllocationCount ()
+{
+
+	pthread_mutex_lock ( & ArenaLock );
+
+	uint32_t Count = Allocations;
+
+	pthread_mutex_unlock ( & ArenaLock );
+
+	return Count;
+
+};
+
+/*
+* Time.
+*/
+
+static double Now ()
+{
+
+	struct timespec Time;
+
+	clock_gettime ( CLOCK_MONOTONIC, & Time );
+
+	return static_cast <double> ( Time.tv_sec ) + static_cast <double> ( Time.tv_nsec ) * 1e-9;
+
+};
+
+// Absolute CLOCK_MONOTONIC deadline for a timeout in ticks.
+static struct timespec Deadline ( int Timeout )
+{
+
+	struct timespec Time;
+
+	clock_gettime ( CLOCK_MONOTONIC, & Time );
+
+	long long Nanoseconds = static_cast <long long> ( Time.tv_nsec ) + static_cast <long long> ( Timeout ) * ( 1000000000LL / HOSTWPILIB_TICK_RATE );
+
+	Time.tv_sec += static_cast <time_t> ( Nanoseconds / 1000000000LL );
+	Time.tv_nsec = static_cast <long> ( Nanoseconds % 1000000000LL );
+
+	return Time;
+
+};
+
+int sysClkRateGet ()
+{
+
+	return HOSTWPILIB_TICK_RATE;
+
+};
+
+void Wait ( double Seconds )
+{
+
+	if ( Seconds <= 0 )
+		return;
+
+	struct timespec Time;
+
+	Time.tv_sec = static_cast <time_t> ( Seconds );
+	Time.tv_nsec = static_cast <long> ( ( Seconds - static_cast <double> ( Time.tv_sec ) ) * 1e9 );
+
+	while ( nanosleep ( & Time, & Time ) != 0 && errno == EINTR )
+	{
+	}
+
+};
+
+double Timer :: GetPPCTimestamp ()
+{
+
+	return Now ();
+
+};
+
+double Timer :: GetFPGATimestamp ()
+{
+
+	return Now ();
+
+};
+
+/*
+* Semaphores. Every one has a mutex and condition, so a blocked take can be cancelled cleanly by Task :: Stop ().
+*/
+
+struct HostSemaphore
+{
+
+	bool Mutex;
+	bool DeleteSafe;
+
+	pthread_mutex_t Lock;
+	pthread_cond_t Changed;
+
+	// Binary: whether it's full. Mutex: the owner and how many times it has taken it.
+	bool Full;
+	pthread_t Owner;
+	uint32_t Depth;
+
+};
+
+// Number of delete-safe mutexes the calling thread holds. Cancellation is off while it's above zero.
+static __thread uint32_t DeleteSafeDepth = 0;
+
+static void UnlockOnCancel ( void * Lock )
+{
+
+	pthread_mutex_unlock ( static_cast <pthread_mutex_t *> ( Lock ) );
+
+};
+
+static void InitializeCondition ( pthread_cond_t * Condition )
+{
+
+	pthread_condattr_t Attributes;
+
+	pthread_condattr_init ( & Attributes );
+	pthread_condattr_setclock ( & Attributes, CLOCK_MONOTONIC );
+	pthread_cond_init ( Condition, & Attributes );
+	pthread_condattr_destroy ( & Attributes );
+
+};
+
+static SEM_ID CreateSemaphore ( bool Mutex, int Options, bool Full )
+{
+
+	SEM_ID Semaphore = static_cast <SEM_ID> ( malloc ( sizeof ( HostSemaphore ) ) );
+
+	Semaphore -> Mutex = Mutex;
+	Semaphore -> DeleteSafe = Mutex && ( Options & SEM_DELETE_SAFE ) != 0;
+	Semaphore -> Full = Full;
+	Semaphore -> Depth = 0;
+
+	pthread_mutex_init ( & Semaphore -> Lock, NULL );
+	InitializeCondition ( & Semaphore -> Changed );
+
+	return Semaphore;
+
+};
+
+SEM_ID semMCreate ( int Options )
+{
+
+	return CreateSemaphore ( true, Options, true );
+
+};
+
+SEM_ID semBCreate ( int Options, SEM_B_STATE InitialState )
+{
+
+	return CreateSemaphore ( false, Options, InitialState == SEM_FULL );
+
+};
+
+STATUS semTake ( SEM_ID Semaphore, int Timeout )
+{
+
+	struct timespec Until = Deadline ( Timeout > 0 ? Timeout : 0 );
+	pthread_t Self = pthread_self ();
+	STATUS Result = OK;
+
+	pthread_mutex_lock ( & Semaphore -> Lock );
+	pthread_cleanup_push ( UnlockOnCancel, & Semaphore -> Lock );
+
+	if ( Semaphore -> Mutex && Semaphore -> Depth != 0 && pthread_equal ( Semaphore -> Owner, Self ) )
+		Semaphore -> Depth ++;
+	else
+	{
+
+		while ( Semaphore -> Mutex ? ( Semaphore -> Depth != 0 ) : ! Semaphore -> Full )
+		{
+
+			if ( Timeout == NO_WAIT )
+			{
+
+				Result = ERROR;
+
+				break;
+
+			}
+
+			if ( Timeout == WAIT_FOREVER )
+				pthread_cond_wait ( & Semaphore -> Changed, & Semaphore -> Lock );
+			else if ( pthread_cond_timedwait ( & Semaphore -> Changed, & Semaphore -> Lock, & Until ) == ETIMEDOUT )
+			{
+
+				if ( Semaphore -> Mutex ? ( Semaphore -> Depth != 0 ) : ! Semaphore -> Full )
+					Result = ERROR;
+
+				break;
+
+			}
+
+		}
+
+		if ( Result == OK )
+		{
+
+			if ( Semaphore -> Mutex )
+			{
+
+				Semaphore -> Owner = Self;
+				Semaphore -> Depth = 1;
+
+			}
+			else
+				Semaphore -> Full = false;
+
+		}
+
+	}
+
+	pthread_cleanup_pop ( 1 );
+
+	if ( Result == OK && Semaphore -> DeleteSafe && DeleteSafeDepth ++ == 0 )
+		pthread_setcancelstate ( PTHREAD_CANCEL_DISABLE, NULL );
+
+	return Result;
+
+};
+
+STATUS semGive ( SEM_ID Semaphore )
+{
+
+	bool Released = false;
+
+	pthread_mutex_lock ( & Semaphore -> Lock );
+
+	if ( Semaphore -> Mutex )
+	{
+
+		if ( Semaphore -> Depth == 0 || ! pthread_equal ( Semaphore -> Owner, pthread_self () ) )
+		{
+
+			pthread_mutex_unlock ( & Semaphore -> Lock );
+
+			return ERROR;
+
+		}
+
+		Released = true;
+
+		if ( -- Semaphore -> Depth == 0 )
+			pthread_cond_signal ( & Semaphore -> Changed );
+
+	}
+	else
+	{
+
+		Semaphore -> Full = true;
+		pthread_cond_signal ( & Semaphore -> Changed );
+
+	}
+
+	pthread_mutex_unlock ( & Semaphore -> Lock );
+
+	// A Stop () that came in while a delete-safe lock was held takes effect at the next cancellation point.
+	if ( Released && Semaphore -> DeleteSafe && -- DeleteSafeDepth == 0 )
+		pthread_setcancelstate ( PTHREAD_CANCEL_ENABLE, NULL );
+
+	return OK;
+
+};
+
+STATUS semDelete ( SEM_ID Semaphore )
+{
+
+	pthread_mutex_destroy ( & Semaphore -> Lock );
+	pthread_cond_destroy ( & Semaphore -> Changed );
+
+	free ( Semaphore );
+
+	return OK;
+
+};
+
+/*
+* Message queues: a ring of fixed size slots.
+*/
+
+struct HostMessageQueue
+{
+
+	pthread_mutex_t Lock;
+	pthread_cond_t NotEmpty;
+	pthread_cond_t NotFull;
+
+	uint32_t Capacity;
+	uint32_t SlotSize;
+
+	uint32_t Head;
+	uint32_t Count;
+
+	uint32_t * Lengths;
+	char * Slots;
+
+};
+
+MSG_Q_ID msgQCreate ( int MaxMessages, int MaxMessageLength, int )
+{
+
+	MSG_Q_ID Queue = static_cast <MSG_Q_ID> ( malloc ( sizeof ( HostMessageQueue ) ) );
+
+	pthread_mutex_init ( & Queue -> Lock, NULL );
+	InitializeCondition ( & Queue -> NotEmpty );
+	InitializeCondition ( & Queue -> NotFull );
+
+	Queue -> Capacity = MaxMessages;
+	Queue -> SlotSize = MaxMessageLength;
+	Queue -> Head = 0;
+	Queue -> Count = 0;
+
+	Queue -> Lengths = static_cast <uint32_t *> ( malloc ( sizeof ( uint32_t ) * MaxMessages ) );
+	Queue -> Slots = static_cast <char *> ( malloc ( static_cast <size_t> ( MaxMessages ) * MaxMessageLength ) );
+
+	return Queue;
+
+};
+
+// Wait on a condition with a VxWorks timeout. False once the timeout has passed.
+static bool WaitCondition ( pthread_cond_t * Condition, pthread_mutex_t * Lock, int Timeout, const struct timespec * Until )
+{
+
+	if ( Timeout == NO_WAIT )
+		return false;
+
+	if ( Timeout == WAIT_FOREVER )
+	{
+
+		pthread_cond_wait ( Condition, Lock );
+
+		return true;
+
+	}
+
+	return pthread_cond_timedwait ( Condition, Lock, Until ) != ETIMEDOUT;
+
+};
+
+STATUS msgQSend ( MSG_Q_ID Queue, char * Buffer, UINT32 Length, int Timeout, int Priority )
+{
+
+	struct timespec Until = Deadline ( Timeout > 0 ? Timeout : 0 );
+	STATUS Result = OK;
+
+	if ( Length > Queue -> SlotSize )
+		return ERROR;
+
+	pthread_mutex_lock ( & Queue -> Lock );
+	pthread_cleanup_push ( UnlockOnCancel, & Queue -> Lock );
+
+	while ( Queue -> Count == Queue -> Capacity )
+	{
+
+		if ( ! WaitCondition ( & Queue -> NotFull, & Queue -> Lock, Timeout, & Until ) && Queue -> Count == Queue -> Capacity )
+		{
+
+			Result = ERROR;
+
+			break;
+
+		}
+
+	}
+
+	if ( Result == OK )
+	{
+
+		uint32_t Slot;
+
+		if ( Priority == MSG_PRI_URGENT )
+		{
+
+			Queue -> Head = ( Queue -> Head + Queue -> Capacity - 1 ) % Queue -> Capacity;
+			Slot = Queue -> Head;
+
+		}
+		else
+			Slot = ( Queue -> Head + Queue -> Count ) % Queue -> Capacity;
+
+		memcpy ( & Queue -> Slots [ static_cast <size_t> ( Slot ) * Queue -> SlotSize ], Buffer, Length );
+		Queue -> Lengths [ Slot ] = Length;
+		Queue -> Count ++;
+
+		pthread_cond_signal ( & Queue -> NotEmpty );
+
+	}
+
+	pthread_cleanup_pop ( 1 );
+
+	return Result;
+
+};
+
+int msgQReceive ( MSG_Q_ID Queue, char * Buffer, UINT32 MaxLength, int Timeout )
+{
+
+	struct timespec Until = Deadline ( Timeout > 0 ? Timeout : 0 );
+	int Result = ERROR;
+
+	pthread_mutex_lock ( & Queue -> Lock );
+	pthread_cleanup_push ( UnlockOnCancel, & Queue -> Lock );
+
+	while ( Queue -> Count == 0 )
+	{
+
+		if ( ! WaitCondition ( & Queue -> NotEmpty, & Queue -> Lock, Timeout, & Until ) && Queue -> Count == 0 )
+			break;
+
+	}
+
+	if ( Queue -> Count != 0 )
+	{
+
+		uint32_t Length = Queue -> Lengths [ Queue -> Head ];
+
+		if ( Length > MaxLength )
+			Length = MaxLength;
+
+		memcpy ( Buffer, & Queue -> Slots [ static_cast <size_t> ( Queue -> Head ) * Queue -> SlotSize ], Length );
+
+		Queue -> Head = ( Queue -> Head + 1 ) % Queue -> Capacity;
+		Queue -> Count --;
+
+		Result = static_cast <int> ( Length );
+
+		pthread_cond_signal ( & Queue -> NotFull );
+
+	}
+
+	pthread_cleanup_pop ( 1 );
+
+	return Result;
+
+};
+
+int msgQNumMsgs ( MSG_Q_ID Queue )
+{
+
+	pthread_mutex_lock ( & Queue -> Lock );
+
+	int Count = static_cast <int> ( Queue -> Count );
+
+	pthread_mutex_unlock ( & Queue -> Lock );
+
+	return Count;
+
+};
+
+STATUS msgQDelete ( MSG_Q_ID Queue )
+{
+
+	pthread_mutex_destroy ( & Queue -> Lock );
+	pthread_cond_destroy ( & Queue -> NotEmpty );
+	pthread_cond_destroy ( & Queue -> NotFull );
+
+	free ( Queue -> Lengths );
+	free ( Queue -> Slots );
+	free ( Queue );
+
+	return OK;
+
+};
+
+/*
+* Tasks.
+*/
+
+typedef int ( * HostTaskEntry ) ( uintptr_t, uintptr_t, uintptr_t, uintptr_t, uintptr_t, uintptr_t, uintptr_t, uintptr_t, uintptr_t, uintptr_t );
+
+// Guards Running between a task's thread finishing and Start () or Stop () from another.
+static pthread_mutex_t TaskLock = PTHREAD_MUTEX_INITIALIZER;
+
+Task :: Task ( const char * Name, FUNCPTR Function, INT32, UINT32 )
+{
+
+	strncpy ( this -> Name, Name, sizeof ( this -> Name ) - 1 );
+	this -> Name [ sizeof ( this -> Name ) - 1 ] = 0;
+
+	this -> Function = Function;
+
+	for ( uint32_t i = 0; i < 10; i ++ )
+		Args [ i ] = 0;
+
+	Thread = malloc ( sizeof ( pthread_t ) );
+	Running = false;
+
+};
+
+Task :: ~Task ()
+{
+
+	Stop ();
+
+	free ( Thread );
+
+};
+
+bool Task :: Start ( UINT32 Arg0, UINT32 Arg1, UINT32 Arg2, UINT32 Arg3, UINT32 Arg4, UINT32 Arg5, UINT32 Arg6, UINT32 Arg7, UINT32 Arg8, UINT32 Arg9 )
+{
+
+	if ( Running )
+		return false;
+
+	UINT32 Values [ 10 ] = { Arg0, Arg1, Arg2, Arg3, Arg4, Arg5, Arg6, Arg7, Arg8, Arg9 };
+
+	for ( uint32_t i = 0; i < 10; i ++ )
+		Args [ i ] = Values [ i ];
+
+	pthread_mutex_lock ( & TaskLock );
+
+	// Set before the thread can finish and clear it.
+	Running = ( pthread_create ( static_cast <pthread_t *> ( Thread ), NULL, & Task :: Run, this ) == 0 );
+
+	bool Started = Running;
+
+	pthread_mutex_unlock ( & TaskLock );
+
+	return Started;
+
+};
+
+void * Task :: Run ( void * This )
+{
+
+	Task * Self = static_cast <Task *> ( This );
+
+	pthread_setcanceltype ( PTHREAD_CANCEL_DEFERRED, NULL );
+
+	// Arguments were squeezed into 32 bits, which is why operator new stays below 4 GB.
+	reinterpret_cast <HostTaskEntry> ( Self -> Function ) ( Self -> Args [ 0 ], Self -> Args [ 1 ], Self -> Args [ 2 ], Self -> Args [ 3 ], Self -> Args [ 4 ], Self -> Args [ 5 ], Self -> Args [ 6 ], Self -> Args [ 7 ], Self -> Args [ 8 ], Self -> Args [ 9 ] );
+
+	// A task whose entry function returns is gone, as with taskSpawn, so it can be started again. Unless Stop () has
+	// already claimed the thread to join it, it reaps itself.
+	pthread_mutex_lock ( & TaskLock );
+
+	if ( Self -> Running )
+	{
+
+		pthread_detach ( pthread_self () );
+		Self -> Running = false;
+
+	}
+
+	pthread_mutex_unlock ( & TaskLock );
+
+	return NULL;
+
+};
+
+bool Task :: Stop ()
+{
+
+	pthread_mutex_lock ( & TaskLock );
+
+	bool Claimed = Running;
+	Running = false;
+
+	pthread_mutex_unlock ( & TaskLock );
+
+	if ( ! Claimed )
+		return true;
+
+	pthread_t * Handle = static_cast <pthread_t *> ( Thread );
+
+	pthread_cancel ( * Handle );
+	pthread_join ( * Handle, NULL );
+
+	return true;
+
+};
+
+bool Task :: Verify ()
+{
+
+	return Running;
+
+};
+
+const char * Task :: GetName ()
+{
+
+	return Name;
+
+};
+
+/*
+* Serial port.
+*/
+
+static char HostDevice [ 256 ] = "";
+
+void SerialPort :: SetHostDevice ( const char * Path )
+{
+
+	strncpy ( HostDevice, Path, sizeof ( HostDevice ) - 1 );
+
+};
+
+SerialPort :: SerialPort ( UINT32, UINT8, Parity, StopBits )
+{
+
+	Descriptor = open ( HostDevice, O_RDWR | O_NOCTTY );
+	Timeout = 5.0;
+
+	if ( Descriptor < 0 )
+	{
+
+		perror ( "SerialPort" );
+
+		return;
+
+	}
+
+	struct termios Settings;
+
+	if ( tcgetattr ( Descriptor, & Settings ) == 0 )
+	{
+
+		cfmakeraw ( & Settings );
+		tcsetattr ( Descriptor, TCSANOW, & Settings );
+
+	}
+
+};
+
+SerialPort :: ~SerialPort ()
+{
+
+	if ( Descriptor >= 0 )
+		close ( Descriptor );
+
+};
+
+void SerialPort :: EnableTermination ( char )
+{
+};
+
+void SerialPort :: DisableTermination ()
+{
+};
+
+INT32 SerialPort :: GetBytesReceived ()
+{
+
+	int Count = 0;
+
+	if ( Descriptor < 0 || ioctl ( Descriptor, FIONREAD, & Count ) != 0 )
+		return 0;
+
+	return Count;
+
+};
+
+UINT32 SerialPort :: Read ( char * Buffer, INT32 Count )
+{
+
+	if ( Descriptor < 0 )
+		return 0;
+
+	double Until = Now () + Timeout;
+	INT32 Received = 0;
+
+	while ( Received < Count )
+	{
+
+		double Left = Until - Now ();
+
+		if ( Left <= 0 )
+			break;
+
+		struct pollfd Poll;
+
+		Poll.fd = Descriptor;
+		Poll.events = POLLIN;
+		Poll.revents = 0;
+
+		if ( poll ( & Poll, 1, static_cast <int> ( Left * 1000 ) + 1 ) <= 0 || ! ( Poll.revents & POLLIN ) )
+			continue;
+
+		ssize_t Got = read ( Descriptor, Buffer + Received, Count - Received );
+
+		if ( Got > 0 )
+			Received += Got;
+
+	}
+
+	return Received;
+
+};
+
+UINT32 SerialPort :: Write ( const char * Buffer, INT32 Count )
+{
+
+	if ( Descriptor < 0 )
+		return 0;
+
+	INT32 Sent = 0;
+
+	while ( Sent < Count )
+	{
+
+		ssize_t Wrote = write ( Descriptor, Buffer + Sent, Count - Sent );
+
+		if ( Wrote <= 0 )
+			break;
+
+		Sent += Wrote;
+
+	}
+
+	return Sent;
+
+};
+
+void SerialPort :: SetTimeout ( float Timeout )
+{
+
+	this -> Timeout = Timeout;
+
+};
+
+void SerialPort :: SetReadBufferSize ( UINT32 )
+{
+};
+
+void SerialPort :: SetWriteBufferSize ( UINT32 )
+{
+};
+
+void SerialPort :: SetWriteBufferMode ( WriteBufferMode )
+{
+};
+
+void SerialPort :: Flush ()
+{
+};
+
+void SerialPort :: Reset ()
+{
+
+	if ( Descriptor >= 0 )
+		tcflush ( Descriptor, TCIOFLUSH );
+
+};
+
+/*
+* Analog inputs.
+*/
+
+UINT32 SensorBase :: GetDefaultAnalogModule ()
+{
+
+	return 1;
+
+};
+
+static volatile double AnalogLevel [ HOSTWPILIB_ANALOG_SLOTS ];
+static volatile double AnalogNoise [ HOSTWPILIB_ANALOG_SLOTS ];
+
+static UINT32 AnalogSlot ( UINT8 ModuleNumber, UINT32 Channel )
+{
+
+	return ( ( ModuleNumber - 1 ) * 8 + ( Channel - 1 ) ) % HOSTWPILIB_ANALOG_SLOTS;
+
+};
+
+void AnalogChannel :: SetHostInput ( UINT8 ModuleNumber, UINT32 Channel, double Voltage, double Noise )
+{
+
+	UINT32 Slot = AnalogSlot ( ModuleNumber, Channel );
+
+	AnalogLevel [ Slot ] = Voltage;
+	AnalogNoise [ Slot ] = Noise;
+
+};
+
+AnalogChannel :: AnalogChannel ( UINT8 ModuleNumber, UINT32 Channel )
+{
+
+	Slot = AnalogSlot ( ModuleNumber, Channel );
+	AverageBits = 0;
+	RandomState = 0x9E3779B97F4A7C15ULL ^ Slot;
+
+};
+
+AnalogChannel :: AnalogChannel ( UINT32 Channel )
+{
+
+	Slot = AnalogSlot ( 1, Channel );
+	AverageBits = 0;
+	RandomState = 0x9E3779B97F4A7C15ULL ^ Slot;
+
+};
+
+AnalogChannel :: ~AnalogChannel ()
+{
+};
+
+// Level plus Gaussian noise, from a xorshift generator and the Box-Muller transform.
+double AnalogChannel :: Sample ( double Noise )
+{
+
+	double Uniform [ 2 ];
+
+	for ( uint32_t i = 0; i < 2; i ++ )
+	{
+
+		RandomState ^= RandomState << 13;
+		RandomState ^= RandomState >> 7;
+		RandomState ^= RandomState << 17;
+
+		Uniform [ i ] = ( static_cast <double> ( RandomState >> 11 ) + 1.0 ) / 9007199254740993.0;
+
+	}
+
+	return AnalogLevel [ Slot ] + Noise * sqrt ( - 2.0 * log ( Uniform [ 0 ] ) ) * cos ( 6.283185307179586 * Uniform [ 1 ] );
+
+};
+
+float AnalogChannel :: GetVoltage ()
+{
+
+	return static_cast <float> ( Sample ( AnalogNoise [ Slot ] ) );
+
+};
+
+float AnalogChannel :: GetAverageVoltage ()
+{
+
+	return static_cast <float> ( Sample ( AnalogNoise [ Slot ] / sqrt ( static_cast <double> ( 1u << AverageBits ) ) ) );
+
+};
+
+void AnalogChannel :: SetAverageBits ( UINT32 Bits )
+{
+
+	AverageBits = Bits;
+
+};
+
+UINT32 AnalogChannel :: GetAverageBits ()
+{
+
+	return AverageBits;
+
+};
+
+/*
+* Gyros, on the same analog slots.
+*/
+
+static volatile double GyroAngle [ HOSTWPILIB_ANALOG_SLOTS ];
+
+void Gyro :: SetHostAngle ( UINT8 ModuleNumber, UINT32 Channel, double Angle )
+{
+
+	GyroAngle [ AnalogSlot ( ModuleNumber, Channel ) ] = Angle;
+
+};
+
+Gyro :: Gyro ( UINT8 ModuleNumber, UINT32 Channel )
+{
+
+	Slot = AnalogSlot ( ModuleNumber, Channel );
+	Offset = GyroAngle [ Slot ];
+
+};
+
+Gyro :: Gyro ( UINT32 Channel )
+{
+
+	Slot = AnalogSlot ( 1, Channel );
+	Offset = GyroAngle [ Slot ];
+
+};
+
+Gyro :: ~Gyro ()
+{
+};
+
+float Gyro :: GetAngle ()
+{
+
+	return static_cast <float> ( GyroAngle [ Slot ] - Offset );
+
+};
+
+void Gyro :: Reset ()
+{
+
+	Offset = GyroAngle [ Slot ];
+
+};
+
+/*
+* Jaguars.
+*/
+
+typedef struct HostJaguarOutput
+{
+
+	float Value;
+	double Time;
+	UINT32 Count;
+
+	double Position;
+	UINT32 PositionReads;
+
+} HostJaguarOutput;
+
+static HostJaguarOutput JaguarOutputs [ HOSTWPILIB_JAGUARS ];
+static pthread_mutex_t JaguarLock = PTHREAD_MUTEX_INITIALIZER;
+
+CANJaguar :: CANJaguar ( UINT8 DeviceNumber, ControlMode Mode )
+{
+
+	this -> DeviceNumber = DeviceNumber % HOSTWPILIB_JAGUARS;
+	this -> Mode = Mode;
+
+	Enabled = false;
+
+};
+
+CANJaguar :: ~CANJaguar ()
+{
+};
+
+void CANJaguar :: Set ( float Value, UINT8 )
+{
+
+	double Time = Now ();
+
+	pthread_mutex_lock ( & JaguarLock );
+
+	JaguarOutputs [ DeviceNumber ].Value = Value;
+	JaguarOutputs [ DeviceNumber ].Time = Time;
+	JaguarOutputs [ DeviceNumber ].Count ++;
+
+	pthread_mutex_unlock ( & JaguarLock );
+
+};
+
+float CANJaguar :: Get ()
+{
+
+	pthread_mutex_lock ( & JaguarLock );
+
+	float Value = JaguarOutputs [ DeviceNumber ].Value;
+
+	pthread_mutex_unlock ( & JaguarLock );
+
+	return Value;
+
+};
+
+void CANJaguar :: Disable ()
+{
+
+	Set ( 0 );
+
+};
+
+void CANJaguar :: EnableControl ( double )
+{
+
+	Enabled = true;
+
+};
+
+void CANJaguar :: DisableControl ()
+{
+
+	Enabled = false;
+
+};
+
+void CANJaguar :: ChangeControlMode ( ControlMode Mode )
+{
+
+	this -> Mode = Mode;
+
+};
+
+CANJaguar :: ControlMode CANJaguar :: GetControlMode ()
+{
+
+	return Mode;
+
+};
+
+void CANJaguar :: SetPID ( double, double, double ) {};
+void CANJaguar :: SetPositionReference ( PositionReference ) {};
+void CANJaguar :: SetSpeedReference ( SpeedReference ) {};
+void CANJaguar :: ConfigEncoderCodesPerRev ( UINT16 ) {};
+void CANJaguar :: ConfigPotentiometerTurns ( UINT16 ) {};
+void CANJaguar :: ConfigNeutralMode ( NeutralMode ) {};
+void CANJaguar :: ConfigMaxOutputVoltage ( double ) {};
+void CANJaguar :: SetSafetyEnabled ( bool ) {};
+
+double CANJaguar :: GetPosition ()
+{
+
+	pthread_mutex_lock ( & JaguarLock );
+
+	double Position = JaguarOutputs [ DeviceNumber ].Position;
+
+	JaguarOutputs [ DeviceNumber ].PositionReads ++;
+
+	pthread_mutex_unlock ( & JaguarLock );
+
+	return Position;
+
+};
+
+float CANJaguar :: GetBusVoltage ()
+{
+
+	return 12.0f;
+
+};
+
+float CANJaguar :: GetOutputVoltage ()
+{
+
+	return 12.0f * Get ();
+
+};
+
+float CANJaguar :: GetOutputCurrent ()
+{
+
+	return 0.0f;
+
+};
+
+void CANJaguar :: UpdateSyncGroup ( UINT8 )
+{
+};
+
+bool CANJaguar :: GetHostOutput ( UINT8 DeviceNumber, float * Value, double * Time, UINT32 * Count )
+{
+
+	pthread_mutex_lock ( & JaguarLock );
+
+	HostJaguarOutput Output = JaguarOutputs [ DeviceNumber % HOSTWPILIB_JAGUARS ];
+
+	pthread_mutex_unlock ( & JaguarLock );
+
+	* Value = Output.Value;
+	* Time = Output.Time;
+	* Count = Output.Count;
+
+	return Output.Count != 0;
+
+};
+
+void CANJaguar :: SetHostPosition ( UINT8 DeviceNumber, double Position )
+{
+
+	pthread_mutex_lock ( & JaguarLock );
+
+	JaguarOutputs [ DeviceNumber % HOSTWPILIB_JAGUARS ].Position = Position;
+
+	pthread_mutex_unlock ( & JaguarLock );
+
+};
+
+UINT32 CANJaguar :: GetHostPositionReads ( UINT8 DeviceNumber )
+{
+
+	pthread_mutex_lock ( & JaguarLock );
+
+	UINT32 Reads = JaguarOutputs [ DeviceNumber % HOSTWPILIB_JAGUARS ].PositionReads;
+
+	pthread_mutex_unlock ( & JaguarLock );
+
+	return Reads;
+
+};
+
+#endif
@@ -0,0 +1,381 @@
+#ifndef SHS_2605_HOST_WPILIB_H
+#define SHS_2605_HOST_WPILIB_H
+
+/*
+* Host stand-in for the parts of WPILib and VxWorks the PIC-Servo, pipe server, CAN Jaguar server and drive code uses,
+* so it can be built and run unmodified on Linux against the simulator. Only for the host drivers in PIC-Servo/Simulator;
+* never on the robot.
+*
+* Tasks are pthreads, and their priorities are ignored. Semaphores and message queues keep VxWorks semantics:
+* mutexes nest, SEM_DELETE_SAFE defers Task :: Stop () until the lock is given back, and MSG_PRI_URGENT puts a message
+* at the head of its queue. Timeouts are in ticks of sysClkRateGet ().
+*
+* The robot code passes object pointers to tasks as uint32_t, so the host build needs -fpermissive, and operator new
+* hands out memory below 4 GB for those pointers to survive the cast. Memory from operator new is never given back,
+* which is fine for short host runs.
+*/
+
+#if defined ( __linux__ )
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <math.h>
+
+typedef int STATUS;
+typedef int BOOL;
+typedef int8_t INT8;
+typedef int16_t INT16;
+typedef int32_t INT32;
+typedef uint8_t UINT8;
+typedef uint16_t UINT16;
+typedef uint32_t UINT32;
+
+typedef int ( * FUNCPTR ) ( ... );
+
+#ifndef OK
+	#define OK 0
+#endif
+
+#ifndef ERROR
+	#define ERROR ( - 1 )
+#endif
+
+#define WAIT_FOREVER ( - 1 )
+#define NO_WAIT 0
+
+#define SEM_Q_FIFO 0x00
+#define SEM_Q_PRIORITY 0x01
+#define SEM_DELETE_SAFE 0x04
+#define SEM_INVERSION_SAFE 0x08
+
+typedef enum
+{
+
+	SEM_EMPTY = 0,
+	SEM_FULL = 1
+
+} SEM_B_STATE;
+
+#define MSG_Q_FIFO 0x00
+#define MSG_Q_PRIORITY 0x01
+
+#define MSG_PRI_NORMAL 0
+#define MSG_PRI_URGENT 1
+
+typedef struct HostSemaphore * SEM_ID;
+typedef struct HostMessageQueue * MSG_Q_ID;
+
+SEM_ID semMCreate ( int Options );
+SEM_ID semBCreate ( int Options, SEM_B_STATE InitialState );
+STATUS semTake ( SEM_ID Semaphore, int Timeout );
+STATUS semGive ( SEM_ID Semaphore );
+STATUS semDelete ( SEM_ID Semaphore );
+
+MSG_Q_ID msgQCreate ( int MaxMessages, int MaxMessageLength, int Options );
+STATUS msgQSend ( MSG_Q_ID Queue, char * Buffer, UINT32 Length, int Timeout, int Priority );
+int msgQReceive ( MSG_Q_ID Queue, char * Buffer, UINT32 MaxLength, int Timeout );
+int msgQNumMsgs ( MSG_Q_ID Queue );
+STATUS msgQDelete ( MSG_Q_ID Queue );
+
+int sysClkRateGet ();
+
+void Wait ( double Seconds );
+
+class Timer
+{
+public:
+
+	static double GetPPCTimestamp ();
+	static double GetFPGATimestamp ();
+
+};
+
+class Task
+{
+public:
+
+	static const INT32 kDefaultPriority = 101;
+
+	Task ( const char * Name, FUNCPTR Function, INT32 Priority = kDefaultPriority, UINT32 StackSize = 20000 );
+	virtual ~Task ();
+
+	bool Start ( UINT32 Arg0 = 0, UINT32 Arg1 = 0, UINT32 Arg2 = 0, UINT32 Arg3 = 0, UINT32 Arg4 = 0, UINT32 Arg5 = 0, UINT32 Arg6 = 0, UINT32 Arg7 = 0, UINT32 Arg8 = 0, UINT32 Arg9 = 0 );
+	bool Stop ();
+
+	bool Verify ();
+	const char * GetName ();
+
+	// Host only: the trampoline a new thread starts in.
+	static void * Run ( void * This );
+
+private:
+
+	char Name [ 64 ];
+	FUNCPTR Function;
+
+	UINT32 Args [ 10 ];
+
+	void * Thread;
+	bool Running;
+
+};
+
+/*
+* Serial port on a host device, normally the simulator's pseudo-terminal. Set the device with SetHostDevice () before
+* the code under test opens the port. Reads block until the count is met or the timeout passes, like VISA reads.
+*/
+class SerialPort
+{
+public:
+
+	typedef enum
+	{
+
+		kParity_None = 0,
+		kParity_Odd = 1,
+		kParity_Even = 2,
+		kParity_Mark = 3,
+		kParity_Space = 4
+
+	} Parity;
+
+	typedef enum
+	{
+
+		kStopBits_One = 10,
+		kStopBits_OnePointFive = 15,
+		kStopBits_Two = 20
+
+	} StopBits;
+
+	typedef enum
+	{
+
+		kFlushOnAccess = 1,
+		kFlushWhenFull = 2
+
+	} WriteBufferMode;
+
+	SerialPort ( UINT32 BaudRate, UINT8 DataBits = 8, Parity ParityMode = kParity_None, StopBits Stop = kStopBits_One );
+	~SerialPort ();
+
+	void EnableTermination ( char Terminator = '\n' );
+	void DisableTermination ();
+
+	INT32 GetBytesReceived ();
+
+	UINT32 Read ( char * Buffer, INT32 Count );
+	UINT32 Write ( const char * Buffer, INT32 Count );
+
+	void SetTimeout ( float Timeout );
+	void SetReadBufferSize ( UINT32 Size );
+	void SetWriteBufferSize ( UINT32 Size );
+	void SetWriteBufferMode ( WriteBufferMode Mode );
+
+	void Flush ();
+	void Reset ();
+
+	// Host only.
+	static void SetHostDevice ( const char * Path );
+
+private:
+
+	int Descriptor;
+	double Timeout;
+
+};
+
+class SensorBase
+{
+public:
+
+	static UINT32 GetDefaultAnalogModule ();
+
+};
+
+/*
+* Analog input reading a host-programmed level plus Gaussian noise. The averaging engine is modeled as 2^bits
+* samples averaged together, which divides the noise by 2^(bits/2).
+*/
+class AnalogChannel
+{
+public:
+
+	AnalogChannel ( UINT8 ModuleNumber, UINT32 Channel );
+	explicit AnalogChannel ( UINT32 Channel );
+	virtual ~AnalogChannel ();
+
+	float GetVoltage ();
+	float GetAverageVoltage ();
+
+	void SetAverageBits ( UINT32 Bits );
+	UINT32 GetAverageBits ();
+
+	// Host only: what a channel reads from now on. Noise is the standard deviation of a single sample, in volts.
+	static void SetHostInput ( UINT8 ModuleNumber, UINT32 Channel, double Voltage, double Noise );
+
+private:
+
+	double Sample ( double Noise );
+
+	UINT32 Slot;
+	UINT32 AverageBits;
+
+	uint64_t RandomState;
+
+};
+
+/*
+* Gyro on an analog channel, reading a host-set angle. Reset () makes the current angle zero.
+*/
+class Gyro
+{
+public:
+
+	Gyro ( UINT8 ModuleNumber, UINT32 Channel );
+	explicit Gyro ( UINT32 Channel );
+	virtual ~Gyro ();
+
+	virtual float GetAngle ();
+	virtual void Reset ();
+
+	// Host only: the angle a gyro has turned through from now on, in degrees clockwise.
+	static void SetHostAngle ( UINT8 ModuleNumber, UINT32 Channel, double Angle );
+
+private:
+
+	UINT32 Slot;
+	double Offset;
+
+};
+
+class SpeedController
+{
+public:
+
+	virtual ~SpeedController () {};
+
+	virtual void Set ( float Speed, UINT8 SyncGroup = 0 ) = 0;
+	virtual float Get () = 0;
+	virtual void Disable () = 0;
+
+};
+
+class ErrorBase
+{
+public:
+
+	virtual ~ErrorBase () {};
+
+};
+
+// WPILib records the error on the object. The host just prints it.
+#define wpi_setWPIErrorWithContext( Error, Context ) fprintf ( stderr, "%s: %s\n", #Error, Context )
+
+/*
+* Jaguar that remembers the last value it was set to, so host drivers can see what the code under test sent, and reads
+* back a position host drivers set. Configuration calls are accepted and only the control mode is kept.
+*/
+class CANJaguar : public SpeedController, public ErrorBase
+{
+public:
+
+	typedef enum
+	{
+
+		kPercentVbus,
+		kCurrent,
+		kSpeed,
+		kPosition,
+		kVoltage
+
+	} ControlMode;
+
+	typedef enum
+	{
+
+		kPosRef_QuadEncoder = 0,
+		kPosRef_Potentiometer = 1,
+		kPosRef_None = 0xFF
+
+	} PositionReference;
+
+	typedef enum
+	{
+
+		kSpeedRef_Encoder = 0,
+		kSpeedRef_InvEncoder = 2,
+		kSpeedRef_QuadEncoder = 3,
+		kSpeedRef_None = 0xFF
+
+	} SpeedReference;
+
+	typedef enum
+	{
+
+		kNeutralMode_Jumper = 0,
+		kNeutralMode_Brake = 1,
+		kNeutralMode_Coast = 2
+
+	} NeutralMode;
+
+	typedef enum
+	{
+
+		kLimitMode_SwitchInputsOnly = 0,
+		kLimitMode_SoftPositionLimits = 1
+
+	} LimitMode;
+
+	explicit CANJaguar ( UINT8 DeviceNumber, ControlMode Mode = kPercentVbus );
+	virtual ~CANJaguar ();
+
+	virtual void Set ( float Value, UINT8 SyncGroup = 0 );
+	virtual float Get ();
+	virtual void Disable ();
+
+	void EnableControl ( double EncoderInitialPosition = 0.0 );
+	void DisableControl ();
+
+	void ChangeControlMode ( ControlMode Mode );
+	ControlMode GetControlMode ();
+
+	void SetPID ( double P, double I, double D );
+	void SetPositionReference ( PositionReference Reference );
+	void SetSpeedReference ( SpeedReference Reference );
+	void ConfigEncoderCodesPerRev ( UINT16 Codes );
+	void ConfigPotentiometerTurns ( UINT16 Turns );
+	void ConfigNeutralMode ( NeutralMode Mode );
+	void ConfigMaxOutputVoltage ( double Voltage );
+	void SetSafetyEnabled ( bool Enabled );
+
+	double GetPosition ();
+	float GetBusVoltage ();
+	float GetOutputVoltage ();
+	float GetOutputCurrent ();
+
+	static void UpdateSyncGroup ( UINT8 SyncGroup );
+
+	// Host only: the last value sent to a device, when it was sent, and how many times it has been set.
+	static bool GetHostOutput ( UINT8 DeviceNumber, float * Value, double * Time, UINT32 * Count );
+
+	// Host only: what GetPosition reads on a device from now on, and how many times it has been read.
+	static void SetHostPosition ( UINT8 DeviceNumber, double Position );
+	static UINT32 GetHostPositionReads ( UINT8 DeviceNumber );
+
+private:
+
+	UINT8 DeviceNumber;
+	bool Enabled;
+
+	ControlMode Mode;
+
+};
+
+// Host only: number of operator new calls so far, for checking that a path doesn't allocate.
+uint32_t HostAllocationCount ();
+
+#endif
+
+#endif
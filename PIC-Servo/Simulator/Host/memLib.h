@@ -0,0 +1,11 @@
+#ifndef SHS_2605_HOST_MEMLIB_H
+#define SHS_2605_HOST_MEMLIB_H
+
+/*
+* Host stand-in for VxWorks memLib.h. glibc declares memalign () in malloc.h.
+*/
+
+#include <stdlib.h>
+#include <malloc.h>
+
+#endif
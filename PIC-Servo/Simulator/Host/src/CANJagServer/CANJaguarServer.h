@@ -0,0 +1,7 @@
+#ifndef SHS_2605_HOST_FORWARD_CANJAGSERVER_CANJAGUARSERVER_H
+#define SHS_2605_HOST_FORWARD_CANJAGSERVER_CANJAGUARSERVER_H
+
+// The robot build includes "src/CANJagServer/CANJaguarServer.h" from the project root. Host builds find it through here.
+#include "../../../../../CANJagServer/CANJaguarServer.h"
+
+#endif
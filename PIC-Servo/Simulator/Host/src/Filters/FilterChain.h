@@ -0,0 +1,7 @@
+#ifndef SHS_2605_HOST_FORWARD_FILTERS_FILTERCHAIN_H
+#define SHS_2605_HOST_FORWARD_FILTERS_FILTERCHAIN_H
+
+// The robot build includes "src/Filters/FilterChain.h" from the project root. Host builds find it through here.
+#include "../../../../../Filters/FilterChain.h"
+
+#endif
@@ -0,0 +1,7 @@
+#ifndef SHS_2605_HOST_FORWARD_MATH_SHSMATH_H
+#define SHS_2605_HOST_FORWARD_MATH_SHSMATH_H
+
+// The robot build includes "src/Math/SHSMath.h" from the project root. Host builds find it through here.
+#include "../../../../../Math/SHSMath.h"
+
+#endif
@@ -0,0 +1,7 @@
+#ifndef SHS_2605_HOST_FORWARD_UTIL_JAGUARUTILS_H
+#define SHS_2605_HOST_FORWARD_UTIL_JAGUARUTILS_H
+
+// The robot build includes "src/Util/JaguarUtils.h" from the project root. Host builds find it through here.
+#include "../../../../../Util/JaguarUtils.h"
+
+#endif
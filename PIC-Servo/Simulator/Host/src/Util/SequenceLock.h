@@ -0,0 +1,7 @@
+#ifndef SHS_2605_HOST_FORWARD_UTIL_SEQUENCELOCK_H
+#define SHS_2605_HOST_FORWARD_UTIL_SEQUENCELOCK_H
+
+// The robot build includes "src/Util/SequenceLock.h" from the project root. Host builds find it through here.
+#include "../../../../../Util/SequenceLock.h"
+
+#endif
@@ -0,0 +1,7 @@
+#ifndef SHS_2605_HOST_FORWARD_UTIL_VECTOR_H
+#define SHS_2605_HOST_FORWARD_UTIL_VECTOR_H
+
+// The robot build includes "src/Util/Vector.h" from the project root. Host builds find it through here.
+#include "../../../../../Util/Vector.h"
+
+#endif
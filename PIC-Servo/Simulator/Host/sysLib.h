@@ -0,0 +1,10 @@
+#ifndef SHS_2605_HOST_SYSLIB_H
+#define SHS_2605_HOST_SYSLIB_H
+
+/*
+* Host stand-in for VxWorks sysLib.h. sysClkRateGet () is declared with the rest of the host WPILib.
+*/
+
+#include "WPILib.h"
+
+#endif
@@ -0,0 +1,637 @@
+/*
+* Host benchmark: MecanumDrive's multiply-add wheel kinematics against the atan2, sin and cos version they replaced.
+*
+* Random commands go through the drive's public interface, with random scales, sine inversion and motor inversion, and
+* the speeds it sets are compared with the trig version's. Where no wheel saturates they must match. Where one does,
+* the drive must scale all four down together, and the direction each version actually drives in is compared with the
+* one commanded, the trig version's wheels being clipped to full scale as the speed controllers would. Then both
+* kernels are timed on their own.
+*
+* Field orientation and heading hold are checked against a FusedHeading with no sources, whose heading and turn rate
+* the bench sets, and FusedHeading's own blending against a host gyro and a running MecanumOdometry.
+*
+* MecanumDrive.cpp is compiled into this file, so the timed kernels inline as they do in PushTransform.
+*
+* Build and run from the repository root:
+*
+*   g++ -std=gnu++98 -fpermissive -O2 -pthread -I PIC-Servo/Simulator/Host PIC-Servo/Simulator/MecanumDriveBench.cpp
+*       PIC-Servo/Simulator/Host/HostWPILib.cpp SubSystems/FusedHeading.cpp SubSystems/MecanumOdometry.cpp
+*       CANJagServer/CANJaguarServer.cpp CANJagServer/AsynchCANJaguar.cpp Util/JaguarUtils.cpp -o MecanumDriveBench
+*   ./MecanumDriveBench [ commands ]
+*/
+
+#if defined ( __linux__ )
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "WPILib.h"
+
+#include "../../SubSystems/MecanumDrive.cpp"
+
+#include "../../CANJagServer/CANJaguarServer.h"
+#include "../../CANJagServer/AsynchCANJaguar.h"
+
+#define MECANUMDRIVEBENCH_TOLERANCE 1e-5
+#define MECANUMDRIVEBENCH_TABLE 4096
+#define MECANUMDRIVEBENCH_DEGREES 57.2957795131
+#define MECANUMDRIVEBENCH_RADIANS 0.01745329252
+
+#define MECANUMDRIVEBENCH_GYRO_CHANNEL 1
+
+static uint32_t RandomState = 0x2605;
+
+static double Random ( double Low, double High )
+{
+
+	RandomState ^= RandomState << 13;
+	RandomState ^= RandomState >> 17;
+	RandomState ^= RandomState << 5;
+
+	return Low + ( High - Low ) * ( RandomState / 4294967296.0 );
+
+};
+
+// Speed controller that keeps what it was last set to.
+class HostMotor : public SpeedController
+{
+public:
+
+	HostMotor () { Value = 0; };
+
+	void Set ( float Speed, UINT8 SyncGroup = 0 ) { Value = Speed; };
+	float Get () { return Value; };
+	void Disable () { Value = 0; };
+
+	float Value;
+
+};
+
+class MecanumDriveBench
+{
+public:
+
+	static bool Check ( uint32_t Commands );
+	static bool FieldOriented ();
+	static bool HeadingHold ();
+	static bool Fusion ();
+	static void Time ();
+
+private:
+
+	static bool Expect ( const char * Name, bool Condition );
+	static void SetHeading ( FusedHeading * Source, double Heading, double Rate );
+	static void Push ( MecanumDrive * Drive, FusedHeading * Source, double Heading, double Rate, double X, double Y, double R );
+	static bool SameWheels ( const HostMotor * A, const HostMotor * B );
+	static bool Bracket ( double Value, double Low, double High );
+
+	static void TrigWheels ( double TX, double TY, double TR, double Scale, bool SineInverted, const bool * Inverted, double * Wheels );
+	static double DirectionError ( const double * Commanded, const double * Wheels, const bool * Inverted, double Scale );
+
+};
+
+// The wheel outputs as PushTransform worked them out before, in FL, FR, RL, RR order.
+void MecanumDriveBench :: TrigWheels ( double TX, double TY, double TR, double Scale, bool SineInverted, const bool * Inverted, double * Wheels )
+{
+
+	double ForceMagnitude = sqrt ( TX * TX + TY * TY );
+	double ForceAngle = atan2 ( TX, TY ) + PI_Div_4;
+
+	double SinCalc = sin ( ForceAngle ) * ForceMagnitude;
+	double CosCalc = cos ( ForceAngle ) * ForceMagnitude;
+
+	Wheels [ 0 ] = ( ( SineInverted ? CosCalc : SinCalc ) + TR ) * ( Inverted [ 0 ] ? - Scale : Scale );
+	Wheels [ 1 ] = ( ( SineInverted ? SinCalc : CosCalc ) - TR ) * ( Inverted [ 1 ] ? - Scale : Scale );
+	Wheels [ 2 ] = ( ( SineInverted ? SinCalc : CosCalc ) + TR ) * ( Inverted [ 2 ] ? - Scale : Scale );
+	Wheels [ 3 ] = ( ( SineInverted ? CosCalc : SinCalc ) - TR ) * ( Inverted [ 3 ] ? - Scale : Scale );
+
+};
+
+// Angle in degrees between the commanded diagonal, anti-diagonal and rotation components and those the wheels produce.
+double MecanumDriveBench :: DirectionError ( const double * Commanded, const double * Wheels, const bool * Inverted, double Scale )
+{
+
+	double W [ 4 ];
+
+	for ( uint32_t i = 0; i < 4; i ++ )
+		W [ i ] = Wheels [ i ] * ( Inverted [ i ] ? - 1 : 1 ) / Scale;
+
+	double Driven [ 3 ] = { ( W [ 0 ] + W [ 3 ] ) / 2, ( W [ 1 ] + W [ 2 ] ) / 2, ( W [ 0 ] - W [ 1 ] + W [ 2 ] - W [ 3 ] ) / 4 };
+
+	double Dot = 0;
+	double CommandedLength = 0;
+	double DrivenLength = 0;
+
+	for ( uint32_t i = 0; i < 3; i ++ )
+	{
+
+		Dot += Commanded [ i ] * Driven [ i ];
+		CommandedLength += Commanded [ i ] * Commanded [ i ];
+		DrivenLength += Driven [ i ] * Driven [ i ];
+
+	}
+
+	double Cosine = Dot / sqrt ( CommandedLength * DrivenLength );
+
+	return MECANUMDRIVEBENCH_DEGREES * acos ( ( Cosine > 1 ) ? 1 : Cosine );
+
+};
+
+bool MecanumDriveBench :: Check ( uint32_t Commands )
+{
+
+	HostMotor Motors [ 4 ];
+
+	MecanumDrive Drive ( & Motors [ 0 ], & Motors [ 1 ], & Motors [ 2 ], & Motors [ 3 ] );
+
+	uint32_t Saturated = 0;
+	uint32_t Mismatches = 0;
+
+	double TrigWorst = 0;
+	double TrigTotal = 0;
+	double DriveWorst = 0;
+
+	for ( uint32_t i = 0; i < Commands; i ++ )
+	{
+
+		bool Inverted [ 4 ] = { Random ( 0, 1 ) < 0.5, Random ( 0, 1 ) < 0.5, Random ( 0, 1 ) < 0.5, Random ( 0, 1 ) < 0.5 };
+		bool SineInverted = ( i & 1 ) != 0;
+
+		double Scale = Random ( 0.5, 1 );
+		double PrescaleT = Random ( 0.5, 1 );
+		double PrescaleR = Random ( 0.5, 1 );
+
+		double X = Random ( - 1, 1 );
+		double Y = Random ( - 1, 1 );
+		double R = Random ( - 1, 1 ) * ( ( i & 2 ) ? 1 : 0.1 );
+
+		// Settings only take while the drive is disabled.
+		Drive.Disable ();
+		Drive.SetInverted ( Inverted [ 0 ], Inverted [ 1 ], Inverted [ 2 ], Inverted [ 3 ] );
+		Drive.SetSineInversion ( SineInverted );
+		Drive.SetMotorScale ( Scale );
+		Drive.SetPreScale ( PrescaleT, PrescaleR );
+		Drive.Enable ();
+
+		Drive.SetTranslation ( X, Y );
+		Drive.SetRotation ( R );
+		Drive.PushTransform ();
+
+		double Trig [ 4 ];
+
+		TrigWheels ( X * SQRT_2 * PrescaleT, Y * PrescaleT, R * PrescaleR, Scale, SineInverted, Inverted, Trig );
+
+		double Peak = 0;
+
+		for ( uint32_t j = 0; j < 4; j ++ )
+			Peak = ( fabs ( Trig [ j ] ) > Peak ) ? fabs ( Trig [ j ] ) : Peak;
+
+		// Where nothing saturates the drive must match, and otherwise it must be the same wheels scaled to full scale.
+		double Expected = ( Peak > Scale ) ? Scale / Peak : 1;
+
+		double Wheels [ 4 ];
+		double Clipped [ 4 ];
+
+		for ( uint32_t j = 0; j < 4; j ++ )
+		{
+
+			Wheels [ j ] = Motors [ j ].Value;
+			Clipped [ j ] = ( Trig [ j ] > Scale ) ? Scale : ( ( Trig [ j ] < - Scale ) ? - Scale : Trig [ j ] );
+
+			if ( fabs ( Wheels [ j ] - Trig [ j ] * Expected ) > MECANUMDRIVEBENCH_TOLERANCE )
+				Mismatches ++;
+
+		}
+
+		if ( Peak <= Scale )
+			continue;
+
+		Saturated ++;
+
+		double Commanded [ 4 ];
+
+		TrigWheels ( X * SQRT_2 * PrescaleT, Y * PrescaleT, R * PrescaleR, 1, SineInverted, Inverted, Commanded );
+
+		double Unscaled [ 4 ];
+
+		for ( uint32_t j = 0; j < 4; j ++ )
+			Unscaled [ j ] = Commanded [ j ] * ( Inverted [ j ] ? - 1 : 1 );
+
+		double Components [ 3 ] = { ( Unscaled [ 0 ] + Unscaled [ 3 ] ) / 2, ( Unscaled [ 1 ] + Unscaled [ 2 ] ) / 2, ( Unscaled [ 0 ] - Unscaled [ 1 ] + Unscaled [ 2 ] - Unscaled [ 3 ] ) / 4 };
+
+		double TrigError = DirectionError ( Components, Clipped, Inverted, Scale );
+		double DriveError = DirectionError ( Components, Wheels, Inverted, Scale );
+
+		TrigTotal += TrigError;
+		TrigWorst = ( TrigError > TrigWorst ) ? TrigError : TrigWorst;
+		DriveWorst = ( DriveError > DriveWorst ) ? DriveError : DriveWorst;
+
+	}
+
+	printf ( "%u commands, %u saturating: %u wheel mismatches\n", Commands, Saturated, Mismatches );
+	printf ( "direction error when saturated, trig clipped:  %6.2f degrees mean, %6.2f worst\n", ( Saturated != 0 ) ? TrigTotal / Saturated : 0.0, TrigWorst );
+	printf ( "direction error when saturated, desaturated:   %6.2f degrees worst\n", DriveWorst );
+
+	return Mismatches == 0 && DriveWorst < 0.01;
+
+};
+
+bool MecanumDriveBench :: Expect ( const char * Name, bool Condition )
+{
+
+	printf ( "  %-64s %s\n", Name, Condition ? "ok" : "FAILED" );
+
+	return Condition;
+
+};
+
+// Make the next Update () return Heading and leave the turn rate at Rate. With no sources, a FusedHeading that hasn't
+// been primed since its reset just returns the reset heading.
+void MecanumDriveBench :: SetHeading ( FusedHeading * Source, double Heading, double Rate )
+{
+
+	Source -> Reset ( Heading );
+	Source -> Rate = Rate;
+
+};
+
+void MecanumDriveBench :: Push ( MecanumDrive * Drive, FusedHeading * Source, double Heading, double Rate, double X, double Y, double R )
+{
+
+	if ( Source != NULL )
+		SetHeading ( Source, Heading, Rate );
+
+	Drive -> SetTranslation ( X, Y );
+	Drive -> SetRotation ( R );
+	Drive -> PushTransform ();
+
+};
+
+bool MecanumDriveBench :: SameWheels ( const HostMotor * A, const HostMotor * B )
+{
+
+	for ( uint32_t i = 0; i < 4; i ++ )
+	{
+
+		if ( fabs ( A [ i ].Value - B [ i ].Value ) > MECANUMDRIVEBENCH_TOLERANCE )
+			return false;
+
+	}
+
+	return true;
+
+};
+
+bool MecanumDriveBench :: Bracket ( double Value, double Low, double High )
+{
+
+	if ( Value >= Low && Value <= High )
+		return true;
+
+	printf ( "    %.6f, expected %.6f to %.6f\n", Value, Low, High );
+
+	return false;
+
+};
+
+// Field-relative translations against the robot-relative ones they should turn into.
+bool MecanumDriveBench :: FieldOriented ()
+{
+
+	bool Passed = true;
+
+	printf ( "field orientation:\n" );
+
+	HostMotor FieldMotors [ 4 ];
+	HostMotor RobotMotors [ 4 ];
+
+	MecanumDrive FieldDrive ( & FieldMotors [ 0 ], & FieldMotors [ 1 ], & FieldMotors [ 2 ], & FieldMotors [ 3 ] );
+	MecanumDrive RobotDrive ( & RobotMotors [ 0 ], & RobotMotors [ 1 ], & RobotMotors [ 2 ], & RobotMotors [ 3 ] );
+
+	FusedHeading Source ( NULL, NULL );
+
+	FieldDrive.SetHeadingSource ( & Source );
+	FieldDrive.SetFieldOriented ( true );
+
+	FieldDrive.Enable ();
+	RobotDrive.Enable ();
+
+	// Heading, field X and Y, and the robot X and Y they should become. Headings are clockwise.
+	const double Cases [][ 5 ] =
+	{
+
+		{ 0, 0, 0.5, 0, 0.5 },
+		{ M_PI / 2, 0, 0.5, - 0.5, 0 },
+		{ - M_PI / 2, 0, 0.5, 0.5, 0 },
+		{ M_PI / 2, 0.5, 0, 0, 0.5 },
+		{ M_PI, 0, 0.5, 0, - 0.5 }
+
+	};
+
+	const char * Names [] =
+	{
+
+		"field forward at 0 degrees drives forward",
+		"field forward at +90 degrees strafes left",
+		"field forward at -90 degrees strafes right",
+		"field right at +90 degrees drives forward",
+		"field forward at 180 degrees drives backward"
+
+	};
+
+	for ( uint32_t i = 0; i < sizeof ( Cases ) / sizeof ( Cases [ 0 ] ); i ++ )
+	{
+
+		Push ( & FieldDrive, & Source, Cases [ i ][ 0 ], 0, Cases [ i ][ 1 ], Cases [ i ][ 2 ], 0 );
+		Push ( & RobotDrive, NULL, 0, 0, Cases [ i ][ 3 ], Cases [ i ][ 4 ], 0 );
+
+		Passed &= Expect ( Names [ i ], SameWheels ( FieldMotors, RobotMotors ) );
+
+	}
+
+	// Rotation is the same in either frame.
+	Push ( & FieldDrive, & Source, M_PI / 2, 0, 0, 0.5, 0.25 );
+	Push ( & RobotDrive, NULL, 0, 0, - 0.5, 0, 0.25 );
+
+	Passed &= Expect ( "and turning while doing it turns the same", SameWheels ( FieldMotors, RobotMotors ) );
+
+	return Passed;
+
+};
+
+bool MecanumDriveBench :: HeadingHold ()
+{
+
+	bool Passed = true;
+
+	printf ( "heading hold:\n" );
+
+	HostMotor Motors [ 4 ];
+
+	MecanumDrive Drive ( & Motors [ 0 ], & Motors [ 1 ], & Motors [ 2 ], & Motors [ 3 ] );
+
+	FusedHeading Source ( NULL, NULL );
+
+	Drive.SetHeadingSource ( & Source );
+	Drive.SetHeadingHold ( true, 1.0, 0.1 );
+	Drive.Enable ();
+
+	Push ( & Drive, & Source, 1.0, 0, 0, 0, 0.5 );
+
+	Passed &= Expect ( "turning passes the rotation through", Drive.CommandR == 0.5 );
+
+	Push ( & Drive, & Source, 1.0, 0, 0, 0, 0 );
+	Push ( & Drive, & Source, 1.2, 0, 0, 0, 0 );
+
+	Passed &= Expect ( "letting go holds the heading it had", Drive.HoldTarget == 1.0 );
+	Passed &= Expect ( "clockwise of the target turns back counterclockwise", fabs ( Drive.CommandR + 0.2 ) < MECANUMDRIVEBENCH_TOLERANCE );
+
+	Push ( & Drive, & Source, 0.7, 0, 0, 0, 0 );
+
+	Passed &= Expect ( "counterclockwise of it turns back clockwise", fabs ( Drive.CommandR - 0.3 ) < MECANUMDRIVEBENCH_TOLERANCE );
+
+	Push ( & Drive, & Source, 1.2, 0.5, 0, 0, 0 );
+
+	Passed &= Expect ( "turning away adds damping", fabs ( Drive.CommandR + 0.25 ) < MECANUMDRIVEBENCH_TOLERANCE );
+
+	Push ( & Drive, & Source, 1.2, 0, 0, 0, 0.03 );
+
+	Passed &= Expect ( "a rotation inside the deadband still holds", fabs ( Drive.CommandR + 0.2 ) < MECANUMDRIVEBENCH_TOLERANCE );
+
+	Push ( & Drive, & Source, 5.0, 0, 0, 0, 0 );
+
+	Passed &= Expect ( "far clockwise saturates at -1", Drive.CommandR == - 1.0 );
+
+	Push ( & Drive, & Source, - 3.0, - 2.0, 0, 0, 0 );
+
+	Passed &= Expect ( "far counterclockwise saturates at +1", Drive.CommandR == 1.0 );
+
+	Push ( & Drive, & Source, 2.0, 0, 0, 0, - 0.5 );
+	Push ( & Drive, & Source, 2.0, 0, 0, 0, 0 );
+
+	Passed &= Expect ( "turning again moves the target", Drive.HoldTarget == 2.0 && Drive.CommandR == 0 );
+
+	return Passed;
+
+};
+
+/*
+* FusedHeading's blending. The blend depends on the time between updates, which the bench can only bracket, so the
+* expected heading is checked against the shortest and longest that time could have been.
+*/
+bool MecanumDriveBench :: Fusion ()
+{
+
+	bool Passed = true;
+
+	printf ( "fused heading:\n" );
+
+	Gyro :: SetHostAngle ( 1, MECANUMDRIVEBENCH_GYRO_CHANNEL, 0 );
+
+	Gyro HeadingGyro ( MECANUMDRIVEBENCH_GYRO_CHANNEL );
+
+	// Gyro only: follows the gyro's changes from the reset heading.
+	FusedHeading GyroOnly ( & HeadingGyro, NULL );
+
+	Gyro :: SetHostAngle ( 1, MECANUMDRIVEBENCH_GYRO_CHANNEL, 30 );
+
+	GyroOnly.Reset ( 1.0 );
+
+	double Before = Timer :: GetPPCTimestamp ();
+	double Primed = GyroOnly.Update ();
+	double After = Timer :: GetPPCTimestamp ();
+
+	Passed &= Expect ( "gyro only: starts at the reset heading", Primed == 1.0 );
+
+	Gyro :: SetHostAngle ( 1, MECANUMDRIVEBENCH_GYRO_CHANNEL, 120 );
+
+	Wait ( 0.05 );
+
+	double Start = Timer :: GetPPCTimestamp ();
+	double Turned = GyroOnly.Update ();
+	double End = Timer :: GetPPCTimestamp ();
+
+	double Quarter = 90 * MECANUMDRIVEBENCH_RADIANS;
+
+	Passed &= Expect ( "gyro only: follows the gyro's turn", fabs ( Turned - 1.0 - Quarter ) < MECANUMDRIVEBENCH_TOLERANCE );
+	Passed &= Expect ( "gyro only: turn rate over the time between updates", Bracket ( GyroOnly.GetRate (), Quarter / ( End - Before ), Quarter / ( Start - After ) ) );
+
+	// Odometry only: the odometry heading, offset to line up with the reset. Its wheels never move here.
+	CANJaguarServer * Server = new CANJaguarServer ();
+	CANJagConfigInfo Config;
+
+	Server -> Start ();
+
+	AsynchCANJaguar * Wheels [ 4 ];
+
+	for ( uint32_t i = 0; i < 4; i ++ )
+		Wheels [ i ] = new AsynchCANJaguar ( Server, i + 1, Config );
+
+	MecanumOdometry * Odometry = new MecanumOdometry ( Wheels [ 0 ], Wheels [ 1 ], Wheels [ 2 ], Wheels [ 3 ], 1, 0.6, 0.4 );
+
+	FusedHeading OdometryOnly ( NULL, Odometry );
+
+	OdometryOnly.Reset ( 1.0 );
+	OdometryOnly.Update ();
+
+	Passed &= Expect ( "odometry only: waits for the odometry to line up", ! OdometryOnly.Primed && OdometryOnly.Get () == 1.0 );
+
+	Server -> SetTelemetryInterval ( 0.01 );
+	Odometry -> Start ();
+
+	Wait ( 0.1 );
+
+	Odometry -> Reset ( 0, 0, 0.3 );
+
+	Passed &= Expect ( "odometry only: then starts at the reset heading", OdometryOnly.Update () == 1.0 && OdometryOnly.Primed );
+
+	Odometry -> Reset ( 0, 0, 0.8 );
+
+	Passed &= Expect ( "odometry only: follows the odometry's turn", fabs ( OdometryOnly.Update () - 1.5 ) < MECANUMDRIVEBENCH_TOLERANCE );
+
+	// Both: the gyro turns a quarter turn the odometry doesn't see, and is pulled back by Elapsed / ( 1 + Elapsed ).
+	FusedHeading Blended ( & HeadingGyro, Odometry, 1.0 );
+
+	Odometry -> Reset ( 0, 0, 0 );
+	HeadingGyro.Reset ();
+	Blended.Reset ( 0 );
+
+	Before = Timer :: GetPPCTimestamp ();
+	Blended.Update ();
+	After = Timer :: GetPPCTimestamp ();
+
+	Gyro :: SetHostAngle ( 1, MECANUMDRIVEBENCH_GYRO_CHANNEL, 210 );
+
+	Wait ( 0.1 );
+
+	Start = Timer :: GetPPCTimestamp ();
+	double Heading = Blended.Update ();
+	End = Timer :: GetPPCTimestamp ();
+
+	printf ( "    gyro turned %.4f rad, odometry 0: blended to %.4f\n", Quarter, Heading );
+
+	Passed &= Expect ( "both: the gyro's turn, pulled toward the odometry", Bracket ( Heading, Quarter / ( 1 + End - Before ), Quarter / ( 1 + Start - After ) ) );
+
+	Blended.SetTimeConstant ( 0 );
+
+	Passed &= Expect ( "both, no time constant: the odometry heading outright", fabs ( Blended.Update () ) < MECANUMDRIVEBENCH_TOLERANCE );
+
+	Odometry -> Stop ();
+
+	return Passed;
+
+};
+
+void MecanumDriveBench :: Time ()
+{
+
+	HostMotor Motors [ 4 ];
+
+	MecanumDrive Drive ( & Motors [ 0 ], & Motors [ 1 ], & Motors [ 2 ], & Motors [ 3 ] );
+
+	static double Table [ MECANUMDRIVEBENCH_TABLE ][ 3 ];
+
+	for ( uint32_t i = 0; i < MECANUMDRIVEBENCH_TABLE; i ++ )
+	{
+
+		Table [ i ][ 0 ] = Random ( - SQRT_2, SQRT_2 );
+		Table [ i ][ 1 ] = Random ( - 1, 1 );
+		Table [ i ][ 2 ] = Random ( - 1, 1 );
+
+	}
+
+	const bool Inverted [ 4 ] = { false, true, false, true };
+	const uint32_t Updates = 20000000;
+
+	double Sink = 0;
+	double Wheels [ 4 ];
+
+	double Start = Timer :: GetPPCTimestamp ();
+
+	for ( uint32_t i = 0; i < Updates; i ++ )
+	{
+
+		const double * Command = Table [ i & ( MECANUMDRIVEBENCH_TABLE - 1 ) ];
+
+		TrigWheels ( Command [ 0 ], Command [ 1 ], Command [ 2 ], 1, false, Inverted, Wheels );
+
+		Sink += Wheels [ 0 ] + Wheels [ 1 ] + Wheels [ 2 ] + Wheels [ 3 ];
+
+	}
+
+	double Trig = 1e9 * ( Timer :: GetPPCTimestamp () - Start ) / Updates;
+
+	Drive.SetInverted ( Inverted [ 0 ], Inverted [ 1 ], Inverted [ 2 ], Inverted [ 3 ] );
+
+	Start = Timer :: GetPPCTimestamp ();
+
+	for ( uint32_t i = 0; i < Updates; i ++ )
+	{
+
+		const double * Command = Table [ i & ( MECANUMDRIVEBENCH_TABLE - 1 ) ];
+
+		Drive.CommandX = Command [ 0 ];
+		Drive.CommandY = Command [ 1 ];
+		Drive.CommandR = Command [ 2 ];
+
+		Drive.ComputeWheels ( & Wheels [ 0 ], & Wheels [ 1 ], & Wheels [ 2 ], & Wheels [ 3 ] );
+
+		Sink += Wheels [ 0 ] + Wheels [ 1 ] + Wheels [ 2 ] + Wheels [ 3 ];
+
+	}
+
+	double MultiplyAdd = 1e9 * ( Timer :: GetPPCTimestamp () - Start ) / Updates;
+
+	// And the whole update, through the motors.
+	Drive.Enable ();
+
+	Start = Timer :: GetPPCTimestamp ();
+
+	for ( uint32_t i = 0; i < Updates; i ++ )
+	{
+
+		const double * Command = Table [ i & ( MECANUMDRIVEBENCH_TABLE - 1 ) ];
+
+		Drive.SetTranslation ( Command [ 0 ], Command [ 1 ] );
+		Drive.SetRotation ( Command [ 2 ] );
+		Drive.PushTransform ();
+
+		Sink += Motors [ 0 ].Value;
+
+	}
+
+	double Push = 1e9 * ( Timer :: GetPPCTimestamp () - Start ) / Updates;
+
+	printf ( "trig kernel:          %6.1f ns\n", Trig );
+	printf ( "multiply-add kernel:  %6.1f ns ( %.1fx ), desaturation included\n", MultiplyAdd, Trig / MultiplyAdd );
+	printf ( "PushTransform:        %6.1f ns, with the four Set calls\n", Push );
+
+	// Keeps the timed loops from being optimized out.
+	if ( Sink == 0.123 )
+		printf ( "\n" );
+
+};
+
+int main ( int argc, char ** argv )
+{
+
+	uint32_t Commands = ( argc > 1 ) ? atoi ( argv [ 1 ] ) : 1000000;
+
+	bool Passed = MecanumDriveBench :: Check ( Commands );
+
+	Passed &= MecanumDriveBench :: FieldOriented ();
+	Passed &= MecanumDriveBench :: HeadingHold ();
+	Passed &= MecanumDriveBench :: Fusion ();
+
+	MecanumDriveBench :: Time ();
+
+	printf ( "%s\n", Passed ? "PASSED" : "FAILED" );
+
+	// The CAN Jaguar server task is still running, so leave without tearing it down.
+	fflush ( stdout );
+	_exit ( Passed ? 0 : 1 );
+
+};
+
+#endif
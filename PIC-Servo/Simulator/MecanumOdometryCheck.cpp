@@ -0,0 +1,466 @@
+/*
+* Host check: CANJaguarServer's telemetry sweeps and MecanumOdometry's dead reckoning.
+*
+* A real server runs with host Jaguars whose positions the check sets. With the telemetry interval left at 0 the
+* server never reads telemetry itself, so the check drives the sweeps one read at a time and steps the estimator
+* after each. That shows a sweep is only published once every registered Jaguar has been read, that a Jaguar
+* registered twice stays registered until both users let go, and that known wheel motions give the right pose:
+* forward, strafe and spin, with and without wheel and sine inversion, clockwise heading, and midpoint integration.
+* Finally the server and estimator run on their own, and the server task is checked not to spin between reads when
+* they come faster than the clock ticks.
+*
+* Build and run from the repository root:
+*
+*   g++ -std=gnu++98 -fpermissive -O2 -pthread -I PIC-Servo/Simulator/Host PIC-Servo/Simulator/MecanumOdometryCheck.cpp
+*       PIC-Servo/Simulator/Host/HostWPILib.cpp CANJagServer/CANJaguarServer.cpp CANJagServer/AsynchCANJaguar.cpp
+*       Util/JaguarUtils.cpp SubSystems/MecanumOdometry.cpp -o MecanumOdometryCheck
+*   ./MecanumOdometryCheck
+*/
+
+#if defined ( __linux__ )
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "WPILib.h"
+
+#include "../../CANJagServer/CANJaguarServer.h"
+#include "../../CANJagServer/AsynchCANJaguar.h"
+#include "../../SubSystems/MecanumOdometry.h"
+
+#define MECANUMODOMETRYCHECK_SHARED_ID 5
+
+// Wheel circumference 1, so positions are distances, and a track and base that make the rotation radius 0.5.
+#define MECANUMODOMETRYCHECK_CIRCUMFERENCE 1.0
+#define MECANUMODOMETRYCHECK_TRACK 0.6
+#define MECANUMODOMETRYCHECK_BASE 0.4
+#define MECANUMODOMETRYCHECK_RADIUS 0.5
+
+#define MECANUMODOMETRYCHECK_TOLERANCE 1e-5
+
+// Steps 0.01 long, each off by at most about 5e-5 when a sweep splits it.
+#define MECANUMODOMETRYCHECK_RAMP_STEPS 100
+#define MECANUMODOMETRYCHECK_RAMP_TOLERANCE 0.01
+
+#define MECANUMODOMETRYCHECK_PI 3.14159265358979
+
+class MecanumOdometryCheck
+{
+public:
+
+	MecanumOdometryCheck ();
+
+	bool Sweeps ();
+	bool SharedUsers ();
+	bool Kinematics ();
+	bool Running ();
+
+private:
+
+	typedef struct Motion_t
+	{
+
+		double Forward;
+		double Strafe;
+		double Turn;
+
+	} Motion_t;
+
+	bool Expect ( const char * Name, bool Condition );
+	bool ExpectPose ( const char * Name, MecanumOdometry * Odometry, double X, double Y, double Heading, double Tolerance = MECANUMODOMETRYCHECK_TOLERANCE );
+
+	void Sweep ();
+	void Move ( MecanumOdometry * Odometry, Motion_t Motion, const bool * Inverted, bool SineInverted );
+
+	MecanumOdometry * NewOdometry ( const bool * Inverted, bool SineInverted );
+
+	CANJaguarServer * Server;
+	AsynchCANJaguar * Wheels [ 4 ];
+
+	// Forward distance each wheel has rolled so far.
+	double Rolled [ 4 ];
+
+};
+
+MecanumOdometryCheck :: MecanumOdometryCheck ()
+{
+
+	CANJagConfigInfo Config;
+
+	Server = new CANJaguarServer ();
+	Server -> Start ();
+
+	for ( uint32_t i = 0; i < 4; i ++ )
+	{
+
+		Wheels [ i ] = new AsynchCANJaguar ( Server, i + 1, Config );
+		Rolled [ i ] = 0;
+
+	}
+
+	Server -> AddJag ( MECANUMODOMETRYCHECK_SHARED_ID, Config );
+
+	// Give the server time to add them.
+	Wait ( 0.05 );
+
+};
+
+bool MecanumOdometryCheck :: Expect ( const char * Name, bool Condition )
+{
+
+	printf ( "  %-64s %s\n", Name, Condition ? "ok" : "FAILED" );
+
+	return Condition;
+
+};
+
+bool MecanumOdometryCheck :: ExpectPose ( const char * Name, MecanumOdometry * Odometry, double X, double Y, double Heading, double Tolerance )
+{
+
+	MecanumPose Pose;
+
+	Odometry -> GetPose ( & Pose );
+
+	bool Matches = fabs ( Pose.X - X ) < Tolerance && fabs ( Pose.Y - Y ) < Tolerance && fabs ( Pose.Heading - Heading ) < Tolerance;
+
+	if ( ! Matches )
+		printf ( "    pose ( %.6f, %.6f, %.6f ), expected ( %.6f, %.6f, %.6f )\n", Pose.X, Pose.Y, Pose.Heading, X, Y, Heading );
+
+	return Expect ( Name, Matches );
+
+};
+
+// One whole sweep, a read per registered Jaguar, as the server loop would do them.
+void MecanumOdometryCheck :: Sweep ()
+{
+
+	uint32_t Count = Server -> TelemetryIDCount;
+
+	for ( uint32_t i = 0; i < Count; i ++ )
+		Server -> UpdateTelemetry ();
+
+};
+
+// Roll the wheels by a robot motion, with MecanumDrive's wheel mix, then sweep and step the estimator.
+void MecanumOdometryCheck :: Move ( MecanumOdometry * Odometry, Motion_t Motion, const bool * Inverted, bool SineInverted )
+{
+
+	double Strafe = SineInverted ? - Motion.Strafe : Motion.Strafe;
+	double Spin = Motion.Turn * MECANUMODOMETRYCHECK_RADIUS;
+
+	Rolled [ 0 ] += Motion.Forward + Strafe + Spin;
+	Rolled [ 1 ] += Motion.Forward - Strafe - Spin;
+	Rolled [ 2 ] += Motion.Forward - Strafe + Spin;
+	Rolled [ 3 ] += Motion.Forward + Strafe - Spin;
+
+	// An inverted wheel's encoder counts backwards.
+	for ( uint32_t i = 0; i < 4; i ++ )
+		CANJaguar :: SetHostPosition ( i + 1, ( Inverted [ i ] ? - 1 : 1 ) * Rolled [ i ] / MECANUMODOMETRYCHECK_CIRCUMFERENCE );
+
+	Sweep ();
+
+	Odometry -> Update ();
+
+};
+
+// An estimator primed on the wheels' current positions, at the origin facing forward.
+MecanumOdometry * MecanumOdometryCheck :: NewOdometry ( const bool * Inverted, bool SineInverted )
+{
+
+	MecanumOdometry * Odometry = new MecanumOdometry ( Wheels [ 0 ], Wheels [ 1 ], Wheels [ 2 ], Wheels [ 3 ], MECANUMODOMETRYCHECK_CIRCUMFERENCE, MECANUMODOMETRYCHECK_TRACK, MECANUMODOMETRYCHECK_BASE );
+
+	Odometry -> SetInverted ( Inverted [ 0 ], Inverted [ 1 ], Inverted [ 2 ], Inverted [ 3 ] );
+	Odometry -> SetSineInversion ( SineInverted );
+
+	Motion_t Still = { 0, 0, 0 };
+
+	Move ( Odometry, Still, Inverted, SineInverted );
+
+	Odometry -> Reset ();
+
+	return Odometry;
+
+};
+
+bool MecanumOdometryCheck :: Sweeps ()
+{
+
+	bool Passed = true;
+
+	printf ( "sweeps:\n" );
+
+	for ( uint32_t i = 0; i < 4; i ++ )
+		Server -> AddJagTelemetry ( i + 1 );
+
+	Wait ( 0.05 );
+
+	CAN_ID IDs [ 4 ] = { 1, 2, 3, 4 };
+	float Positions [ 4 ];
+	double Timestamp = 0;
+
+	for ( uint32_t i = 0; i < 4; i ++ )
+		CANJaguar :: SetHostPosition ( i + 1, 1 + i );
+
+	Passed &= Expect ( "four wheels registered", Server -> TelemetryIDCount == 4 );
+
+	for ( uint32_t i = 0; i < 3; i ++ )
+		Server -> UpdateTelemetry ();
+
+	Passed &= Expect ( "nothing published three reads into the first sweep", ! Server -> GetJagCachedPositions ( IDs, 4, Positions ) );
+
+	Server -> UpdateTelemetry ();
+
+	bool Published = Server -> GetJagCachedPositions ( IDs, 4, Positions, & Timestamp );
+
+	Passed &= Expect ( "first sweep published after the fourth read", Published && Positions [ 0 ] == 1 && Positions [ 3 ] == 4 );
+
+	for ( uint32_t i = 0; i < 4; i ++ )
+		CANJaguar :: SetHostPosition ( i + 1, 10 + i );
+
+	for ( uint32_t i = 0; i < 3; i ++ )
+		Server -> UpdateTelemetry ();
+
+	double Before = Timestamp;
+
+	Server -> GetJagCachedPositions ( IDs, 4, Positions, & Timestamp );
+
+	Passed &= Expect ( "partial second sweep leaves the first one published", Timestamp == Before && Positions [ 0 ] == 1 && Positions [ 3 ] == 4 );
+
+	Server -> UpdateTelemetry ();
+
+	Server -> GetJagCachedPositions ( IDs, 4, Positions, & Timestamp );
+
+	Passed &= Expect ( "second sweep replaces it whole", Timestamp != Before && Positions [ 0 ] == 10 && Positions [ 1 ] == 11 && Positions [ 2 ] == 12 && Positions [ 3 ] == 13 );
+
+	return Passed;
+
+};
+
+bool MecanumOdometryCheck :: SharedUsers ()
+{
+
+	bool Passed = true;
+
+	printf ( "shared users:\n" );
+
+	float Position;
+
+	CANJaguar :: SetHostPosition ( MECANUMODOMETRYCHECK_SHARED_ID, 7 );
+
+	Server -> AddJagTelemetry ( MECANUMODOMETRYCHECK_SHARED_ID );
+	Server -> AddJagTelemetry ( MECANUMODOMETRYCHECK_SHARED_ID );
+
+	Wait ( 0.05 );
+
+	Passed &= Expect ( "registered twice, read once per sweep", Server -> TelemetryIDCount == 5 );
+
+	Sweep ();
+
+	Passed &= Expect ( "published", Server -> GetJagCachedPosition ( MECANUMODOMETRYCHECK_SHARED_ID, & Position ) && Position == 7 );
+
+	Server -> RemoveJagTelemetry ( MECANUMODOMETRYCHECK_SHARED_ID );
+
+	Wait ( 0.05 );
+
+	uint32_t Reads = CANJaguar :: GetHostPositionReads ( MECANUMODOMETRYCHECK_SHARED_ID );
+
+	Sweep ();
+
+	Passed &= Expect ( "one user gone, still read", Server -> TelemetryIDCount == 5 && CANJaguar :: GetHostPositionReads ( MECANUMODOMETRYCHECK_SHARED_ID ) == Reads + 1 );
+
+	Server -> RemoveJagTelemetry ( MECANUMODOMETRYCHECK_SHARED_ID );
+
+	Wait ( 0.05 );
+
+	Passed &= Expect ( "both gone, dropped from the published sweep at once", Server -> TelemetryIDCount == 4 && ! Server -> GetJagCachedPosition ( MECANUMODOMETRYCHECK_SHARED_ID, & Position ) );
+
+	Reads = CANJaguar :: GetHostPositionReads ( MECANUMODOMETRYCHECK_SHARED_ID );
+
+	Sweep ();
+
+	Passed &= Expect ( "and no longer read", CANJaguar :: GetHostPositionReads ( MECANUMODOMETRYCHECK_SHARED_ID ) == Reads );
+
+	return Passed;
+
+};
+
+bool MecanumOdometryCheck :: Kinematics ()
+{
+
+	bool Passed = true;
+
+	printf ( "kinematics:\n" );
+
+	const bool Straight [ 4 ] = { false, false, false, false };
+	const bool Crossed [ 4 ] = { true, false, true, false };
+
+	Motion_t Forward = { 0.25, 0, 0 };
+	Motion_t Right = { 0, 0.25, 0 };
+	Motion_t Clockwise = { 0, 0, MECANUMODOMETRYCHECK_PI / 8 };
+
+	for ( uint32_t Case = 0; Case < 2; Case ++ )
+	{
+
+		const bool * Inverted = ( Case == 0 ) ? Straight : Crossed;
+		const char * Suffix = ( Case == 0 ) ? "" : ", FL and RL inverted";
+
+		char Name [ 128 ];
+
+		MecanumOdometry * Odometry = NewOdometry ( Inverted, false );
+
+		for ( uint32_t i = 0; i < 4; i ++ )
+			Move ( Odometry, Forward, Inverted, false );
+
+		MecanumPose Pose;
+
+		Odometry -> GetPose ( & Pose );
+
+		snprintf ( Name, sizeof ( Name ), "forward 1 is +Y%s", Suffix );
+		Passed &= ExpectPose ( Name, Odometry, 0, 1, 0 );
+
+		// Steps are microseconds apart here, so float rounding in the positions shows up in the speeds; compare to VY.
+		snprintf ( Name, sizeof ( Name ), "forward speed is +VY%s", Suffix );
+		Passed &= Expect ( Name, Pose.VY > 0 && fabs ( Pose.VX ) < Pose.VY * 1e-3 && fabs ( Pose.Omega ) < Pose.VY * 1e-3 );
+
+		for ( uint32_t i = 0; i < 4; i ++ )
+			Move ( Odometry, Right, Inverted, false );
+
+		snprintf ( Name, sizeof ( Name ), "then strafe right 1 is +X%s", Suffix );
+		Passed &= ExpectPose ( Name, Odometry, 1, 1, 0 );
+
+		for ( uint32_t i = 0; i < 4; i ++ )
+			Move ( Odometry, Clockwise, Inverted, false );
+
+		snprintf ( Name, sizeof ( Name ), "then spin a quarter turn clockwise, in place%s", Suffix );
+		Passed &= ExpectPose ( Name, Odometry, 1, 1, MECANUMODOMETRYCHECK_PI / 2 );
+
+		for ( uint32_t i = 0; i < 4; i ++ )
+			Move ( Odometry, Forward, Inverted, false );
+
+		snprintf ( Name, sizeof ( Name ), "then forward 1, facing right, is +X%s", Suffix );
+		Passed &= ExpectPose ( Name, Odometry, 2, 1, MECANUMODOMETRYCHECK_PI / 2 );
+
+		for ( uint32_t i = 0; i < 4; i ++ )
+			Move ( Odometry, Right, Inverted, false );
+
+		snprintf ( Name, sizeof ( Name ), "then strafe right 1, facing right, is -Y%s", Suffix );
+		Passed &= ExpectPose ( Name, Odometry, 2, 0, MECANUMODOMETRYCHECK_PI / 2 );
+
+	}
+
+	// Forward and turning in one step moves along the heading halfway through it.
+	MecanumOdometry * Odometry = NewOdometry ( Straight, false );
+
+	Motion_t Arc = { 1, 0, 0.5 };
+
+	Move ( Odometry, Arc, Straight, false );
+
+	Passed &= ExpectPose ( "forward 1 turning 0.5 rad in one step, at the midpoint heading", Odometry, sin ( 0.25 ), cos ( 0.25 ), 0.5 );
+
+	// Rollers the other way round strafe the other way for the same wheel motions.
+	Odometry = NewOdometry ( Straight, true );
+
+	for ( uint32_t i = 0; i < 4; i ++ )
+		Move ( Odometry, Right, Straight, true );
+
+	Passed &= ExpectPose ( "strafe right 1 with sine inversion is +X", Odometry, 1, 0, 0 );
+
+	Odometry = NewOdometry ( Straight, false );
+
+	for ( uint32_t i = 0; i < 4; i ++ )
+		Move ( Odometry, Right, Straight, true );
+
+	Passed &= Expect ( "the same wheels without it go -X", fabs ( Odometry -> Pose.X + 1 ) < MECANUMODOMETRYCHECK_TOLERANCE );
+
+	return Passed;
+
+};
+
+// The server and estimator on their own: telemetry every 2 ms over four wheels, faster than the 1 ms clock ticks.
+bool MecanumOdometryCheck :: Running ()
+{
+
+	bool Passed = true;
+
+	printf ( "running:\n" );
+
+	MecanumOdometry * Odometry = new MecanumOdometry ( Wheels [ 0 ], Wheels [ 1 ], Wheels [ 2 ], Wheels [ 3 ], MECANUMODOMETRYCHECK_CIRCUMFERENCE, MECANUMODOMETRYCHECK_TRACK, MECANUMODOMETRYCHECK_BASE );
+
+	Server -> SetTelemetryInterval ( 0.002 );
+
+	Odometry -> Start ();
+
+	Wait ( 0.1 );
+
+	Odometry -> Reset ();
+
+	// A sweep can read some wheels before a move and some after, which the estimator takes for a turn and then a turn
+	// back. The heading comes out right, but the pose is off by about the square of the move over the rotation
+	// radius. So the wheels roll a little at a time, as real ones do, and the pose gets a looser tolerance.
+	for ( uint32_t Step = 0; Step < MECANUMODOMETRYCHECK_RAMP_STEPS; Step ++ )
+	{
+
+		for ( uint32_t i = 0; i < 4; i ++ )
+		{
+
+			Rolled [ i ] += 1.0 / MECANUMODOMETRYCHECK_RAMP_STEPS;
+
+			CANJaguar :: SetHostPosition ( i + 1, Rolled [ i ] );
+
+		}
+
+		Wait ( 0.002 );
+
+	}
+
+	Wait ( 0.1 );
+
+	Passed &= ExpectPose ( "forward 1, read by the server task", Odometry, 0, 1, 0, MECANUMODOMETRYCHECK_RAMP_TOLERANCE );
+
+	struct timespec CPUStart;
+	struct timespec CPUEnd;
+
+	clock_gettime ( CLOCK_PROCESS_CPUTIME_ID, & CPUStart );
+
+	double Start = Timer :: GetPPCTimestamp ();
+
+	Wait ( 1.0 );
+
+	clock_gettime ( CLOCK_PROCESS_CPUTIME_ID, & CPUEnd );
+
+	double Busy = ( CPUEnd.tv_sec - CPUStart.tv_sec ) + 1e-9 * ( CPUEnd.tv_nsec - CPUStart.tv_nsec );
+	double Load = Busy / ( Timer :: GetPPCTimestamp () - Start );
+
+	printf ( "    %.1f%% of a CPU while reading telemetry every 0.5 ms\n", 100 * Load );
+
+	Passed &= Expect ( "server doesn't spin between reads", Load < 0.25 );
+
+	Odometry -> Stop ();
+
+	return Passed;
+
+};
+
+int main ()
+{
+
+	MecanumOdometryCheck Check;
+
+	bool Passed = true;
+
+	Passed &= Check.Sweeps ();
+	Passed &= Check.SharedUsers ();
+	Passed &= Check.Kinematics ();
+	Passed &= Check.Running ();
+
+	printf ( "%s\n", Passed ? "PASSED" : "FAILED" );
+
+	// The server task is still running, so leave without tearing it down.
+	fflush ( stdout );
+	_exit ( Passed ? 0 : 1 );
+
+};
+
+#endif
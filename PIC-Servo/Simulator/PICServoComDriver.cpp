@@ -0,0 +1,304 @@
+/*
+* Host driver: runs PICServoCom, unmodified, against the simulator's pseudo-terminal.
+*
+* Addresses the simulated modules, defines and polls their status, checks that a trajectory loaded without immediate
+* motion is held until a group START_MOVE, then measures how many commands a second the link carries with requests
+* pipelined against one at a time. With a second baud rate, it negotiates up to it and measures again. Throughout, no
+* reply may be due on the modules' shared line before the one ahead of it is done.
+*
+* Build and run from the repository root:
+*
+*   g++ -std=gnu++98 -fpermissive -O2 -pthread -I PIC-Servo/Simulator/Host PIC-Servo/Simulator/PICServoComDriver.cpp
+*       PIC-Servo/Simulator/PICServoSimulator.cpp PIC-Servo/Simulator/Host/HostWPILib.cpp PIC-Servo/PICServoCom.cpp
+*       -o PICServoComDriver
+*   ./PICServoComDriver [ modules [ seconds [ baud ] ] ]
+*/
+
+#if defined ( __linux__ )
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "WPILib.h"
+
+#include "../PICServoCom.h"
+#include "PICServoSimulator.h"
+
+#define PICSERVOCOMDRIVER_GROUP 0x80
+#define PICSERVOCOMDRIVER_STATUS ( PICSERVO_STATUS_TYPE_POSITION | PICSERVO_STATUS_TYPE_AUXILIARY_STATUS )
+
+#define PICSERVOCOMDRIVER_TARGET 5000
+#define PICSERVOCOMDRIVER_VELOCITY 10.0
+#define PICSERVOCOMDRIVER_ACCELERATION 0.1
+
+static void * RunSimulator ( void * Simulator )
+{
+
+	static_cast <PICServoSimulator *> ( Simulator ) -> Run ();
+
+	return NULL;
+
+};
+
+static bool Check ( bool Passed, const char * What )
+{
+
+	printf ( "%-56s %s\n", What, Passed ? "ok" : "FAILED" );
+
+	return Passed;
+
+};
+
+static int32_t ReadPosition ( PICServoCom * Com, uint8_t Module, uint8_t * Flags )
+{
+
+	PICServoCom :: PICServoStatus_t Status;
+
+	if ( ! Com -> ModuleReadStatus ( Module, PICSERVO_STATUS_TYPE_POSITION, & Status ) )
+		return 0x7FFFFFFF;
+
+	if ( Flags != NULL )
+		* Flags = Status.StandardFlags;
+
+	return static_cast <int32_t> ( Status.Position );
+
+};
+
+// A status request to every module, each Completed before the next is sent.
+static double MeasureSerial ( PICServoCom * Com, uint32_t Modules, double Seconds, uint32_t * Failures )
+{
+
+	double Start = Timer :: GetPPCTimestamp ();
+	uint32_t Commands = 0;
+
+	while ( Timer :: GetPPCTimestamp () - Start < Seconds )
+	{
+
+		for ( uint32_t i = 0; i < Modules; i ++ )
+		{
+
+			if ( ! Com -> Complete ( Com -> ModuleGetStatus ( i + 1 ) ) )
+				( * Failures ) ++;
+
+			Commands ++;
+
+		}
+
+	}
+
+	return Commands / ( Timer :: GetPPCTimestamp () - Start );
+
+};
+
+// The same requests, all queued before any is waited on, as the controller's poll and command tasks do.
+static double MeasurePipelined ( PICServoCom * Com, uint32_t Modules, double Seconds, uint32_t * Failures )
+{
+
+	PICServoCom :: PICServoTransaction_t * Requests [ PICSERVOSIM_MAX_MODULES ];
+
+	double Start = Timer :: GetPPCTimestamp ();
+	uint32_t Commands = 0;
+
+	while ( Timer :: GetPPCTimestamp () - Start < Seconds )
+	{
+
+		for ( uint32_t i = 0; i < Modules; i ++ )
+			Requests [ i ] = Com -> ModuleGetStatus ( i + 1 );
+
+		for ( uint32_t i = 0; i < Modules; i ++ )
+		{
+
+			if ( ! Com -> Complete ( Requests [ i ] ) )
+				( * Failures ) ++;
+
+			Commands ++;
+
+		}
+
+	}
+
+	return Commands / ( Timer :: GetPPCTimestamp () - Start );
+
+};
+
+static void PrintLink ( PICServoCom * Com, const PICServoCom :: PICServoLinkMetrics_t * Before )
+{
+
+	PICServoCom :: PICServoLinkMetrics_t After;
+
+	Com -> GetLinkMetrics ( & After );
+
+	double Elapsed = After.Timestamp - Before -> Timestamp;
+	uint32_t Replies = After.Replies - Before -> Replies;
+
+	printf ( "  link: %u baud, tx busy %.0f%%, rx busy %.0f%%, %u replies, mean latency %.3f ms, %u timeouts, %u checksum errors, %u acquire timeouts\n", After.BaudRate, 100 * ( After.TxLineTime - Before -> TxLineTime ) / Elapsed, 100 * ( After.RxLineTime - Before -> RxLineTime ) / Elapsed, Replies, ( Replies != 0 ) ? 1000 * ( After.LatencyTotal - Before -> LatencyTotal ) / Replies : 0.0, After.Timeouts - Before -> Timeouts, After.ChecksumErrors - Before -> ChecksumErrors, After.AcquireTimeouts - Before -> AcquireTimeouts );
+
+	printf ( "  SubmitLock: %u taken, %u contended, %.3f ms max wait; LinkLock: %u taken, %u contended, %.3f ms max wait\n", After.SubmitLock.Acquisitions - Before -> SubmitLock.Acquisitions, After.SubmitLock.Contentions - Before -> SubmitLock.Contentions, 1000 * After.SubmitLock.WaitMax, After.LinkLock.Acquisitions - Before -> LinkLock.Acquisitions, After.LinkLock.Contentions - Before -> LinkLock.Contentions, 1000 * After.LinkLock.WaitMax );
+
+};
+
+static void Measure ( PICServoCom * Com, uint32_t Modules, double Seconds )
+{
+
+	PICServoCom :: PICServoLinkMetrics_t Before;
+	uint32_t Failures = 0;
+
+	Com -> GetLinkMetrics ( & Before );
+
+	double Serial = MeasureSerial ( Com, Modules, Seconds, & Failures );
+
+	printf ( "one at a time: %8.0f commands/s\n", Serial );
+	PrintLink ( Com, & Before );
+
+	Com -> GetLinkMetrics ( & Before );
+
+	double Pipelined = MeasurePipelined ( Com, Modules, Seconds, & Failures );
+
+	printf ( "pipelined:     %8.0f commands/s ( %.2fx )\n", Pipelined, Pipelined / Serial );
+	PrintLink ( Com, & Before );
+
+	Check ( Failures == 0, "every request answered" );
+
+};
+
+int main ( int argc, char ** argv )
+{
+
+	uint32_t Modules = ( argc > 1 ) ? atoi ( argv [ 1 ] ) : 4;
+	double Seconds = ( argc > 2 ) ? atof ( argv [ 2 ] ) : 2.0;
+	uint32_t FastBaud = ( argc > 3 ) ? atoi ( argv [ 3 ] ) : 0;
+
+	if ( Modules < 1 )
+		Modules = 1;
+
+	if ( Modules > PICSERVOSIM_MAX_MODULES )
+		Modules = PICSERVOSIM_MAX_MODULES;
+
+	static PICServoSimulator Simulator ( Modules );
+
+	if ( ! Simulator.Open () )
+	{
+
+		perror ( "PICServoSimulator" );
+
+		return 1;
+
+	}
+
+	pthread_t SimulatorThread;
+	pthread_create ( & SimulatorThread, NULL, & RunSimulator, & Simulator );
+
+	SerialPort :: SetHostDevice ( Simulator.GetDevicePath () );
+
+	printf ( "%u modules on %s\n", Modules, Simulator.GetDevicePath () );
+
+	PICServoCom * Com = new PICServoCom ();
+
+	bool Passed = true;
+
+	// Unaddressed modules all answer to 0, so each SET_ADDR takes the next one off the chain.
+	bool Addressed = true;
+
+	for ( uint32_t i = 0; i < Modules; i ++ )
+		Addressed &= Com -> Complete ( Com -> ModuleSetAddress ( 0, i + 1, PICSERVOCOMDRIVER_GROUP ) );
+
+	Passed &= Check ( Addressed, "SET_ADDR answered by every module" );
+
+	bool Defined = true;
+
+	for ( uint32_t i = 0; i < Modules; i ++ )
+		Defined &= Com -> Complete ( Com -> ModuleDefineStatus ( i + 1, PICSERVOCOMDRIVER_STATUS ) );
+
+	Passed &= Check ( Defined, "DEF_STAT answered by every module" );
+
+	// Status poll: every module answers with the items it was told to send.
+	bool Polled = true;
+
+	for ( uint32_t i = 0; i < Modules; i ++ )
+	{
+
+		PICServoCom :: PICServoStatus_t Status;
+
+		Polled &= Com -> Complete ( Com -> ModuleGetStatus ( i + 1 ), & Status );
+		Polled &= ( Com -> GetStatusType ( i + 1 ) == PICSERVOCOMDRIVER_STATUS );
+		Polled &= ( Status.Position == 0 );
+
+	}
+
+	Passed &= Check ( Polled, "status poll decodes position and auxiliary status" );
+
+	// Trajectory load, held until the group START_MOVE.
+	Passed &= Check ( Com -> Complete ( Com -> ModuleLoadTrajectory ( 1, PICSERVOCOMDRIVER_TARGET, PICSERVOCOMDRIVER_VELOCITY, PICSERVOCOMDRIVER_ACCELERATION, 0, true, true, true, false, true, false, false, false ) ), "LOAD_TRAJ without immediate motion answered" );
+
+	Wait ( 0.05 );
+
+	Passed &= Check ( ReadPosition ( Com, 1, NULL ) == 0, "trajectory held until START_MOVE" );
+
+	// Group frames get no reply, so this completes once it has gone out.
+	Com -> Complete ( Com -> ModuleStartMove ( PICSERVOCOMDRIVER_GROUP ) );
+
+	int32_t Position = 0;
+	uint8_t Flags = 0;
+
+	double Start = Timer :: GetPPCTimestamp ();
+
+	do
+	{
+
+		Wait ( 0.01 );
+
+		Position = ReadPosition ( Com, 1, & Flags );
+
+	}
+	while ( ! ( Flags & PICSERVOSIM_STATUS_MOVE_DONE ) && Timer :: GetPPCTimestamp () - Start < 2.0 );
+
+	printf ( "  module 1 at %d after %.3f s\n", Position, Timer :: GetPPCTimestamp () - Start );
+
+	Passed &= Check ( Position == PICSERVOCOMDRIVER_TARGET && ( Flags & PICSERVOSIM_STATUS_MOVE_DONE ), "group START_MOVE runs the trajectory to its target" );
+
+	printf ( "\n%u baud:\n", Com -> GetBaudRate () );
+	Measure ( Com, Modules, Seconds );
+
+	if ( FastBaud != 0 )
+	{
+
+		uint8_t Addresses [ PICSERVOSIM_MAX_MODULES ];
+
+		for ( uint32_t i = 0; i < Modules; i ++ )
+			Addresses [ i ] = i + 1;
+
+		bool Negotiated = Com -> NegotiateBaud ( FastBaud, PICSERVOCOMDRIVER_GROUP, Addresses, Modules );
+
+		Passed &= Check ( Negotiated && Com -> GetBaudRate () == FastBaud, "baud rate negotiated" );
+
+		if ( Negotiated )
+		{
+
+			bool Repolled = true;
+
+			for ( uint32_t i = 0; i < Modules; i ++ )
+				Repolled &= ( ReadPosition ( Com, i + 1, NULL ) != 0x7FFFFFFF );
+
+			Passed &= Check ( Repolled, "status poll answered at the new rate" );
+
+			printf ( "\n%u baud:\n", Com -> GetBaudRate () );
+			Measure ( Com, Modules, Seconds );
+
+		}
+
+	}
+
+	printf ( "\nsimulator: %u frames, %u checksum errors, %u reply collisions\n", Simulator.GetFramesReceived (), Simulator.GetChecksumErrors (), Simulator.GetCollisions () );
+
+	Passed &= Check ( Simulator.GetCollisions () == 0, "no replies collided on the shared line" );
+
+	delete Com;
+
+	printf ( "%s\n", Passed ? "PASSED" : "FAILED" );
+
+	return Passed ? 0 : 1;
+
+};
+
+#endif
@@ -0,0 +1,178 @@
+/*
+* Host benchmark: PICServoCom frame encode throughput, with group addressed frames written to /dev/null.
+*
+* Group frames get no reply, so nothing ever waits on the line and the send task runs as fast as frames can be encoded,
+* queued and written. First a LOAD_TRAJ frame is checked byte for byte against one built by hand, then frames are
+* issued detached, as the controller's command task does, and again Completed one at a time. The link metrics give the
+* bytes sent.
+*
+* Build and run from the repository root:
+*
+*   g++ -std=gnu++98 -fpermissive -O2 -pthread -I PIC-Servo/Simulator/Host PIC-Servo/Simulator/PICServoEncodeBench.cpp
+*       PIC-Servo/Simulator/Host/HostWPILib.cpp PIC-Servo/PICServoCom.cpp -o PICServoEncodeBench
+*   ./PICServoEncodeBench [ frames ]
+*/
+
+#if defined ( __linux__ )
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "WPILib.h"
+
+#include "../PICServoCom.h"
+
+#define PICSERVOENCODEBENCH_GROUP 0x80
+
+typedef enum
+{
+
+	kLoadTrajectory,
+	kStartMove,
+	kAddPathPoints
+
+} Frame_t;
+
+static const char * FrameNames [] = { "LOAD_TRAJ", "START_MOVE", "ADD_PATHPT" };
+static const uint32_t FrameSizes [] = { 17, 4, 18 };
+
+static PICServoCom :: PICServoTransaction_t * Issue ( PICServoCom * Com, Frame_t Frame, uint32_t i )
+{
+
+	static const int32_t Points [ 7 ] = { 1, 2, 3, 4, 5, 6, 7 };
+
+	switch ( Frame )
+	{
+
+	case kLoadTrajectory:
+
+		return Com -> ModuleLoadTrajectory ( PICSERVOENCODEBENCH_GROUP, i, 100.0, 0.5, 0, true, true, true, false, true, false, false, false );
+
+	case kStartMove:
+
+		return Com -> ModuleStartMove ( PICSERVOENCODEBENCH_GROUP );
+
+	default:
+
+		return Com -> ModuleAddPathPoints ( PICSERVOENCODEBENCH_GROUP, Points, 7 );
+
+	}
+
+};
+
+// Waits for the send task to have written Bytes more than Before, so a run is timed to the last byte out.
+static bool Drain ( PICServoCom * Com, const PICServoCom :: PICServoLinkMetrics_t * Before, uint32_t Bytes, PICServoCom :: PICServoLinkMetrics_t * After )
+{
+
+	double Start = Timer :: GetPPCTimestamp ();
+
+	do
+	{
+
+		Com -> GetLinkMetrics ( After );
+
+		if ( After -> BytesSent - Before -> BytesSent >= Bytes )
+			return true;
+
+	}
+	while ( Timer :: GetPPCTimestamp () - Start < 5.0 );
+
+	return false;
+
+};
+
+static bool Measure ( PICServoCom * Com, Frame_t Frame, uint32_t Count, bool Detached )
+{
+
+	PICServoCom :: PICServoLinkMetrics_t Before;
+	PICServoCom :: PICServoLinkMetrics_t After;
+
+	Com -> GetLinkMetrics ( & Before );
+
+	uint32_t Allocations = HostAllocationCount ();
+	double Start = Timer :: GetPPCTimestamp ();
+
+	for ( uint32_t i = 0; i < Count; i ++ )
+	{
+
+		if ( Detached )
+			Com -> Detach ( Issue ( Com, Frame, i ) );
+		else
+			Com -> Complete ( Issue ( Com, Frame, i ) );
+
+	}
+
+	bool Drained = Drain ( Com, & Before, Count * FrameSizes [ Frame ], & After );
+
+	double Elapsed = After.Timestamp - Start;
+
+	uint32_t Bytes = After.BytesSent - Before.BytesSent;
+
+	printf ( "%-10s %-9s %9.0f frames/s %7.2f MB/s %7.0f ns/frame, %u allocations\n", FrameNames [ Frame ], Detached ? "detached" : "completed", Count / Elapsed, Bytes / Elapsed / 1e6, 1e9 * Elapsed / Count, HostAllocationCount () - Allocations );
+
+	return Drained && Bytes == Count * FrameSizes [ Frame ] && After.AcquireTimeouts == Before.AcquireTimeouts;
+
+};
+
+// 0xAA, address, length nibble and command, payload little endian, then the sum of everything after the header byte.
+static bool CheckLoadTrajectory ( PICServoCom * Com )
+{
+
+	uint8_t Expected [ 17 ] = { 0xAA, PICSERVOENCODEBENCH_GROUP, 0xD4, 0x97, 0x78, 0x56, 0x34, 0x12, 0x00, 0x80, 0x64, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00 };
+
+	uint8_t Sum = 0;
+
+	for ( uint32_t i = 1; i < 16; i ++ )
+		Sum += Expected [ i ];
+
+	Expected [ 16 ] = Sum;
+
+	PICServoCom :: PICServoTransaction_t * Transaction = Com -> ModuleLoadTrajectory ( PICSERVOENCODEBENCH_GROUP, 0x12345678, 100.5, 0.5, 0, true, true, true, false, true, false, false, true );
+
+	if ( Transaction == NULL )
+		return false;
+
+	Com -> Wait ( Transaction );
+
+	bool Matches = ( Transaction -> FrameSize == sizeof ( Expected ) && memcmp ( Transaction -> Frame, Expected, sizeof ( Expected ) ) == 0 );
+
+	Com -> Release ( Transaction );
+
+	return Matches;
+
+};
+
+int main ( int argc, char ** argv )
+{
+
+	uint32_t Count = ( argc > 1 ) ? atoi ( argv [ 1 ] ) : 200000;
+
+	SerialPort :: SetHostDevice ( "/dev/null" );
+
+	PICServoCom * Com = new PICServoCom ();
+
+	bool Passed = CheckLoadTrajectory ( Com );
+
+	printf ( "LOAD_TRAJ frame matches the hand-built one: %s\n", Passed ? "ok" : "FAILED" );
+
+	// Once to warm up, then measured.
+	Measure ( Com, kLoadTrajectory, Count / 10, true );
+
+	for ( uint32_t Frame = kLoadTrajectory; Frame <= kAddPathPoints; Frame ++ )
+	{
+
+		Passed &= Measure ( Com, static_cast <Frame_t> ( Frame ), Count, true );
+		Passed &= Measure ( Com, static_cast <Frame_t> ( Frame ), Count / 10, false );
+
+	}
+
+	delete Com;
+
+	printf ( "%s\n", Passed ? "PASSED" : "FAILED" );
+
+	return Passed ? 0 : 1;
+
+};
+
+#endif
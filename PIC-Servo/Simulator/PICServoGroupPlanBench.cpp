@@ -0,0 +1,297 @@
+/*
+* Host benchmark: PICServoGroupPlanner planning time for 2 to 16 axes, and a dispatched group move on the simulator.
+*
+* A PICServoController runs, unmodified, against a chain of simulated modules. Planning is timed for each group size
+* with trapezoidal and jerk limited axes. Then one move per group size is dispatched with different distances and
+* limits on every axis, and the simulator reports when each module started and set MOVE_DONE, so the spread of the
+* finish times can be checked against the planned duration. Last, a PICServoProfiler runs a velocity move on one axis
+* to its end and then runs another.
+*
+* Build and run from the repository root:
+*
+*   g++ -std=gnu++98 -fpermissive -O2 -pthread -I PIC-Servo/Simulator/Host PIC-Servo/Simulator/PICServoGroupPlanBench.cpp
+*       PIC-Servo/Simulator/PICServoSimulator.cpp PIC-Servo/Simulator/Host/HostWPILib.cpp PIC-Servo/PICServo*.cpp
+*       PIC-Servo/AnalogCANJaguarPipeServer.cpp Filters/FilterChain.cpp -o PICServoGroupPlanBench
+*   ./PICServoGroupPlanBench [ plans ]
+*/
+
+#if defined ( __linux__ )
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "WPILib.h"
+
+#include "../PICServoController.h"
+#include "../PICServoGroupPlanner.h"
+#include "../PICServoProfiler.h"
+#include "PICServoSimulator.h"
+
+#define PICSERVOGROUPPLANBENCH_GROUP 0x80
+#define PICSERVOGROUPPLANBENCH_AXES 16
+#define PICSERVOGROUPPLANBENCH_COUNTS 2000
+
+static uint32_t RandomState = 0x2605;
+
+static double Random ( double Low, double High )
+{
+
+	RandomState ^= RandomState << 13;
+	RandomState ^= RandomState >> 17;
+	RandomState ^= RandomState << 5;
+
+	return Low + ( High - Low ) * ( RandomState / 4294967296.0 );
+
+};
+
+static void * RunSimulator ( void * Simulator )
+{
+
+	static_cast <PICServoSimulator *> ( Simulator ) -> Run ();
+
+	return NULL;
+
+};
+
+// Axis i gets its own limits, so every axis has a different natural duration.
+static void AddAxes ( PICServoGroupPlanner * Planner, PICServoController * Controller, uint32_t Count, bool Jerk )
+{
+
+	Planner -> ClearAxes ();
+
+	for ( uint32_t i = 0; i < Count; i ++ )
+		Planner -> AddAxis ( Controller -> GetModule ( i + 1 ), 4 + i, 8 + 2 * i, Jerk ? 80 + 20 * i : 0 );
+
+};
+
+static double TimePlans ( PICServoGroupPlanner * Planner, uint32_t Count, uint32_t Plans )
+{
+
+	const uint32_t Sets = 64;
+
+	double Starts [ Sets ][ PICSERVOGROUPPLANBENCH_AXES ];
+	double Targets [ Sets ][ PICSERVOGROUPPLANBENCH_AXES ];
+
+	for ( uint32_t i = 0; i < Sets; i ++ )
+	{
+
+		for ( uint32_t j = 0; j < Count; j ++ )
+		{
+
+			Starts [ i ][ j ] = Random ( - 10, 10 );
+			Targets [ i ][ j ] = Random ( - 10, 10 );
+
+		}
+
+	}
+
+	double Start = Timer :: GetPPCTimestamp ();
+
+	for ( uint32_t i = 0; i < Plans; i ++ )
+		Planner -> Plan ( Starts [ i & ( Sets - 1 ) ], Targets [ i & ( Sets - 1 ) ] );
+
+	return 1e9 * ( Timer :: GetPPCTimestamp () - Start ) / Plans;
+
+};
+
+// Dispatches a move from wherever the axes are to new targets, and checks they all finish on time together.
+static bool RunMove ( PICServoGroupPlanner * Planner, PICServoController * Controller, PICServoSimulator * Simulator, uint32_t Count, const double * Starts )
+{
+
+	double Targets [ PICSERVOGROUPPLANBENCH_AXES ];
+	double Alone = 1e9;
+	double AloneMax = 0;
+
+	for ( uint32_t i = 0; i < Count; i ++ )
+	{
+
+		Targets [ i ] = Starts [ i ] + ( ( i & 1 ) ? - 1 : 1 ) * ( 0.5 + 0.5 * i );
+
+		PICServoProfile Profile;
+
+		Profile.Plan ( Starts [ i ], Targets [ i ], 4 + i, 8 + 2 * i );
+
+		if ( Profile.GetDuration () < Alone )
+			Alone = Profile.GetDuration ();
+
+		if ( Profile.GetDuration () > AloneMax )
+			AloneMax = Profile.GetDuration ();
+
+	}
+
+	AddAxes ( Planner, Controller, Count, false );
+
+	if ( ! Planner -> Plan ( Starts, Targets ) )
+		return false;
+
+	double Duration = Planner -> GetDuration ();
+	double Start = Timer :: GetPPCTimestamp ();
+
+	if ( ! Planner -> Dispatch () )
+		return false;
+
+	double DispatchTime = Timer :: GetPPCTimestamp () - Start;
+
+	Wait ( Duration + 0.25 );
+
+	double FirstStart = 1e9;
+	double LastStart = 0;
+	double FirstFinish = 1e9;
+	double LastFinish = 0;
+
+	for ( uint32_t i = 0; i < Count; i ++ )
+	{
+
+		double Started;
+		double Finished;
+
+		if ( ! Simulator -> GetMoveTimes ( i + 1, & Started, & Finished ) )
+		{
+
+			printf ( "  axis %u never finished\n", i + 1 );
+
+			return false;
+
+		}
+
+		FirstStart = ( Started < FirstStart ) ? Started : FirstStart;
+		LastStart = ( Started > LastStart ) ? Started : LastStart;
+		FirstFinish = ( Finished < FirstFinish ) ? Finished : FirstFinish;
+		LastFinish = ( Finished > LastFinish ) ? Finished : LastFinish;
+
+	}
+
+	double Elapsed = LastFinish - FirstStart;
+
+	printf ( "%2u axes: planned %.3f s ( alone %.3f to %.3f s ), dispatch %.1f ms, starts within %.3f ms, finished %.3f to %.3f s, spread %.1f ms\n", Count, Duration, Alone, AloneMax, 1000 * DispatchTime, 1000 * ( LastStart - FirstStart ), FirstFinish - FirstStart, Elapsed, 1000 * ( LastFinish - FirstFinish ) );
+
+	// The modules run their own trapezoids at the servo rate, so allow a couple of percent on the duration.
+	return LastStart - FirstStart < 0.001 && LastFinish - FirstFinish < 0.02 * Duration + 0.005 && fabs ( Elapsed - Duration ) < 0.02 * Duration + 0.005;
+
+};
+
+// Runs a velocity profile on one axis to its end, twice, as a profiler is used between group moves.
+static bool RunProfiler ( PICServoController * Controller )
+{
+
+	// From operator new, so the task argument holds it.
+	PICServoProfiler * Profiler = new PICServoProfiler ( Controller -> GetModule ( 1 ) );
+
+	bool Passed = true;
+
+	for ( uint32_t i = 0; i < 2; i ++ )
+	{
+
+		PICServoProfile Move;
+
+		Move.Plan ( 0, 1, 4, 8 );
+
+		bool Started = Profiler -> Run ( Move );
+
+		Wait ( Move.GetDuration () + 0.1 );
+
+		bool Finished = ! Profiler -> IsRunning ();
+
+		printf ( "profiler run %u: %s, %s\n", i + 1, Started ? "started" : "FAILED to start", Finished ? "finished" : "still running" );
+
+		Passed &= Started && Finished;
+
+	}
+
+	delete Profiler;
+
+	return Passed;
+
+};
+
+int main ( int argc, char ** argv )
+{
+
+	uint32_t Plans = ( argc > 1 ) ? atoi ( argv [ 1 ] ) : 200000;
+
+	static PICServoSimulator Simulator ( PICSERVOGROUPPLANBENCH_AXES );
+
+	if ( ! Simulator.Open () )
+	{
+
+		perror ( "PICServoSimulator" );
+
+		return 1;
+
+	}
+
+	pthread_t SimulatorThread;
+	pthread_create ( & SimulatorThread, NULL, & RunSimulator, & Simulator );
+
+	SerialPort :: SetHostDevice ( Simulator.GetDevicePath () );
+
+	PICServoController * Controller = new PICServoController ( PICSERVOGROUPPLANBENCH_GROUP );
+
+	for ( uint32_t i = 0; i < PICSERVOGROUPPLANBENCH_AXES; i ++ )
+	{
+
+		Controller -> AddPICServo ( i + 1, true, i + 1, ( i % 8 ) + 1 );
+
+		PICServo * Servo = Controller -> GetModule ( i + 1 );
+
+		Servo -> SetEncoderResolution ( PICSERVOGROUPPLANBENCH_COUNTS );
+		Servo -> SetControlMode ( PICServo :: kPosition );
+		Servo -> Enable ();
+
+	}
+
+	bool Passed = Controller -> SetBaudRate ( 115200 );
+
+	printf ( "%u modules on %s at 115200 baud: %s\n\n", PICSERVOGROUPPLANBENCH_AXES, Simulator.GetDevicePath (), Passed ? "ok" : "FAILED" );
+
+	PICServoGroupPlanner Planner ( Controller );
+
+	printf ( "axes   trapezoid          jerk limited\n" );
+
+	for ( uint32_t Count = 2; Count <= PICSERVOGROUPPLANBENCH_AXES; Count *= 2 )
+	{
+
+		AddAxes ( & Planner, Controller, Count, false );
+
+		double Trapezoid = TimePlans ( & Planner, Count, Plans );
+
+		AddAxes ( & Planner, Controller, Count, true );
+
+		double SCurve = TimePlans ( & Planner, Count, Plans );
+
+		printf ( "%4u   %6.0f ns %5.1f/axis  %6.0f ns %5.1f/axis\n", Count, Trapezoid, Trapezoid / Count, SCurve, SCurve / Count );
+
+	}
+
+	printf ( "\n" );
+
+	// Each move starts where the last left the axes.
+	double Positions [ PICSERVOGROUPPLANBENCH_AXES ] = { 0 };
+
+	for ( uint32_t Count = 2; Count <= PICSERVOGROUPPLANBENCH_AXES; Count *= 2 )
+	{
+
+		Passed &= RunMove ( & Planner, Controller, & Simulator, Count, Positions );
+
+		for ( uint32_t i = 0; i < Count; i ++ )
+			Positions [ i ] = Planner.GetProfile ( i ) -> GetEnd ();
+
+	}
+
+	printf ( "\n" );
+
+	Passed &= RunProfiler ( Controller );
+
+	printf ( "\nsimulator: %u frames, %u checksum errors, %u reply collisions\n", Simulator.GetFramesReceived (), Simulator.GetChecksumErrors (), Simulator.GetCollisions () );
+
+	printf ( "%s\n", Passed ? "PASSED" : "FAILED" );
+
+	// The controller's tasks are still running, so leave without tearing them down.
+	fflush ( stdout );
+	_exit ( Passed ? 0 : 1 );
+
+};
+
+#endif
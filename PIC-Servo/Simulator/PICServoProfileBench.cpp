@@ -0,0 +1,290 @@
+/*
+* Host benchmark: checks PICServoProfile moves against their limits, then times planning and per-tick evaluation.
+*
+* Random moves, trapezoidal and jerk limited, are sampled end to end. Each must start and finish at rest on its end
+* points, never pass its velocity or acceleration limit, never back up, and have a velocity that agrees with its
+* position from one sample to the next. Every move is checked again after stretching it to a longer duration.
+* Evaluation is timed at the servo rate over short and long moves, which should cost the same, and at random times,
+* which make the segment search start over.
+*
+* Build and run from the repository root:
+*
+*   g++ -std=gnu++98 -fpermissive -O2 -pthread -I PIC-Servo/Simulator/Host PIC-Servo/Simulator/PICServoProfileBench.cpp
+*       PIC-Servo/Simulator/Host/HostWPILib.cpp PIC-Servo/PICServoProfile.cpp -o PICServoProfileBench
+*   ./PICServoProfileBench [ moves ]
+*/
+
+#if defined ( __linux__ )
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "WPILib.h"
+
+#include "../PICServoProfile.h"
+
+// Same rate the modules servo at, from PICServo.h, without pulling the controller in.
+#define PICSERVOPROFILEBENCH_TICK ( 1.0 / 1953.125 )
+
+#define PICSERVOPROFILEBENCH_SAMPLES 4000
+#define PICSERVOPROFILEBENCH_TOLERANCE 1e-9
+
+static uint32_t RandomState = 0x2605;
+
+static double Random ( double Low, double High )
+{
+
+	RandomState ^= RandomState << 13;
+	RandomState ^= RandomState >> 17;
+	RandomState ^= RandomState << 5;
+
+	return Low + ( High - Low ) * ( RandomState / 4294967296.0 );
+
+};
+
+// Log uniform, so short and long moves both get tried.
+static double RandomScale ( double Low, double High )
+{
+
+	return exp ( Random ( log ( Low ), log ( High ) ) );
+
+};
+
+typedef struct Limits_t
+{
+
+	double Velocity;
+	double Acceleration;
+
+} Limits_t;
+
+// Returns a description of the first thing wrong with the move, or NULL.
+static const char * CheckMove ( PICServoProfile * Profile, Limits_t Limits )
+{
+
+	double Duration = Profile -> GetDuration ();
+	double Start = Profile -> GetStart ();
+	double End = Profile -> GetEnd ();
+
+	double Direction = ( End < Start ) ? - 1.0 : 1.0;
+	double Scale = 1 + fabs ( End - Start );
+
+	double Position;
+	double Velocity;
+	double Acceleration;
+
+	Profile -> Evaluate ( 0, & Position, & Velocity, & Acceleration );
+
+	if ( fabs ( Position - Start ) > PICSERVOPROFILEBENCH_TOLERANCE * Scale || Velocity != 0 )
+		return "doesn't start at rest on its start";
+
+	Profile -> Evaluate ( Duration, & Position, & Velocity, & Acceleration );
+
+	if ( Position != End || Velocity != 0 || Acceleration != 0 )
+		return "doesn't finish at rest on its end";
+
+	if ( Profile -> GetPeakVelocity () > Limits.Velocity * ( 1 + PICSERVOPROFILEBENCH_TOLERANCE ) )
+		return "peak velocity over the limit";
+
+	double Step = Duration / PICSERVOPROFILEBENCH_SAMPLES;
+
+	double LastPosition = Start;
+	double LastVelocity = 0;
+
+	for ( uint32_t i = 1; i <= PICSERVOPROFILEBENCH_SAMPLES; i ++ )
+	{
+
+		Profile -> Evaluate ( i * Step, & Position, & Velocity, & Acceleration );
+
+		if ( fabs ( Velocity ) > Limits.Velocity * ( 1 + PICSERVOPROFILEBENCH_TOLERANCE ) )
+			return "velocity over the limit";
+
+		if ( fabs ( Acceleration ) > Limits.Acceleration * ( 1 + PICSERVOPROFILEBENCH_TOLERANCE ) )
+			return "acceleration over the limit";
+
+		if ( Direction * ( Position - LastPosition ) < - PICSERVOPROFILEBENCH_TOLERANCE * Scale )
+			return "backs up";
+
+		// Over one sample the position moves by the mean velocity, give or take what the acceleration can add.
+		if ( fabs ( Position - LastPosition - Step * ( Velocity + LastVelocity ) / 2 ) > Limits.Acceleration * Step * Step + PICSERVOPROFILEBENCH_TOLERANCE * Scale )
+			return "position and velocity disagree";
+
+		if ( fabs ( Velocity - LastVelocity ) > Limits.Acceleration * Step * ( 1 + PICSERVOPROFILEBENCH_TOLERANCE ) + PICSERVOPROFILEBENCH_TOLERANCE )
+			return "velocity jumps";
+
+		LastPosition = Position;
+		LastVelocity = Velocity;
+
+	}
+
+	return NULL;
+
+};
+
+static double TimeTicks ( PICServoProfile * Profile, uint32_t Ticks, double * Sink )
+{
+
+	double Position;
+	double Velocity;
+
+	double Start = Timer :: GetPPCTimestamp ();
+
+	for ( uint32_t i = 0; i < Ticks; i ++ )
+	{
+
+		Profile -> Evaluate ( i * PICSERVOPROFILEBENCH_TICK, & Position, & Velocity );
+
+		* Sink += Position + Velocity;
+
+	}
+
+	return 1e9 * ( Timer :: GetPPCTimestamp () - Start ) / Ticks;
+
+};
+
+int main ( int argc, char ** argv )
+{
+
+	uint32_t Moves = ( argc > 1 ) ? atoi ( argv [ 1 ] ) : 20000;
+
+	uint32_t Failures = 0;
+
+	for ( uint32_t i = 0; i < Moves; i ++ )
+	{
+
+		PICServoProfile Profile;
+
+		double Start = Random ( - 50, 50 );
+		double Distance = RandomScale ( 0.001, 100 ) * ( ( i & 1 ) ? - 1 : 1 );
+
+		Limits_t Limits = { RandomScale ( 0.5, 20 ), RandomScale ( 1, 200 ) };
+
+		// Every third move is a plain trapezoid.
+		double Jerk = ( i % 3 == 0 ) ? 0 : RandomScale ( 10, 5000 );
+
+		if ( ! Profile.Plan ( Start, Start + Distance, Limits.Velocity, Limits.Acceleration, Jerk ) )
+		{
+
+			printf ( "move %u: Plan refused valid limits\n", i );
+			Failures ++;
+
+			continue;
+
+		}
+
+		const char * Problem = CheckMove ( & Profile, Limits );
+
+		double S = Random ( 1, 4 );
+
+		if ( Problem == NULL )
+		{
+
+			double Duration = Profile.GetDuration ();
+
+			if ( ! Profile.Stretch ( Duration * S ) || fabs ( Profile.GetDuration () - Duration * S ) > PICSERVOPROFILEBENCH_TOLERANCE * Duration * S )
+				Problem = "didn't stretch to the duration asked for";
+			else
+			{
+
+				Limits_t Stretched = { Limits.Velocity / S, Limits.Acceleration / ( S * S ) };
+
+				Problem = CheckMove ( & Profile, Stretched );
+
+			}
+
+		}
+
+		if ( Problem != NULL )
+		{
+
+			if ( Failures < 10 )
+				printf ( "move %u ( %g to %g, v %g, a %g, j %g, stretch %g ): %s\n", i, Start, Start + Distance, Limits.Velocity, Limits.Acceleration, Jerk, S, Problem );
+
+			Failures ++;
+
+		}
+
+	}
+
+	printf ( "%u moves, each sampled %u times before and after stretching: %u failures\n", Moves, PICSERVOPROFILEBENCH_SAMPLES, Failures );
+
+	double Sink = 0;
+
+	// Planning.
+	PICServoProfile Profile;
+
+	uint32_t Plans = 1000000;
+	double Start = Timer :: GetPPCTimestamp ();
+
+	for ( uint32_t i = 0; i < Plans; i ++ )
+	{
+
+		Profile.Plan ( 0, 1 + ( i & 63 ), 10, 40, ( i & 1 ) ? 400 : 0 );
+
+		Sink += Profile.GetDuration ();
+
+	}
+
+	printf ( "Plan:                         %7.1f ns\n", 1e9 * ( Timer :: GetPPCTimestamp () - Start ) / Plans );
+
+	// Per tick, a quarter second move against a sixty second one.
+	Profile.Plan ( 0, 0.5, 10, 40, 400 );
+
+	double Short = Profile.GetDuration ();
+	uint32_t ShortTicks = static_cast <uint32_t> ( Short / PICSERVOPROFILEBENCH_TICK ) + 1;
+
+	double ShortCost = 0;
+
+	for ( uint32_t i = 0; i < 1000; i ++ )
+		ShortCost += TimeTicks ( & Profile, ShortTicks, & Sink ) / 1000;
+
+	Profile.Plan ( 0, 590, 10, 40, 400 );
+
+	double Long = Profile.GetDuration ();
+	uint32_t LongTicks = static_cast <uint32_t> ( Long / PICSERVOPROFILEBENCH_TICK ) + 1;
+
+	double LongCost = 0;
+
+	for ( uint32_t i = 0; i < 10; i ++ )
+		LongCost += TimeTicks ( & Profile, LongTicks, & Sink ) / 10;
+
+	printf ( "Evaluate, %6.2f s move:      %7.1f ns per tick over %u ticks\n", Short, ShortCost, ShortTicks );
+	printf ( "Evaluate, %6.2f s move:      %7.1f ns per tick over %u ticks\n", Long, LongCost, LongTicks );
+
+	// Random times, so the segment search mostly starts over from the first segment.
+	const uint32_t Times = 4096;
+	double RandomTimes [ Times ];
+
+	for ( uint32_t i = 0; i < Times; i ++ )
+		RandomTimes [ i ] = Random ( 0, Long );
+
+	uint32_t Evaluations = 4000000;
+	double Position;
+	double Velocity;
+
+	Start = Timer :: GetPPCTimestamp ();
+
+	for ( uint32_t i = 0; i < Evaluations; i ++ )
+	{
+
+		Profile.Evaluate ( RandomTimes [ i & ( Times - 1 ) ], & Position, & Velocity );
+
+		Sink += Position + Velocity;
+
+	}
+
+	printf ( "Evaluate, random times:       %7.1f ns\n", 1e9 * ( Timer :: GetPPCTimestamp () - Start ) / Evaluations );
+
+	// Keeps the timed loops from being optimized out.
+	if ( Sink == 0.123 )
+		printf ( "\n" );
+
+	bool Passed = ( Failures == 0 );
+
+	printf ( "%s\n", Passed ? "PASSED" : "FAILED" );
+
+	return Passed ? 0 : 1;
+
+};
+
+#endif
@@ -0,0 +1,977 @@
+#if defined ( __linux__ ) && ! defined ( _XOPEN_SOURCE )
+	#define _XOPEN_SOURCE 600
+#endif
+
+#include "PICServoSimulator.h"
+
+#if defined ( __linux__ )
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/select.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+PICServoSimulator :: PICServoSimulator ( uint32_t ModuleCount, uint32_t BaudRate )
+{
+
+	if ( ModuleCount > PICSERVOSIM_MAX_MODULES )
+		ModuleCount = PICSERVOSIM_MAX_MODULES;
+
+	this -> ModuleCount = ModuleCount;
+	this -> BaudRate = BaudRate;
+
+	ReplyDelay = PICSERVOSIM_REPLY_DELAY;
+
+	for ( uint32_t i = 0; i < ModuleCount; i ++ )
+		ResetModule ( & Modules [ i ] );
+
+	Master = - 1;
+	DevicePath [ 0 ] = 0;
+
+	FrameLength = 0;
+	FrameExpected = 0;
+
+	FramesReceived = 0;
+	ChecksumErrors = 0;
+
+	LastUpdate = Now ();
+
+	ArrivalTime = 0;
+	PendingTicks = 0;
+	HeldCount = 0;
+	ReplyLineFree = 0;
+
+	Collisions = 0;
+
+};
+
+PICServoSimulator :: ~PICServoSimulator ()
+{
+
+	if ( Master >= 0 )
+		close ( Master );
+
+};
+
+/**
+* Create the pseudo-terminal. Point the code under test at GetDevicePath ().
+*/
+bool PICServoSimulator :: Open ()
+{
+
+	Master = posix_openpt ( O_RDWR | O_NOCTTY );
+
+	if ( Master < 0 )
+		return false;
+
+	if ( grantpt ( Master ) != 0 || unlockpt ( Master ) != 0 )
+	{
+
+		close ( Master );
+		Master = - 1;
+
+		return false;
+
+	}
+
+	strncpy ( DevicePath, ptsname ( Master ), sizeof ( DevicePath ) - 1 );
+	DevicePath [ sizeof ( DevicePath ) - 1 ] = 0;
+
+	// Raw bytes both ways, the same as a serial line.
+	struct termios Settings;
+
+	if ( tcgetattr ( Master, & Settings ) == 0 )
+	{
+
+		cfmakeraw ( & Settings );
+		tcsetattr ( Master, TCSANOW, & Settings );
+
+	}
+
+	return true;
+
+};
+
+const char * PICServoSimulator :: GetDevicePath ()
+{
+
+	return DevicePath;
+
+};
+
+/**
+* Baud rate used to pace commands and replies. SET_BAUD commands change it too.
+*/
+void PICServoSimulator :: SetBaudRate ( uint32_t BaudRate )
+{
+
+	this -> BaudRate = BaudRate;
+
+};
+
+/**
+* Time a module takes between the end of a command and the start of its reply.
+*/
+void PICServoSimulator :: SetReplyDelay ( double Delay )
+{
+
+	ReplyDelay = Delay;
+
+};
+
+void PICServoSimulator :: Run ()
+{
+
+	while ( true )
+		Step ( 0.001 );
+
+};
+
+/**
+* Handle whatever bytes have arrived, waiting at most Timeout seconds for some, then advance the motor models.
+*/
+void PICServoSimulator :: Step ( double Timeout )
+{
+
+	uint8_t Buffer [ PICSERVOSIM_READ_SIZE ];
+	double Seen [ PICSERVOSIM_READ_SIZE ];
+
+	// Bytes picked up while a frame was being answered go first, each starting down the line when it turned up, since
+	// the host can't have written it any sooner. Answering these can pick up more.
+	while ( HeldCount != 0 )
+	{
+
+		uint32_t Count = HeldCount;
+
+		memcpy ( Buffer, Held, Count );
+		memcpy ( Seen, HeldSeen, Count * sizeof ( double ) );
+
+		HeldCount = 0;
+
+		for ( uint32_t i = 0; i < Count; i ++ )
+			Receive ( Buffer [ i ], Seen [ i ] );
+
+	}
+
+	struct pollfd Poll;
+
+	Poll.fd = Master;
+	Poll.events = POLLIN;
+	Poll.revents = 0;
+
+	if ( poll ( & Poll, 1, static_cast <int> ( Timeout * 1000 ) ) > 0 && ( Poll.revents & POLLIN ) )
+	{
+
+		ssize_t Count = read ( Master, Buffer, sizeof ( Buffer ) );
+
+		double Earliest = Now ();
+
+		for ( ssize_t i = 0; i < Count; i ++ )
+			Receive ( Buffer [ i ], Earliest );
+
+	}
+
+	double Time = Now ();
+
+	Update ( Time - LastUpdate );
+
+	LastUpdate = Time;
+
+};
+
+uint32_t PICServoSimulator :: GetFramesReceived ()
+{
+
+	return FramesReceived;
+
+};
+
+uint32_t PICServoSimulator :: GetChecksumErrors ()
+{
+
+	return ChecksumErrors;
+
+};
+
+/**
+* Replies that would have started on the shared reply line before the one ahead of them was done.
+*/
+uint32_t PICServoSimulator :: GetCollisions ()
+{
+
+	return Collisions;
+
+};
+
+/**
+* When the module at Address started its last trajectory, and when it finished. Read without locking while the
+* simulator runs, so only ask once the move should be over.
+*
+* @return False if no module has that address, or its move hasn't finished.
+*/
+bool PICServoSimulator :: GetMoveTimes ( uint8_t Address, double * Started, double * Finished )
+{
+
+	for ( uint32_t i = 0; i < ModuleCount; i ++ )
+	{
+
+		if ( Modules [ i ].Address != Address )
+			continue;
+
+		* Started = Modules [ i ].MoveStarted;
+		* Finished = Modules [ i ].MoveFinished;
+
+		return Modules [ i ].MoveFinished != 0;
+
+	}
+
+	return false;
+
+};
+
+void PICServoSimulator :: ResetModule ( SimulatedModule * Module )
+{
+
+	memset ( Module, 0, sizeof ( SimulatedModule ) );
+
+	Module -> Address = 0;
+	Module -> GroupAddress = 0xFF;
+	Module -> StatusByte = PICSERVOSIM_STATUS_POWER_ON | PICSERVOSIM_STATUS_MOVE_DONE;
+	Module -> Mode = kModeIdle;
+
+};
+
+/*
+* Frames are 0xAA, address, command, data ( upper nibble of the command gives its length ), checksum. Each byte takes
+* a byte time on the line, starting no sooner than Earliest, and a frame is acted on once its last byte is in.
+*/
+void PICServoSimulator :: Receive ( uint8_t Byte, double Earliest )
+{
+
+	if ( ArrivalTime < Earliest )
+		ArrivalTime = Earliest;
+
+	ArrivalTime += 10.0 / static_cast <double> ( BaudRate );
+
+	if ( FrameLength == 0 )
+	{
+
+		if ( Byte == 0xAA )
+			Frame [ FrameLength ++ ] = Byte;
+
+		return;
+
+	}
+
+	Frame [ FrameLength ++ ] = Byte;
+
+	if ( FrameLength == 3 )
+		FrameExpected = 4 + ( Frame [ 2 ] >> 4 );
+
+	if ( FrameLength >= 3 && FrameLength == FrameExpected )
+	{
+
+		Pause ( ArrivalTime );
+
+		Execute ();
+
+		FrameLength = 0;
+
+	}
+
+};
+
+void PICServoSimulator :: Execute ()
+{
+
+	// Run the motor models up to now first, so the frame takes effect from when it landed. Frames can be answered one
+	// after another for a while before Step gets around to it.
+	double Time = Now ();
+
+	Update ( Time - LastUpdate );
+
+	LastUpdate = Time;
+
+	uint8_t Sum = 0;
+
+	for ( uint32_t i = 1; i < FrameLength - 1; i ++ )
+		Sum += Frame [ i ];
+
+	uint8_t Address = Frame [ 1 ];
+	uint8_t Command = Frame [ 2 ];
+
+	FramesReceived ++;
+
+	bool Valid = ( Sum == Frame [ FrameLength - 1 ] );
+
+	if ( ! Valid )
+		ChecksumErrors ++;
+
+	for ( uint32_t i = 0; i < ModuleCount; i ++ )
+	{
+
+		SimulatedModule * Module = & Modules [ i ];
+
+		bool Individual = ( Module -> Address == Address );
+		bool Group = ( Address >= PICSERVO_GROUP_ADDRESS_BASE && Module -> GroupAddress == Address );
+
+		if ( ! Individual && ! Group )
+			continue;
+
+		// A module that sees a bad checksum flags it and doesn't act on the frame.
+		if ( ! Valid )
+		{
+
+			Module -> StatusByte |= PICSERVOSIM_STATUS_CHECKSUM_ERROR;
+
+			continue;
+
+		}
+
+		Execute ( Module, Command, & Frame [ 3 ], FrameLength - 4, Individual );
+
+		// Addresses are unique, so only one module answers an individual frame.
+		if ( Individual )
+			break;
+
+	}
+
+};
+
+void PICServoSimulator :: Execute ( SimulatedModule * Module, uint8_t Command, const uint8_t * Data, uint8_t DataSize, bool Reply )
+{
+
+	uint8_t StatusType = Module -> StatusType;
+
+	switch ( Command & 0x0F )
+	{
+
+	case PICSERVO_COMMAND_RESET_POS:
+
+		if ( DataSize == 5 && ( Data [ 0 ] & 0x02 ) )
+			Module -> Position = static_cast <int32_t> ( Data [ 1 ] | ( Data [ 2 ] << 8 ) | ( Data [ 3 ] << 16 ) | ( static_cast <uint32_t> ( Data [ 4 ] ) << 24 ) );
+		else
+			Module -> Position = 0;
+
+		Module -> GoalPosition = Module -> Position;
+
+		break;
+
+	case PICSERVO_COMMAND_SET_ADDR:
+
+		if ( DataSize >= 2 )
+		{
+
+			Module -> Address = Data [ 0 ];
+			Module -> GroupAddress = Data [ 1 ];
+
+		}
+
+		break;
+
+	case PICSERVO_COMMAND_DEF_STAT:
+
+		if ( DataSize >= 1 )
+			Module -> StatusType = StatusType = Data [ 0 ];
+
+		break;
+
+	case PICSERVO_COMMAND_READ_STAT:
+
+		if ( DataSize >= 1 )
+			StatusType = Data [ 0 ];
+
+		break;
+
+	case PICSERVO_COMMAND_LOAD_TRAJ:
+	{
+
+		if ( DataSize < 1 )
+			break;
+
+		uint8_t Control = Data [ 0 ];
+		uint32_t Index = 1;
+
+		int32_t Position = 0;
+		double Velocity = 0;
+		double Acceleration = 0;
+		int16_t PWM = 0;
+
+		if ( ( Control & 0x01 ) && Index + 4 <= DataSize )
+		{
+
+			Position = static_cast <int32_t> ( Data [ Index ] | ( Data [ Index + 1 ] << 8 ) | ( Data [ Index + 2 ] << 16 ) | ( static_cast <uint32_t> ( Data [ Index + 3 ] ) << 24 ) );
+			Index += 4;
+
+		}
+
+		// Velocity and acceleration are 16.16 fixed point, in counts per servo tick.
+		if ( ( Control & 0x02 ) && Index + 4 <= DataSize )
+		{
+
+			Velocity = static_cast <double> ( Data [ Index ] | ( Data [ Index + 1 ] << 8 ) | ( Data [ Index + 2 ] << 16 ) | ( static_cast <uint32_t> ( Data [ Index + 3 ] ) << 24 ) ) / 65536.0;
+			Index += 4;
+
+		}
+
+		if ( ( Control & 0x04 ) && Index + 4 <= DataSize )
+		{
+
+			Acceleration = static_cast <double> ( Data [ Index ] | ( Data [ Index + 1 ] << 8 ) | ( Data [ Index + 2 ] << 16 ) | ( static_cast <uint32_t> ( Data [ Index + 3 ] ) << 24 ) ) / 65536.0;
+			Index += 4;
+
+		}
+
+		if ( ( Control & 0x08 ) && Index + 1 <= DataSize )
+			PWM = Data [ Index ];
+
+		if ( Control & 0x80 )
+			LoadTrajectory ( Module, Control, Position, Velocity, Acceleration, PWM );
+		else
+		{
+
+			Module -> PendingControl = Control | 0x80;
+			Module -> PendingPosition = Position;
+			Module -> PendingVelocity = Velocity;
+			Module -> PendingAcceleration = Acceleration;
+			Module -> PendingPWM = PWM;
+			Module -> HasPending = true;
+
+		}
+
+		break;
+
+	}
+
+	case PICSERVO_COMMAND_START_MOVE:
+
+		if ( Module -> HasPending )
+		{
+
+			LoadTrajectory ( Module, Module -> PendingControl, Module -> PendingPosition, Module -> PendingVelocity, Module -> PendingAcceleration, Module -> PendingPWM );
+
+			Module -> HasPending = false;
+
+		}
+
+		break;
+
+	case PICSERVO_COMMAND_STOP_MOTOR:
+
+		if ( DataSize >= 1 )
+		{
+
+			Module -> ServoEnabled = ( Data [ 0 ] & 0x01 ) != 0 && ( Data [ 0 ] & 0x02 ) == 0;
+			Module -> Mode = Module -> ServoEnabled ? kModePosition : kModeIdle;
+			Module -> GoalPosition = Module -> Position;
+
+			if ( Data [ 0 ] & 0x04 )
+				Module -> Velocity = 0;
+
+		}
+
+		Module -> PathRunning = false;
+
+		break;
+
+	case PICSERVO_COMMAND_IO_CTRL:
+
+		if ( DataSize >= 1 )
+			Module -> IOControl = Data [ 0 ];
+
+		break;
+
+	case PICSERVO_COMMAND_SET_BAUD:
+
+		// The divisor is for a 20 MHz clock, 16 clocks per bit.
+		if ( DataSize >= 1 && ! Reply )
+		{
+
+			double Baud = 20000000.0 / ( 16.0 * ( Data [ 0 ] + 1 ) );
+
+			static const uint32_t Standard [] = { 9600, 19200, 38400, 57600, 115200, 230400 };
+
+			uint32_t Best = Standard [ 0 ];
+
+			for ( uint32_t i = 1; i < sizeof ( Standard ) / sizeof ( Standard [ 0 ] ); i ++ )
+			{
+
+				if ( fabs ( Standard [ i ] - Baud ) < fabs ( Best - Baud ) )
+					Best = Standard [ i ];
+
+			}
+
+			BaudRate = Best;
+
+		}
+
+		break;
+
+	case PICSERVO_COMMAND_CLEAR_BITS:
+
+		Module -> StatusByte &= ~ ( PICSERVOSIM_STATUS_CHECKSUM_ERROR | PICSERVOSIM_STATUS_POSITION_ERROR );
+
+		break;
+
+	case PICSERVO_COMMAND_SAVE_AS_HOME:
+
+		Module -> HomePosition = Module -> Position;
+
+		break;
+
+	case PICSERVO_COMMAND_ADD_PATHPOINT:
+
+		if ( DataSize == 0 )
+		{
+
+			if ( Module -> PathLength != 0 )
+			{
+
+				Module -> Mode = kModePath;
+				Module -> PathRunning = true;
+				Module -> PathTime = 0;
+
+			}
+
+			break;
+
+		}
+
+		// Points carry the low 16 bits of the position, and are extended from the previous point.
+		for ( uint8_t i = 0; i + 1 < DataSize && Module -> PathLength < PICSERVOSIM_PATH_BUFFER_SIZE; i += 2 )
+		{
+
+			uint16_t Low = Data [ i ] | ( Data [ i + 1 ] << 8 );
+			int32_t Point = Module -> LastPathPoint + static_cast <int16_t> ( Low - static_cast <uint16_t> ( Module -> LastPathPoint & 0xFFFF ) );
+
+			Module -> Path [ ( Module -> PathHead + Module -> PathLength ) % PICSERVOSIM_PATH_BUFFER_SIZE ] = Point;
+			Module -> PathLength ++;
+			Module -> LastPathPoint = Point;
+
+		}
+
+		break;
+
+	case PICSERVO_COMMAND_HARD_RESET:
+
+		ResetModule ( Module );
+
+		return;
+
+	default:
+
+		break;
+
+	}
+
+	if ( Reply )
+		SendStatus ( Module, StatusType );
+
+};
+
+void PICServoSimulator :: LoadTrajectory ( SimulatedModule * Module, uint8_t Control, int32_t Position, double Velocity, double Acceleration, int16_t PWM )
+{
+
+	if ( Control & 0x02 )
+		Module -> GoalVelocity = Velocity;
+
+	if ( Control & 0x04 )
+		Module -> Acceleration = Acceleration;
+
+	Module -> ServoEnabled = ( Control & 0x10 ) != 0;
+
+	if ( Control & 0x08 )
+	{
+
+		Module -> PWM = ( Control & 0x40 ) ? - PWM : PWM;
+		Module -> Mode = kModePWM;
+
+	}
+	else if ( Control & 0x20 )
+	{
+
+		if ( Control & 0x40 )
+			Module -> GoalVelocity = - fabs ( Module -> GoalVelocity );
+		else
+			Module -> GoalVelocity = fabs ( Module -> GoalVelocity );
+
+		Module -> Mode = kModeVelocity;
+
+	}
+	else if ( Control & 0x01 )
+	{
+
+		Module -> GoalPosition = ( Control & 0x40 ) ? Module -> Position + Position : Position;
+		Module -> Mode = kModePosition;
+
+	}
+
+	Module -> PathRunning = false;
+	Module -> StatusByte &= ~ PICSERVOSIM_STATUS_MOVE_DONE;
+
+	Module -> MoveStarted = Now ();
+	Module -> MoveFinished = 0;
+
+};
+
+/*
+* Replies are paced one byte at a time at the simulated baud rate. A byte is written once its stop bit would be in,
+* since that's when the host can first read it.
+*/
+void PICServoSimulator :: SendStatus ( SimulatedModule * Module, uint8_t Type )
+{
+
+	uint8_t Reply [ 20 ];
+	uint32_t Length = 0;
+
+	Reply [ Length ++ ] = Module -> StatusByte;
+
+	if ( Type & PICSERVO_STATUS_TYPE_POSITION )
+	{
+
+		uint32_t Position = static_cast <uint32_t> ( static_cast <int32_t> ( Module -> Position ) );
+
+		Reply [ Length ++ ] = Position;
+		Reply [ Length ++ ] = Position >> 8;
+		Reply [ Length ++ ] = Position >> 16;
+		Reply [ Length ++ ] = Position >> 24;
+
+	}
+
+	if ( Type & PICSERVO_STATUS_TYPE_CURRENT_SENSE )
+		Reply [ Length ++ ] = static_cast <uint8_t> ( fabs ( Module -> Velocity ) * 255.0 / PICSERVOSIM_MAX_SPEED );
+
+	if ( Type & PICSERVO_STATUS_TYPE_ENCODER_VELOCITY )
+	{
+
+		uint16_t Velocity = static_cast <uint16_t> ( static_cast <int16_t> ( Module -> Velocity ) );
+
+		Reply [ Length ++ ] = Velocity;
+		Reply [ Length ++ ] = Velocity >> 8;
+
+	}
+
+	if ( Type & PICSERVO_STATUS_TYPE_AUXILIARY_STATUS )
+		Reply [ Length ++ ] = Module -> AuxiliaryStatus;
+
+	if ( Type & PICSERVO_STATUS_TYPE_HOME_POSITION )
+	{
+
+		uint32_t Home = static_cast <uint32_t> ( static_cast <int32_t> ( Module -> HomePosition ) );
+
+		Reply [ Length ++ ] = Home;
+		Reply [ Length ++ ] = Home >> 8;
+		Reply [ Length ++ ] = Home >> 16;
+		Reply [ Length ++ ] = Home >> 24;
+
+	}
+
+	if ( Type & PICSERVO_STATUS_TYPE_DEVICE_TYPE_VERSION )
+	{
+
+		Reply [ Length ++ ] = 0x00;
+		Reply [ Length ++ ] = 0x0A;
+
+	}
+
+	if ( Type & PICSERVO_STATUS_TYPE_SERVO_ERROR )
+	{
+
+		uint16_t Error = static_cast <uint16_t> ( static_cast <int16_t> ( Module -> GoalPosition - Module -> Position ) );
+
+		Reply [ Length ++ ] = Error;
+		Reply [ Length ++ ] = Error >> 8;
+
+	}
+
+	if ( Type & PICSERVO_STATUS_TYPE_PATH_REMAINING )
+		Reply [ Length ++ ] = Module -> PathLength;
+
+	uint8_t Sum = 0;
+
+	for ( uint32_t i = 0; i < Length; i ++ )
+		Sum += Reply [ i ];
+
+	Reply [ Length ++ ] = Sum;
+
+	// Ten bit times per byte: start, eight data, stop.
+	double ByteTime = 10.0 / static_cast <double> ( BaudRate );
+
+	// Every module answers on the same line, so a reply due before the last one is done would have garbled both. The
+	// check goes by when replies were due rather than when they went out, so the simulator running late isn't taken
+	// for a collision. The host only ever sees replies later than they were due, so it can't get away with one either.
+	double Due = ArrivalTime + ReplyDelay;
+
+	if ( Due < ReplyLineFree )
+		Collisions ++;
+
+	ReplyLineFree = Due + Length * ByteTime;
+
+	if ( Due < Now () )
+		Due = Now ();
+
+	for ( uint32_t i = 0; i < Length; i ++ )
+	{
+
+		Due += ByteTime;
+
+		Pause ( Due );
+
+		if ( write ( Master, & Reply [ i ], 1 ) != 1 )
+			return;
+
+	}
+
+};
+
+/*
+* Sleep until Until, reading whatever the host writes meanwhile into Held, so Step knows when each byte turned up.
+*/
+void PICServoSimulator :: Pause ( double Until )
+{
+
+	while ( HeldCount < PICSERVOSIM_READ_SIZE )
+	{
+
+		double Left = Until - Now ();
+
+		if ( Left <= 0 )
+			return;
+
+		fd_set Readable;
+
+		FD_ZERO ( & Readable );
+		FD_SET ( Master, & Readable );
+
+		struct timeval Wait;
+
+		Wait.tv_sec = static_cast <time_t> ( Left );
+		Wait.tv_usec = static_cast <suseconds_t> ( ( Left - Wait.tv_sec ) * 1000000.0 );
+
+		if ( select ( Master + 1, & Readable, NULL, NULL, & Wait ) <= 0 )
+			continue;
+
+		ssize_t Count = read ( Master, & Held [ HeldCount ], PICSERVOSIM_READ_SIZE - HeldCount );
+
+		// Nothing comes in while the host has the port closed, as it does to change baud rates.
+		if ( Count <= 0 )
+			break;
+
+		double Time = Now ();
+
+		for ( ssize_t i = 0; i < Count; i ++ )
+			HeldSeen [ HeldCount ++ ] = Time;
+
+	}
+
+	double Left = Until - Now ();
+
+	if ( Left > 0 )
+		usleep ( static_cast <useconds_t> ( Left * 1000000.0 ) );
+
+};
+
+void PICServoSimulator :: Update ( double Elapsed )
+{
+
+	double Time = Now ();
+
+	// A whole servo tick at a time, as the modules run, so the motor models don't depend on how often Step () runs.
+	PendingTicks += Elapsed * PICSERVOSIM_SERVO_RATE;
+
+	while ( PendingTicks >= 1.0 )
+	{
+
+		PendingTicks -= 1.0;
+
+		// When this tick came due, which is earlier than now if the simulator is catching up.
+		double TickTime = Time - PendingTicks / PICSERVOSIM_SERVO_RATE;
+
+		for ( uint32_t i = 0; i < ModuleCount; i ++ )
+		{
+
+			bool WasDone = ( Modules [ i ].StatusByte & PICSERVOSIM_STATUS_MOVE_DONE ) != 0;
+
+			UpdateModule ( & Modules [ i ], 1.0 );
+
+			if ( ! WasDone && ( Modules [ i ].StatusByte & PICSERVOSIM_STATUS_MOVE_DONE ) )
+				Modules [ i ].MoveFinished = TickTime;
+
+		}
+
+	}
+
+};
+
+// Velocities are in counts per servo tick, and accelerations in counts per tick per tick, as the module uses them.
+void PICServoSimulator :: UpdateModule ( SimulatedModule * Module, double Ticks )
+{
+
+	switch ( Module -> Mode )
+	{
+
+	case kModePWM:
+
+		Module -> Velocity = PICSERVOSIM_MAX_SPEED * Module -> PWM / 255.0;
+		Module -> Position += Module -> Velocity * Ticks;
+
+		break;
+
+	case kModeVelocity:
+	{
+
+		double Step = ( Module -> Acceleration > 0 ) ? Module -> Acceleration * Ticks : fabs ( Module -> GoalVelocity - Module -> Velocity );
+		double Delta = Module -> GoalVelocity - Module -> Velocity;
+
+		if ( fabs ( Delta ) <= Step )
+		{
+
+			Module -> Velocity = Module -> GoalVelocity;
+			Module -> StatusByte |= PICSERVOSIM_STATUS_MOVE_DONE;
+
+		}
+		else
+			Module -> Velocity += ( Delta > 0 ) ? Step : - Step;
+
+		Module -> Position += Module -> Velocity * Ticks;
+
+		break;
+
+	}
+
+	case kModePosition:
+	{
+
+		double Remaining = Module -> GoalPosition - Module -> Position;
+		double Speed = fabs ( Module -> GoalVelocity ) > 0 ? fabs ( Module -> GoalVelocity ) : PICSERVOSIM_MAX_SPEED;
+		double Acceleration = Module -> Acceleration > 0 ? Module -> Acceleration : Speed;
+
+		// Trapezoid: speed up to the velocity limit, and slow down in time to stop on the goal. Slowing by
+		// Acceleration a tick from V covers V^2 / 2A + V / 2, so that's the fastest speed that still stops in time.
+		double StoppingSpeed = sqrt ( Acceleration * Acceleration / 4.0 + 2.0 * Acceleration * fabs ( Remaining ) ) - Acceleration / 2.0;
+		double Target = ( StoppingSpeed < Speed ? StoppingSpeed : Speed ) * ( Remaining >= 0 ? 1.0 : - 1.0 );
+		double Change = Acceleration * Ticks;
+
+		if ( fabs ( Target - Module -> Velocity ) <= Change )
+			Module -> Velocity = Target;
+		else
+			Module -> Velocity += ( Target > Module -> Velocity ) ? Change : - Change;
+
+		double Move = Module -> Velocity * Ticks;
+
+		if ( fabs ( Move ) >= fabs ( Remaining ) )
+		{
+
+			Module -> Position = Module -> GoalPosition;
+			Module -> Velocity = 0;
+			Module -> StatusByte |= PICSERVOSIM_STATUS_MOVE_DONE;
+
+		}
+		else
+			Module -> Position += Move;
+
+		break;
+
+	}
+
+	case kModePath:
+	{
+
+		if ( ! Module -> PathRunning )
+			break;
+
+		double PointTicks = PICSERVOSIM_SERVO_RATE / ( ( Module -> IOControl & 0x40 ) ? 60.0 : 30.0 );
+
+		Module -> PathTime += Ticks;
+
+		while ( Module -> PathTime >= PointTicks && Module -> PathLength != 0 )
+		{
+
+			double Next = Module -> Path [ Module -> PathHead ];
+
+			Module -> Velocity = ( Next - Module -> Position ) / PointTicks;
+			Module -> Position = Next;
+			Module -> GoalPosition = Next;
+
+			Module -> PathHead = ( Module -> PathHead + 1 ) % PICSERVOSIM_PATH_BUFFER_SIZE;
+			Module -> PathLength --;
+			Module -> PathTime -= PointTicks;
+
+		}
+
+		// The path ends when the buffer runs dry, and the module holds position.
+		if ( Module -> PathLength == 0 )
+		{
+
+			Module -> PathRunning = false;
+			Module -> Mode = kModePosition;
+			Module -> Velocity = 0;
+			Module -> StatusByte |= PICSERVOSIM_STATUS_MOVE_DONE;
+
+		}
+
+		break;
+
+	}
+
+	default:
+
+		Module -> Velocity = 0;
+
+		break;
+
+	}
+
+};
+
+double PICServoSimulator :: Now ()
+{
+
+	struct timespec Time;
+
+	clock_gettime ( CLOCK_MONOTONIC, & Time );
+
+	return static_cast <double> ( Time.tv_sec ) + static_cast <double> ( Time.tv_nsec ) * 1e-9;
+
+};
+
+#if defined ( PICSERVOSIM_MAIN )
+
+/*
+* Standalone simulator: PICServoSimulator [ modules [ baud ] ]
+*/
+int main ( int argc, char ** argv )
+{
+
+	uint32_t Count = ( argc > 1 ) ? atoi ( argv [ 1 ] ) : 4;
+	uint32_t Baud = ( argc > 2 ) ? atoi ( argv [ 2 ] ) : PICSERVO_BAUD_RATE_INITIAL;
+
+	PICServoSimulator Simulator ( Count, Baud );
+
+	if ( ! Simulator.Open () )
+	{
+
+		perror ( "PICServoSimulator" );
+
+		return 1;
+
+	}
+
+	printf ( "Simulating %u modules at %u baud on %s\n", Count, Baud, Simulator.GetDevicePath () );
+	fflush ( stdout );
+
+	Simulator.Run ();
+
+	return 0;
+
+};
+
+#endif
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef SHS_2605_PICSERVO_SIMULATOR_H
+#define SHS_2605_PICSERVO_SIMULATOR_H
+
+/*
+* Host-side PIC-SERVO network simulator. Only built on Linux, where it serves the protocol over a pseudo-terminal.
+*/
+
+#if defined ( __linux__ )
+
+#include <stdint.h>
+
+#include "../PICServoProtocol.h"
+
+#define PICSERVOSIM_MAX_MODULES 32
+#define PICSERVOSIM_MAX_FRAME_SIZE 20
+#define PICSERVOSIM_PATH_BUFFER_SIZE 32
+
+#define PICSERVOSIM_SERVO_RATE 1953.125
+#define PICSERVOSIM_MAX_SPEED 20.0
+#define PICSERVOSIM_REPLY_DELAY 0.0002
+
+// Most bytes read from the host at once, or held while a frame is being answered.
+#define PICSERVOSIM_READ_SIZE 256
+
+#define PICSERVOSIM_STATUS_MOVE_DONE 0x01
+#define PICSERVOSIM_STATUS_CHECKSUM_ERROR 0x02
+#define PICSERVOSIM_STATUS_POWER_ON 0x08
+#define PICSERVOSIM_STATUS_POSITION_ERROR 0x10
+
+/*
+* Simulates a chain of PIC-SERVO modules behind one pseudo-terminal.
+*
+* Frames are parsed byte by byte exactly as a module would see them, commands and replies are both paced at the
+* simulated baud rate, and a reply due before the one ahead of it is done counts as a collision. Each module runs a
+* simple motor model at the servo rate: PWM drives velocity directly, velocity mode ramps at the loaded acceleration,
+* position mode runs a trapezoid, and path mode steps through buffered path points.
+*/
+class PICServoSimulator
+{
+public:
+
+	PICServoSimulator ( uint32_t ModuleCount, uint32_t BaudRate = PICSERVO_BAUD_RATE_INITIAL );
+	~PICServoSimulator ();
+
+	bool Open ();
+	const char * GetDevicePath ();
+
+	void SetBaudRate ( uint32_t BaudRate );
+	void SetReplyDelay ( double Delay );
+
+	void Run ();
+	void Step ( double Timeout );
+
+	uint32_t GetFramesReceived ();
+	uint32_t GetChecksumErrors ();
+	uint32_t GetCollisions ();
+
+	bool GetMoveTimes ( uint8_t Address, double * Started, double * Finished );
+
+private:
+
+	typedef struct SimulatedModule
+	{
+
+		uint8_t Address;
+		uint8_t GroupAddress;
+		uint8_t StatusType;
+		uint8_t StatusByte;
+		uint8_t AuxiliaryStatus;
+		uint8_t IOControl;
+
+		double Position;
+		double Velocity;
+		double HomePosition;
+
+		bool ServoEnabled;
+		uint8_t Mode;
+
+		double GoalPosition;
+		double GoalVelocity;
+		double Acceleration;
+		double PWM;
+
+		uint8_t PendingControl;
+		int32_t PendingPosition;
+		double PendingVelocity;
+		double PendingAcceleration;
+		int16_t PendingPWM;
+		bool HasPending;
+
+		int32_t Path [ PICSERVOSIM_PATH_BUFFER_SIZE ];
+		uint32_t PathHead;
+		uint32_t PathLength;
+		int32_t LastPathPoint;
+		bool PathRunning;
+		double PathTime;
+
+		// When the last trajectory was started, and when it set MOVE_DONE. ( Zero until it does )
+		double MoveStarted;
+		double MoveFinished;
+
+	} SimulatedModule;
+
+	enum
+	{
+
+		kModeIdle = 0,
+		kModePWM,
+		kModeVelocity,
+		kModePosition,
+		kModePath
+
+	};
+
+	void ResetModule ( SimulatedModule * Module );
+
+	void Receive ( uint8_t Byte, double Earliest );
+	void Execute ();
+	void Execute ( SimulatedModule * Module, uint8_t Command, const uint8_t * Data, uint8_t DataSize, bool Reply );
+
+	void LoadTrajectory ( SimulatedModule * Module, uint8_t Control, int32_t Position, double Velocity, double Acceleration, int16_t PWM );
+	void SendStatus ( SimulatedModule * Module, uint8_t Type );
+	void Pause ( double Until );
+
+	void Update ( double Elapsed );
+	void UpdateModule ( SimulatedModule * Module, double Ticks );
+
+	static double Now ();
+
+	int Master;
+	char DevicePath [ 128 ];
+
+	uint32_t BaudRate;
+	double ReplyDelay;
+
+	SimulatedModule Modules [ PICSERVOSIM_MAX_MODULES ];
+	uint32_t ModuleCount;
+
+	uint8_t Frame [ PICSERVOSIM_MAX_FRAME_SIZE ];
+	uint32_t FrameLength;
+	uint32_t FrameExpected;
+
+	uint32_t FramesReceived;
+	uint32_t ChecksumErrors;
+
+	// When the last byte received finished arriving on the simulated line.
+	double ArrivalTime;
+
+	// Bytes read while a frame was being answered, and when each turned up, waiting for Step to handle them.
+	uint8_t Held [ PICSERVOSIM_READ_SIZE ];
+	double HeldSeen [ PICSERVOSIM_READ_SIZE ];
+	uint32_t HeldCount;
+
+	// When the last reply would have finished going out, had it started on time.
+	double ReplyLineFree;
+	uint32_t Collisions;
+
+	double LastUpdate;
+
+	// Servo ticks elapsed but not yet run.
+	double PendingTicks;
+
+};
+
+#endif
+
+#endif
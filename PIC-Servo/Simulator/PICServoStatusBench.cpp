@@ -0,0 +1,232 @@
+/*
+* Host benchmark: checks PICServoCom's table-driven status decoder against a byte-by-byte reference walk for all 256
+* status masks, then times both.
+*
+* The reference walks the items in bit order with a cursor, the way the module sends them, so it shares nothing with
+* the layout table. Every mask is decoded from random replies and each field compared, along with the packet size.
+*
+* Build and run from the repository root:
+*
+*   g++ -std=gnu++98 -fpermissive -O2 -pthread -I PIC-Servo/Simulator/Host PIC-Servo/Simulator/PICServoStatusBench.cpp
+*       PIC-Servo/Simulator/Host/HostWPILib.cpp PIC-Servo/PICServoCom.cpp -o PICServoStatusBench
+*   ./PICServoStatusBench [ replies per mask [ passes ] ]
+*/
+
+#if defined ( __linux__ )
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "WPILib.h"
+
+#include "../PICServoCom.h"
+
+#define PICSERVOSTATUSBENCH_MAX_REPLY 32
+
+typedef PICServoCom :: PICServoStatus_t Status_t;
+
+static uint32_t RandomState = 0x2605;
+
+static uint8_t RandomByte ()
+{
+
+	RandomState ^= RandomState << 13;
+	RandomState ^= RandomState >> 17;
+	RandomState ^= RandomState << 5;
+
+	return RandomState & 0xFF;
+
+};
+
+static uint32_t ReferenceTake ( const uint8_t * Bytes, uint32_t * Cursor, uint32_t Count )
+{
+
+	uint32_t Value = 0;
+
+	for ( uint32_t i = 0; i < Count; i ++ )
+		Value |= static_cast <uint32_t> ( Bytes [ ( * Cursor ) ++ ] ) << ( 8 * i );
+
+	return Value;
+
+};
+
+// Returns the reply length, status byte and checksum included.
+static uint32_t ReferenceDecode ( const uint8_t * Bytes, uint8_t Type, Status_t * Status )
+{
+
+	uint32_t Cursor = 0;
+
+	Status -> StandardFlags = ReferenceTake ( Bytes, & Cursor, 1 );
+
+	if ( Type & PICSERVO_STATUS_TYPE_POSITION )
+		Status -> Position = ReferenceTake ( Bytes, & Cursor, 4 );
+
+	if ( Type & PICSERVO_STATUS_TYPE_CURRENT_SENSE )
+		Status -> CurrentSense = ReferenceTake ( Bytes, & Cursor, 1 );
+
+	if ( Type & PICSERVO_STATUS_TYPE_ENCODER_VELOCITY )
+		Status -> EncoderVelocity = ReferenceTake ( Bytes, & Cursor, 2 );
+
+	if ( Type & PICSERVO_STATUS_TYPE_AUXILIARY_STATUS )
+		Status -> AuxiliaryStatus = ReferenceTake ( Bytes, & Cursor, 1 );
+
+	if ( Type & PICSERVO_STATUS_TYPE_HOME_POSITION )
+		Status -> HomePosition = ReferenceTake ( Bytes, & Cursor, 4 );
+
+	if ( Type & PICSERVO_STATUS_TYPE_DEVICE_TYPE_VERSION )
+	{
+
+		Status -> DeviceType = ReferenceTake ( Bytes, & Cursor, 1 );
+		Status -> DeviceVersion = ReferenceTake ( Bytes, & Cursor, 1 );
+
+	}
+
+	if ( Type & PICSERVO_STATUS_TYPE_SERVO_ERROR )
+		Status -> PositionError = ReferenceTake ( Bytes, & Cursor, 2 );
+
+	if ( Type & PICSERVO_STATUS_TYPE_PATH_REMAINING )
+		Status -> PathPointsPending = ReferenceTake ( Bytes, & Cursor, 1 );
+
+	return Cursor + 1;
+
+};
+
+// Fields the reply doesn't carry must come out untouched, so both sides start from the same filler.
+static void Fill ( Status_t * Status )
+{
+
+	Status -> StandardFlags = 0xA5;
+	Status -> Position = 0xA5A5A5A5;
+	Status -> CurrentSense = 0xA5;
+	Status -> EncoderVelocity = 0xA5A5;
+	Status -> AuxiliaryStatus = 0xA5;
+	Status -> HomePosition = 0xA5A5A5A5;
+	Status -> DeviceType = 0xA5;
+	Status -> DeviceVersion = 0xA5;
+	Status -> PositionError = 0xA5A5;
+	Status -> PathPointsPending = 0xA5;
+
+};
+
+static bool Same ( const Status_t * A, const Status_t * B )
+{
+
+	return A -> StandardFlags == B -> StandardFlags && A -> Position == B -> Position && A -> CurrentSense == B -> CurrentSense && A -> EncoderVelocity == B -> EncoderVelocity && A -> AuxiliaryStatus == B -> AuxiliaryStatus && A -> HomePosition == B -> HomePosition && A -> DeviceType == B -> DeviceType && A -> DeviceVersion == B -> DeviceVersion && A -> PositionError == B -> PositionError && A -> PathPointsPending == B -> PathPointsPending;
+
+};
+
+int main ( int argc, char ** argv )
+{
+
+	uint32_t Replies = ( argc > 1 ) ? atoi ( argv [ 1 ] ) : 1000;
+	uint32_t Passes = ( argc > 2 ) ? atoi ( argv [ 2 ] ) : 20000;
+
+	uint32_t SizeMismatches = 0;
+	uint32_t FieldMismatches = 0;
+
+	for ( uint32_t Type = 0; Type < 256; Type ++ )
+	{
+
+		for ( uint32_t i = 0; i < Replies; i ++ )
+		{
+
+			uint8_t Bytes [ PICSERVOSTATUSBENCH_MAX_REPLY ];
+
+			for ( uint32_t j = 0; j < PICSERVOSTATUSBENCH_MAX_REPLY; j ++ )
+				Bytes [ j ] = RandomByte ();
+
+			Status_t Reference;
+			Status_t Decoded;
+
+			Fill ( & Reference );
+			Fill ( & Decoded );
+
+			uint32_t Size = ReferenceDecode ( Bytes, Type, & Reference );
+			PICServoCom :: DecodeStatus ( Bytes, Type, & Decoded );
+
+			if ( Size != PICServoCom :: StatusPacketSize ( Type ) )
+				SizeMismatches ++;
+
+			if ( ! Same ( & Reference, & Decoded ) )
+			{
+
+				if ( FieldMismatches == 0 )
+					printf ( "first mismatch at mask 0x%02X\n", Type );
+
+				FieldMismatches ++;
+
+			}
+
+		}
+
+	}
+
+	printf ( "%u replies over 256 masks: %u size mismatches, %u field mismatches\n", Replies * 256, SizeMismatches, FieldMismatches );
+
+	// One reply per mask, decoded round robin so the branches see every mask in turn.
+	uint8_t Bytes [ 256 ][ PICSERVOSTATUSBENCH_MAX_REPLY ];
+
+	for ( uint32_t Type = 0; Type < 256; Type ++ )
+	{
+
+		for ( uint32_t j = 0; j < PICSERVOSTATUSBENCH_MAX_REPLY; j ++ )
+			Bytes [ Type ][ j ] = RandomByte ();
+
+	}
+
+	Status_t Status;
+	volatile uint32_t Sink = 0;
+
+	Fill ( & Status );
+
+	double Start = Timer :: GetPPCTimestamp ();
+
+	for ( uint32_t Pass = 0; Pass < Passes; Pass ++ )
+	{
+
+		for ( uint32_t Type = 0; Type < 256; Type ++ )
+		{
+
+			Sink += ReferenceDecode ( Bytes [ Type ], Type, & Status );
+			Sink += Status.Position;
+
+		}
+
+	}
+
+	double ReferenceTime = Timer :: GetPPCTimestamp () - Start;
+
+	Start = Timer :: GetPPCTimestamp ();
+
+	for ( uint32_t Pass = 0; Pass < Passes; Pass ++ )
+	{
+
+		for ( uint32_t Type = 0; Type < 256; Type ++ )
+		{
+
+			PICServoCom :: DecodeStatus ( Bytes [ Type ], Type, & Status );
+
+			Sink += PICServoCom :: StatusPacketSize ( Type );
+			Sink += Status.Position;
+
+		}
+
+	}
+
+	double TableTime = Timer :: GetPPCTimestamp () - Start;
+
+	double Decodes = static_cast <double> ( Passes ) * 256;
+
+	printf ( "reference walk: %7.2f ns per decode\n", 1e9 * ReferenceTime / Decodes );
+	printf ( "layout table:   %7.2f ns per decode ( %.2fx )\n", 1e9 * TableTime / Decodes, ReferenceTime / TableTime );
+
+	bool Passed = ( SizeMismatches == 0 && FieldMismatches == 0 );
+
+	printf ( "%s\n", Passed ? "PASSED" : "FAILED" );
+
+	return Passed ? 0 : 1;
+
+};
+
+#endif
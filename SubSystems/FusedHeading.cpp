@@ -0,0 +1,157 @@
+#include "FusedHeading.h"
+
+/*
+* Copyright (C) 2014 Liam Taylor
+* FRC Team Sehome Semonsters 2605
+*/
+
+/**
+* Constructor
+*
+* @param HeadingGyro Yaw gyro. ( NULL to use odometry only )
+* @param Odometry Wheel odometry. ( NULL to use the gyro only )
+* @param TimeConstant Seconds over which the odometry heading corrects gyro drift.
+*/
+FusedHeading :: FusedHeading ( Gyro * HeadingGyro, MecanumOdometry * Odometry, double TimeConstant )
+{
+
+	this -> HeadingGyro = HeadingGyro;
+	this -> Odometry = Odometry;
+	this -> TimeConstant = TimeConstant;
+
+	Heading = 0;
+	Rate = 0;
+
+	LastGyroAngle = 0;
+	LastTime = 0;
+
+	OdometryOffset = 0;
+
+	Primed = false;
+
+};
+
+FusedHeading :: ~FusedHeading ()
+{
+};
+
+void FusedHeading :: SetTimeConstant ( double TimeConstant )
+{
+
+	this -> TimeConstant = TimeConstant;
+
+};
+
+/**
+* Declare the robot's current heading. The next Update () starts from it.
+*
+* The next Update () lines up the odometry heading with it afresh, so an odometry reset can come before or after this
+* one, as long as no Update () runs in between. MecanumOdometry :: Reset publishes before it returns.
+*/
+void FusedHeading :: Reset ( double Heading )
+{
+
+	this -> Heading = Heading;
+	Rate = 0;
+
+	Primed = false;
+
+};
+
+/**
+* Blend in the latest gyro and odometry readings.
+*
+* @return The fused heading in radians.
+*/
+double FusedHeading :: Update ()
+{
+
+	double Now = Timer :: GetPPCTimestamp ();
+	double GyroAngle = ( HeadingGyro != NULL ) ? HeadingGyro -> GetAngle () * FUSEDHEADING_DEGREES_TO_RADIANS : 0;
+
+	double OdometryHeading;
+	bool HaveOdometry = ReadOdometry ( & OdometryHeading );
+
+	if ( ! Primed )
+	{
+
+		LastGyroAngle = GyroAngle;
+		LastTime = Now;
+
+		if ( HaveOdometry )
+			OdometryOffset = Heading - OdometryHeading;
+
+		// Without odometry there's nothing to line up, so the reset has to wait for it.
+		Primed = HaveOdometry || Odometry == NULL;
+
+		return Heading;
+
+	}
+
+	double Elapsed = Now - LastTime;
+	double Previous = Heading;
+
+	if ( HeadingGyro != NULL )
+	{
+
+		Heading += GyroAngle - LastGyroAngle;
+
+		if ( HaveOdometry )
+		{
+
+			double Blend = ( TimeConstant > 0 ) ? Elapsed / ( TimeConstant + Elapsed ) : 1.0;
+
+			Heading += ( OdometryHeading + OdometryOffset - Heading ) * Blend;
+
+		}
+
+	}
+	else if ( HaveOdometry )
+		Heading = OdometryHeading + OdometryOffset;
+
+	if ( Elapsed > 0 )
+		Rate = ( Heading - Previous ) / Elapsed;
+
+	LastGyroAngle = GyroAngle;
+	LastTime = Now;
+
+	return Heading;
+
+};
+
+/**
+* Heading in radians as of the last Update ().
+*/
+double FusedHeading :: Get ()
+{
+
+	return Heading;
+
+};
+
+/**
+* Turn rate in radians per second as of the last Update ().
+*/
+double FusedHeading :: GetRate ()
+{
+
+	return Rate;
+
+};
+
+bool FusedHeading :: ReadOdometry ( double * Heading )
+{
+
+	if ( Odometry == NULL )
+		return false;
+
+	MecanumPose Pose;
+
+	if ( ! Odometry -> GetPose ( & Pose ) || Pose.Timestamp == 0 )
+		return false;
+
+	* Heading = Pose.Heading;
+
+	return true;
+
+};
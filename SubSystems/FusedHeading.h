@@ -0,0 +1,69 @@
+#ifndef SHS_2605_FUSED_HEADING_H
+#define SHS_2605_FUSED_HEADING_H
+
+/*
+* Copyright (C) 2014 Liam Taylor
+* FRC Team Sehome Semonsters 2605
+*/
+
+#include "WPILib.h"
+#include <math.h>
+
+#include "MecanumOdometry.h"
+
+#define FUSEDHEADING_TIME_CONSTANT_DEFAULT 2.0
+#define FUSEDHEADING_DEGREES_TO_RADIANS 0.01745329252
+
+/*
+* Robot heading blended from a gyro and wheel odometry.
+*
+* The gyro follows quick turns well but drifts over time, while the odometry heading doesn't drift with time but is
+* thrown off whenever the wheels slip. A complementary filter takes the gyro's changes and pulls the result toward the
+* odometry heading with the given time constant. Either source may be left out.
+*
+* Heading is in radians, clockwise, like MecanumPose. Update () only reads the gyro's accumulator and the odometry's
+* published pose, so it never blocks. It should be called from one task only.
+*/
+class FusedHeading
+{
+
+	// Host benchmark in PIC-Servo/Simulator, which sets the heading and turn rate the drive sees.
+	friend class MecanumDriveBench;
+
+public:
+
+	FusedHeading ( Gyro * HeadingGyro, MecanumOdometry * Odometry, double TimeConstant = FUSEDHEADING_TIME_CONSTANT_DEFAULT );
+	~FusedHeading ();
+
+	void SetTimeConstant ( double TimeConstant );
+
+	void Reset ( double Heading = 0 );
+
+	double Update ();
+	double Get ();
+
+	double GetRate ();
+
+private:
+
+	bool ReadOdometry ( double * Heading );
+
+	Gyro * HeadingGyro;
+	MecanumOdometry * Odometry;
+
+	double TimeConstant;
+
+	double Heading;
+	double Rate;
+
+	double LastGyroAngle;
+	double LastTime;
+
+	// Odometry heading plus this offset lines up with Heading as of the last reset.
+	double OdometryOffset;
+
+	bool Primed;
+
+};
+
+#endif
@@ -1,6 +1,8 @@
 #include "MecanumDrive.h"
 #include <math.h>
 
+#include "FusedHeading.h"
+
 /*
 * Copyright (C) 2014 Liam Taylor
 * WheelFRC Team Sehome Semonsters 2605
@@ -39,6 +41,25 @@ MecanumDrive :: MecanumDrive ( SpeedController * WheelFL, SpeedController * Whee
 	SineInverted = false;
 
 	Enabled = false;
+
+	CommandX = 0;
+	CommandY = 0;
+	CommandR = 0;
+
+	HeadingSource = NULL;
+
+	FieldOriented = false;
+	HeadingHold = false;
+	HoldCaptured = false;
+
+	HoldP = MECANUMDRIVE_HOLD_P_DEFAULT;
+	HoldD = MECANUMDRIVE_HOLD_D_DEFAULT;
+	HoldTarget = 0;
+
+	Heading = 0;
+	CosHeading = 1;
+	SinStrafe = 0;
+	SinForward = 0;
 	
 };
 
@@ -77,6 +98,8 @@ bool MecanumDrive :: Enable ()
 		return false;
 
 	Enabled = true;
+	HoldCaptured = false;
+
 	return true;
 	
 };
@@ -101,13 +124,126 @@ bool MecanumDrive :: GetEnabled ()
 	
 };
 
+/*
+* Work out the robot relative command from the driver's.
+*
+* In field-oriented mode, the translation is rotated from the field frame into the robot's by the current heading.
+* Since SetTranslation scales X by sqrt ( 2 ), the sine terms carry that scaling, and they're only recomputed when the
+* heading changes. With heading hold on, a rotation inside the deadband holds the heading the robot had when the
+* driver last let go, using a PD controller on the heading error.
+*/
+void MecanumDrive :: UpdateCommand ( bool RefreshHeading )
+{
+
+	bool UseHeading = ( HeadingSource != NULL ) && ( FieldOriented || HeadingHold );
+
+	if ( UseHeading && RefreshHeading )
+	{
+
+		double NewHeading = HeadingSource -> Update ();
+
+		if ( NewHeading != Heading )
+		{
+
+			double Sin = sin ( NewHeading );
+
+			Heading = NewHeading;
+			CosHeading = cos ( NewHeading );
+			SinStrafe = Sin * SQRT_2;
+			SinForward = Sin * INV_SQRT_2;
+
+		}
+
+	}
+
+	if ( UseHeading && FieldOriented )
+	{
+
+		CommandX = TX * CosHeading - TY * SinStrafe;
+		CommandY = TX * SinForward + TY * CosHeading;
+
+	}
+	else
+	{
+
+		CommandX = TX;
+		CommandY = TY;
+
+	}
+
+	CommandR = TR;
+
+	if ( UseHeading && HeadingHold )
+	{
+
+		if ( fabs ( TR ) > MECANUMDRIVE_HOLD_DEADBAND || ! HoldCaptured )
+		{
+
+			HoldTarget = Heading;
+			HoldCaptured = true;
+
+		}
+		else
+		{
+
+			CommandR = HoldP * ( HoldTarget - Heading ) - HoldD * HeadingSource -> GetRate ();
+
+			if ( CommandR > 1.0 )
+				CommandR = 1.0;
+			else if ( CommandR < - 1.0 )
+				CommandR = - 1.0;
+
+		}
+
+	}
+
+};
+
+/*
+* Wheel outputs for the current command.
+*
+* Rotating the translation by 45 degrees only takes a sum and a difference: sin ( a + 45 ) * |T| is ( TX + TY ) / sqrt ( 2 ),
+* and cos ( a + 45 ) * |T| is ( TY - TX ) / sqrt ( 2 ). If any wheel would pass full scale, all four are scaled down by
+* the same factor, so the robot still moves in the commanded direction.
+*/
+void MecanumDrive :: ComputeWheels ( double * FL, double * FR, double * RL, double * RR )
+{
+
+	double SinCalc = ( CommandX + CommandY ) * INV_SQRT_2;
+	double CosCalc = ( CommandY - CommandX ) * INV_SQRT_2;
+
+	double Diagonal = SineInverted ? CosCalc : SinCalc;
+	double AntiDiagonal = SineInverted ? SinCalc : CosCalc;
+
+	double WheelFL = Diagonal + CommandR;
+	double WheelFR = AntiDiagonal - CommandR;
+	double WheelRL = AntiDiagonal + CommandR;
+	double WheelRR = Diagonal - CommandR;
+
+	double Peak = fabs ( WheelFL );
+
+	if ( fabs ( WheelFR ) > Peak )
+		Peak = fabs ( WheelFR );
+
+	if ( fabs ( WheelRL ) > Peak )
+		Peak = fabs ( WheelRL );
+
+	if ( fabs ( WheelRR ) > Peak )
+		Peak = fabs ( WheelRR );
+
+	double Desaturate = ( Peak > 1.0 ) ? Scale / Peak : Scale;
+
+	* FL = WheelFL * ( MotorFL.Inverted ? - Desaturate : Desaturate );
+	* FR = WheelFR * ( MotorFR.Inverted ? - Desaturate : Desaturate );
+	* RL = WheelRL * ( MotorRL.Inverted ? - Desaturate : Desaturate );
+	* RR = WheelRR * ( MotorRR.Inverted ? - Desaturate : Desaturate );
+
+};
+
 void MecanumDrive :: PushTransform ()
 {
 	
-	double ForceAngle;
-	double ForceMagnitude;
-	double SinCalc;
-	double CosCalc;
+	double FL, FR, RL, RR;
 	
 	if ( ! Enabled )
 	{
@@ -120,44 +256,25 @@ void MecanumDrive :: PushTransform ()
 		return;
 	
 	}
-		
-	ForceMagnitude = sqrt ( TX * TX + TY * TY );
 	
-	ForceAngle = atan2 ( TX, TY );
-	ForceAngle += PI_Div_4;
-	
-	SinCalc = sin ( ForceAngle ) * ForceMagnitude;
-	CosCalc = cos ( ForceAngle ) * ForceMagnitude;
+	UpdateCommand ( true );
+	ComputeWheels ( & FL, & FR, & RL, & RR );
 
-	MotorFL.Motor -> Set ( ( ( SineInverted ? CosCalc : SinCalc ) + TR ) * ( MotorFL.Inverted ? - Scale : Scale ) );
-	MotorFR.Motor -> Set ( ( ( SineInverted ? SinCalc : CosCalc ) - TR ) * ( MotorFR.Inverted ? - Scale : Scale ) );
-	MotorRL.Motor -> Set ( ( ( SineInverted ? SinCalc : CosCalc ) + TR ) * ( MotorRL.Inverted ? - Scale : Scale ) );
-	MotorRR.Motor -> Set ( ( ( SineInverted ? CosCalc : SinCalc ) - TR ) * ( MotorRR.Inverted ? - Scale : Scale ) );
+	MotorFL.Motor -> Set ( FL );
+	MotorFR.Motor -> Set ( FR );
+	MotorRL.Motor -> Set ( RL );
+	MotorRR.Motor -> Set ( RR );
 	
 };
 
 void MecanumDrive :: DebugValues ()
 {
 	
-	double ForceAngle;
-	double ForceMagnitude;
-	double SinCalc;
-	double CosCalc;
-	
 	double FL, FR, RL, RR;
 	
-	ForceMagnitude = sqrt ( TX * TX + TY * TY );
-	
-	ForceAngle = atan2 ( TX, TY );
-	ForceAngle += PI_Div_4;
-	
-	SinCalc = sin ( ForceAngle ) * ForceMagnitude;
-	CosCalc = cos ( ForceAngle ) * ForceMagnitude;
-	
-	FL = ( ( SineInverted ? CosCalc : SinCalc ) + TR ) * ( MotorFL.Inverted ? - Scale : Scale );
-	FR = ( ( SineInverted ? SinCalc : CosCalc ) - TR ) * ( MotorFR.Inverted ? - Scale : Scale );
-	RL = ( ( SineInverted ? SinCalc : CosCalc ) + TR ) * ( MotorRL.Inverted ? - Scale : Scale );
-	RR = ( ( SineInverted ? CosCalc : SinCalc ) - TR ) * ( MotorRR.Inverted ? - Scale : Scale );
+	// Uses the heading from the last PushTransform, so printing doesn't move the heading estimate along.
+	UpdateCommand ( false );
+	ComputeWheels ( & FL, & FR, & RL, & RR );
 	
 	printf ( "[ Mecanum Drive Debug ]\n%s\nInput X: %4.4f\nInput Y: %4.4f\nInput R: %4.4f\n[%+4.4f]---[%+4.4f]\n   |         |   \n   |         |   \n   |         |   \n   |         |   \n   |         |   \n   |         |   \n[%+4.4f]---[%+4.4f]\n", ( Enabled ? "Enabled." : "Disabled." ), TX, TY, TR, FL, FR, RL, RR );
 	
@@ -220,3 +337,57 @@ void MecanumDrive :: SetSineInversion ( bool SineInverted = false )
 	this -> SineInverted = SineInverted;
 	
 };
+
+/**
+* Heading estimate used for field-oriented driving and heading hold. Updated once per PushTransform.
+*/
+void MecanumDrive :: SetHeadingSource ( FusedHeading * Source )
+{
+
+	if ( Enabled )
+		return;
+
+	HeadingSource = Source;
+
+};
+
+/**
+* Interpret SetTranslation in the field frame instead of the robot's. Needs a heading source.
+*/
+void MecanumDrive :: SetFieldOriented ( bool FieldOriented )
+{
+
+	this -> FieldOriented = FieldOriented;
+
+};
+
+bool MecanumDrive :: GetFieldOriented ()
+{
+
+	return FieldOriented;
+
+};
+
+/**
+* Hold the heading whenever the rotation input is inside MECANUMDRIVE_HOLD_DEADBAND. Needs a heading source.
+*
+* @param P Rotation output per radian of heading error.
+* @param D Rotation output per radian per second of turn rate.
+*/
+void MecanumDrive :: SetHeadingHold ( bool Hold, double P, double D )
+{
+
+	HoldP = P;
+	HoldD = D;
+
+	HoldCaptured = false;
+	HeadingHold = Hold;
+
+};
+
+bool MecanumDrive :: GetHeadingHold ()
+{
+
+	return HeadingHold;
+
+};
@@ -11,6 +11,11 @@
 
 #define PI_Div_4 0.78539816339
 #define SQRT_2 1.41421356237
+#define INV_SQRT_2 0.70710678118
+
+#define MECANUMDRIVE_HOLD_DEADBAND 0.05
+#define MECANUMDRIVE_HOLD_P_DEFAULT 1.0
+#define MECANUMDRIVE_HOLD_D_DEFAULT 0.1
 
 typedef struct
 {
@@ -20,8 +25,14 @@ typedef struct
 	
 } MecMotor;
 
+class FusedHeading;
+
 class MecanumDrive
 {
+
+	// Host benchmark in PIC-Servo/Simulator, which checks and times the wheel kinematics against the trig version.
+	friend class MecanumDriveBench;
+
 public:
 
 	MecanumDrive ( SpeedController * WwheelFL, SpeedController * WheelFR, SpeedController * WheelRL, SpeedController * WheelRR );
@@ -48,17 +59,39 @@ public:
 	
 	void SetSineInversion ( bool Inverted );
 
+	void SetHeadingSource ( FusedHeading * Source );
+
+	void SetFieldOriented ( bool FieldOriented );
+	bool GetFieldOriented ();
+
+	void SetHeadingHold ( bool Hold, double P = MECANUMDRIVE_HOLD_P_DEFAULT, double D = MECANUMDRIVE_HOLD_D_DEFAULT );
+	bool GetHeadingHold ();
+
 	void DebugValues ();
 	
 	void PushTransform ();
 	
 private:
 	
+	void UpdateCommand ( bool RefreshHeading );
+	void ComputeWheels ( double * FL, double * FR, double * RL, double * RR );
+
 	MecMotor MotorFL, MotorFR, MotorRL, MotorRR;
 	
 	double TX, TY, TR, Scale, PrescaleR, PrescaleT;
 
 	bool Enabled, SineInverted;
+
+	// Robot relative command, after field orientation and heading hold.
+	double CommandX, CommandY, CommandR;
+
+	FusedHeading * HeadingSource;
+
+	bool FieldOriented, HeadingHold, HoldCaptured;
+	double HoldP, HoldD, HoldTarget;
+
+	// Rotation terms for the last heading, with the strafe scaling of SetTranslation folded in.
+	double Heading, CosHeading, SinStrafe, SinForward;
 	
 };
 
@@ -0,0 +1,307 @@
+#include "MecanumOdometry.h"
+
+/*
+* Copyright (C) 2014 Liam Taylor
+* FRC Team Sehome Semonsters 2605
+*/
+
+/**
+* Constructor
+*
+* @param WheelFL Front-left wheel Jaguar
+* @param WheelFR Front-right wheel Jaguar
+* @param WheelRL Rear-left wheel Jaguar
+* @param WheelRR Rear-right wheel Jaguar ( All four on the same CANJaguarServer )
+* @param WheelCircumference Distance a wheel rolls in one revolution. ( Sets the unit of the pose )
+* @param TrackWidth Distance between the left and right wheels.
+* @param WheelBase Distance between the front and rear wheels.
+*/
+MecanumOdometry :: MecanumOdometry ( AsynchCANJaguar * WheelFL, AsynchCANJaguar * WheelFR, AsynchCANJaguar * WheelRL, AsynchCANJaguar * WheelRR, double WheelCircumference, double TrackWidth, double WheelBase )
+{
+
+	Server = WheelFL -> GetServer ();
+
+	WheelIDs [ 0 ] = WheelFL -> GetID ();
+	WheelIDs [ 1 ] = WheelFR -> GetID ();
+	WheelIDs [ 2 ] = WheelRL -> GetID ();
+	WheelIDs [ 3 ] = WheelRR -> GetID ();
+
+	for ( uint32_t i = 0; i < 4; i ++ )
+	{
+
+		WheelSigns [ i ] = 1;
+		LastPositions [ i ] = 0;
+
+	}
+
+	DistancePerRev = WheelCircumference;
+	RotationRadius = ( TrackWidth + WheelBase ) / 2;
+
+	SineInverted = false;
+
+	OdometryTask = new Task ( "2605_MecanumOdometry_Task", (FUNCPTR) & _StartOdometryTask, MECANUMODOMETRY_PRIORITY, MECANUMODOMETRY_STACKSIZE );
+	UpdateLock = semMCreate ( SEM_Q_PRIORITY | SEM_DELETE_SAFE | SEM_INVERSION_SAFE );
+	Running = false;
+
+	Primed = false;
+	LastTimestamp = 0;
+
+	X = 0;
+	Y = 0;
+	Heading = 0;
+
+	Pose.X = 0;
+	Pose.Y = 0;
+	Pose.Heading = 0;
+	Pose.VX = 0;
+	Pose.VY = 0;
+	Pose.Omega = 0;
+	Pose.Timestamp = 0;
+
+};
+
+MecanumOdometry :: ~MecanumOdometry ()
+{
+
+	Stop ();
+
+	delete OdometryTask;
+
+	semDelete ( UpdateLock );
+
+};
+
+/**
+* Match the wheel inversions given to MecanumDrive :: SetInverted, so every wheel counts forward as positive.
+*/
+void MecanumOdometry :: SetInverted ( bool FL, bool FR, bool RL, bool RR )
+{
+
+	if ( Running )
+		return;
+
+	WheelSigns [ 0 ] = FL ? - 1 : 1;
+	WheelSigns [ 1 ] = FR ? - 1 : 1;
+	WheelSigns [ 2 ] = RL ? - 1 : 1;
+	WheelSigns [ 3 ] = RR ? - 1 : 1;
+
+};
+
+/**
+* Match MecanumDrive :: SetSineInversion. ( Rollers mounted the other way round strafe the other way )
+*/
+void MecanumOdometry :: SetSineInversion ( bool Inverted )
+{
+
+	if ( Running )
+		return;
+
+	SineInverted = Inverted;
+
+};
+
+bool MecanumOdometry :: Start ()
+{
+
+	if ( Running )
+		return true;
+
+	Primed = false;
+
+	// The server only reads the positions of wheels someone has asked for.
+	for ( uint32_t i = 0; i < 4; i ++ )
+		Server -> AddJagTelemetry ( WheelIDs [ i ] );
+
+	Running = OdometryTask -> Start ( reinterpret_cast <uint32_t> ( this ) );
+
+	if ( ! Running )
+	{
+
+		for ( uint32_t i = 0; i < 4; i ++ )
+			Server -> RemoveJagTelemetry ( WheelIDs [ i ] );
+
+	}
+
+	return Running;
+
+};
+
+void MecanumOdometry :: Stop ()
+{
+
+	if ( ! Running )
+		return;
+
+	// The task holds the update lock while it updates, so it can't be stopped half way through publishing a pose.
+	semTake ( UpdateLock, WAIT_FOREVER );
+
+	OdometryTask -> Stop ();
+
+	semGive ( UpdateLock );
+
+	for ( uint32_t i = 0; i < 4; i ++ )
+		Server -> RemoveJagTelemetry ( WheelIDs [ i ] );
+
+	Running = false;
+
+};
+
+bool MecanumOdometry :: IsRunning ()
+{
+
+	return Running;
+
+};
+
+/**
+* Set the pose the robot is at now. The new pose is published before this returns, so a FusedHeading reset right
+* after it lines up with the new heading.
+*/
+void MecanumOdometry :: Reset ( double X, double Y, double Heading )
+{
+
+	semTake ( UpdateLock, WAIT_FOREVER );
+
+	this -> X = X;
+	this -> Y = Y;
+	this -> Heading = Heading;
+
+	// The wheel positions are kept, so the next step carries on from the new pose.
+	Publish ( Pose.VX, Pose.VY, Pose.Omega );
+
+	semGive ( UpdateLock );
+
+};
+
+/**
+* Copy out the latest pose. Never blocks.
+*
+* @return False if a consistent copy couldn't be made. Pose still holds the last attempt.
+*/
+bool MecanumOdometry :: GetPose ( MecanumPose * Pose )
+{
+
+	for ( uint32_t Attempt = 0; Attempt < 16; Attempt ++ )
+	{
+
+		uint32_t Sequence = PoseLock.BeginRead ();
+
+		* Pose = this -> Pose;
+
+		if ( PoseLock.EndRead ( Sequence ) )
+			return true;
+
+	}
+
+	return false;
+
+};
+
+void MecanumOdometry :: Update ()
+{
+
+	float Positions [ 4 ];
+	double Timestamp = 0;
+
+	// All four from one sweep, so a step never mixes old and new wheel positions.
+	bool Sampled = Server -> GetJagCachedPositions ( WheelIDs, 4, Positions, & Timestamp );
+
+	double VX = Pose.VX;
+	double VY = Pose.VY;
+	double Omega = Pose.Omega;
+
+	if ( ! Sampled || Timestamp == LastTimestamp )
+		return;
+
+	if ( Primed )
+	{
+
+		double Distances [ 4 ];
+
+		for ( uint32_t i = 0; i < 4; i ++ )
+			Distances [ i ] = ( Positions [ i ] - LastPositions [ i ] ) * WheelSigns [ i ] * DistancePerRev;
+
+		// Mecanum forward kinematics: the inverse of MecanumDrive's wheel mix.
+		double Forward = ( Distances [ 0 ] + Distances [ 1 ] + Distances [ 2 ] + Distances [ 3 ] ) / 4;
+		double Strafe = ( Distances [ 0 ] - Distances [ 1 ] - Distances [ 2 ] + Distances [ 3 ] ) / 4;
+		double Turn = ( Distances [ 0 ] - Distances [ 1 ] + Distances [ 2 ] - Distances [ 3 ] ) / ( 4 * RotationRadius );
+
+		if ( SineInverted )
+			Strafe = - Strafe;
+
+		// Rotate into the field frame at the heading halfway through the step.
+		double Midpoint = Heading + Turn / 2;
+		double Cos = cos ( Midpoint );
+		double Sin = sin ( Midpoint );
+
+		X += Strafe * Cos + Forward * Sin;
+		Y += Forward * Cos - Strafe * Sin;
+		Heading += Turn;
+
+		double Elapsed = Timestamp - LastTimestamp;
+
+		if ( Elapsed > 0 )
+		{
+
+			VX = Strafe / Elapsed;
+			VY = Forward / Elapsed;
+			Omega = Turn / Elapsed;
+
+		}
+
+	}
+
+	for ( uint32_t i = 0; i < 4; i ++ )
+		LastPositions [ i ] = Positions [ i ];
+
+	LastTimestamp = Timestamp;
+	Primed = true;
+
+	Publish ( VX, VY, Omega );
+
+};
+
+// Publish the pose. Call with UpdateLock held, which keeps the sequence lock to a single writer.
+void MecanumOdometry :: Publish ( double VX, double VY, double Omega )
+{
+
+	PoseLock.BeginWrite ();
+
+	Pose.X = X;
+	Pose.Y = Y;
+	Pose.Heading = Heading;
+	Pose.VX = VX;
+	Pose.VY = VY;
+	Pose.Omega = Omega;
+	Pose.Timestamp = LastTimestamp;
+
+	PoseLock.EndWrite ();
+
+};
+
+void MecanumOdometry :: RunLoop ()
+{
+
+	while ( true )
+	{
+
+		semTake ( UpdateLock, WAIT_FOREVER );
+
+		Update ();
+
+		semGive ( UpdateLock );
+
+		Wait ( MECANUMODOMETRY_PERIOD );
+
+	}
+
+};
+
+int MecanumOdometry :: _StartOdometryTask ( MecanumOdometry * This )
+{
+
+	This -> RunLoop ();
+
+	return 0;
+
+};
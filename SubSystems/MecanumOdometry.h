@@ -0,0 +1,106 @@
+#ifndef SHS_2605_MECANUM_ODOMETRY_H
+#define SHS_2605_MECANUM_ODOMETRY_H
+
+/*
+* Copyright (C) 2014 Liam Taylor
+* FRC Team Sehome Semonsters 2605
+*/
+
+#include "WPILib.h"
+#include <math.h>
+
+#include "src/CANJagServer/AsynchCANJaguar.h"
+#include "src/Util/SequenceLock.h"
+
+#define MECANUMODOMETRY_PERIOD 0.01
+
+#define MECANUMODOMETRY_PRIORITY 55
+#define MECANUMODOMETRY_STACKSIZE 0x8000
+
+/*
+* Robot pose on the field. X is to the right and Y forward of where the pose was last reset, and Heading is in
+* radians, clockwise, the same sense as MecanumDrive :: SetRotation. Velocities are in the robot's own frame.
+*/
+typedef struct MecanumPose
+{
+
+	double X;
+	double Y;
+	double Heading;
+
+	double VX;
+	double VY;
+	double Omega;
+
+	double Timestamp;
+
+} MecanumPose;
+
+/*
+* Dead-reckons the robot's pose from its four wheel encoders.
+*
+* Wheel positions come from the CANJaguarServer telemetry cache, so the estimator never waits on the CAN bus and never
+* gets in the way of the drive. The wheels are registered for telemetry while the estimator runs, and the server's
+* telemetry interval has to be set for the cache to fill. Each new sweep is turned into a robot motion with mecanum
+* forward kinematics, and integrated at the midpoint heading. Wheel slip isn't modeled, so the pose drifts, strafing
+* fastest.
+*/
+class MecanumOdometry
+{
+
+	// Host check in PIC-Servo/Simulator, which steps the estimator one sweep at a time.
+	friend class MecanumOdometryCheck;
+
+public:
+
+	MecanumOdometry ( AsynchCANJaguar * WheelFL, AsynchCANJaguar * WheelFR, AsynchCANJaguar * WheelRL, AsynchCANJaguar * WheelRR, double WheelCircumference, double TrackWidth, double WheelBase );
+	~MecanumOdometry ();
+
+	void SetInverted ( bool FL, bool FR, bool RL, bool RR );
+	void SetSineInversion ( bool Inverted );
+
+	bool Start ();
+	void Stop ();
+
+	bool IsRunning ();
+
+	void Reset ( double X = 0, double Y = 0, double Heading = 0 );
+
+	bool GetPose ( MecanumPose * Pose );
+
+private:
+
+	void Update ();
+	void Publish ( double VX, double VY, double Omega );
+	void RunLoop ();
+
+	static int _StartOdometryTask ( MecanumOdometry * This );
+
+	CANJaguarServer * Server;
+	CAN_ID WheelIDs [ 4 ];
+	double WheelSigns [ 4 ];
+
+	double DistancePerRev;
+	double RotationRadius;
+
+	bool SineInverted;
+
+	Task * OdometryTask;
+	SEM_ID UpdateLock;
+	bool Running;
+
+	// Only touched under UpdateLock.
+	bool Primed;
+	float LastPositions [ 4 ];
+	double LastTimestamp;
+
+	double X;
+	double Y;
+	double Heading;
+
+	SequenceLock PoseLock;
+	MecanumPose Pose;
+
+};
+
+#endif
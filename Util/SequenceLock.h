@@ -0,0 +1,75 @@
+#ifndef SHS_2605_SEQUENCE_LOCK_H
+#define SHS_2605_SEQUENCE_LOCK_H
+
+/*
+* Copyright (C) 2014 Liam Taylor
+* FRC Team Sehome Semonsters 2605
+*/
+
+#include <stdint.h>
+
+#if defined ( __PPC__ ) || defined ( __ppc__ )
+	#define SEQUENCELOCK_BARRIER() __asm__ __volatile__ ( "sync" : : : "memory" )
+#else
+	#define SEQUENCELOCK_BARRIER() __asm__ __volatile__ ( "" : : : "memory" )
+#endif
+
+/*
+* Single-writer sequence lock. The writer never blocks, and readers never block the writer.
+*
+* A reader copies the data between BeginRead () and EndRead (), and only trusts the copy if EndRead () returns true.
+* Readers shouldn't spin forever on a failed read, since a lower priority writer may be stuck part way through an update.
+*/
+class SequenceLock
+{
+public:
+
+	SequenceLock ()
+	{
+
+		Sequence = 0;
+
+	};
+
+	void BeginWrite ()
+	{
+
+		Sequence ++;
+		SEQUENCELOCK_BARRIER ();
+
+	};
+
+	void EndWrite ()
+	{
+
+		SEQUENCELOCK_BARRIER ();
+		Sequence ++;
+
+	};
+
+	uint32_t BeginRead ()
+	{
+
+		uint32_t Start = Sequence;
+		SEQUENCELOCK_BARRIER ();
+
+		return Start;
+
+	};
+
+	bool EndRead ( uint32_t Start )
+	{
+
+		SEQUENCELOCK_BARRIER ();
+
+		return ( ( Start & 1 ) == 0 ) && ( Sequence == Start );
+
+	};
+
+private:
+
+	volatile uint32_t Sequence;
+
+};
+
+#endif